@@ -384,6 +384,7 @@ bool RawModel::loadFiffData(QFile* qFile)
     m_pfiffIO = QSharedPointer<FiffIO>(new FiffIO(*qFile));
     if(!m_pfiffIO->m_qlistRaw.empty()) {
         m_iAbsFiffCursor = m_pfiffIO->m_qlistRaw[0]->first_samp; //Set cursor somewhere into fiff file [in samples]
+        m_pfiffIO->m_qlistRaw[0]->setBufferCacheSize(256*1024*1024); //Keep recently viewed buffers decoded when scrolling back and forth
         m_iCurAbsScrollPos = 0;
         m_bStartReached = true;
 
@@ -124,8 +124,11 @@ void FiffProducer::run()
     //
 
     fiff_int_t first, last;
-    MatrixXd data;
-    MatrixXd times;
+
+    //
+    //   The block which is pushed to the buffer, read in single precision and reused for every quantum
+    //
+    MatrixXf tmp(m_pFiffSimulator->m_RawInfo.info.nchan, quantum);
 
     first = from;
 
@@ -153,13 +156,11 @@ void FiffProducer::run()
             last = to;
         }
 
-        if (!m_pFiffSimulator->m_RawInfo.read_raw_segment(data,times,first,last))
+        if (!m_pFiffSimulator->m_RawInfo.read_raw_segment(tmp.leftCols(last-first+1),first,last))
         {
             printf("error during read_raw_segment\n");
         }
 
-        MatrixXf tmp = data.cast<float>();//(inv_calsMat*data).cast<float>();
-
         if(t_bRestart)
         {
             //
@@ -170,20 +171,11 @@ void FiffProducer::run()
             first = from;
             last = first+t_iDiff-1;
 
-            if (!m_pFiffSimulator->m_RawInfo.read_raw_segment(data,times,first,last))
+            if (!m_pFiffSimulator->m_RawInfo.read_raw_segment(tmp.rightCols(t_iDiff),first,last))
             {
                 printf("error during read_raw_segment\n");
             }
 
-            MatrixXf tmp2 = data.cast<float>();//(inv_calsMat*data).cast<float>();
-
-            MatrixXf tmp3(tmp.rows(), tmp.cols()+tmp2.cols());
-
-            tmp3.block(0,0,tmp.rows(),tmp.cols()) = tmp;
-            tmp3.block(0,tmp.cols(),tmp.rows(),tmp2.cols()) = tmp2;
-
-            tmp = tmp3;
-
             t_bRestart = false;
             first += t_iDiff;
         }
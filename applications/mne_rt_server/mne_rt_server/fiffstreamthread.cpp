@@ -176,6 +176,15 @@ void FiffStreamThread::parseCommand(FiffTag::SPtr p_pTag)
 }
 
 
+//*************************************************************************************************************
+
+void FiffStreamThread::receiveTag(const QSharedPointer<FiffTag>& p_pTag)
+{
+    if(p_pTag->kind == FIFF_MNE_RT_COMMAND)
+        parseCommand(p_pTag);
+}
+
+
 //*************************************************************************************************************
 
 void FiffStreamThread::sendRawBuffer(QSharedPointer<Eigen::MatrixXf> m_pMatRawData)
@@ -322,7 +331,13 @@ void FiffStreamThread::run()
                t_qTcpSocket.peerPort());
     }
 
-    FiffStream t_FiffStreamIn(&t_qTcpSocket);
+    //
+    // Incoming tags are decoded as the bytes arrive, the parser lives in this thread
+    //
+    FiffTagParser t_tagParser;
+    connect(&t_tagParser, &FiffTagParser::tagReceived,
+            this, &FiffStreamThread::receiveTag, Qt::DirectConnection);
+    t_tagParser.attach(&t_qTcpSocket);
 
 //    int i = 0;
     while(t_qTcpSocket.state() != QAbstractSocket::UnconnectedState && m_bIsRunning)
@@ -352,33 +367,10 @@ void FiffStreamThread::run()
         m_qMutex.unlock();
 
         //
-        // Read: Wait 10ms for incomming tag header, read and continue
+        // Read: Wait up to 10ms for incoming bytes, readyRead hands them to the tag parser. Incomplete tags are
+        // completed by later reads, so sending is never held up by a partially received tag.
         //
         t_qTcpSocket.waitForReadyRead(10);
-
-        if (t_qTcpSocket.bytesAvailable() >= (int)sizeof(qint32)*4)
-        {
-//            qDebug() << "goes to read bytes " ;
-            FiffTag::SPtr t_pTag;
-            t_FiffStreamIn.read_tag_info(t_pTag, false);
-
-            //
-            // wait until tag size data are available and read the data
-            //
-            while (t_qTcpSocket.bytesAvailable() < t_pTag->size())
-            {
-                t_qTcpSocket.waitForReadyRead(10);
-            }
-            t_FiffStreamIn.read_tag_data(t_pTag);
-
-            //
-            // Parse the tag
-            //
-            if(t_pTag->kind == FIFF_MNE_RT_COMMAND)
-            {
-                parseCommand(t_pTag);
-            }
-        }
     }
 
     t_qTcpSocket.disconnectFromHost();
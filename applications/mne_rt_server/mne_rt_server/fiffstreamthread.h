@@ -43,6 +43,7 @@
 
 #include <fiff/fiff_stream.h>
 #include <fiff/fiff_info.h>
+#include <fiff/fiff_tag_parser.h>
 
 
 //*************************************************************************************************************
@@ -96,6 +97,8 @@ public:
 
     void parseCommand(QSharedPointer<FiffTag> p_pTag);
 
+    void receiveTag(const QSharedPointer<FiffTag>& p_pTag);
+
     void writeClientId();
 
 //    void sendData(QTcpSocket& p_qTcpSocket);
@@ -906,10 +906,33 @@ void RealTimeMultiSampleArrayModel::filterChanged(QList<FilterData> filterData)
 {
     m_filterData = filterData;
 
-    m_iMaxFilterLength = 1;
+    //IIR filters keep a state per channel across the blocks, filtering every block on its own would restart them
+    m_filterDataFIR.clear();
+    int iNumSections = 0;
+    for(int i=0; i<filterData.size(); ++i) {
+        if(filterData.at(i).m_matSOS.rows() > 0) {
+            iNumSections += filterData.at(i).m_matSOS.rows();
+        } else {
+            m_filterDataFIR.append(filterData.at(i));
+        }
+    }
+
+    m_matIIRSOS.resize(iNumSections, 6);
+    iNumSections = 0;
     for(int i=0; i<filterData.size(); ++i) {
-        if(m_iMaxFilterLength<filterData.at(i).m_iFilterOrder) {
-            m_iMaxFilterLength = filterData.at(i).m_iFilterOrder;
+        const MatrixXd& matSOS = filterData.at(i).m_matSOS;
+        if(matSOS.rows() > 0) {
+            m_matIIRSOS.middleRows(iNumSections, matSOS.rows()) = matSOS;
+            iNumSections += matSOS.rows();
+        }
+    }
+    m_matIIRState = MatrixXd::Zero(m_pFiffInfo->chs.size(), IIRFilter::stateSize(m_matIIRSOS));
+
+    //Only the FIR filters need the overlap
+    m_iMaxFilterLength = 1;
+    for(int i=0; i<m_filterDataFIR.size(); ++i) {
+        if(m_iMaxFilterLength<m_filterDataFIR.at(i).m_iFilterOrder) {
+            m_iMaxFilterLength = m_filterDataFIR.at(i).m_iFilterOrder;
         }
     }
 
@@ -1146,6 +1169,12 @@ void RealTimeMultiSampleArrayModel::filterChannelsConcurrently()
     fftLength = pow(2, exp) < 512 ? 512 : pow(2, exp);
 
     for(int i = 0; i<m_filterData.size(); ++i) {
+        //IIR filters do not depend on the fft length, keep their sections and ripple
+        if(m_filterData.at(i).m_matSOS.rows() > 0) {
+            tempFilterList.append(m_filterData.at(i));
+            continue;
+        }
+
         FilterData tempFilter(m_filterData.at(i).m_sName,
                               m_filterData.at(i).m_Type,
                               m_filterData.at(i).m_iFilterOrder,
@@ -1212,11 +1241,33 @@ void RealTimeMultiSampleArrayModel::filterChannelsConcurrently(const MatrixXd &d
     QList<QPair<QList<FilterData>,QPair<int,RowVectorXd> > > timeData;
     QList<int> notFilterChannelIndex;
 
+    if(m_matIIRState.rows() != data.rows())
+        m_matIIRState = MatrixXd::Zero(data.rows(), IIRFilter::stateSize(m_matIIRSOS));
+
     for(qint32 i = 0; i < data.rows(); ++i) {
-        if(m_filterChannelList.contains(m_pFiffInfo->chs.at(i).ch_name))
-            timeData.append(QPair<QList<FilterData>,QPair<int,RowVectorXd> >(m_filterData,QPair<int,RowVectorXd>(i,data.row(i))));
-        else
+        if(m_filterChannelList.contains(m_pFiffInfo->chs.at(i).ch_name)) {
+            RowVectorXd vecData = data.row(i);
+
+            //IIR filters run causally and continue where the last block ended
+            if(m_matIIRSOS.rows() > 0) {
+                MatrixXd matData = vecData;
+                MatrixXd matState = m_matIIRState.row(i);
+                IIRFilter::filter(m_matIIRSOS, matData, matState);
+                m_matIIRState.row(i) = matState;
+                vecData = matData;
+            }
+
+            //Without FIR filters the data only gets the overlap-add layout: m_iMaxFilterLength samples of overhead with the data delayed by half of it
+            if(m_filterDataFIR.isEmpty()) {
+                RowVectorXd vecLayout = RowVectorXd::Zero(vecData.cols() + m_iMaxFilterLength);
+                vecLayout.segment(m_iMaxFilterLength/2, vecData.cols()) = vecData;
+                vecData = vecLayout;
+            }
+
+            timeData.append(QPair<QList<FilterData>,QPair<int,RowVectorXd> >(m_filterDataFIR,QPair<int,RowVectorXd>(i,vecData)));
+        } else {
             notFilterChannelIndex.append(i);
+        }
     }
 
     //Do the concurrent filtering
@@ -47,6 +47,7 @@
 #include <fiff/fiff_info.h>
 
 #include <utils/filterTools/filterdata.h>
+#include <utils/filterTools/iirfilter.h>
 #include <utils/mnemath.h>
 #include <utils/detecttrigger.h>
 #include <utils/ioutils.h>
@@ -603,6 +604,9 @@ private:
     QMap<int,QList<QPair<int,double> > >m_qMapDetectedTriggerOldFreeze;             /**< Old detected trigger for each trigger channel while display is freezed. */
     QMap<qint32,float>                  m_qMapChScaling;                            /**< Channel scaling map. */
     QList<FilterData>                   m_filterData;                               /**< List of currently active filters. */
+    QList<FilterData>                   m_filterDataFIR;                            /**< The FIR filters of m_filterData, applied block wise by overlap-add. */
+    MatrixXd                            m_matIIRSOS;                                /**< Second-order sections of all IIR filters of m_filterData, applied causally before the FIR filters. */
+    MatrixXd                            m_matIIRState;                              /**< State of the IIR sections, one row per channel. */
     QList<RealTimeSampleArrayChInfo>    m_qListChInfo;                              /**< Channel info list. ToDo: Obsolete*/
     QStringList                         m_filterChannelList;                        /**< List of channels which are to be filtered.*/
     QStringList                         m_visibleChannelList;                       /**< List of currently visible channels in the view.*/
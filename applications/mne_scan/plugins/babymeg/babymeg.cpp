@@ -362,8 +362,9 @@ void BabyMEG::run()
             //Create digital trigger information
             createDigTrig(matValue);
 
-            //Write raw data to fif file
-            if(m_bWriteToFile) {
+            //Write raw data to fif file, the recording can be stopped from the GUI thread at any time
+            m_mutex.lock();
+            if(m_bWriteToFile && m_pRawWriter) {
                 size += matValue.rows()*matValue.cols() * 4;
 
                 if(size > MAX_DATA_LEN) {
@@ -371,12 +372,11 @@ void BabyMEG::run()
                     this->splitRecordingFile();
                 }
 
-                m_mutex.lock();
-                m_pOutfid->write_raw_buffer(matValue.cast<double>());
-                m_mutex.unlock();
+                m_pRawWriter->write_raw_buffer(matValue);
             } else {
                 size = 0;
             }
+            m_mutex.unlock();
 
             if(m_pRTMSABabyMEG) {
                 m_pRTMSABabyMEG->data()->setValue(this->calibrate(matValue));
@@ -754,6 +754,9 @@ void BabyMEG::splitRecordingFile()
     QString nextFileName = m_sRecordFile.remove("_raw.fif");
     nextFileName += QString("-%1_raw.fif").arg(m_iSplitCount);
 
+    //Write the queued buffers before closing the current file
+    m_pRawWriter->stop();
+
     //Write the link to the next file
     qint32 data;
     m_pOutfid->start_block(FIFFB_REF);
@@ -773,6 +776,9 @@ void BabyMEG::splitRecordingFile()
     m_pOutfid = FiffStream::start_writing_raw(m_qFileOut, *m_pFiffInfo, m_cals, defaultMatrixXi, false);
     fiff_int_t first = 0;
     m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
+
+    m_pRawWriter = FiffRawWriter::SPtr(new FiffRawWriter(m_pOutfid, m_pFiffInfo->nchan, m_iBufferSize));
+    m_pRawWriter->start();
 }
 
 
@@ -782,11 +788,18 @@ void BabyMEG::toggleRecordingFile()
 {
     //Setup writing to file
     if(m_bWriteToFile) {
+        //Stop run() from queueing buffers before the writer is released
         m_mutex.lock();
-        m_pOutfid->finish_writing_raw();
+        m_bWriteToFile = false;
+        FiffRawWriter::SPtr pRawWriter = m_pRawWriter;
+        m_pRawWriter.clear();
+        m_pOutfid.clear();
         m_mutex.unlock();
 
-        m_bWriteToFile = false;
+        if(pRawWriter) {
+            pRawWriter->finish_writing_raw();
+        }
+
         m_iSplitCount = 0;
 
         //Stop record timer
@@ -829,9 +842,13 @@ void BabyMEG::toggleRecordingFile()
         m_pOutfid = FiffStream::start_writing_raw(m_qFileOut, *m_pFiffInfo, m_cals, defaultMatrixXi, false);
         fiff_int_t first = 0;
         m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
-        m_mutex.unlock();
+
+        //The data buffers are written by a separate thread so a slow disk does not stall the acquisition
+        m_pRawWriter = FiffRawWriter::SPtr(new FiffRawWriter(m_pOutfid, m_pFiffInfo->nchan, m_iBufferSize));
+        m_pRawWriter->start();
 
         m_bWriteToFile = true;
+        m_mutex.unlock();
 
         //Start timers for record button blinking, recording timer and updating the elapsed time in the proj widget
         m_pBlinkingRecordButtonTimer->start(500);
@@ -47,6 +47,7 @@
 
 #include <fiff/fiff_info.h>
 #include <fiff/fiff_stream.h>
+#include <fiff/fiff_raw_writer.h>
 
 #include <scShared/Interfaces/ISensor.h>
 #include <utils/generics/circularmatrixbuffer.h>
@@ -337,7 +338,7 @@ protected:
 
     //=========================================================================================================
     /**
-    * Determines current file. And starts a new one.
+    * Determines current file. And starts a new one. Has to be called with m_mutex locked.
     */
     void splitRecordingFile();
 
@@ -418,6 +419,7 @@ protected:
 
     FIFFLIB::FiffInfo::SPtr                 m_pFiffInfo;                    /**< Fiff measurement info.*/
     FIFFLIB::FiffStream::SPtr               m_pOutfid;                      /**< FiffStream to write to.*/
+    FIFFLIB::FiffRawWriter::SPtr            m_pRawWriter;                   /**< Writes the raw data buffers to m_pOutfid on its own thread.*/
 
     qint16                                  m_iBlinkStatus;                 /**< The blink status of the recording button.*/
     qint32                                  m_iBufferSize;                  /**< The raw data buffer size.*/
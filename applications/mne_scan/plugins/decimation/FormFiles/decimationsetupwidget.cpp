@@ -0,0 +1,107 @@
+//=============================================================================================================
+/**
+* @file     decimationsetupwidget.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Contains the implementation of the DecimationSetupWidget class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "decimationsetupwidget.h"
+#include "../decimation.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace DECIMATIONPLUGIN;
+using namespace REALTIMELIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+DecimationSetupWidget::DecimationSetupWidget(Decimation* toolbox, QWidget *parent)
+: QWidget(parent)
+, m_pDecimation(toolbox)
+{
+    ui.setupUi(this);
+
+    ui.m_qSpinBoxFactor->setValue(m_pDecimation->m_iFactor);
+    updateOutputRate();
+
+    //Changing the factor while the plugin runs would change the rate of the connected plugins
+    ui.m_qSpinBoxFactor->setEnabled(!m_pDecimation->isRunning());
+
+    connect(ui.m_qSpinBoxFactor, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &DecimationSetupWidget::onFactorChanged);
+}
+
+
+//*************************************************************************************************************
+
+DecimationSetupWidget::~DecimationSetupWidget()
+{
+
+}
+
+
+//*************************************************************************************************************
+
+void DecimationSetupWidget::updateOutputRate()
+{
+    if(!m_pDecimation->m_pFiffInfo) {
+        ui.m_qLabelOutputRate->setText(tr("Known when data arrives"));
+        return;
+    }
+
+    double sfreq = m_pDecimation->m_pFiffInfo->sfreq;
+    RtDecimator decimator(m_pDecimation->m_iFactor);
+
+    ui.m_qLabelOutputRate->setText(tr("%1 Hz (anti-alias cutoff %2 Hz)").arg(sfreq / decimator.factor()).arg(decimator.cutoff(sfreq)));
+}
+
+
+//*************************************************************************************************************
+
+void DecimationSetupWidget::onFactorChanged(int value)
+{
+    m_pDecimation->m_iFactor = value;
+    updateOutputRate();
+}
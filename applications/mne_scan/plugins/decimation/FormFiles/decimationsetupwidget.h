@@ -0,0 +1,122 @@
+//=============================================================================================================
+/**
+* @file     decimationsetupwidget.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Contains the declaration of the DecimationSetupWidget class.
+*
+*/
+
+#ifndef DECIMATIONSETUPWIDGET_H
+#define DECIMATIONSETUPWIDGET_H
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../ui_decimationsetup.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtWidgets>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE DECIMATIONPLUGIN
+//=============================================================================================================
+
+namespace DECIMATIONPLUGIN
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class Decimation;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS DecimationSetupWidget
+*
+* @brief The DecimationSetupWidget class provides the Decimation configuration window.
+*/
+class DecimationSetupWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    //=========================================================================================================
+    /**
+    * Constructs a DecimationSetupWidget which is a child of parent.
+    *
+    * @param [in] toolbox a pointer to the corresponding Decimation.
+    * @param [in] parent pointer to parent widget; If parent is 0, the new DecimationSetupWidget becomes a window. If parent is another widget, DecimationSetupWidget becomes a child window inside parent. DecimationSetupWidget is deleted when its parent is deleted.
+    */
+    DecimationSetupWidget(Decimation* toolbox, QWidget *parent = 0);
+
+    //=========================================================================================================
+    /**
+    * Destroys the DecimationSetupWidget.
+    * All DecimationSetupWidget's children are deleted first. The application exits if DecimationSetupWidget is the main widget.
+    */
+    ~DecimationSetupWidget();
+
+    //=========================================================================================================
+    /**
+    * Shows the sampling rate and the cutoff of the output, once the sampling rate of the input is known.
+    */
+    void updateOutputRate();
+
+private:
+    //=========================================================================================================
+    /**
+    * Sets the decimation factor, it is applied when the plugin is started.
+    *
+    * @param [in] value     the new decimation factor
+    */
+    void onFactorChanged(int value);
+
+    Decimation* m_pDecimation;              /**< Holds a pointer to corresponding Decimation.*/
+
+    Ui::DecimationSetupWidgetClass ui;      /**< Holds the user interface for the DecimationSetupWidget.*/
+};
+
+} // NAMESPACE
+
+#endif // DECIMATIONSETUPWIDGET_H
@@ -0,0 +1,281 @@
+//=============================================================================================================
+/**
+* @file     decimation.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Contains the implementation of the Decimation class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "decimation.h"
+#include "FormFiles/decimationsetupwidget.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace DECIMATIONPLUGIN;
+using namespace SCSHAREDLIB;
+using namespace SCMEASLIB;
+using namespace IOBUFFER;
+using namespace REALTIMELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+Decimation::Decimation()
+: m_bIsRunning(false)
+, m_iFactor(4)
+, m_pBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pDecimationInput(NULL)
+, m_pDecimationOutput(NULL)
+{
+}
+
+
+//*************************************************************************************************************
+
+Decimation::~Decimation()
+{
+    if(this->isRunning())
+        stop();
+}
+
+
+//*************************************************************************************************************
+
+QSharedPointer<IPlugin> Decimation::clone() const
+{
+    QSharedPointer<Decimation> pDecimationClone(new Decimation);
+    return pDecimationClone;
+}
+
+
+//*************************************************************************************************************
+
+void Decimation::init()
+{
+    //
+    // Load Settings
+    //
+    QSettings settings;
+    m_iFactor = settings.value(QString("Plugin/%1/Factor").arg(this->getName()), 4).toInt();
+
+    // Input
+    m_pDecimationInput = PluginInputData<NewRealTimeMultiSampleArray>::create(this, "DecimationIn", "Decimation input data");
+    connect(m_pDecimationInput.data(), &PluginInputConnector::notify, this, &Decimation::update, Qt::DirectConnection);
+    m_inputConnectors.append(m_pDecimationInput);
+
+    // Output
+    m_pDecimationOutput = PluginOutputData<NewRealTimeMultiSampleArray>::create(this, "DecimationOut", "Decimation output data");
+    m_outputConnectors.append(m_pDecimationOutput);
+
+    //Delete Buffer - will be initailzed with first incoming data
+    if(!m_pBuffer.isNull())
+        m_pBuffer = CircularMatrixBuffer<double>::SPtr();
+}
+
+
+//*************************************************************************************************************
+
+void Decimation::unload()
+{
+    //
+    // Store Settings
+    //
+    QSettings settings;
+    settings.setValue(QString("Plugin/%1/Factor").arg(this->getName()), m_iFactor);
+}
+
+
+//*************************************************************************************************************
+
+bool Decimation::start()
+{
+    //Check if the thread is already or still running. This can happen if the start button is pressed immediately after the stop button was pressed. In this case the stopping process is not finished yet but the start process is initiated.
+    if(this->isRunning())
+        QThread::wait();
+
+    m_bIsRunning = true;
+
+    //Start thread
+    QThread::start();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool Decimation::stop()
+{
+    m_bIsRunning = false;
+
+    if(m_pBuffer) {
+        m_pBuffer->releaseFromPop();
+        m_pBuffer->releaseFromPush();
+
+        m_pBuffer->clear();
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+IPlugin::PluginType Decimation::getType() const
+{
+    return _IAlgorithm;
+}
+
+
+//*************************************************************************************************************
+
+QString Decimation::getName() const
+{
+    return "Decimation";
+}
+
+
+//*************************************************************************************************************
+
+QWidget* Decimation::setupWidget()
+{
+    DecimationSetupWidget* setupWidget = new DecimationSetupWidget(this);//widget is later distroyed by CentralWidget - so it has to be created everytime new
+    connect(this, &Decimation::fiffInfoAvailable, setupWidget, &DecimationSetupWidget::updateOutputRate);
+    return setupWidget;
+}
+
+
+//*************************************************************************************************************
+
+void Decimation::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
+{
+    QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
+
+    if(pRTMSA) {
+        //Check if buffer initialized
+        if(!m_pBuffer) {
+            m_pBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        }
+
+        //Fiff information
+        if(!m_pFiffInfo) {
+            m_pFiffInfo = pRTMSA->info();
+            emit fiffInfoAvailable();
+        }
+
+        if(m_bIsRunning) {
+            for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i)
+                m_pBuffer->push(&pRTMSA->getMultiSampleArray()[i]);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void Decimation::run()
+{
+    //
+    // Wait for Fiff Info
+    //
+    while(!m_pFiffInfo && m_bIsRunning)
+        msleep(10);// Wait for fiff Info
+
+    if(!m_bIsRunning)
+        return;
+
+    //
+    // The decimator, stimulus channels keep their pulses
+    //
+    m_pRtDecimator = RtDecimator::SPtr(new RtDecimator(m_iFactor));
+
+    QVector<int> lStimChannels;
+    for(int i = 0; i < m_pFiffInfo->chs.size(); ++i)
+        if(m_pFiffInfo->chs.at(i).kind == FIFFV_STIM_CH)
+            lStimChannels.append(i);
+    m_pRtDecimator->setStimChannels(lStimChannels);
+
+    //
+    // The output runs at the decimated rate and is band limited by the anti-alias filter
+    //
+    FiffInfo::SPtr pFiffInfoOut(new FiffInfo(*m_pFiffInfo));
+    pFiffInfoOut->sfreq = m_pFiffInfo->sfreq / m_iFactor;
+    pFiffInfoOut->lowpass = qMin(m_pFiffInfo->lowpass, (float)m_pRtDecimator->cutoff(m_pFiffInfo->sfreq));
+
+    m_pDecimationOutput->data()->initFromFiffInfo(pFiffInfoOut);
+    m_pDecimationOutput->data()->setMultiArraySize(1);
+    m_pDecimationOutput->data()->setVisibility(true);
+
+    //
+    // The decimated samples are collected into blocks of a fixed size, the input block size need not be a
+    // multiple of the factor
+    //
+    int iOutputBlockSize = qMax((int)m_pBuffer->cols() / m_iFactor, 1);
+    MatrixXd matOutput(m_pBuffer->rows(), iOutputBlockSize);
+    int iFilled = 0;
+
+    MatrixXd matData, matDecimated;
+
+    while(m_bIsRunning) {
+        //Dispatch the inputs
+        if(!m_pBuffer->pop(matData))
+            continue;
+
+        m_pRtDecimator->decimate(matData, matDecimated);
+
+        for(int j = 0; j < matDecimated.cols(); ) {
+            int n = qMin((int)matDecimated.cols() - j, iOutputBlockSize - iFilled);
+            matOutput.middleCols(iFilled, n) = matDecimated.middleCols(j, n);
+            iFilled += n;
+            j += n;
+
+            //Send the data to the connected plugins and the online display
+            if(iFilled == iOutputBlockSize) {
+                m_pDecimationOutput->data()->setValue(matOutput);
+                iFilled = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,159 @@
+//=============================================================================================================
+/**
+* @file     decimation.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Contains the declaration of the Decimation class.
+*
+*/
+
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "decimation_global.h"
+
+#include <scShared/Interfaces/IAlgorithm.h>
+#include <utils/generics/circularmatrixbuffer.h>
+#include <scMeas/newrealtimemultisamplearray.h>
+#include <realtime/rtProcessing/rtdecimator.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtWidgets>
+#include <QtCore/QtPlugin>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE DECIMATIONPLUGIN
+//=============================================================================================================
+
+namespace DECIMATIONPLUGIN
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace SCSHAREDLIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS Decimation
+*
+* @brief The Decimation class lowers the sampling rate of the incoming data by an integer factor, so that the
+*        connected plugins (display, connectivity, source estimation) only process the rate they need. The
+*        output blocks have a fixed size of input block size/factor samples.
+*/
+class DECIMATIONSHARED_EXPORT Decimation : public IAlgorithm
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "scsharedlib/1.0" FILE "decimation.json") //New Qt5 Plugin system replaces Q_EXPORT_PLUGIN2 macro
+    // Use the Q_INTERFACES() macro to tell Qt's meta-object system about the interfaces
+    Q_INTERFACES(SCSHAREDLIB::IAlgorithm)
+
+    friend class DecimationSetupWidget;
+
+public:
+    //=========================================================================================================
+    /**
+    * Constructs a Decimation.
+    */
+    Decimation();
+
+    //=========================================================================================================
+    /**
+    * Destroys the Decimation.
+    */
+    ~Decimation();
+
+    //=========================================================================================================
+    /**
+    * IAlgorithm functions
+    */
+    virtual QSharedPointer<IPlugin> clone() const;
+    virtual void init();
+    virtual void unload();
+    virtual bool start();
+    virtual bool stop();
+    virtual IPlugin::PluginType getType() const;
+    virtual QString getName() const;
+    virtual QWidget* setupWidget();
+
+    //=========================================================================================================
+    /**
+    * Udates the pugin with new (incoming) data.
+    *
+    * @param[in] pMeasurement    The incoming data in form of a generalized NewMeasurement.
+    */
+    void update(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
+
+protected:
+    //=========================================================================================================
+    /**
+    * IAlgorithm function
+    */
+    virtual void run();
+
+private:
+    bool                                            m_bIsRunning;           /**< Flag whether thread is running.*/
+    int                                             m_iFactor;              /**< The decimation factor, it is applied when the plugin is started.*/
+
+    FIFFLIB::FiffInfo::SPtr                         m_pFiffInfo;            /**< Fiff measurement info of the input.*/
+
+    IOBUFFER::CircularMatrixBuffer<double>::SPtr    m_pBuffer;              /**< Holds incoming data.*/
+    REALTIMELIB::RtDecimator::SPtr                  m_pRtDecimator;         /**< The decimator.*/
+
+    PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr      m_pDecimationInput;     /**< The NewRealTimeMultiSampleArray of the Decimation input.*/
+    PluginOutputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr     m_pDecimationOutput;    /**< The NewRealTimeMultiSampleArray of the Decimation output.*/
+
+signals:
+    //=========================================================================================================
+    /**
+    * Emitted when fiffInfo is available
+    */
+    void fiffInfoAvailable();
+};
+
+} // NAMESPACE
+
+#endif // DECIMATION_H
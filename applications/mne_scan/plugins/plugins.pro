@@ -69,6 +69,7 @@ contains(MNECPP_CONFIG, buildBasicMneScanVersion) {
         averaging \
         covariance \
         noise \
+        decimation \
         # bci \
         rtsss \
         rthpi \
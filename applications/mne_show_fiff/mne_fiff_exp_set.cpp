@@ -44,6 +44,7 @@
 
 
 #include <fiff/fiff_tag.h>
+#include <fiff/fiff_tag_view.h>
 #include <fiff/fiff_stream.h>
 
 #include <iostream>
@@ -252,6 +253,7 @@ bool MneFiffExpSet::show_fiff_contents(FILE *out, const QString &name, bool verb
 
     FiffDirEntry::SPtr this_ent;
     FiffTag::SPtr   tag;
+    FiffTagView     view;
     int             day,month,year;
     int             block;
     int             count = 0;
@@ -276,8 +278,7 @@ bool MneFiffExpSet::show_fiff_contents(FILE *out, const QString &name, bool verb
                 if (this_ent->kind == FIFF_BLOCK_START) {
                     for (int k = 0; k < indent; k++)
                         fprintf(out," ");
-                    if ( stream->read_tag(tag, this_ent->pos) ) {
-                        block = *tag->toInt();
+                    if ( stream->read_tag_view(view, this_ent->pos) && view.size == (fiff_int_t)sizeof(block) && view.copy_data((char*)&block) ) {
                         exp = this->find_fiff_explanation(CLASS_BLOCK,block);
                         if (exp != this->constEnd())
                             fprintf(out,"%-d = %-s\n",exp->kind,exp->text.toUtf8().constData());
@@ -322,8 +323,7 @@ bool MneFiffExpSet::show_fiff_contents(FILE *out, const QString &name, bool verb
                         fprintf(out,"%4d = %-s",exp->kind,exp->text.toUtf8().constData());
                     else
                         fprintf(out,"%4d = %-s",this_ent->kind,"Not explained");
-                    if ( stream->read_tag(tag,this_ent->pos)) {
-                        block = *tag->toInt();
+                    if ( stream->read_tag_view(view, this_ent->pos) && view.size == (fiff_int_t)sizeof(block) && view.copy_data((char*)&block) ) {
                         exp = this->find_fiff_explanation(CLASS_BLOCK,block);
                         if (exp != this->constEnd())
                             fprintf(out,"\t%-d = %-s",exp->kind,exp->text.toUtf8().constData());
@@ -436,6 +436,7 @@ int main(int argc, char *argv[])
             }
 
             epoch->event = event;
+            epoch->sample = event_samp;
             epoch->tmin = ((float)(from)-(float)(raw.first_samp))/raw.info.sfreq;
             epoch->tmax = ((float)(to)-(float)(raw.first_samp))/raw.info.sfreq;
 
@@ -38,7 +38,7 @@ include(../../mne-cpp.pri)
 
 TEMPLATE = lib
 
-QT += network
+QT += network concurrent
 QT -= gui
 
 DEFINES += FIFF_LIBRARY
@@ -86,6 +86,7 @@ SOURCES += fiff.cpp \
     fiff_proj.cpp \
     fiff_named_matrix.cpp \
     fiff_raw_data.cpp \
+    fiff_raw_codec.cpp \
     fiff_ctf_comp.cpp \
     fiff_id.cpp \
     fiff_info.cpp \
@@ -101,6 +102,11 @@ SOURCES += fiff.cpp \
     fiff_io.cpp \
     fiff_dig_point_set.cpp \
     fiff_dir_node.cpp \
+    fiff_tag_view.cpp \
+    fiff_raw_writer.cpp \
+    fiff_tag_iterator.cpp \
+    fiff_tag_parser.cpp \
+    fiff_raw_resampler.cpp \
     c/fiff_coord_trans_old.cpp \
     c/fiff_sparse_matrix.cpp \
     c/fiff_digitizer_data.cpp \
@@ -121,6 +127,7 @@ HEADERS += fiff.h \
     fiff_ctf_comp.h \
     fiff_info.h \
     fiff_raw_data.h \
+    fiff_raw_codec.h \
     fiff_dir_entry.h \
     fiff_raw_dir.h \
     fiff_dig_point.h \
@@ -133,6 +140,11 @@ HEADERS += fiff.h \
     fiff_io.h \
     fiff_dig_point_set.h \
     fiff_dir_node.h \
+    fiff_tag_view.h \
+    fiff_raw_writer.h \
+    fiff_tag_iterator.h \
+    fiff_tag_parser.h \
+    fiff_raw_resampler.h \
     c/fiff_coord_trans_old.h \
     c/fiff_sparse_matrix.h \
     c/fiff_types_mne-c.h \
@@ -319,6 +319,7 @@ namespace FIFFLIB
     //
 #define FIFFB_MNE_CTF_COMP           370
 #define FIFFB_MNE_CTF_COMP_DATA      371
+#define FIFFB_MNE_EPOCHS             373
     ////
     // Fiff tags associated with MNE computations (3500...)
     //
@@ -494,7 +494,7 @@ bool FiffEvoked::read(QIODevice& p_IODevice, FiffEvoked& p_FiffEvoked, QVariant
 
 //*************************************************************************************************************
 
-void FiffEvoked::setInfo(FiffInfo &p_info, bool proj)
+void FiffEvoked::setInfo(const FiffInfo &p_info, bool proj)
 {
     info = p_info;
     //
@@ -206,7 +206,7 @@ public:
     * @param[in] p_info     Info to set
     * @param[in] proj       Apply SSP projection vectors (optional, default = true)
     */
-    void setInfo(FiffInfo &p_info, bool proj = true);
+    void setInfo(const FiffInfo &p_info, bool proj = true);
 
     //=========================================================================================================
     /**
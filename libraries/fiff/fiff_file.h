@@ -116,6 +116,8 @@ namespace FIFFLIB
 *   FIFFT_COMPLEX_FLOAT        20       Complex number encoded with floats
 *   FIFFT_COMPLEX_DOUBLE       21       Complex number encoded with doubles
 *   FIFFT_OLD_PACK             23       Neuromag proprietary 16 bit packing.
+*   FIFFT_INT_DELTA_RICE       24       Lossless delta + Rice coded 32 bit integers (MNE-CPP, see FiffRawCodec).
+*                                       Not part of the FIFF standard, files using it can only be read by MNE-CPP.
 *
 * Following are structure types defined in fiff_types.h
 *
@@ -245,6 +247,7 @@ namespace FIFFLIB
 #define FIFFT_COMPLEX_FLOAT        20
 #define FIFFT_COMPLEX_DOUBLE       21
 #define FIFFT_OLD_PACK             23
+#define FIFFT_INT_DELTA_RICE       24     /**< MNE-CPP only, see FiffStream::start_writing_raw */
 #define FIFFT_CH_INFO_STRUCT       30
 #define FIFFT_ID_STRUCT            31
 #define FIFFT_DIR_ENTRY_STRUCT     32
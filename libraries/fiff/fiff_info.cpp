@@ -80,22 +80,15 @@ FiffInfo::FiffInfo(const FiffInfo& p_FiffInfo)
 , highpass(p_FiffInfo.highpass)
 , lowpass(p_FiffInfo.lowpass)
 , dev_ctf_t(p_FiffInfo.dev_ctf_t)
+, dig(p_FiffInfo.dig)
 , dig_trans(p_FiffInfo.dig_trans)
+, projs(p_FiffInfo.projs)
+, comps(p_FiffInfo.comps)
 , acq_pars(p_FiffInfo.acq_pars)
 , acq_stim(p_FiffInfo.acq_stim)
 {
     meas_date[0] = p_FiffInfo.meas_date[0];
     meas_date[1] = p_FiffInfo.meas_date[1];
-
-    qint32 i;
-    for(i = 0; i < p_FiffInfo.dig.size(); ++i)
-        dig.append(FiffDigPoint(p_FiffInfo.dig[i]));
-
-    for(i = 0; i < p_FiffInfo.projs.size(); ++i)
-        projs.append(p_FiffInfo.projs[i]);
-
-    for(i = 0; i < p_FiffInfo.comps.size(); ++i)
-        comps.append(p_FiffInfo.comps[i]);
 }
 
 
@@ -332,19 +325,16 @@ FiffInfo FiffInfo::pick_info(const RowVectorXi &sel) const
 
 QList<FiffChInfo> FiffInfo::set_current_comp(QList<FiffChInfo>& chs, fiff_int_t value)
 {
-    QList<FiffChInfo> new_chs;
+    QList<FiffChInfo> new_chs = chs;
     qint32 k;
     fiff_int_t coil_type;
 
-    for(k = 0; k < chs.size(); ++k)
-        new_chs.append(chs[k]);
-
     qint32 lower_half = 65535;// hex2dec('FFFF');
     for (k = 0; k < chs.size(); ++k)
     {
-        if (chs[k].kind == FIFFV_MEG_CH)
+        if (chs.at(k).kind == FIFFV_MEG_CH)
         {
-            coil_type = chs[k].chpos.coil_type & lower_half;
+            coil_type = chs.at(k).chpos.coil_type & lower_half;
             new_chs[k].chpos.coil_type = (coil_type | (value << 16));
         }
     }
@@ -91,6 +91,9 @@ class FiffStream;
 /**
 * Provides fiff measurement file information
 *
+* Like the channel list of FiffInfoBase, the digitizer points, projectors and compensators are implicitly shared,
+* so copying an info does not allocate until one of the copies is modified.
+*
 * @brief FIFF measurement file information
 */
 class FIFFSHARED_EXPORT FiffInfo : public FiffInfoBase
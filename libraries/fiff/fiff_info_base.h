@@ -80,6 +80,9 @@ namespace FIFFLIB
 /**
 * Light measurement info -> ToDo transform this to FiffInfo base class for FiffInfo
 *
+* Copies are cheap: the channel list and the name lists are implicitly shared and only copied when one of the
+* infos modifies them. Read them through const references or at() to keep them shared.
+*
 * @brief light measurement info
 */
 class FIFFSHARED_EXPORT FiffInfoBase
@@ -113,10 +113,10 @@ FiffProj::~FiffProj()
 
 void FiffProj::activate_projs(QList<FiffProj> &p_qListFiffProj)
 {
-    // Activate the projection items
-    QList<FiffProj>::Iterator it;
-    for(it = p_qListFiffProj.begin(); it != p_qListFiffProj.end(); ++it)
-        it->active = true;
+    // Activate the projection items, a shared list is only detached if there is something to activate
+    for(qint32 i = 0; i < p_qListFiffProj.size(); ++i)
+        if(!p_qListFiffProj.at(i).active)
+            p_qListFiffProj[i].active = true;
 
     printf("\t%d projection items activated.\n", p_qListFiffProj.size());
 }
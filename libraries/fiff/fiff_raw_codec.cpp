@@ -0,0 +1,336 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_codec.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffRawCodec Class.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_codec.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QtEndian>
+#include <QtAlgorithms>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE STATIC METHODS
+//=============================================================================================================
+
+//
+//   Unary codes of this length are escapes, followed by the verbatim 32 bit value
+//
+#define RICE_ESCAPE     24
+
+#define CHANNEL_HEADER_SIZE 9
+
+
+//*************************************************************************************************************
+
+static inline quint32 zigzag(quint32 diff)
+{
+    return (diff << 1) ^ (0u - (diff >> 31));
+}
+
+
+//*************************************************************************************************************
+
+static inline quint32 unzigzag(quint32 value)
+{
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+
+//*************************************************************************************************************
+
+/**
+* Collects bits MSB first.
+*/
+class RiceBitWriter
+{
+public:
+    RiceBitWriter(uchar* out)
+    : m_pOut(out)
+    , m_iAcc(0)
+    , m_iBits(0)
+    {
+    }
+
+    inline void put(quint32 value, qint32 nbits)
+    {
+        if(nbits == 0)
+            return;
+        m_iAcc = (m_iAcc << nbits) | (value & (quint32)(((quint64)1 << nbits) - 1));
+        m_iBits += nbits;
+        while(m_iBits >= 8) {
+            m_iBits -= 8;
+            *m_pOut++ = (uchar)(m_iAcc >> m_iBits);
+        }
+    }
+
+    inline uchar* flush()
+    {
+        if(m_iBits > 0)
+            *m_pOut++ = (uchar)(m_iAcc << (8 - m_iBits));
+        m_iBits = 0;
+        return m_pOut;
+    }
+
+private:
+    uchar*  m_pOut;
+    quint64 m_iAcc;
+    qint32  m_iBits;
+};
+
+
+//*************************************************************************************************************
+
+/**
+* Reads bits MSB first. The valid bits are kept at the top of the accumulator; reading past the end yields
+* zeros, which is detected with consumed().
+*/
+class RiceBitReader
+{
+public:
+    RiceBitReader(const uchar* in, const uchar* end)
+    : m_pIn(in)
+    , m_pBegin(in)
+    , m_pEnd(end)
+    , m_iAcc(0)
+    , m_iBits(0)
+    {
+    }
+
+    inline void refill()
+    {
+        while(m_iBits <= 56) {
+            quint64 byte = m_pIn < m_pEnd ? *m_pIn : 0;
+            ++m_pIn;
+            m_iAcc |= byte << (56 - m_iBits);
+            m_iBits += 8;
+        }
+    }
+
+    inline quint32 leading_ones() const
+    {
+        return (quint32)qCountLeadingZeroBits(~m_iAcc);
+    }
+
+    inline void skip(qint32 nbits)
+    {
+        m_iAcc <<= nbits;
+        m_iBits -= nbits;
+    }
+
+    inline quint32 get(qint32 nbits)
+    {
+        if(nbits == 0)
+            return 0;
+        quint32 value = (quint32)(m_iAcc >> (64 - nbits));
+        skip(nbits);
+        return value;
+    }
+
+    inline qint64 consumed() const
+    {
+        return (qint64)(m_pIn - m_pBegin)*8 - m_iBits;
+    }
+
+private:
+    const uchar*    m_pIn;
+    const uchar*    m_pBegin;
+    const uchar*    m_pEnd;
+    quint64         m_iAcc;
+    qint32          m_iBits;
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+qint64 FiffRawCodec::max_encoded_size(qint32 nchan, qint32 nsamp)
+{
+    //
+    //   Worst case: every difference is escaped
+    //
+    qint64 maxBits = (qint64)(nsamp > 1 ? nsamp - 1 : 0) * (RICE_ESCAPE + 32);
+    return HeaderSize + (qint64)nchan * (CHANNEL_HEADER_SIZE + (maxBits + 7) / 8);
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawCodec::encode_buffer(const qint32* src, qint32 nchan, qint32 nsamp, char* dest)
+{
+    uchar* out = (uchar*)dest;
+    qToBigEndian<qint32>(nchan, out);
+    qToBigEndian<qint32>(nsamp, out + 4);
+    out += HeaderSize;
+
+    if(nsamp <= 0)
+        return out - (uchar*)dest;
+
+    for(qint32 ch = 0; ch < nchan; ++ch) {
+        const qint32* p = src + ch;
+
+        //
+        //   Pick the Rice parameter from the mean magnitude of the differences
+        //
+        quint64 sum = 0;
+        quint32 prev = (quint32)p[0];
+        for(qint32 s = 1; s < nsamp; ++s) {
+            quint32 cur = (quint32)p[(qint64)s*nchan];
+            sum += zigzag(cur - prev);
+            prev = cur;
+        }
+        quint64 n = (quint64)(nsamp - 1);
+        qint32 k = 0;
+        while(k < 31 && (n << (k + 1)) <= sum)
+            ++k;
+
+        uchar* head = out;
+        head[0] = (uchar)k;
+        qToBigEndian<qint32>(p[0], head + 1);
+
+        RiceBitWriter writer(head + CHANNEL_HEADER_SIZE);
+        prev = (quint32)p[0];
+        for(qint32 s = 1; s < nsamp; ++s) {
+            quint32 cur = (quint32)p[(qint64)s*nchan];
+            quint32 value = zigzag(cur - prev);
+            prev = cur;
+
+            quint32 q = value >> k;
+            if(q < RICE_ESCAPE) {
+                writer.put(((1u << q) - 1) << 1, q + 1);
+                writer.put(value, k);
+            }
+            else {
+                writer.put((1u << RICE_ESCAPE) - 1, RICE_ESCAPE);
+                writer.put(value, 32);
+            }
+        }
+        out = writer.flush();
+
+        qToBigEndian<qint32>((qint32)(out - head - CHANNEL_HEADER_SIZE), head + 5);
+    }
+
+    return out - (uchar*)dest;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawCodec::decode_buffer(const char* src, qint64 size, qint32* dest, qint32 nchan, qint32 nsamp)
+{
+    if(size < HeaderSize)
+        return false;
+
+    qint32 t_nchan, t_nsamp;
+    read_header(src, t_nchan, t_nsamp);
+    if(t_nchan != nchan || t_nsamp != nsamp)
+        return false;
+
+    const uchar* in = (const uchar*)src + HeaderSize;
+    const uchar* end = (const uchar*)src + size;
+
+    if(nsamp <= 0)
+        return true;
+
+    for(qint32 ch = 0; ch < nchan; ++ch) {
+        if(end - in < CHANNEL_HEADER_SIZE)
+            return false;
+
+        qint32 k = in[0];
+        qint32 nbytes = qFromBigEndian<qint32>(in + 5);
+        if(k > 31 || nbytes < 0 || nbytes > end - in - CHANNEL_HEADER_SIZE)
+            return false;
+
+        qint32* p = dest + ch;
+        quint32 prev = (quint32)qFromBigEndian<qint32>(in + 1);
+        p[0] = (qint32)prev;
+
+        const uchar* bits = in + CHANNEL_HEADER_SIZE;
+        RiceBitReader reader(bits, bits + nbytes);
+        for(qint32 s = 1; s < nsamp; ++s) {
+            reader.refill();
+
+            quint32 value;
+            quint32 q = reader.leading_ones();
+            if(q >= RICE_ESCAPE) {
+                reader.skip(RICE_ESCAPE);
+                value = reader.get(32);
+            }
+            else {
+                reader.skip(q + 1);
+                value = (q << k) | reader.get(k);
+            }
+
+            prev += unzigzag(value);
+            p[(qint64)s*nchan] = (qint32)prev;
+        }
+
+        if(reader.consumed() > (qint64)nbytes*8)
+            return false;
+
+        in = bits + nbytes;
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawCodec::read_header(const char* src, qint32& nchan, qint32& nsamp)
+{
+    nchan = qFromBigEndian<qint32>((const uchar*)src);
+    nsamp = qFromBigEndian<qint32>((const uchar*)src + 4);
+}
@@ -0,0 +1,132 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_codec.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawCodec class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_CODEC_H
+#define FIFF_RAW_CODEC_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//=============================================================================================================
+/**
+* Lossless codec for integer raw data buffers (tag type FIFFT_INT_DELTA_RICE). Each channel of a buffer is
+* delta coded over time and the zigzag mapped differences are Rice coded with a per channel parameter. Large
+* differences are escaped and stored verbatim, so any 32 bit input round trips exactly.
+*
+* Payload layout (all integers big endian):
+*   nchan, nsamp                                    2 x int32
+*   per channel: k, first sample, nbytes, bits      uint8, int32, int32, nbytes of Rice coded differences
+*
+* Channels are independent of each other and buffers are independent of each other; buffers are decoded in
+* parallel by FiffRawData::read_raw_segment. The format is an MNE-CPP extension and is not understood by other
+* FIFF readers, FiffStream::start_writing_raw therefore only writes it when asked to explicitly.
+*
+* The codec is lossless with respect to FIFFT_INT storage only: floating point samples are scaled and rounded
+* to integers by FiffStream exactly as for FIFFT_INT before they reach the codec.
+*
+* @brief Delta + Rice codec for raw data buffers
+*/
+class FIFFSHARED_EXPORT FiffRawCodec
+{
+public:
+    static const qint32 HeaderSize = 8;     /**< Size of the buffer header in bytes */
+
+    //=========================================================================================================
+    /**
+    * Returns an upper bound of the encoded size of a buffer.
+    *
+    * @param[in] nchan      Number of channels
+    * @param[in] nsamp      Number of samples
+    *
+    * @return the maximal number of bytes encode_buffer writes
+    */
+    static qint64 max_encoded_size(qint32 nchan, qint32 nsamp);
+
+    //=========================================================================================================
+    /**
+    * Encodes a buffer. The samples are stored one after the other, all channels of a sample together (like the
+    * payload of an uncompressed data buffer), in native byte order.
+    *
+    * @param[in] src        The samples (nchan x nsamp, column major)
+    * @param[in] nchan      Number of channels
+    * @param[in] nsamp      Number of samples
+    * @param[out] dest      Destination, has to provide max_encoded_size bytes
+    *
+    * @return the number of bytes written
+    */
+    static qint64 encode_buffer(const qint32* src, qint32 nchan, qint32 nsamp, char* dest);
+
+    //=========================================================================================================
+    /**
+    * Decodes a buffer written by encode_buffer.
+    *
+    * @param[in] src        The encoded payload
+    * @param[in] size       Size of the payload in bytes
+    * @param[out] dest      Destination for nchan x nsamp samples (column major, native byte order)
+    * @param[in] nchan      Expected number of channels
+    * @param[in] nsamp      Expected number of samples
+    *
+    * @return true if succeeded, false if the payload is damaged or does not match the dimensions
+    */
+    static bool decode_buffer(const char* src, qint64 size, qint32* dest, qint32 nchan, qint32 nsamp);
+
+    //=========================================================================================================
+    /**
+    * Reads the dimensions of an encoded buffer from its header.
+    *
+    * @param[in] src        The first HeaderSize bytes of the payload
+    * @param[out] nchan     Number of channels
+    * @param[out] nsamp     Number of samples
+    */
+    static void read_header(const char* src, qint32& nchan, qint32& nsamp);
+};
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_CODEC_H
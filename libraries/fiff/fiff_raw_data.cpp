@@ -40,9 +40,28 @@
 
 #include "fiff_raw_data.h"
 #include "fiff_tag.h"
+#include "fiff_tag_view.h"
 #include "fiff_stream.h"
+#include "fiff_raw_codec.h"
 #include "cstdlib"
 
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <algorithm>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QThread>
+#include <QtConcurrent>
+
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -51,6 +70,39 @@
 using namespace FIFFLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE LOCAL TYPES
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* One data buffer of a segment, which is decoded, calibrated and projected on the thread pool.
+*/
+template<typename T>
+struct RawBufferJob
+{
+    qint32 rawdir_idx;                                      /**< Index of the buffer in rawdir. */
+    FiffTagView view;                                       /**< The buffer tag as read from file. The payload is big endian. */
+    QByteArray baRaw;                                       /**< The payload if the file is not memory mapped, reused by the following batches. */
+    FiffTag::SPtr pScratch;                                 /**< The decode target of this job, reused by the following batches. */
+    FiffTag::SPtr pDecoded;                                 /**< The decoded buffer, either from the cache or decoded from view. */
+    bool bDecode;                                           /**< Whether view has to be decoded into pDecoded. */
+    Matrix<typename T::Scalar,Dynamic,Dynamic> matPicked;   /**< The buffer in output precision the operator is applied to, reused by the following batches. */
+    fiff_int_t nsamp;                                       /**< Number of samples in the buffer. */
+    fiff_int_t first_pick;                                  /**< First sample of the buffer to use. */
+    fiff_int_t picksamp;                                    /**< Number of samples to use. */
+    qint32 dest;                                            /**< First output column. */
+
+    T* pData;                                               /**< The output matrix. */
+    qint32 nchan;                                           /**< Number of channels stored in the buffer. */
+    const SparseMatrix<typename T::Scalar>* pMult;          /**< Compensation/projection/calibration operator, empty if not applied. */
+    const VectorXi* pRowSel;                                /**< Stored channel of each output row, if no operator is applied. */
+    const Matrix<typename T::Scalar,Dynamic,1>* pRowCal;    /**< Calibration of each output row, if no operator is applied. */
+    bool bOk;                                               /**< Whether the buffer could be decoded. */
+};
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -59,6 +111,11 @@ using namespace FIFFLIB;
 FiffRawData::FiffRawData()
 : first_samp(-1)
 , last_samp(-1)
+, m_bMemoryMapped(false)
+, m_iBufferCacheHits(0)
+, m_iBufferCacheMisses(0)
+, m_bMultValid(false)
+, m_iMultCompKind(-1)
 {
 
 }
@@ -69,6 +126,11 @@ FiffRawData::FiffRawData()
 FiffRawData::FiffRawData(QIODevice &p_IODevice)
 : first_samp(-1)
 , last_samp(-1)
+, m_bMemoryMapped(false)
+, m_iBufferCacheHits(0)
+, m_iBufferCacheMisses(0)
+, m_bMultValid(false)
+, m_iMultCompKind(-1)
 {
     //setup FiffRawData object
     if(!FiffStream::setup_read_raw(p_IODevice, *this))
@@ -84,6 +146,7 @@ FiffRawData::FiffRawData(QIODevice &p_IODevice)
 
 FiffRawData::FiffRawData(const FiffRawData &p_FiffRawData)
 : file(p_FiffRawData.file)
+, files(p_FiffRawData.files)
 , info(p_FiffRawData.info)
 , first_samp(p_FiffRawData.first_samp)
 , last_samp(p_FiffRawData.last_samp)
@@ -91,7 +154,24 @@ FiffRawData::FiffRawData(const FiffRawData &p_FiffRawData)
 , rawdir(p_FiffRawData.rawdir)
 , proj(p_FiffRawData.proj)
 , comp(p_FiffRawData.comp)
+, m_bMemoryMapped(p_FiffRawData.m_bMemoryMapped)
+, m_vecRawdirLast(p_FiffRawData.m_vecRawdirLast)
+, m_iBufferCacheHits(0)
+, m_iBufferCacheMisses(0)
+, m_bMultValid(p_FiffRawData.m_bMultValid)
+, m_matCal(p_FiffRawData.m_matCal)
+, m_matMult(p_FiffRawData.m_matMult)
+, m_matMultF(p_FiffRawData.m_matMultF)
+, m_vecMultSel(p_FiffRawData.m_vecMultSel)
+, m_vecMultCals(p_FiffRawData.m_vecMultCals)
+, m_matMultProj(p_FiffRawData.m_matMultProj)
+, m_iMultCompKind(p_FiffRawData.m_iMultCompKind)
+, m_matMultComp(p_FiffRawData.m_matMultComp)
 {
+    //
+    //  The copy gets its own, empty cache
+    //
+    this->setBufferCacheSize(p_FiffRawData.bufferCacheSize());
 
 }
 
@@ -108,49 +188,168 @@ FiffRawData::~FiffRawData()
 
 void FiffRawData::clear()
 {
+    files.clear();
     info.clear();
     first_samp = -1;
     last_samp = -1;
     cals = RowVectorXd();
     rawdir.clear();
+    m_vecRawdirLast.clear();
     proj = MatrixXd();
     comp.clear();
+    m_bMultValid = false;
+    clearBufferCache();
 }
 
 
 //*************************************************************************************************************
 
-bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel, bool do_debug)
+void FiffRawData::setMemoryMapped(bool bMemoryMapped)
 {
-    bool projAvailable = true;
+    m_bMemoryMapped = bMemoryMapped;
 
-    if (this->proj.size() == 0)
-        projAvailable = false;
+    if(!m_bMemoryMapped) {
+        if(this->file)
+            this->file->unmap();
+        for(qint32 i = 0; i < this->files.size(); ++i)
+            this->files[i]->unmap();
+    }
+}
 
-    if(from == -1)
-        from = this->first_samp;
-    if(to == -1)
-        to = this->last_samp;
-    //
-    //  Initial checks
-    //
-    if(from < this->first_samp)
-        from = this->first_samp;
-    if(to > this->last_samp)
-        to = this->last_samp;
-    //
-    if(from > to)
+
+//*************************************************************************************************************
+
+bool FiffRawData::isMemoryMapped() const
+{
+    return m_bMemoryMapped;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawData::setBufferCacheSize(qint32 iMaxBytes)
+{
+    if (iMaxBytes <= 0)
+        m_pBufferCache.clear();
+    else if (!m_pBufferCache)
+        m_pBufferCache = QSharedPointer<QCache<qint32, FiffTag::SPtr> >(new QCache<qint32, FiffTag::SPtr>(iMaxBytes));
+    else
+        m_pBufferCache->setMaxCost(iMaxBytes);
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawData::bufferCacheSize() const
+{
+    return m_pBufferCache ? m_pBufferCache->maxCost() : 0;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawData::bufferCacheHits() const
+{
+    return m_iBufferCacheHits;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawData::bufferCacheMisses() const
+{
+    return m_iBufferCacheMisses;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawData::clearBufferCache()
+{
+    if (m_pBufferCache)
+        m_pBufferCache->clear();
+    m_iBufferCacheHits = 0;
+    m_iBufferCacheMisses = 0;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawData::build_rawdir_index()
+{
+    if (m_pBufferCache)
+        m_pBufferCache->clear();
+
+    m_vecRawdirLast.resize(this->rawdir.size());
+    for(qint32 k = 0; k < this->rawdir.size(); ++k)
+        m_vecRawdirLast[k] = this->rawdir[k].last;
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawData::find_rawdir_entry(fiff_int_t sample) const
+{
+    if(sample < this->first_samp || sample > this->last_samp)
+        return -1;
+
+    if(m_vecRawdirLast.size() != this->rawdir.size())
     {
-        printf("No data in this range\n");
-        return false;
+        //
+        //  Index is out of date (rawdir was changed by hand) -> linear search
+        //
+        for(qint32 k = 0; k < this->rawdir.size(); ++k)
+            if(this->rawdir[k].last >= sample)
+                return k;
+        return -1;
     }
-    printf("Reading %d ... %d  =  %9.3f ... %9.3f secs...", from, to, ((float)from)/this->info.sfreq, ((float)to)/this->info.sfreq);
+
     //
-    //  Initialize the data and calibration vector
+    //  The buffers are sorted by sample -> first buffer whose last sample is not before the requested one
+    //
+    QVector<fiff_int_t>::const_iterator it = std::lower_bound(m_vecRawdirLast.constBegin(), m_vecRawdirLast.constEnd(), sample);
+    if(it == m_vecRawdirLast.constEnd())
+        return -1;
+
+    return (qint32)(it - m_vecRawdirLast.constBegin());
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+static bool same_matrix(const T& a, const T& b)
+{
+    return a.rows() == b.rows() && a.cols() == b.cols() && (a.size() == 0 || a == b);
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawData::make_mult(const RowVectorXi& sel)
+{
     //
+    //  Keep the operators of the previous read unless the selection, the calibration, the projector or
+    //  the compensator changed. The comparison is O(nchan^2), rebuilding is O(nchan^3).
+    //
+    if (m_bMultValid
+            && same_matrix(m_vecMultSel, sel)
+            && same_matrix(m_vecMultCals, this->cals)
+            && same_matrix(m_matMultProj, this->proj)
+            && m_iMultCompKind == this->comp.kind
+            && (this->comp.kind == -1 || same_matrix(m_matMultComp, this->comp.data->data)))
+        return;
+
+    SparseMatrix<double>& cal = m_matCal;
+    SparseMatrix<double>& mult = m_matMult;
+
+    bool projAvailable = true;
+
+    if (this->proj.size() == 0)
+        projAvailable = false;
+
     qint32 nchan = this->info.nchan;
-    qint32 dest  = 0;//1;
-    qint32 i, k, r;
+    qint32 i, k;
 
     typedef Eigen::Triplet<double> T;
     std::vector<T> tripletList;
@@ -158,7 +357,7 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
     for(i = 0; i < nchan; ++i)
         tripletList.push_back(T(i, i, this->cals[i]));
 
-    SparseMatrix<double> cal(nchan, nchan);
+    cal = SparseMatrix<double>(nchan, nchan);
     cal.setFromTriplets(tripletList.begin(), tripletList.end());
 //    cal.makeCompressed();
 
@@ -166,8 +365,6 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
     //
     if (sel.size() == 0)
     {
-        data = MatrixXd(nchan, to-from+1);
-//            data->setZero();
         if (projAvailable || this->comp.kind != -1)
         {
             if (!projAvailable)
@@ -180,9 +377,6 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
     }
     else
     {
-        data = MatrixXd(sel.size(),to-from+1);
-//            data->setZero();
-
         MatrixXd selVect(sel.size(), nchan);
 
         selVect.setZero();
@@ -233,205 +427,301 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
             if(mult_full(i,k) != 0)
                 tripletList.push_back(T(i, k, mult_full(i,k)));
 
-    SparseMatrix<double> mult(mult_full.rows(),mult_full.cols());
+    mult = SparseMatrix<double>(mult_full.rows(),mult_full.cols());
     if(tripletList.size() > 0)
         mult.setFromTriplets(tripletList.begin(), tripletList.end());
 //    mult.makeCompressed();
 
-    //
+    m_matMultF = mult.cast<float>();
+
+    m_vecMultSel = sel;
+    m_vecMultCals = this->cals;
+    m_matMultProj = this->proj;
+    m_iMultCompKind = this->comp.kind;
+    m_matMultComp = this->comp.kind == -1 ? MatrixXd() : this->comp.data->data;
+    m_bMultValid = true;
+}
+
+
+//*************************************************************************************************************
 
+FiffStream::SPtr FiffRawData::open_raw_stream(qint32 file_idx)
+{
     FiffStream::SPtr fid;
-    if (!this->file->device()->isOpen())
+    if (file_idx == 0)
+        fid = this->file;
+    else if (file_idx > 0 && file_idx < this->files.size())
+        fid = this->files[file_idx];
+
+    if (!fid)
+        return FiffStream::SPtr();
+
+    if (!fid->device()->isOpen())
     {
-        if (!this->file->device()->open(QIODevice::ReadOnly))
+        if (!fid->device()->open(QIODevice::ReadOnly))
         {
-            printf("Cannot open file %s",this->info.filename.toUtf8().constData());
+            printf("Cannot open file %s\n",fid->streamName().toUtf8().constData());
+            return FiffStream::SPtr();
+        }
+    }
+
+    if (m_bMemoryMapped && !fid->isMapped())
+        fid->map();
+
+    return fid;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel, bool do_debug)
+{
+    SparseMatrix<double> multSegment;
+    return this->read_raw_segment(data, times, multSegment, from, to, sel, do_debug);
+}
+
+
+//*************************************************************************************************************
+
+template<typename Scalar>
+static void make_row_cal(const RowVectorXd& cals, const RowVectorXi& sel, qint32 nchan, VectorXi& rowSel, Matrix<Scalar,Dynamic,1>& rowCal)
+{
+    qint32 nrow = sel.size() == 0 ? nchan : sel.size();
+
+    rowSel.resize(nrow);
+    rowCal.resize(nrow);
+    for(qint32 r = 0; r < nrow; ++r)
+    {
+        rowSel[r] = sel.size() == 0 ? r : sel[r];
+        rowCal[r] = (Scalar)cals[rowSel[r]];
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename S, typename T>
+static void calibrate_raw_buffer(const S* src, qint32 nchan, fiff_int_t nsamp, fiff_int_t first_pick, fiff_int_t picksamp,
+                                 const SparseMatrix<typename T::Scalar>& mult, const VectorXi& rowSel,
+                                 const Matrix<typename T::Scalar,Dynamic,1>& rowCal, Matrix<typename T::Scalar,Dynamic,Dynamic>& picked,
+                                 T& data, qint32 dest)
+{
+    typedef typename T::Scalar Scalar;
+
+    if (mult.cols() == 0)
+    {
+        //
+        //  Calibration and selection only -> straight into the output
+        //
+        for(fiff_int_t c = 0; c < picksamp; ++c)
+        {
+            const S* col = src + (qint64)(first_pick + c)*nchan;
+            for(qint32 r = 0; r < rowSel.size(); ++r)
+                data(r, dest + c) = rowCal[r]*(Scalar)col[rowSel[r]];
         }
-        fid = this->file;
     }
     else
     {
-        fid = this->file;
+        //
+        //  The whole buffer is converted, so that the size of picked does not change with the picked samples
+        //
+        picked = Map< const Matrix<S,Dynamic,Dynamic> >(src, nchan, nsamp).template cast<Scalar>();
+        data.middleCols(dest, picksamp).noalias() = mult*picked.middleCols(first_pick, picksamp);
     }
+}
+
+
+//*************************************************************************************************************
 
-    MatrixXd one;
-    fiff_int_t first_pick, last_pick, picksamp;
-    for(k = 0; k < this->rawdir.size(); ++k)
+template<typename T>
+static void decode_raw_buffer(RawBufferJob<T>& job)
+{
+    if (job.bDecode)
     {
-        FiffRawDir thisRawDir = this->rawdir[k];
+        if (job.view.isEmpty())
+        {
+            //
+            //  Skip is translated to zeros
+            //
+            job.pData->middleCols(job.dest, job.picksamp).setZero();
+            job.bOk = true;
+            return;
+        }
+
+        const FiffTagView& view = job.view;
+
         //
-        //  Do we need this buffer
+        //  Decode into the scratch tag of the job, its storage is kept for the next batch
         //
-        if (thisRawDir.last > from)
+        job.pDecoded = job.pScratch;
+        job.pDecoded->kind = view.kind;
+        if (view.type == FIFFT_INT_DELTA_RICE)
         {
-            if (thisRawDir.ent->kind == -1)
+            //
+            //  Decompressed buffers are kept (and cached) as plain integer buffers
+            //
+            job.pDecoded->type = FIFFT_INT;
+            job.pDecoded->resize(4*job.nchan*job.nsamp);
+            if (!FiffRawCodec::decode_buffer(view.data, view.size, (qint32*)job.pDecoded->data(), job.nchan, job.nsamp))
             {
-                //
-                //  Take the easy route: skip is translated to zeros
-                //
-                if(do_debug)
-                    printf("S");
-                if (sel.cols() <= 0)
-                    one.resize(nchan,thisRawDir.nsamp);
-                else
-                    one.resize(sel.cols(),thisRawDir.nsamp);
+                job.pDecoded->type = FIFFT_INT_DELTA_RICE;
+                job.bOk = false;
+                return;
+            }
+        }
+        else
+        {
+            job.pDecoded->type = view.type;
+            job.pDecoded->resize(view.size);
+            view.copy_data(job.pDecoded->data());
+        }
+    }
+
+    const FiffTag& decoded = *job.pDecoded;
+
+    job.bOk = true;
+    if (decoded.type == FIFFT_DAU_PACK16)
+        calibrate_raw_buffer((const qint16*)decoded.constData(), job.nchan, job.nsamp, job.first_pick, job.picksamp, *job.pMult, *job.pRowSel, *job.pRowCal, job.matPicked, *job.pData, job.dest);
+    else if (decoded.type == FIFFT_INT)
+        calibrate_raw_buffer((const qint32*)decoded.constData(), job.nchan, job.nsamp, job.first_pick, job.picksamp, *job.pMult, *job.pRowSel, *job.pRowCal, job.matPicked, *job.pData, job.dest);
+    else if (decoded.type == FIFFT_FLOAT)
+        calibrate_raw_buffer((const float*)decoded.constData(), job.nchan, job.nsamp, job.first_pick, job.picksamp, *job.pMult, *job.pRowSel, *job.pRowCal, job.matPicked, *job.pData, job.dest);
+    else
+        job.bOk = false;
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+bool FiffRawData::read_raw_buffers(T& data, fiff_int_t from, fiff_int_t to, const SparseMatrix<typename T::Scalar>& mult, const VectorXi& rowSel, const Matrix<typename T::Scalar,Dynamic,1>& rowCal, bool do_debug)
+{
+    FiffStream::SPtr fid;
+
+    //
+    //  Look up the first buffer we need instead of walking the directory from its beginning
+    //
+    if (m_vecRawdirLast.size() != this->rawdir.size())
+        this->build_rawdir_index();
+
+    qint32 k = this->find_rawdir_entry(from);
+    if (k < 0)
+    {
+        printf("Sample %d is not covered by the raw directory\n", from);
+        return false;
+    }
+
+    //
+    //  The buffers are read sequentially, then decoded, calibrated and projected on the thread pool. Each buffer
+    //  writes to its own output columns. Work in batches to bound the memory held by not yet decoded buffers. The
+    //  job slots keep their payload, decode and pick buffers from batch to batch.
+    //
+    qint32 batchSize = 4*qMax(1, QThread::idealThreadCount());
+    QVector<RawBufferJob<T> > jobs(batchSize);
+    qint32 njobs;
 
-                one.setZero();
+    qint32 i;
+    qint32 dest = 0;
+    while (dest < data.cols())
+    {
+        njobs = 0;
+        for(; k < this->rawdir.size() && dest < data.cols() && njobs < batchSize; ++k)
+        {
+            const FiffRawDir& thisRawDir = this->rawdir[k];
+
+            RawBufferJob<T>& job = jobs[njobs];
+            job.first_pick = qMax(from, thisRawDir.first) - thisRawDir.first;
+            job.picksamp = qMin(to, thisRawDir.last) - thisRawDir.first - job.first_pick + 1;
+            if (job.picksamp <= 0)
+                continue;
+
+            if (do_debug)
+                qDebug() << "buffer" << k << "first_pick:" << job.first_pick << "picksamp:" << job.picksamp;
+
+            job.rawdir_idx = k;
+            job.nsamp = thisRawDir.nsamp;
+            job.dest = dest;
+            job.pData = &data;
+            job.nchan = this->info.nchan;
+            job.pMult = &mult;
+            job.pRowSel = &rowSel;
+            job.pRowCal = &rowCal;
+            job.bOk = false;
+            job.bDecode = true;
+            job.view.clear();
+            job.pDecoded.clear();
+
+            FiffTag::SPtr* pCached = m_pBufferCache ? m_pBufferCache->object(k) : NULL;
+            if (pCached)
+            {
+                job.pDecoded = *pCached;
+                job.bDecode = false;
+                ++m_iBufferCacheHits;
             }
-            else
+            else if (thisRawDir.ent && thisRawDir.ent->kind != -1)
             {
-                FiffTag::SPtr t_pTag;
-                fid->read_tag(t_pTag, thisRawDir.ent->pos);
+                if (m_pBufferCache)
+                    ++m_iBufferCacheMisses;
+
                 //
-                //   Depending on the state of the projection and selection
-                //   we proceed a little bit differently
+                //  Buffers of split recordings live in different files
                 //
-                if (mult.cols() == 0)
-                {
-                    if (sel.cols() == 0)
-                    {
-                        if (t_pTag->type == FIFFT_DAU_PACK16)
-                            one = cal*(Map< MatrixDau16 >( t_pTag->toDauPack16(),nchan, thisRawDir.nsamp)).cast<double>();
-                        else if(t_pTag->type == FIFFT_INT)
-                            one = cal*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
-                        else if(t_pTag->type == FIFFT_FLOAT)
-                            one = cal*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
-                        else
-                            printf("Data Storage Format not known jet [1]!! Type: %d\n", t_pTag->type);
-                    }
-                    else
-                    {
-
-                        //ToDo find a faster solution for this!! --> make cal and mul sparse like in MATLAB
-                        MatrixXd newData(sel.cols(), thisRawDir.nsamp); //ToDo this can be done much faster, without newData
-
-                        if (t_pTag->type == FIFFT_DAU_PACK16)
-                        {
-                            MatrixXd tmp_data = (Map< MatrixDau16 > ( t_pTag->toDauPack16(),nchan, thisRawDir.nsamp)).cast<double>();
-
-                            for(r = 0; r < sel.size(); ++r)
-                                newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
-                        }
-                        else if(t_pTag->type == FIFFT_INT)
-                        {
-                            MatrixXd tmp_data = (Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
-
-                            for(r = 0; r < sel.size(); ++r)
-                                newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
-                        }
-                        else if(t_pTag->type == FIFFT_FLOAT)
-                        {
-                            MatrixXd tmp_data = (Map< MatrixXf > ( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
-
-                            for(r = 0; r < sel.size(); ++r)
-                                newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
-                        }
-                        else
-                        {
-                            printf("Data Storage Format not known jet [2]!! Type: %d\n", t_pTag->type);
-                        }
-
-                        one = cal*newData;
-                    }
-                }
-                else
+                fid = this->open_raw_stream(thisRawDir.file_idx);
+                if (!fid)
                 {
-                    if (t_pTag->type == FIFFT_DAU_PACK16)
-                        one = mult*(Map< MatrixDau16 >( t_pTag->toDauPack16(),nchan, thisRawDir.nsamp)).cast<double>();
-                    else if(t_pTag->type == FIFFT_INT)
-                        one = mult*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
-                    else if(t_pTag->type == FIFFT_FLOAT)
-                        one = mult*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
-                    else
-                        printf("Data Storage Format not known jet [3]!! Type: %d\n", t_pTag->type);
+                    printf("Data buffer %d refers to the missing file %d\n", k, thisRawDir.file_idx);
+                    return false;
                 }
-            }
-            //
-            //  The picking logic is a bit complicated
-            //
-            if (to >= thisRawDir.last && from <= thisRawDir.first)
-            {
+
                 //
-                //  We need the whole buffer
+                //  Without a mapping the payload is read straight into the buffer of the job
                 //
-                first_pick = 0;//1;
-                last_pick  = thisRawDir.nsamp - 1;
-                if (do_debug)
-                    printf("W");
-            }
-            else if (from > thisRawDir.first)
-            {
-                first_pick = from - thisRawDir.first;// + 1;
-                if(to < thisRawDir.last)
+                if (!fid->read_tag_view(job.view, job.baRaw, thisRawDir.ent->pos))
                 {
-                    //
-                    //  Something from the middle
-                    //
-//                    qDebug() << "This needs to be debugged!";
-                    last_pick = thisRawDir.nsamp + to - thisRawDir.last - 1;//is this alright?
-                    if (do_debug)
-                        printf("M");
+                    printf("Could not read data buffer at %d\n", thisRawDir.ent->pos);
+                    return false;
                 }
-                else
-                {
-                    //
-                    //  From the middle to the end
-                    //
-                    last_pick = thisRawDir.nsamp - 1;
-                    if (do_debug)
-                        printf("E");
-                }
-            }
-            else
-            {
+
                 //
-                //  From the beginning to the middle
+                //  The cache keeps the decoded tag, so it needs a tag of its own
                 //
-                first_pick = 0;//1;
-                last_pick  = to - thisRawDir.first;// + 1;
-                if (do_debug)
-                    printf("B");
+                if (!job.pScratch || m_pBufferCache)
+                    job.pScratch = FiffTag::SPtr(new FiffTag());
             }
-            //
-            //  Now we are ready to pick
-            //
-            picksamp = last_pick - first_pick + 1;
 
-            if(do_debug)
-            {
-                qDebug() << "first_pick: " << first_pick;
-                qDebug() << "last_pick: " << last_pick;
-                qDebug() << "picksamp: " << picksamp;
-            }
+            ++njobs;
+            dest += job.picksamp;
+        }
 
-            if (picksamp > 0)
-            {
-//                    for(r = 0; r < data->rows(); ++r)
-//                        for(c = 0; c < picksamp; ++c)
-//                            (*data)(r,dest + c) = one(r,first_pick + c);
-                data.block(0,dest,data.rows(),picksamp) = one.block(0, first_pick, data.rows(), picksamp);
+        if (njobs == 0)
+            break;
 
-                dest += picksamp;
+        if (njobs == 1)
+            decode_raw_buffer(jobs[0]);
+        else
+            QtConcurrent::blockingMap(jobs.begin(), jobs.begin() + njobs, decode_raw_buffer<T>);
+
+        for(i = 0; i < njobs; ++i)
+        {
+            if (!jobs[i].bOk)
+            {
+                if (jobs[i].pDecoded->type == FIFFT_INT_DELTA_RICE)
+                    printf("Damaged compressed data buffer %d\n", jobs[i].rawdir_idx);
+                else
+                    printf("Data Storage Format not known jet!! Type: %d\n", jobs[i].pDecoded->type);
+                return false;
             }
         }
-        //
-        //  Done?
-        //
-        if (thisRawDir.last >= to)
+
+        if (m_pBufferCache)
         {
-            printf(" [done]\n");
-            break;
+            for(i = 0; i < njobs; ++i)
+                if (jobs[i].bDecode && !jobs[i].view.isEmpty())
+                    m_pBufferCache->insert(jobs[i].rawdir_idx, new FiffTag::SPtr(jobs[i].pDecoded), jobs[i].pDecoded->size());
         }
     }
 
-//        fclose(fid);
-
-    times = MatrixXd(1, to-from+1);
-
-    for (i = 0; i < times.cols(); ++i)
-        times(0, i) = ((float)(from+i)) / this->info.sfreq;
-
-    return true;
+    return dest == data.cols();
 }
 
 
@@ -439,11 +729,6 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, fiff_int_t f
 
 bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix<double>& multSegment, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel, bool do_debug)
 {
-    bool projAvailable = true;
-
-    if (this->proj.size() == 0)
-        projAvailable = false;
-
     if(from == -1)
         from = this->first_samp;
     if(to == -1)
@@ -466,293 +751,79 @@ bool FiffRawData::read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix
     //  Initialize the data and calibration vector
     //
     qint32 nchan = this->info.nchan;
-    qint32 dest  = 0;//1;
-    qint32 i, k, r;
+    qint32 i;
 
-    typedef Eigen::Triplet<double> T;
-    std::vector<T> tripletList;
-    tripletList.reserve(nchan);
-    for(i = 0; i < nchan; ++i)
-        tripletList.push_back(T(i, i, this->cals[i]));
+    data = MatrixXd(sel.size() == 0 ? nchan : sel.size(), to-from+1);
 
-    SparseMatrix<double> cal(nchan, nchan);
-    cal.setFromTriplets(tripletList.begin(), tripletList.end());
-//    cal.makeCompressed();
+    this->make_mult(sel);
 
-    MatrixXd mult_full;
-    //
-    if (sel.size() == 0)
-    {
-        data = MatrixXd(nchan, to-from+1);
-//            data->setZero();
-        if (projAvailable || this->comp.kind != -1)
-        {
-            if (!projAvailable)
-                mult_full = this->comp.data->data*cal;
-            else if (this->comp.kind == -1)
-                mult_full = this->proj*cal;
-            else
-                mult_full = this->proj*this->comp.data->data*cal;
-        }
-    }
-    else
-    {
-        data = MatrixXd(sel.size(),to-from+1);
-//            data->setZero();
+    VectorXi rowSel;
+    VectorXd rowCal;
+    if (m_matMult.cols() == 0)
+        make_row_cal(this->cals, sel, nchan, rowSel, rowCal);
 
-        MatrixXd selVect(sel.size(), nchan);
+    if (!this->read_raw_buffers(data, from, to, m_matMult, rowSel, rowCal, do_debug))
+        return false;
 
-        selVect.setZero();
+    printf(" [done]\n");
 
-        if (!projAvailable && this->comp.kind == -1)
-        {
-            tripletList.clear();
-            tripletList.reserve(sel.size());
-            for(i = 0; i < sel.size(); ++i)
-                tripletList.push_back(T(i, i, this->cals[sel[i]]));
-            cal = SparseMatrix<double>(sel.size(), sel.size());
-            cal.setFromTriplets(tripletList.begin(), tripletList.end());
-        }
-        else
-        {
-            if (!projAvailable)
-            {
-                qDebug() << "This has to be debugged! #1";
-                for( i = 0; i  < sel.size(); ++i)
-                    selVect.row(i) = this->comp.data->data.block(sel[i],0,1,nchan);
-                mult_full = selVect*cal;
-            }
-            else if (this->comp.kind == -1)
-            {
-                for( i = 0; i  < sel.size(); ++i)
-                    selVect.row(i) = this->proj.block(sel[i],0,1,nchan);
+    if(m_matMult.cols()==0)
+        multSegment = m_matCal;
+    else
+        multSegment = m_matMult;
 
-                mult_full = selVect*cal;
-            }
-            else
-            {
-                qDebug() << "This has to be debugged! #3";
-                for( i = 0; i  < sel.size(); ++i)
-                    selVect.row(i) = this->proj.block(sel[i],0,1,nchan);
+    times = MatrixXd(1, to-from+1);
 
-                mult_full = selVect*this->comp.data->data*cal;
-            }
-        }
-    }
+    for (i = 0; i < times.cols(); ++i)
+        times(0, i) = ((float)(from+i)) / this->info.sfreq;
 
-    //
-    // Make mult sparse
-    //
-    tripletList.clear();
-    tripletList.reserve(mult_full.rows()*mult_full.cols());
-    for(i = 0; i < mult_full.rows(); ++i)
-        for(k = 0; k < mult_full.cols(); ++k)
-            if(mult_full(i,k) != 0)
-                tripletList.push_back(T(i, k, mult_full(i,k)));
+    return true;
+}
 
-    SparseMatrix<double> mult(mult_full.rows(),mult_full.cols());
-    if(tripletList.size() > 0)
-        mult.setFromTriplets(tripletList.begin(), tripletList.end());
-//    mult.makeCompressed();
 
-    //
+//*************************************************************************************************************
 
-    FiffStream::SPtr fid;
-    if (!this->file->device()->isOpen())
+template<typename T>
+bool FiffRawData::read_raw_segment_float(T& data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel)
+{
+    if(from < this->first_samp || to > this->last_samp || from > to)
     {
-        if (!this->file->device()->open(QIODevice::ReadOnly))
-        {
-            printf("Cannot open file %s",this->info.filename.toUtf8().constData());
-        }
-        fid = this->file;
+        printf("No data in this range\n");
+        return false;
     }
-    else
+
+    qint32 nchan = this->info.nchan;
+    qint32 nrow = sel.size() == 0 ? nchan : sel.size();
+    if(data.rows() != nrow || data.cols() != to-from+1)
     {
-        fid = this->file;
+        printf("Output matrix is %d x %d, expected %d x %d\n", (qint32)data.rows(), (qint32)data.cols(), nrow, to-from+1);
+        return false;
     }
 
-    MatrixXd one;
-    fiff_int_t first_pick, last_pick, picksamp;
-    for(k = 0; k < this->rawdir.size(); ++k)
-    {
-        FiffRawDir thisRawDir = this->rawdir[k];
-        //
-        //  Do we need this buffer
-        //
-        if (thisRawDir.last > from)
-        {
-            if (thisRawDir.ent->kind == -1)
-            {
-                //
-                //  Take the easy route: skip is translated to zeros
-                //
-                if(do_debug)
-                    printf("S");
-                if (sel.cols() <= 0)
-                    one.resize(nchan,thisRawDir.nsamp);
-                else
-                    one.resize(sel.cols(),thisRawDir.nsamp);
+    this->make_mult(sel);
 
-                one.setZero();
-            }
-            else
-            {
-                FiffTag::SPtr t_pTag;
-                fid->read_tag(t_pTag, thisRawDir.ent->pos);
-                //
-                //   Depending on the state of the projection and selection
-                //   we proceed a little bit differently
-                //
-                if (mult.cols() == 0)
-                {
-                    if (sel.cols() == 0)
-                    {
-                        if (t_pTag->type == FIFFT_DAU_PACK16)
-                            one = cal*(Map< MatrixDau16 >( t_pTag->toDauPack16(),nchan, thisRawDir.nsamp)).cast<double>();
-                        else if(t_pTag->type == FIFFT_INT)
-                            one = cal*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
-                        else if(t_pTag->type == FIFFT_FLOAT)
-                            one = cal*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
-                        else
-                            printf("Data Storage Format not known jet [1]!! Type: %d\n", t_pTag->type);
-                    }
-                    else
-                    {
-
-                        //ToDo find a faster solution for this!! --> make cal and mul sparse like in MATLAB
-                        MatrixXd newData(sel.cols(), thisRawDir.nsamp); //ToDo this can be done much faster, without newData
-
-                        if (t_pTag->type == FIFFT_DAU_PACK16)
-                        {
-                            MatrixXd tmp_data = (Map< MatrixDau16 > ( t_pTag->toDauPack16(),nchan, thisRawDir.nsamp)).cast<double>();
-
-                            for(r = 0; r < sel.size(); ++r)
-                                newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
-                        }
-                        else if(t_pTag->type == FIFFT_INT)
-                        {
-                            MatrixXd tmp_data = (Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
-
-                            for(r = 0; r < sel.size(); ++r)
-                                newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
-                        }
-                        else if(t_pTag->type == FIFFT_FLOAT)
-                        {
-                            MatrixXd tmp_data = (Map< MatrixXf > ( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
-
-                            for(r = 0; r < sel.size(); ++r)
-                                newData.block(r,0,1,thisRawDir.nsamp) = tmp_data.block(sel[r],0,1,thisRawDir.nsamp);
-                        }
-                        else
-                        {
-                            printf("Data Storage Format not known jet [2]!! Type: %d\n", t_pTag->type);
-                        }
-
-                        one = cal*newData;
-                    }
-                }
-                else
-                {
-                    if (t_pTag->type == FIFFT_DAU_PACK16)
-                        one = mult*(Map< MatrixDau16 >( t_pTag->toDauPack16(),nchan, thisRawDir.nsamp)).cast<double>();
-                    else if(t_pTag->type == FIFFT_INT)
-                        one = mult*(Map< MatrixXi >( t_pTag->toInt(),nchan, thisRawDir.nsamp)).cast<double>();
-                    else if(t_pTag->type == FIFFT_FLOAT)
-                        one = mult*(Map< MatrixXf >( t_pTag->toFloat(),nchan, thisRawDir.nsamp)).cast<double>();
-                    else
-                        printf("Data Storage Format not known jet [3]!! Type: %d\n", t_pTag->type);
-                }
-            }
-            //
-            //  The picking logic is a bit complicated
-            //
-            if (to >= thisRawDir.last && from <= thisRawDir.first)
-            {
-                //
-                //  We need the whole buffer
-                //
-                first_pick = 0;//1;
-                last_pick  = thisRawDir.nsamp - 1;
-                if (do_debug)
-                    printf("W");
-            }
-            else if (from > thisRawDir.first)
-            {
-                first_pick = from - thisRawDir.first;// + 1;
-                if(to < thisRawDir.last)
-                {
-                    //
-                    //  Something from the middle
-                    //
-//                    qDebug() << "This needs to be debugged!";
-                    last_pick = thisRawDir.nsamp + to - thisRawDir.last - 1;//is this alright?
-                    if (do_debug)
-                        printf("M");
-                }
-                else
-                {
-                    //
-                    //  From the middle to the end
-                    //
-                    last_pick = thisRawDir.nsamp - 1;
-                    if (do_debug)
-                        printf("E");
-                }
-            }
-            else
-            {
-                //
-                //  From the beginning to the middle
-                //
-                first_pick = 0;//1;
-                last_pick  = to - thisRawDir.first;// + 1;
-                if (do_debug)
-                    printf("B");
-            }
-            //
-            //  Now we are ready to pick
-            //
-            picksamp = last_pick - first_pick + 1;
+    VectorXi rowSel;
+    VectorXf rowCal;
+    if (m_matMult.cols() == 0)
+        make_row_cal(this->cals, sel, nchan, rowSel, rowCal);
 
-            if(do_debug)
-            {
-                qDebug() << "first_pick: " << first_pick;
-                qDebug() << "last_pick: " << last_pick;
-                qDebug() << "picksamp: " << picksamp;
-            }
+    return this->read_raw_buffers(data, from, to, m_matMultF, rowSel, rowCal);
+}
 
-            if (picksamp > 0)
-            {
-//                    for(r = 0; r < data->rows(); ++r)
-//                        for(c = 0; c < picksamp; ++c)
-//                            (*data)(r,dest + c) = one(r,first_pick + c);
-                data.block(0,dest,data.rows(),picksamp) = one.block(0, first_pick, data.rows(), picksamp);
 
-                dest += picksamp;
-            }
-        }
-        //
-        //  Done?
-        //
-        if (thisRawDir.last >= to)
-        {
-            printf(" [done]\n");
-            break;
-        }
-    }
+//*************************************************************************************************************
 
-    if(mult.cols()==0)
-        multSegment = cal;
-    else
-        multSegment = mult;
-//        fclose(fid);
+bool FiffRawData::read_raw_segment(Ref<MatrixXf> data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel)
+{
+    return this->read_raw_segment_float(data, from, to, sel);
+}
 
-    times = MatrixXd(1, to-from+1);
 
-    for (i = 0; i < times.cols(); ++i)
-        times(0, i) = ((float)(from+i)) / this->info.sfreq;
+//*************************************************************************************************************
 
-    return true;
+bool FiffRawData::read_raw_segment(Ref<Matrix<float,Dynamic,Dynamic,RowMajor> > data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel)
+{
+    return this->read_raw_segment_float(data, from, to, sel);
 }
 
 
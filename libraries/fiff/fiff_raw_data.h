@@ -45,6 +45,7 @@
 #include "fiff_info.h"
 #include "fiff_raw_dir.h"
 #include "fiff_stream.h"
+#include "fiff_tag.h"
 
 
 //*************************************************************************************************************
@@ -61,8 +62,10 @@
 // Qt INCLUDES
 //=============================================================================================================
 
+#include <QCache>
 #include <QList>
 #include <QSharedPointer>
+#include <QVector>
 
 
 //*************************************************************************************************************
@@ -141,6 +144,84 @@ public:
         return first_samp == -1 && info.isEmpty();
     }
 
+    //=========================================================================================================
+    /**
+    * Enables or disables the memory mapped read mode. When enabled, the raw file is mapped into memory on the
+    * next read and the data buffers are decoded straight out of the mapping into a reused scratch buffer,
+    * instead of being read into a freshly allocated FiffTag first. If the file can not be mapped, reading falls
+    * back to the regular QIODevice based path.
+    *
+    * @param[in] bMemoryMapped  Whether to use the memory mapped read mode
+    */
+    void setMemoryMapped(bool bMemoryMapped);
+
+    //=========================================================================================================
+    /**
+    * Returns whether the memory mapped read mode is enabled.
+    *
+    * @return true if memory mapped reading is enabled
+    */
+    bool isMemoryMapped() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the size of the cache of decoded data buffers. Reads which hit a cached buffer skip the file access
+    * and the endian conversion, which makes repeated overlapping reads (scrolling, overlapping epochs) memory
+    * bound. The buffers are cached before calibration, so the cache stays valid if the channel selection, the
+    * projector or the compensator change. Buffers are evicted least recently used first.
+    *
+    * @param[in] iMaxBytes  Maximal size of the cached buffers in bytes, 0 disables (and clears) the cache
+    */
+    void setBufferCacheSize(qint32 iMaxBytes);
+
+    //=========================================================================================================
+    /**
+    * Returns the maximal size of the buffer cache.
+    *
+    * @return the maximal size in bytes, 0 if the cache is disabled
+    */
+    qint32 bufferCacheSize() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of data buffers which were taken from the cache since the cache was last cleared.
+    *
+    * @return the number of cache hits
+    */
+    qint64 bufferCacheHits() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of data buffers which had to be read from file since the cache was last cleared.
+    *
+    * @return the number of cache misses
+    */
+    qint64 bufferCacheMisses() const;
+
+    //=========================================================================================================
+    /**
+    * Drops all cached buffers and resets the hit and miss counters.
+    */
+    void clearBufferCache();
+
+    //=========================================================================================================
+    /**
+    * Builds the sorted sample-to-buffer index of the raw directory, which is used by read_raw_segment to seek
+    * to the first buffer of a segment in O(log n). This is done by setup_read_raw and has to be repeated only
+    * if rawdir is modified by hand. The buffer cache is cleared, since it is keyed by the rawdir index.
+    */
+    void build_rawdir_index();
+
+    //=========================================================================================================
+    /**
+    * Looks up the raw directory entry (data buffer or skip) which contains the given sample.
+    *
+    * @param[in] sample     The sample of interest (in the same sample numbering as first_samp and last_samp)
+    *
+    * @return the index into rawdir, -1 if the sample is not part of the recording
+    */
+    qint32 find_rawdir_entry(fiff_int_t sample) const;
+
     //=========================================================================================================
     /**
     * ### MNE toolbox root function ###: Implementation of the fiff_read_raw_segment function
@@ -174,6 +255,35 @@ public:
     */
     bool read_raw_segment(MatrixXd& data, MatrixXd& times, SparseMatrix<double>& multSegment, fiff_int_t from = -1, fiff_int_t to = -1, const RowVectorXi& sel = defaultRowVectorXi, bool do_debug = false);
 
+    //=========================================================================================================
+    /**
+    * Reads a raw data segment in single precision into a preallocated matrix. Nothing is allocated per call
+    * apart from the scratch buffers of the decoder; compensation, projection and calibration are applied
+    * like in the double precision version, but the data are never widened to double.
+    *
+    * @param[out] data      the matrix to fill (channels x samples), has to be sized sel.size() (or nchan) x (to-from+1)
+    * @param[in] from       first sample to include
+    * @param[in] to         last sample to include
+    * @param[in] sel        channel selection vector (optional)
+    *
+    * @return true if succeeded, false if the range is not part of the recording or data has the wrong size
+    */
+    bool read_raw_segment(Ref<MatrixXf> data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel = defaultRowVectorXi);
+
+    //=========================================================================================================
+    /**
+    * Reads a raw data segment in single precision into a preallocated row major matrix, e.g. a view on a
+    * channel-wise ring buffer. See the column major version for details.
+    *
+    * @param[out] data      the matrix to fill (channels x samples), has to be sized sel.size() (or nchan) x (to-from+1)
+    * @param[in] from       first sample to include
+    * @param[in] to         last sample to include
+    * @param[in] sel        channel selection vector (optional)
+    *
+    * @return true if succeeded, false if the range is not part of the recording or data has the wrong size
+    */
+    bool read_raw_segment(Ref<Matrix<float,Dynamic,Dynamic,RowMajor> > data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel = defaultRowVectorXi);
+
     //=========================================================================================================
     /**
     * ### MNE toolbox root function ###: Implementation of the fiff_read_raw_segment function
@@ -192,6 +302,7 @@ public:
 
 public:
     FiffStream::SPtr file;      /**< replaces fid */
+    QList<FiffStream::SPtr> files;  /**< All files of a split recording in order, files[0] is file */
     FiffInfo info;              /**< Fiff measurement information */
     fiff_int_t first_samp;      /**< Do we have a skip ToDo... */
     fiff_int_t last_samp;       /**< Do we have a skip ToDo... */
@@ -199,6 +310,71 @@ public:
     QList<FiffRawDir> rawdir;   /**< Special fiff diretory entry for raw data. */
     MatrixXd proj;              /**< SSP operator to apply to the data. */
     FiffCtfComp comp;           /**< Compensator. */
+
+private:
+    //=========================================================================================================
+    /**
+    * Assembles the calibration (m_matCal: nchan x nchan, or sel x sel if only a selection is applied) and the
+    * combined compensation/projection/calibration operator (m_matMult, m_matMultF: empty if neither compensation
+    * nor projection is applied) of a read. The operators are cached and only rebuilt if sel, cals, proj or comp
+    * differ from the ones they were built for.
+    *
+    * @param[in] sel        channel selection vector
+    */
+    void make_mult(const RowVectorXi& sel);
+
+    //=========================================================================================================
+    /**
+    * Opens (and, if requested, maps) a raw file for reading. The file stays open for subsequent reads.
+    *
+    * @param[in] file_idx   Index of the file in files (0 = file)
+    *
+    * @return the stream to read the data buffers from, or a null pointer if there is no such file or it can not
+    *         be opened
+    */
+    FiffStream::SPtr open_raw_stream(qint32 file_idx = 0);
+
+    //=========================================================================================================
+    /**
+    * Reads the buffers covering from ... to into data. The tags are read sequentially, decoding and applying
+    * either mult or the per row calibration is spread over the global thread pool.
+    *
+    * @param[out] data      output matrix, already sized (rows x (to-from+1))
+    * @param[in] from       first sample to include
+    * @param[in] to         last sample to include
+    * @param[in] mult       compensation/projection/calibration operator, empty if only rowSel/rowCal are applied
+    * @param[in] rowSel     stored channel of each output row
+    * @param[in] rowCal     calibration of each output row
+    * @param[in] do_debug   print the picks of each buffer
+    *
+    * @return true if succeeded, false otherwise
+    */
+    template<typename T>
+    bool read_raw_buffers(T& data, fiff_int_t from, fiff_int_t to, const SparseMatrix<typename T::Scalar>& mult, const VectorXi& rowSel, const Matrix<typename T::Scalar,Dynamic,1>& rowCal, bool do_debug = false);
+
+    //=========================================================================================================
+    /**
+    * Common implementation of the single precision read_raw_segment versions.
+    */
+    template<typename T>
+    bool read_raw_segment_float(T& data, fiff_int_t from, fiff_int_t to, const RowVectorXi& sel);
+
+    bool m_bMemoryMapped;       /**< Whether the raw buffers are read from a memory mapped file. */
+    QVector<fiff_int_t> m_vecRawdirLast;    /**< Last sample of each rawdir entry, the sorted index used to look up buffers. */
+
+    QSharedPointer<QCache<qint32, FiffTag::SPtr> > m_pBufferCache; /**< Decoded data buffers by rawdir index, NULL if disabled. */
+    qint64 m_iBufferCacheHits;          /**< Buffers taken from the cache. */
+    qint64 m_iBufferCacheMisses;        /**< Buffers read from file while the cache is enabled. */
+
+    bool m_bMultValid;                  /**< Whether the cached operators below are set up. */
+    SparseMatrix<double> m_matCal;      /**< Cached calibration operator. */
+    SparseMatrix<double> m_matMult;     /**< Cached compensation/projection/calibration operator, empty if not applied. */
+    SparseMatrix<float> m_matMultF;     /**< Single precision copy of m_matMult. */
+    RowVectorXi m_vecMultSel;           /**< Channel selection the operators were built for. */
+    RowVectorXd m_vecMultCals;          /**< Calibration the operators were built for. */
+    MatrixXd m_matMultProj;             /**< Projector the operators were built for. */
+    fiff_int_t m_iMultCompKind;         /**< Compensator kind the operators were built for. */
+    MatrixXd m_matMultComp;             /**< Compensator the operators were built for. */
 };
 
 } // NAMESPACE
@@ -109,6 +109,7 @@ public:
     fiff_int_t          first;  /**< first sample */
     fiff_int_t          last;   /**< last sample */
     fiff_int_t          nsamp;  /**< Number of samples */
+    qint32              file_idx;   /**< Index of the file holding the buffer, see FiffRawData::files (0 unless the recording is split) */
 };
 
 } // NAMESPACE
@@ -0,0 +1,345 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_resampler.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawResampler class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_resampler.h"
+#include "fiff_raw_data.h"
+#include "fiff_stream.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QVector>
+#include <QtConcurrent>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE LOCAL TYPES
+//=============================================================================================================
+
+typedef Matrix<float, Dynamic, Dynamic, RowMajor> RowMajorMatrixXf;
+typedef Matrix<double, Dynamic, Dynamic, RowMajor> RowMajorMatrixXd;
+
+//=============================================================================================================
+/**
+* One channel of an output buffer, which is computed on the thread pool.
+*/
+struct ResampleJob
+{
+    qint32 chan;                        /**< The channel. */
+    bool bStim;                         /**< Whether the channel is a stimulus channel. */
+
+    const RowMajorMatrixXf* pIn;        /**< The input window, shared by all jobs. */
+    qint64 winFirst;                    /**< Input sample of the first column of the window. */
+    RowMajorMatrixXf* pOut;             /**< The output buffer, shared by all jobs. */
+    qint64 outFirst;                    /**< Output sample of the first column of the output buffer. */
+
+    const RowMajorMatrixXd* pPhases;    /**< The polyphase branches of the filter. */
+    qint32 up;                          /**< Upsampling factor. */
+    qint32 down;                        /**< Downsampling factor. */
+    qint32 center;                      /**< Center tap of the filter. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+static void resample_channel(ResampleJob& job)
+{
+    const float* x = job.pIn->data() + (qint64)job.chan * job.pIn->cols();
+    float* y = job.pOut->data() + (qint64)job.chan * job.pOut->cols();
+    qint64 nout = job.pOut->cols();
+
+    if(job.bStim)
+    {
+        //
+        //   Take the maximum of the input samples represented by each output sample
+        //
+        qint64 last = job.winFirst + job.pIn->cols() - 1;
+        for(qint64 j = 0; j < nout; ++j)
+        {
+            qint64 n = job.outFirst + j;
+            qint64 from = (n * job.down + job.up - 1) / job.up;
+            qint64 to = ((n + 1) * job.down + job.up - 1) / job.up - 1;
+            if(to < from)
+                from = to = (n * job.down) / job.up;    // upsampling, hold the preceding input sample
+            from = qMin(qMax(from, job.winFirst), last);
+            to = qMin(to, last);
+            float value = x[from - job.winFirst];
+            for(qint64 i = from + 1; i <= to; ++i)
+                value = qMax(value, x[i - job.winFirst]);
+            y[j] = value;
+        }
+        return;
+    }
+
+    qint32 ntaps = job.pPhases->cols();
+    for(qint64 j = 0; j < nout; ++j)
+    {
+        qint64 pos = (job.outFirst + j) * job.down + job.center;
+        const double* c = job.pPhases->data() + (pos % job.up) * ntaps;
+        const float* xi = x + (pos / job.up - job.winFirst);
+
+        double sum = 0.0;
+        for(qint32 k = 0; k < ntaps; ++k)
+            sum += c[k] * xi[-k];
+        y[j] = (float)sum;
+    }
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffRawResampler::FiffRawResampler(qint32 up, qint32 down, qint32 iHalfLength, double dRolloff)
+: m_iUp(qMax(up, 1))
+, m_iDown(qMax(down, 1))
+, m_dRolloff(dRolloff)
+{
+    //
+    //   Windowed sinc at the upsampled rate, cutting off below the lower of both Nyquist frequencies
+    //
+    qint32 factor = qMax(m_iUp, m_iDown);
+    m_iCenter = qMax(iHalfLength, 1) * factor;
+    qint32 ntaps = 2 * m_iCenter + 1;
+    double fc = m_dRolloff / (2.0 * factor);
+
+    m_vecFilter.resize(ntaps);
+    for(qint32 i = 0; i < ntaps; ++i)
+    {
+        double t = i - m_iCenter;
+        double sinc = (t == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+        double window = 0.54 - 0.46 * cos(2.0 * M_PI * i / (ntaps - 1));
+        m_vecFilter[i] = sinc * window;
+    }
+    m_vecFilter *= m_iUp / m_vecFilter.sum();
+
+    //
+    //   Split into the polyphase branches: branch p holds the taps p, p+up, p+2*up, ... which meet the input
+    //   samples last_input, last_input-1, ... of the output samples with phase p
+    //
+    m_iTaps = (ntaps + m_iUp - 1) / m_iUp;
+    m_matPhases = RowMajorMatrixXd::Zero(m_iUp, m_iTaps);
+    for(qint32 i = 0; i < ntaps; ++i)
+        m_matPhases(i % m_iUp, i / m_iUp) = m_vecFilter[i];
+}
+
+
+//*************************************************************************************************************
+
+double FiffRawResampler::cutoff(double sfreq) const
+{
+    return m_dRolloff * sfreq * m_iUp / (2.0 * qMax(m_iUp, m_iDown));
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawResampler::resampled_nsamp(qint64 nsamp) const
+{
+    return (nsamp * m_iUp + m_iDown - 1) / m_iDown;
+}
+
+
+//*************************************************************************************************************
+
+fiff_int_t FiffRawResampler::resampled_first_samp(fiff_int_t first_samp) const
+{
+    return (fiff_int_t)floor((double)first_samp * m_iUp / m_iDown + 0.5);
+}
+
+
+//*************************************************************************************************************
+
+MatrixXi FiffRawResampler::resample_events(const MatrixXi& events, fiff_int_t first_samp) const
+{
+    MatrixXi eventsOut = events;
+    fiff_int_t first_samp_out = resampled_first_samp(first_samp);
+
+    for(qint32 i = 0; i < events.rows(); ++i)
+    {
+        qint64 rel = (qint64)events(i, 0) - first_samp;
+        eventsOut(i, 0) = first_samp_out + (fiff_int_t)((rel >= 0 ? rel * m_iUp : rel * m_iUp - m_iDown + 1) / m_iDown);
+    }
+
+    return eventsOut;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawResampler::resample(FiffRawData& raw, QIODevice& p_IODevice, fiff_int_t data_type, qint32 nBufferSize) const
+{
+    qint32 nchan = raw.info.nchan;
+    qint64 nin = raw.last_samp - raw.first_samp + 1;
+    qint64 nout = resampled_nsamp(nin);
+    if(nchan <= 0 || nin <= 0 || nBufferSize <= 0)
+        return false;
+
+    //
+    //   Measurement info of the output
+    //
+    FiffInfo info = raw.info;
+    info.sfreq = raw.info.sfreq * m_iUp / m_iDown;
+    if(m_iUp < m_iDown)
+        info.lowpass = qMin(info.lowpass, (float)cutoff(raw.info.sfreq));
+
+    RowVectorXd cals;
+    FiffStream::SPtr outfid = FiffStream::start_writing_raw(p_IODevice, info, cals, defaultMatrixXi, false, data_type);
+    if(!outfid)
+        return false;
+
+    fiff_int_t first_samp = resampled_first_samp(raw.first_samp);
+    outfid->write_int(FIFF_FIRST_SAMPLE, &first_samp);
+
+    printf("Resampling %lld samples at %.1f Hz to %lld samples at %.1f Hz...", (long long)nin, raw.info.sfreq, (long long)nout, info.sfreq);
+
+    //
+    //   One job per channel, the window and buffer pointers stay valid for all buffers
+    //
+    RowMajorMatrixXf t_matWin, t_matNext, t_matOut;
+    QVector<ResampleJob> jobs(nchan);
+    for(qint32 c = 0; c < nchan; ++c)
+    {
+        jobs[c].chan = c;
+        jobs[c].bStim = raw.info.chs[c].kind == FIFFV_STIM_CH;
+        jobs[c].pIn = &t_matWin;
+        jobs[c].pOut = &t_matOut;
+        jobs[c].pPhases = &m_matPhases;
+        jobs[c].up = m_iUp;
+        jobs[c].down = m_iDown;
+        jobs[c].center = m_iCenter;
+    }
+
+    qint64 winFirst = first_input(0);
+    qint64 winLast = winFirst - 1;
+    VectorXf t_vecEdge;
+
+    for(qint64 n0 = 0; n0 < nout; n0 += nBufferSize)
+    {
+        qint64 n1 = qMin(n0 + nBufferSize, nout);
+
+        //
+        //   Input window of this buffer, keeping the samples shared with the previous window
+        //
+        qint64 from = first_input(n0);
+        qint64 to = last_input(n1 - 1);
+        t_matNext.resize(nchan, to - from + 1);
+
+        qint64 keep = qMax(from, winFirst);
+        if(winLast >= keep)
+            t_matNext.middleCols(keep - from, winLast - keep + 1) = t_matWin.middleCols(keep - winFirst, winLast - keep + 1);
+
+        qint64 readFrom = qMax(qMax(from, winLast + 1), (qint64)0);
+        qint64 readTo = qMin(to, nin - 1);
+        if(readTo >= readFrom)
+        {
+            Ref<RowMajorMatrixXf> t_block = t_matNext.middleCols(readFrom - from, readTo - readFrom + 1);
+            if(!raw.read_raw_segment(t_block, raw.first_samp + (fiff_int_t)readFrom, raw.first_samp + (fiff_int_t)readTo))
+            {
+                printf("Could not read samples %lld to %lld.\n", (long long)readFrom, (long long)readTo);
+                outfid->finish_writing_raw();
+                return false;
+            }
+        }
+
+        //
+        //   Extend the recording with its first and last sample
+        //
+        for(qint64 i = qMax(from, winLast + 1); i < qMin(to + 1, (qint64)0); ++i)
+            t_matNext.col(i - from) = t_matNext.col(-from);
+        if(readTo == nin - 1 && readTo >= readFrom)
+            t_vecEdge = t_matNext.col(readTo - from);
+        for(qint64 i = qMax(qMax(from, winLast + 1), nin); i <= to; ++i)
+            t_matNext.col(i - from) = t_vecEdge;
+
+        t_matWin.swap(t_matNext);
+        winFirst = from;
+        winLast = to;
+
+        //
+        //   Filter the channels in parallel
+        //
+        t_matOut.resize(nchan, n1 - n0);
+        for(qint32 c = 0; c < nchan; ++c)
+        {
+            jobs[c].winFirst = winFirst;
+            jobs[c].outFirst = n0;
+        }
+        QtConcurrent::blockingMap(jobs, resample_channel);
+
+        if(!outfid->write_raw_buffer(MatrixXf(t_matOut), cals))
+        {
+            printf("Could not write the resampled buffer.\n");
+            outfid->finish_writing_raw();
+            return false;
+        }
+    }
+
+    outfid->finish_writing_raw();
+    printf("[done]\n");
+
+    return true;
+}
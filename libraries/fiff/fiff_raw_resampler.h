@@ -0,0 +1,276 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_resampler.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawResampler class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_RESAMPLER_H
+#define FIFF_RAW_RESAMPLER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_file.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QIODevice>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class FiffRawData;
+
+
+//=============================================================================================================
+/**
+* Changes the sampling rate of a raw data file by the rational factor up/down without loading the recording into
+* memory. The recording is read, filtered and written buffer by buffer: the anti-alias filter is a windowed sinc
+* which is evaluated in its polyphase form, so only the output samples are computed. The input samples a buffer
+* shares with the previous one are kept between the buffers, the recording is extended with its first and last
+* sample at the edges. Channels are filtered in parallel. Stimulus channels are not filtered, each output sample
+* holds the maximum of the input samples it replaces (the preceding input sample when upsampling), so short
+* trigger pulses survive a decimation.
+*
+* @code
+* FiffRawData raw(t_fileIn);
+* FiffRawResampler resampler(1, 5);     // e.g. 5 kHz -> 1 kHz
+* resampler.resample(raw, t_fileOut);
+* MatrixXi eventsOut = resampler.resample_events(events, raw.first_samp);
+* @endcode
+*
+* @brief Streaming polyphase resampler for raw data files
+*/
+class FIFFSHARED_EXPORT FiffRawResampler
+{
+public:
+    typedef QSharedPointer<FiffRawResampler> SPtr;              /**< Shared pointer type for FiffRawResampler. */
+    typedef QSharedPointer<const FiffRawResampler> ConstSPtr;   /**< Const shared pointer type for FiffRawResampler. */
+
+    //=========================================================================================================
+    /**
+    * Constructs the resampler and designs the anti-alias filter.
+    *
+    * @param[in] up             Upsampling factor
+    * @param[in] down           Downsampling factor
+    * @param[in] iHalfLength    Half length of the filter in samples of the lower of both rates
+    * @param[in] dRolloff       Cutoff of the filter relative to the Nyquist frequency of the lower rate
+    */
+    FiffRawResampler(qint32 up, qint32 down, qint32 iHalfLength = 16, double dRolloff = 0.9);
+
+    //=========================================================================================================
+    /**
+    * Returns the upsampling factor.
+    *
+    * @return the upsampling factor
+    */
+    inline qint32 up() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the downsampling factor.
+    *
+    * @return the downsampling factor
+    */
+    inline qint32 down() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the anti-alias filter at the upsampled rate. Its gain is up.
+    *
+    * @return the filter coefficients
+    */
+    inline const Eigen::VectorXd& filter() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the cutoff frequency of the anti-alias filter.
+    *
+    * @param[in] sfreq      Sampling frequency of the input
+    *
+    * @return the cutoff frequency in Hz
+    */
+    double cutoff(double sfreq) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of output samples of a recording.
+    *
+    * @param[in] nsamp      Number of input samples
+    *
+    * @return the number of output samples
+    */
+    qint64 resampled_nsamp(qint64 nsamp) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the first sample of the output. The first sample is scaled like the sampling frequency, so the
+    * output keeps the time axis of the input (exactly, if first_samp*up is divisible by down).
+    *
+    * @param[in] first_samp The first sample of the input
+    *
+    * @return the first sample of the output
+    */
+    fiff_int_t resampled_first_samp(fiff_int_t first_samp) const;
+
+    //=========================================================================================================
+    /**
+    * Maps events to the output. An event ends up on the output sample whose stimulus channel value holds the
+    * input sample of the event, i.e., events found on the resampled stimulus channels match the mapped ones.
+    *
+    * @param[in] events     The events (sample, before, after) in samples including the first sample
+    * @param[in] first_samp The first sample of the input
+    *
+    * @return the events of the output
+    */
+    Eigen::MatrixXi resample_events(const Eigen::MatrixXi& events, fiff_int_t first_samp) const;
+
+    //=========================================================================================================
+    /**
+    * Resamples a raw data file. The measurement info is copied with sfreq and lowpass adjusted, the first sample
+    * is stored with the data. The memory use depends on the buffer size and not on the length of the recording.
+    * If reading or writing a buffer fails, the output is finished after the buffers written so far.
+    *
+    * @param[in] raw            The raw data to resample
+    * @param[in] p_IODevice     The device to write the resampled file to
+    * @param[in] data_type      Storage type of the output buffers (see FiffStream::start_writing_raw)
+    * @param[in] nBufferSize    Number of output samples per buffer
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool resample(FiffRawData& raw, QIODevice& p_IODevice, fiff_int_t data_type = FIFFT_FLOAT, qint32 nBufferSize = 1000) const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns the last input sample the output sample n depends on.
+    *
+    * @param[in] n          The output sample
+    *
+    * @return the last input sample
+    */
+    inline qint64 last_input(qint64 n) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the first input sample the output sample n depends on.
+    *
+    * @param[in] n          The output sample
+    *
+    * @return the first input sample
+    */
+    inline qint64 first_input(qint64 n) const;
+
+    qint32          m_iUp;          /**< Upsampling factor. */
+    qint32          m_iDown;        /**< Downsampling factor. */
+    double          m_dRolloff;     /**< Cutoff relative to the Nyquist frequency of the lower rate. */
+    qint32          m_iCenter;      /**< Center tap of the filter. */
+    qint32          m_iTaps;        /**< Number of taps of each polyphase branch. */
+    Eigen::VectorXd m_vecFilter;    /**< The anti-alias filter at the upsampled rate. */
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> m_matPhases;   /**< The polyphase branches (one row per phase, taps in reversed time order). */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline qint32 FiffRawResampler::up() const
+{
+    return m_iUp;
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 FiffRawResampler::down() const
+{
+    return m_iDown;
+}
+
+
+//*************************************************************************************************************
+
+inline const Eigen::VectorXd& FiffRawResampler::filter() const
+{
+    return m_vecFilter;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffRawResampler::last_input(qint64 n) const
+{
+    return (n * m_iDown + m_iCenter) / m_iUp;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffRawResampler::first_input(qint64 n) const
+{
+    return last_input(n) - m_iTaps + 1;
+}
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_RESAMPLER_H
@@ -0,0 +1,382 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_writer.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawWriter class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_writer.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QFileDevice>
+#include <QMutexLocker>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffRawWriter::FiffRawWriter(FiffStream::SPtr p_pStream,
+                             qint32 nchan,
+                             qint32 nsamp,
+                             qint32 iRingSize,
+                             const RowVectorXd& cals,
+                             QObject* parent)
+: QThread(parent)
+, m_pStream(p_pStream)
+, m_vecCals(cals)
+, m_vecRing(iRingSize > 0 ? iRingSize : 1)
+, m_iHead(0)
+, m_iCount(0)
+, m_bStop(false)
+, m_bBlocking(true)
+, m_flushPolicy(NoFlush)
+, m_iMaxQueueDepth(0)
+, m_iWritten(0)
+, m_iDropped(0)
+, m_iLate(0)
+{
+    if(nchan > 0 && nsamp > 0) {
+        for(qint32 i = 0; i < m_vecRing.size(); ++i) {
+            m_vecRing[i].resize(nchan, nsamp);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+FiffRawWriter::~FiffRawWriter()
+{
+    if(this->isRunning()) {
+        this->stop();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawWriter::setFlushPolicy(FlushPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+    m_flushPolicy = policy;
+}
+
+
+//*************************************************************************************************************
+
+FiffRawWriter::FlushPolicy FiffRawWriter::flushPolicy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_flushPolicy;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawWriter::setBlocking(bool bBlocking)
+{
+    QMutexLocker locker(&m_mutex);
+    m_bBlocking = bBlocking;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::write_raw_buffer(const MatrixXf& buf)
+{
+    if(m_vecCals.size() > 0 && buf.rows() != m_vecCals.cols()) {
+        printf("buffer and calibration sizes do not match\n");
+        return false;
+    }
+
+    m_mutex.lock();
+
+    if(m_bStop) {
+        m_mutex.unlock();
+        return false;
+    }
+
+    if(m_iCount == m_vecRing.size()) {
+        if(!m_bBlocking) {
+            ++m_iDropped;
+            m_mutex.unlock();
+            return false;
+        }
+
+        ++m_iLate;
+        while(m_iCount == m_vecRing.size() && !m_bStop) {
+            m_condNotFull.wait(&m_mutex);
+        }
+
+        if(m_bStop) {
+            m_mutex.unlock();
+            return false;
+        }
+    }
+
+    qint32 iSlot = (m_iHead + m_iCount) % m_vecRing.size();
+    m_mutex.unlock();
+
+    //
+    //   The slot is not visible to the writer thread until the count is raised, so copy without the lock.
+    //   Only a change of the buffer size reallocates the slot.
+    //
+    m_vecRing[iSlot] = buf;
+
+    m_mutex.lock();
+    ++m_iCount;
+    if(m_iCount > m_iMaxQueueDepth) {
+        m_iMaxQueueDepth = m_iCount;
+    }
+    m_condNotEmpty.wakeOne();
+    m_mutex.unlock();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::flush()
+{
+    int iHandle = -1;
+
+    m_mutex.lock();
+    while(m_iCount > 0 && this->isRunning()) {
+        m_condDrained.wait(&m_mutex);
+    }
+
+    //
+    //   The writer thread only touches the stream while buffers are queued, the device buffer is flushed before
+    //   the lock is released
+    //
+    if(!flush_device(false)) {
+        m_mutex.unlock();
+        return false;
+    }
+
+    QFileDevice* pFile = qobject_cast<QFileDevice*>(m_pStream->device());
+    if(pFile) {
+        iHandle = pFile->handle();
+    }
+    m_mutex.unlock();
+
+    //
+    //   The sync can take long, the writer thread and the producer keep going meanwhile
+    //
+    return sync_handle(iHandle);
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawWriter::stop()
+{
+    m_mutex.lock();
+    m_bStop = true;
+    m_condNotEmpty.wakeAll();
+    m_condNotFull.wakeAll();
+    m_mutex.unlock();
+
+    this->wait();
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawWriter::finish_writing_raw()
+{
+    this->stop();
+    m_pStream->finish_writing_raw();
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawWriter::queueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iCount;
+}
+
+
+//*************************************************************************************************************
+
+qint32 FiffRawWriter::maxQueueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iMaxQueueDepth;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawWriter::writtenBuffers() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iWritten;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawWriter::droppedBuffers() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iDropped;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawWriter::lateBuffers() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iLate;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawWriter::run()
+{
+    while(true) {
+        m_mutex.lock();
+        while(m_iCount == 0 && !m_bStop) {
+            m_condNotEmpty.wait(&m_mutex);
+        }
+
+        //
+        //   Queued buffers are written before stopping
+        //
+        if(m_iCount == 0) {
+            m_condDrained.wakeAll();
+            m_mutex.unlock();
+            break;
+        }
+
+        qint32 iSlot = m_iHead;
+        FlushPolicy policy = m_flushPolicy;
+        m_mutex.unlock();
+
+        if(m_vecCals.size() > 0) {
+            m_pStream->write_raw_buffer(m_vecRing[iSlot], m_vecCals);
+        } else {
+            m_pStream->write_raw_buffer(m_vecRing[iSlot]);
+        }
+
+        if(policy != NoFlush) {
+            flush_device(policy == SyncEachBuffer);
+        }
+
+        m_mutex.lock();
+        m_iHead = (m_iHead + 1) % m_vecRing.size();
+        --m_iCount;
+        ++m_iWritten;
+        m_condNotFull.wakeOne();
+        if(m_iCount == 0) {
+            m_condDrained.wakeAll();
+        }
+        m_mutex.unlock();
+    }
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::flush_device(bool bSync)
+{
+    QFileDevice* pFile = qobject_cast<QFileDevice*>(m_pStream->device());
+
+    if(!pFile) {
+        return true;
+    }
+
+    if(!pFile->flush()) {
+        return false;
+    }
+
+    if(bSync) {
+        return sync_handle(pFile->handle());
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawWriter::sync_handle(int iHandle)
+{
+    if(iHandle < 0) {
+        return true;
+    }
+
+#ifdef Q_OS_WIN
+    return _commit(iHandle) == 0;
+#else
+    return ::fsync(iHandle) == 0;
+#endif
+}
@@ -0,0 +1,277 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_writer.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffRawWriter class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_WRITER_H
+#define FIFF_RAW_WRITER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_stream.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+
+//=============================================================================================================
+/**
+* The raw writer decouples the acquisition from the disk. Buffers handed to write_raw_buffer are copied into a
+* bounded ring of preallocated single precision slots and written to the stream by a dedicated thread, so a
+* slow disk does not stall the caller. When the ring is full the writer either blocks the caller (the buffer is
+* counted as late) or drops the buffer (counted as dropped), depending on setBlocking. The ring is meant to be
+* fed by a single producer thread. The stream has to be prepared with start_writing_raw beforehand and must not
+* be used by anyone else while the writer is running.
+*
+* @brief Asynchronous ring buffered writer for raw data buffers
+*/
+class FIFFSHARED_EXPORT FiffRawWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    typedef QSharedPointer<FiffRawWriter> SPtr;             /**< Shared pointer type for FiffRawWriter. */
+    typedef QSharedPointer<const FiffRawWriter> ConstSPtr;  /**< Const shared pointer type for FiffRawWriter. */
+
+    //=========================================================================================================
+    /**
+    * Flush policy applied by the writer thread after each written buffer.
+    */
+    enum FlushPolicy {
+        NoFlush,            /**< Leave flushing to the stream device and the operating system. */
+        FlushEachBuffer,    /**< Flush the device buffer to the operating system after each buffer. */
+        SyncEachBuffer      /**< Flush and sync the file to the disk after each buffer. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs the writer and preallocates the ring. The thread is not started.
+    *
+    * @param[in] p_pStream      Stream prepared with start_writing_raw
+    * @param[in] nchan          Number of channels of the buffers
+    * @param[in] nsamp          Number of samples of the buffers, used for the preallocation only
+    * @param[in] iRingSize      Number of ring slots
+    * @param[in] cals           Calibration factors; the buffers are written uncalibrated if empty
+    * @param[in] parent         Parent object
+    */
+    FiffRawWriter(FiffStream::SPtr p_pStream,
+                  qint32 nchan,
+                  qint32 nsamp,
+                  qint32 iRingSize = 16,
+                  const Eigen::RowVectorXd& cals = Eigen::RowVectorXd(),
+                  QObject* parent = Q_NULLPTR);
+
+    //=========================================================================================================
+    /**
+    * Destroys the writer. A running writer thread is stopped after the queued buffers have been written.
+    */
+    ~FiffRawWriter();
+
+    //=========================================================================================================
+    /**
+    * Sets the flush policy of the writer thread.
+    *
+    * @param[in] policy     The flush policy
+    */
+    void setFlushPolicy(FlushPolicy policy);
+
+    //=========================================================================================================
+    /**
+    * Returns the flush policy of the writer thread.
+    *
+    * @return the flush policy
+    */
+    FlushPolicy flushPolicy() const;
+
+    //=========================================================================================================
+    /**
+    * Sets whether write_raw_buffer blocks on a full ring (default) or drops the buffer.
+    *
+    * @param[in] bBlocking  True to block, false to drop buffers
+    */
+    void setBlocking(bool bBlocking);
+
+    //=========================================================================================================
+    /**
+    * Queues a raw buffer for writing. The buffer is copied, the caller can reuse it right away.
+    *
+    * @param[in] buf        The buffer to write (nchan x nsamp)
+    *
+    * @return true if the buffer was queued, false if it was dropped or the writer is stopped
+    */
+    bool write_raw_buffer(const Eigen::MatrixXf& buf);
+
+    //=========================================================================================================
+    /**
+    * Waits until all queued buffers are written, then flushes the stream device and syncs the file to the disk.
+    * The sync runs without holding the ring lock, so buffers can be queued while the disk catches up.
+    *
+    * @return true if succeeded, false if the sync failed
+    */
+    bool flush();
+
+    //=========================================================================================================
+    /**
+    * Writes the queued buffers and stops the writer thread. The stream stays open.
+    */
+    void stop();
+
+    //=========================================================================================================
+    /**
+    * Stops the writer thread and finishes the raw data file (see FiffStream::finish_writing_raw).
+    */
+    void finish_writing_raw();
+
+    //=========================================================================================================
+    /**
+    * Returns the number of buffers waiting in the ring.
+    *
+    * @return the current queue depth
+    */
+    qint32 queueDepth() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the highest number of buffers which waited in the ring at the same time.
+    *
+    * @return the maximal queue depth
+    */
+    qint32 maxQueueDepth() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of buffers written to the stream.
+    *
+    * @return the number of written buffers
+    */
+    qint64 writtenBuffers() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of buffers dropped because the ring was full in non-blocking mode.
+    *
+    * @return the number of dropped buffers
+    */
+    qint64 droppedBuffers() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of buffers which had to wait for a free slot in blocking mode.
+    *
+    * @return the number of late buffers
+    */
+    qint64 lateBuffers() const;
+
+protected:
+    //=========================================================================================================
+    /**
+    * Writes the queued buffers until the writer is stopped.
+    */
+    virtual void run();
+
+private:
+    //=========================================================================================================
+    /**
+    * Flushes the stream device and, if requested, syncs the file to the disk.
+    *
+    * @param[in] bSync      Whether to sync the file to the disk
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool flush_device(bool bSync);
+
+    //=========================================================================================================
+    /**
+    * Syncs an open file to the disk.
+    *
+    * @param[in] iHandle    The file handle, -1 if the stream device is not a file
+    *
+    * @return true if succeeded, false otherwise
+    */
+    static bool sync_handle(int iHandle);
+
+    FiffStream::SPtr            m_pStream;          /**< The stream to write to. */
+    Eigen::RowVectorXd          m_vecCals;          /**< Calibration factors; empty for uncalibrated writing. */
+
+    QVector<Eigen::MatrixXf>    m_vecRing;          /**< The preallocated ring slots. */
+    qint32                      m_iHead;            /**< Slot of the next buffer to write. */
+    qint32                      m_iCount;           /**< Number of queued buffers. */
+    bool                        m_bStop;            /**< Set when the writer thread should stop. */
+    bool                        m_bBlocking;        /**< Block on a full ring instead of dropping buffers. */
+    FlushPolicy                 m_flushPolicy;      /**< The flush policy. */
+
+    qint32                      m_iMaxQueueDepth;   /**< Highest observed queue depth. */
+    qint64                      m_iWritten;         /**< Number of written buffers. */
+    qint64                      m_iDropped;         /**< Number of dropped buffers. */
+    qint64                      m_iLate;            /**< Number of buffers which had to wait for a slot. */
+
+    mutable QMutex              m_mutex;            /**< Guards the ring state and the statistics. */
+    QWaitCondition              m_condNotEmpty;     /**< Signaled when a buffer was queued or on stop. */
+    QWaitCondition              m_condNotFull;      /**< Signaled when a slot was released. */
+    QWaitCondition              m_condDrained;      /**< Signaled when the ring ran empty. */
+};
+
+} // NAMESPACE
+
+#endif // FIFF_RAW_WRITER_H
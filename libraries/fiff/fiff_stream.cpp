@@ -40,6 +40,9 @@
 
 #include "fiff_stream.h"
 #include "fiff_tag.h"
+#include "fiff_tag_view.h"
+#include "fiff_tag_iterator.h"
+#include "fiff_raw_codec.h"
 #include "fiff_dir_node.h"
 #include "fiff_ctf_comp.h"
 #include "fiff_info.h"
@@ -74,6 +77,9 @@
 //=============================================================================================================
 
 #include <iostream>
+#include <cstring>
+#include <cmath>
+#include <climits>
 #include <time.h>
 
 
@@ -92,7 +98,21 @@
 //=============================================================================================================
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
 #include <QTcpSocket>
+#include <QtEndian>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define FIFF_DIR_INDEX_MAGIC    0x46444958  /* "FDIX" */
+#define FIFF_DIR_INDEX_VERSION  2
 
 
 //*************************************************************************************************************
@@ -111,6 +131,11 @@ using namespace UTILSLIB;
 
 FiffStream::FiffStream(QIODevice *p_pIODevice)
 : QDataStream(p_pIODevice)
+, m_pMappedData(NULL)
+, m_iMappedSize(0)
+, m_iRawDataType(FIFFT_FLOAT)
+, m_bDirIndexEnabled(false)
+, m_bCompressedRawEnabled(false)
 {
     this->setFloatingPointPrecision(QDataStream::SinglePrecision);
     this->setByteOrder(QDataStream::BigEndian);
@@ -122,6 +147,11 @@ FiffStream::FiffStream(QIODevice *p_pIODevice)
 
 FiffStream::FiffStream(QByteArray * a, QIODevice::OpenMode mode)
 : QDataStream(a, mode)
+, m_pMappedData(NULL)
+, m_iMappedSize(0)
+, m_iRawDataType(FIFFT_FLOAT)
+, m_bDirIndexEnabled(false)
+, m_bCompressedRawEnabled(false)
 {
     this->setFloatingPointPrecision(QDataStream::SinglePrecision);
     this->setByteOrder(QDataStream::BigEndian);
@@ -209,6 +239,10 @@ void FiffStream::end_file()
 
 void FiffStream::finish_writing_raw()
 {
+    for(qint32 k = 0; k < m_vecRawClipped.size(); ++k)
+        if(m_vecRawClipped[k] > 0)
+            printf("Warning: %d samples of channel %d exceeded the range of the storage type and were clipped\n", m_vecRawClipped[k], k);
+
     this->end_block(FIFFB_RAW_DATA);
     this->end_block(FIFFB_MEAS);
     this->end_file();
@@ -316,45 +350,62 @@ bool FiffStream::open(QIODevice::OpenModeFlag mode)
     printf("\nCreating tag directory for %s...", t_sFileName.toUtf8().constData());
 
     m_dir.clear();
-    qint32 dirpos = *t_pTag->toInt();
-    /*
-    * Do we have a directory or not?
-    */
-    if (dirpos <= 0) {  /* Must do it in the hard way... */
-        bool ok = false;
-        m_dir = this->make_dir(&ok);
-        if (!ok) {
-          qCritical ("Could not create tag directory!");
-          return false;
+    m_dirtree.clear();
+
+    //
+    //   A valid index also holds the type and id of each block, the tree is then built without reading tags
+    //
+    QList<FiffDirNode::SPtr> t_indexBlocks;
+    bool t_bWriteIndex = false;
+    if(!m_bDirIndexEnabled || !this->read_dir_index(t_indexBlocks)) {
+        qint32 dirpos = *t_pTag->toInt();
+        /*
+        * Do we have a directory or not?
+        */
+        if (dirpos <= 0) {  /* Must do it in the hard way... */
+            bool ok = false;
+            m_dir = this->make_dir(&ok);
+            if (!ok) {
+              qCritical ("Could not create tag directory!");
+              return false;
+            }
         }
-    }
-    else {              /* Just read the directory */
-        if(!this->read_tag(t_pTag, dirpos)) {
-            qCritical("Could not read the tag directory (file probably damaged)!");
-            return false;
+        else {              /* Just read the directory */
+            if(!this->read_tag(t_pTag, dirpos)) {
+                qCritical("Could not read the tag directory (file probably damaged)!");
+                return false;
+            }
+            m_dir = t_pTag->toDirEntry();
         }
-        m_dir = t_pTag->toDirEntry();
-    }
 
-    /*
-    * Check for a mistake
-    */
-    if (m_dir[m_dir.size()-2]->kind == FIFF_DIR) {
-        m_dir.removeLast();
-        m_dir[m_dir.size()-1]->kind = -1;
-        m_dir[m_dir.size()-1]->type = -1;
-        m_dir[m_dir.size()-1]->size = -1;
-        m_dir[m_dir.size()-1]->pos  = -1;
+        /*
+        * Check for a mistake
+        */
+        if (m_dir[m_dir.size()-2]->kind == FIFF_DIR) {
+            m_dir.removeLast();
+            m_dir[m_dir.size()-1]->kind = -1;
+            m_dir[m_dir.size()-1]->type = -1;
+            m_dir[m_dir.size()-1]->size = -1;
+            m_dir[m_dir.size()-1]->pos  = -1;
+        }
+
+        t_bWriteIndex = m_bDirIndexEnabled;
     }
 
     //
     //   Create the directory tree structure
     //
-    if((this->m_dirtree = this->make_subtree(m_dir)) == NULL)
+    qint32 t_iBlock = 0;
+    if((this->m_dirtree = this->make_subtree(m_dir, t_indexBlocks, t_iBlock)) == NULL) {
+        qCritical("Could not create the directory tree (file probably damaged)!");
         return false;
+    }
     else
         this->m_dirtree->parent.clear();
 
+    if(t_bWriteIndex)
+        this->write_dir_index();
+
     printf("[done]\n");
 
     //
@@ -365,10 +416,93 @@ bool FiffStream::open(QIODevice::OpenModeFlag mode)
 }
 
 
+//*************************************************************************************************************
+
+void FiffStream::setDirIndexEnabled(bool bEnabled)
+{
+    m_bDirIndexEnabled = bEnabled;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::dirIndexEnabled() const
+{
+    return m_bDirIndexEnabled;
+}
+
+
+//*************************************************************************************************************
+
+QString FiffStream::dir_index_name(const QString& fileName)
+{
+    return fileName + QString(".dirindex");
+}
+
+
+//*************************************************************************************************************
+
+static void collect_dir_blocks(const FiffDirNode::SPtr& p_pNode, QList<FiffDirNode::SPtr>& p_Blocks)
+{
+    p_Blocks.append(p_pNode);
+    for(qint32 k = 0; k < p_pNode->children.size(); ++k)
+        collect_dir_blocks(p_pNode->children[k], p_Blocks);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::write_dir_index()
+{
+    QFile* t_pFile = qobject_cast<QFile*>(this->device());
+    if(!t_pFile || m_dir.isEmpty() || !m_dirtree)
+        return false;
+
+    QFileInfo t_fileInfo(t_pFile->fileName());
+
+    //
+    //   Write to a temporary file which replaces the index only when complete
+    //
+    QSaveFile t_indexFile(dir_index_name(t_fileInfo.absoluteFilePath()));
+    if(!t_indexFile.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream t_stream(&t_indexFile);
+    t_stream.setByteOrder(QDataStream::BigEndian);
+
+    t_stream << (quint32)FIFF_DIR_INDEX_MAGIC << (qint32)FIFF_DIR_INDEX_VERSION;
+    t_stream << (qint64)t_fileInfo.size() << (qint64)t_fileInfo.lastModified().toMSecsSinceEpoch();
+    t_stream << (qint32)m_id.version << (qint32)m_id.machid[0] << (qint32)m_id.machid[1];
+    t_stream << (qint32)m_id.time.secs << (qint32)m_id.time.usecs;
+
+    t_stream << (qint32)m_dir.size();
+    for(qint32 k = 0; k < m_dir.size(); ++k)
+        t_stream << (qint32)m_dir[k]->kind << (qint32)m_dir[k]->type << (qint32)m_dir[k]->size << (qint32)m_dir[k]->pos;
+
+    //
+    //   Type and id of the blocks in the order make_subtree visits them, the tree follows from the directory
+    //
+    QList<FiffDirNode::SPtr> t_blocks;
+    collect_dir_blocks(m_dirtree, t_blocks);
+
+    t_stream << (qint32)t_blocks.size();
+    for(qint32 k = 0; k < t_blocks.size(); ++k) {
+        const FiffId& t_id = t_blocks[k]->id;
+        t_stream << (qint32)t_blocks[k]->type;
+        t_stream << (qint32)t_id.version << (qint32)t_id.machid[0] << (qint32)t_id.machid[1];
+        t_stream << (qint32)t_id.time.secs << (qint32)t_id.time.usecs;
+    }
+
+    return t_indexFile.commit();
+}
+
+
 //*************************************************************************************************************
 
 bool FiffStream::close()
 {
+    this->unmap();
+
     if(this->device()->isOpen())
         this->device()->close();
 
@@ -376,9 +510,65 @@ bool FiffStream::close()
 }
 
 
+//*************************************************************************************************************
+
+bool FiffStream::map()
+{
+    if(this->isMapped())
+        return true;
+
+    QFile* t_pFile = qobject_cast<QFile*>(this->device());
+    if(!t_pFile || !t_pFile->isOpen() || t_pFile->size() <= 0)
+        return false;
+
+    m_pMappedData = t_pFile->map(0, t_pFile->size());
+    if(!m_pMappedData) {
+        qWarning("FiffStream::map - Could not map %s (%s). Falling back to regular reads.", t_pFile->fileName().toUtf8().constData(), t_pFile->errorString().toUtf8().constData());
+        m_iMappedSize = 0;
+        return false;
+    }
+    m_iMappedSize = t_pFile->size();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffStream::unmap()
+{
+    if(m_pMappedData) {
+        QFile* t_pFile = qobject_cast<QFile*>(this->device());
+        if(t_pFile && t_pFile->isOpen())
+            t_pFile->unmap(m_pMappedData);
+    }
+
+    m_pMappedData = NULL;
+    m_iMappedSize = 0;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::isMapped() const
+{
+    // QFile::close releases all mappings, so a closed device is never mapped
+    return m_pMappedData != NULL && this->device() && this->device()->isOpen();
+}
+
+
 //*************************************************************************************************************
 
 FiffDirNode::SPtr FiffStream::make_subtree(QList<FiffDirEntry::SPtr> &dentry)
+{
+    qint32 t_iBlock = 0;
+    return this->make_subtree(dentry, QList<FiffDirNode::SPtr>(), t_iBlock);
+}
+
+
+//*************************************************************************************************************
+
+FiffDirNode::SPtr FiffStream::make_subtree(QList<FiffDirEntry::SPtr> &dentry, const QList<FiffDirNode::SPtr>& p_Blocks, qint32& p_iBlock)
 {
     FiffDirNode::SPtr defaultNode;
     FiffDirNode::SPtr node = FiffDirNode::SPtr(new FiffDirNode);
@@ -392,7 +582,16 @@ FiffDirNode::SPtr FiffStream::make_subtree(QList<FiffDirEntry::SPtr> &dentry)
     node->parent      = FiffDirNode::SPtr();
     node->type = FIFFB_ROOT;
 
-    if (dentry[current]->kind == FIFF_BLOCK_START) {
+    //
+    //   Type and id come from the directory index if there is one
+    //
+    bool indexed = p_iBlock < p_Blocks.size();
+    if (indexed) {
+        node->type = p_Blocks[p_iBlock]->type;
+        node->id = p_Blocks[p_iBlock]->id;
+        ++p_iBlock;
+    }
+    else if (dentry[current]->kind == FIFF_BLOCK_START) {
         if (!this->read_tag(t_pTag,dentry[current]->pos))
             return defaultNode;
         else
@@ -410,7 +609,7 @@ FiffDirNode::SPtr FiffStream::make_subtree(QList<FiffDirEntry::SPtr> &dentry)
             level++;
             if (level == 1) {
                 QList<FiffDirEntry::SPtr> sub_dentry = dentry.mid(current);
-                if (!(child = this->make_subtree(sub_dentry)))
+                if (!(child = this->make_subtree(sub_dentry, p_Blocks, p_iBlock)))
                     return defaultNode;
                 child->parent = node;
                 node->children.append(child);
@@ -429,7 +628,7 @@ FiffDirNode::SPtr FiffStream::make_subtree(QList<FiffDirEntry::SPtr> &dentry)
             * block id, or file id. Let the block id
             * take precedence over parent block id and file id
             */
-            if (((dentry[current]->kind == FIFF_PARENT_BLOCK_ID || dentry[current]->kind == FIFF_FILE_ID) && node->id.isEmpty()) || dentry[current]->kind == FIFF_BLOCK_ID) {
+            if (!indexed && ((dentry[current]->kind == FIFF_PARENT_BLOCK_ID || dentry[current]->kind == FIFF_FILE_ID) && node->id.isEmpty()) || dentry[current]->kind == FIFF_BLOCK_ID) {
                 if (!this->read_tag(t_pTag,dentry[current]->pos))
                     return defaultNode;
                 node->id = t_pTag->toFiffID();
@@ -1286,9 +1485,82 @@ bool FiffStream::read_meas_info(const FiffDirNode::SPtr& p_Node, FiffInfo& info,
 
 //*************************************************************************************************************
 
-bool FiffStream::read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat)
+template<typename T>
+static bool read_dense_float_matrix(FiffStream* p_pStream, const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, Matrix<T,Dynamic,Dynamic>& data, bool transposed)
+{
+    FiffTagView t_view;
+    for(int k = 0; k < p_Node->nent(); ++k)
+    {
+        if(p_Node->dir[k]->kind == matkind)
+        {
+            if(!p_pStream->read_tag_view(t_view, p_Node->dir[k]->pos))
+                return false;
+            break;
+        }
+    }
+
+    if(t_view.isEmpty() || !t_view.isMatrix() || t_view.getType() != FIFFT_FLOAT
+            || FiffTag::fiff_type_matrix_coding(t_view.type) != FIFFTS_MC_DENSE || t_view.size < 3*4)
+        return false;
+
+    //
+    //   The dimensions and the number of dimensions trail the elements
+    //
+    qint32 tail[3];
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_32(t_view.data + t_view.size - 3*4, tail, 3);
+#else
+    memcpy(tail, t_view.data + t_view.size - 3*4, 3*4);
+#endif
+    if(tail[2] != 2)
+    {
+        printf("Only two-dimensional matrices are supported at this time");
+        return false;
+    }
+
+    //
+    //   The elements are stored as tail[1] runs of tail[0] values, i.e., the columns of the column major
+    //   tail[0] x tail[1] matrix. Each run is converted on its own, so no complete float copy is ever held.
+    //
+    qint32 nrun = tail[1];
+    qint32 nel = tail[0];
+    if(nrun < 0 || nel < 0 || (qint64)nrun*nel*4 > t_view.size - 3*4)
+    {
+        printf("Matrix dimensions do not match the size of the tag\n");
+        return false;
+    }
+
+    if(transposed)
+        data.resize(nel, nrun);
+    else
+        data.resize(nrun, nel);
+
+    VectorXf run(nel);
+    for(qint32 i = 0; i < nrun; ++i)
+    {
+        const char* src = t_view.data + (qint64)i*nel*4;
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_32(src, run.data(), nel);
+#else
+        memcpy(run.data(), src, nel*4);
+#endif
+        if(transposed)
+            data.col(i) = run.cast<T>();
+        else
+            data.row(i) = run.cast<T>().transpose();
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+static bool read_named_matrix_data(FiffStream* p_pStream, const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat, Matrix<T,Dynamic,Dynamic>& data, bool transposed)
 {
     mat.clear();
+    data.resize(0, 0);
 
     FiffDirNode::SPtr node = p_Node;
     //
@@ -1326,52 +1598,65 @@ bool FiffStream::read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t m
 
     FiffTag::SPtr t_pTag;
     //
-    //   Read everything we need
+    //   Read everything we need, dense float matrices straight out of the tag view
     //
-    if(!node->find_tag(this, matkind, t_pTag))
-    {
-        printf("Matrix data missing.\n");
-        return false;
-    }
-    else
+    if(!read_dense_float_matrix(p_pStream, node, matkind, data, transposed))
     {
-        //qDebug() << "Is Matrix" << t_pTag->isMatrix() << "Special Type:" << t_pTag->getType();
-        mat.data = t_pTag->toFloatMatrix().cast<double>();
-        mat.data.transposeInPlace();
+        if(!node->find_tag(p_pStream, matkind, t_pTag))
+        {
+            printf("Matrix data missing.\n");
+            return false;
+        }
+        else
+        {
+            //qDebug() << "Is Matrix" << t_pTag->isMatrix() << "Special Type:" << t_pTag->getType();
+            data = t_pTag->toFloatMatrix().cast<T>();
+            if(!transposed)
+                data.transposeInPlace();
+        }
     }
 
-    mat.nrow = mat.data.rows();
-    mat.ncol = mat.data.cols();
+    mat.nrow = data.rows();
+    mat.ncol = data.cols();
+
+    //
+    //   The remaining tags describe the matrix as stored
+    //
+    fiff_int_t nrow = transposed ? mat.ncol : mat.nrow;
+    fiff_int_t ncol = transposed ? mat.nrow : mat.ncol;
 
-    if(node->find_tag(this, FIFF_MNE_NROW, t_pTag))
-        if (*t_pTag->toInt() != mat.nrow)
+    if(node->find_tag(p_pStream, FIFF_MNE_NROW, t_pTag))
+        if (*t_pTag->toInt() != nrow)
         {
             printf("Number of rows in matrix data and FIFF_MNE_NROW tag do not match");
             return false;
         }
-    if(node->find_tag(this, FIFF_MNE_NCOL, t_pTag))
-        if (*t_pTag->toInt() != mat.ncol)
+    if(node->find_tag(p_pStream, FIFF_MNE_NCOL, t_pTag))
+        if (*t_pTag->toInt() != ncol)
         {
             printf("Number of columns in matrix data and FIFF_MNE_NCOL tag do not match");
             return false;
         }
 
     QString row_names;
-    if(node->find_tag(this, FIFF_MNE_ROW_NAMES, t_pTag))
+    if(node->find_tag(p_pStream, FIFF_MNE_ROW_NAMES, t_pTag))
         row_names = t_pTag->toString();
 
     QString col_names;
-    if(node->find_tag(this, FIFF_MNE_COL_NAMES, t_pTag))
+    if(node->find_tag(p_pStream, FIFF_MNE_COL_NAMES, t_pTag))
         col_names = t_pTag->toString();
 
     //
     //   Put it together
     //
+    if (transposed)
+        row_names.swap(col_names);
+
     if (!row_names.isEmpty())
-        mat.row_names = split_name_list(row_names);
+        mat.row_names = FiffStream::split_name_list(row_names);
 
     if (!col_names.isEmpty())
-        mat.col_names = split_name_list(col_names);
+        mat.col_names = FiffStream::split_name_list(col_names);
 
     if (mat.row_names.size() != mat.nrow)
     {
@@ -1387,6 +1672,25 @@ bool FiffStream::read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t m
 }
 
 
+//*************************************************************************************************************
+
+bool FiffStream::read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat, bool transposed)
+{
+    //
+    //   mat.clear() releases mat.data before it gets filled
+    //
+    return read_named_matrix_data(this, p_Node, matkind, mat, mat.data, transposed);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat, MatrixXf& data, bool transposed)
+{
+    return read_named_matrix_data(this, p_Node, matkind, mat, data, transposed);
+}
+
+
 //*************************************************************************************************************
 
 QList<FiffProj> FiffStream::read_proj(const FiffDirNode::SPtr& p_Node)
@@ -1624,15 +1928,20 @@ fiff_long_t FiffStream::read_tag_info(FiffTag::SPtr &p_pTag, bool p_bDoSkip)
 
 bool FiffStream::read_rt_tag(FiffTag::SPtr &p_pTag)
 {
+    //
+    //   Block until the bytes arrive instead of polling, give up when the device is closed
+    //
     while(this->device()->bytesAvailable() < 16)
-        this->device()->waitForReadyRead(10);
+        if(!this->device()->waitForReadyRead(-1))
+            return false;
 
 //    if(!this->read_tag_info(p_pTag, false))
 //        return false;
     this->read_tag_info(p_pTag, false);
 
     while(this->device()->bytesAvailable() < p_pTag->size())
-        this->device()->waitForReadyRead(10);
+        if(!this->device()->waitForReadyRead(-1))
+            return false;
 
     if(!this->read_tag_data(p_pTag))
         return false;
@@ -1645,6 +1954,14 @@ bool FiffStream::read_rt_tag(FiffTag::SPtr &p_pTag)
 
 bool FiffStream::read_tag(FiffTag::SPtr &p_pTag, fiff_long_t pos)
 {
+    if (this->isMapped()) {
+        FiffTagView t_view;
+        if(!this->read_tag_view(t_view, pos))
+            return false;
+        p_pTag = t_view.toFiffTag();
+        return true;
+    }
+
     if (pos >= 0) {
         this->device()->seek(pos);
     }
@@ -1681,69 +1998,279 @@ bool FiffStream::read_tag(FiffTag::SPtr &p_pTag, fiff_long_t pos)
 
 //*************************************************************************************************************
 
-bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool allow_maxshield)
+bool FiffStream::read_tag_view(FiffTagView& p_View, fiff_long_t pos)
 {
-    //
-    //   Open the file
-    //
-    FiffStream::SPtr t_pStream(new FiffStream(&p_IODevice));
-    QString t_sFileName = t_pStream->streamName();
+    return this->read_tag_view(p_View, m_baViewBuffer, pos);
+}
 
-    printf("Opening raw data %s...\n",t_sFileName.toUtf8().constData());
 
-    if(!t_pStream->open())
-        return false;
+//*************************************************************************************************************
 
-    //
-    //   Read the measurement info
-    //
-    FiffInfo info;// = NULL;
-    FiffDirNode::SPtr meas;
-    if(!t_pStream->read_meas_info(t_pStream->dirtree(), info, meas))
-        return false;
+bool FiffStream::read_tag_view(FiffTagView& p_View, QByteArray& p_baBuffer, fiff_long_t pos)
+{
+    p_View.clear();
 
-    //
-    //   Locate the data of interest
-    //
-    QList<FiffDirNode::SPtr> raw = meas->dir_tree_find(FIFFB_RAW_DATA);
-    if (raw.size() == 0)
-    {
-        raw = meas->dir_tree_find(FIFFB_CONTINUOUS_DATA);
-        if(allow_maxshield)
-        {
-//            for (qint32 i = 0; i < raw.size(); ++i)
-//                if(raw[i])
-//                    delete raw[i];
-            raw = meas->dir_tree_find(FIFFB_SMSH_RAW_DATA);
-            if (raw.size() == 0)
-            {
-                printf("No raw data in %s\n", t_sFileName.toUtf8().constData());
-                return false;
-            }
+    if (this->isMapped()) {
+        if (pos < 0)
+            pos = this->device()->pos();
+
+        if (pos < 0 || pos + (fiff_long_t)FIFFC_DATA_OFFSET > m_iMappedSize) {
+            qWarning("FiffStream::read_tag_view - Tag position %lld is outside of the mapped file.", (long long)pos);
+            return false;
         }
-        else
-        {
-            if (raw.size() == 0)
-            {
-                printf("No raw data in %s\n", t_sFileName.toUtf8().constData());
-                return false;
-            }
+
+        //
+        // Read fiff tag header directly from the mapping
+        //
+        const uchar* t_pHeader = m_pMappedData + pos;
+        p_View.pos  = pos;
+        p_View.kind = qFromBigEndian<qint32>(t_pHeader);
+        p_View.type = qFromBigEndian<qint32>(t_pHeader + 4);
+        p_View.size = qFromBigEndian<qint32>(t_pHeader + 8);
+        p_View.next = qFromBigEndian<qint32>(t_pHeader + 12);
+
+        if (p_View.size < 0 || pos + (fiff_long_t)FIFFC_DATA_OFFSET + p_View.size > m_iMappedSize) {
+            qWarning("FiffStream::read_tag_view - Tag at %lld exceeds the mapped file (file probably damaged).", (long long)pos);
+            p_View.clear();
+            return false;
         }
+        p_View.data = (const char*)(t_pHeader + FIFFC_DATA_OFFSET);
+
+        //
+        // Leave the device where the unmapped read would leave it, so that sequential reads continue from
+        // here no matter whether the stream is mapped
+        //
+        if (p_View.next > 0)
+            this->device()->seek(p_View.next);
+        else
+            this->device()->seek(pos + FIFFC_DATA_OFFSET + p_View.size);
+
+        return true;
     }
+
+    if (pos >= 0)
+        this->device()->seek(pos);
+
+    p_View.pos = this->device()->pos();
+
     //
-    //   Set up the output structure
+    // Read fiff tag header from stream
     //
-    info.filename   = t_sFileName;
+    *this  >> p_View.kind;
+    *this  >> p_View.type;
+    *this  >> p_View.size;
+    *this  >> p_View.next;
+
+    if (p_View.size < 0) {
+        p_View.clear();
+        return false;
+    }
 
-    data.clear();
-    data.file = t_pStream;// fid;
-    data.info = info;
-    data.first_samp = 0;
-    data.last_samp  = 0;
     //
-    //   Process the directory
+    // Read data into the given buffer
     //
-
+    if (p_View.size > 0) {
+        if(p_baBuffer.size() < p_View.size)
+            p_baBuffer.resize(p_View.size);
+        if(this->readRawData(p_baBuffer.data(), p_View.size) != p_View.size) {
+            p_View.clear();
+            return false;
+        }
+        p_View.data = p_baBuffer.constData();
+    }
+
+    if (p_View.next != FIFFV_NEXT_SEQ)
+        this->device()->seek(p_View.next);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::read_tag_header(FiffTagView& p_View, fiff_long_t pos)
+{
+    p_View.clear();
+
+    if (pos < 0)
+        pos = this->device()->pos();
+
+    if (this->isMapped()) {
+        if (pos + (fiff_long_t)FIFFC_DATA_OFFSET > m_iMappedSize)
+            return false;
+
+        const uchar* t_pHeader = m_pMappedData + pos;
+        p_View.kind = qFromBigEndian<qint32>(t_pHeader);
+        p_View.type = qFromBigEndian<qint32>(t_pHeader + 4);
+        p_View.size = qFromBigEndian<qint32>(t_pHeader + 8);
+        p_View.next = qFromBigEndian<qint32>(t_pHeader + 12);
+
+        //
+        // The device ends up behind the header like after the unmapped read
+        //
+        this->device()->seek(pos + FIFFC_DATA_OFFSET);
+    }
+    else {
+        if (!this->device()->seek(pos))
+            return false;
+
+        this->resetStatus();
+        *this  >> p_View.kind;
+        *this  >> p_View.type;
+        *this  >> p_View.size;
+        *this  >> p_View.next;
+
+        if (this->status() != QDataStream::Ok) {
+            this->resetStatus();
+            p_View.clear();
+            return false;
+        }
+    }
+
+    if (p_View.size < 0) {
+        p_View.clear();
+        return false;
+    }
+
+    p_View.pos = pos;
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+static void delete_split_stream(FiffStream* p_pStream)
+{
+    //
+    //   Streams of continuation files own their file
+    //
+    QIODevice* t_pDevice = p_pStream->device();
+    delete p_pStream;
+    delete t_pDevice;
+}
+
+
+//*************************************************************************************************************
+
+static QString find_next_raw_file(const FiffStream::SPtr& p_pStream)
+{
+    FiffTag::SPtr t_pTag;
+    QList<FiffDirNode::SPtr> refs = p_pStream->dirtree()->dir_tree_find(FIFFB_REF);
+
+    for(qint32 k = 0; k < refs.size(); ++k)
+    {
+        if(!refs[k]->find_tag(p_pStream.data(), FIFF_REF_ROLE, t_pTag) || *t_pTag->toInt() != FIFFV_ROLE_NEXT_FILE)
+            continue;
+        if(!refs[k]->find_tag(p_pStream.data(), FIFF_REF_FILE_NAME, t_pTag))
+            continue;
+
+        //
+        //   The link may be relative or point to where the recording was made, look next to the current file too
+        //
+        QString t_sName = t_pTag->toString();
+        QDir t_dir = QFileInfo(p_pStream->streamName()).absoluteDir();
+        if(QFileInfo(t_sName).isRelative())
+            t_sName = t_dir.filePath(t_sName);
+        if(!QFileInfo::exists(t_sName))
+            t_sName = t_dir.filePath(QFileInfo(t_sName).fileName());
+
+        return t_sName;
+    }
+
+    return QString();
+}
+
+
+//*************************************************************************************************************
+
+static fiff_int_t compressed_buffer_nsamp(const FiffStream::SPtr& p_pStream, const FiffDirEntry::SPtr& ent, fiff_int_t nchan)
+{
+    //
+    //   The sample count of a compressed buffer can not be derived from its size, it is kept in the payload header
+    //
+    char header[FiffRawCodec::HeaderSize];
+    if(ent->size < FiffRawCodec::HeaderSize
+            || !p_pStream->device()->seek(ent->pos + FIFFC_DATA_OFFSET)
+            || p_pStream->device()->read(header, FiffRawCodec::HeaderSize) != FiffRawCodec::HeaderSize)
+        return -1;
+
+    qint32 t_nchan, t_nsamp;
+    FiffRawCodec::read_header(header, t_nchan, t_nsamp);
+
+    return t_nchan == nchan ? t_nsamp : -1;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool allow_maxshield)
+{
+    //
+    //   Open the file
+    //
+    FiffStream::SPtr t_pStream(new FiffStream(&p_IODevice));
+    QString t_sFileName = t_pStream->streamName();
+
+    printf("Opening raw data %s...\n",t_sFileName.toUtf8().constData());
+
+    //
+    //   Reopening a recording takes the directory and the block tree from the index sidecar
+    //
+    t_pStream->setDirIndexEnabled(true);
+    if(!t_pStream->open())
+        return false;
+
+    //
+    //   Read the measurement info
+    //
+    FiffInfo info;// = NULL;
+    FiffDirNode::SPtr meas;
+    if(!t_pStream->read_meas_info(t_pStream->dirtree(), info, meas))
+        return false;
+
+    //
+    //   Locate the data of interest
+    //
+    QList<FiffDirNode::SPtr> raw = meas->dir_tree_find(FIFFB_RAW_DATA);
+    if (raw.size() == 0)
+    {
+        raw = meas->dir_tree_find(FIFFB_CONTINUOUS_DATA);
+        if(allow_maxshield)
+        {
+//            for (qint32 i = 0; i < raw.size(); ++i)
+//                if(raw[i])
+//                    delete raw[i];
+            raw = meas->dir_tree_find(FIFFB_SMSH_RAW_DATA);
+            if (raw.size() == 0)
+            {
+                printf("No raw data in %s\n", t_sFileName.toUtf8().constData());
+                return false;
+            }
+        }
+        else
+        {
+            if (raw.size() == 0)
+            {
+                printf("No raw data in %s\n", t_sFileName.toUtf8().constData());
+                return false;
+            }
+        }
+    }
+    //
+    //   Set up the output structure
+    //
+    info.filename   = t_sFileName;
+
+    data.clear();
+    data.file = t_pStream;// fid;
+    data.files.append(t_pStream);
+    data.info = info;
+    data.first_samp = 0;
+    data.last_samp  = 0;
+    //
+    //   Process the directory
+    //
+
     QList<FiffDirEntry::SPtr> dir = raw[0]->dir;
     fiff_int_t nent = raw[0]->nent();
     fiff_int_t nchan = info.nchan;
@@ -1809,6 +2336,14 @@ bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool a
                 case FIFFT_INT:
                     nsamp = ent->size/(4*nchan);
                     break;
+                case FIFFT_INT_DELTA_RICE:
+                    nsamp = compressed_buffer_nsamp(t_pStream, ent, nchan);
+                    if (nsamp < 0)
+                    {
+                        printf("Damaged compressed data buffer at %d\n", ent->pos);
+                        return false;
+                    }
+                    break;
                 default:
                     printf("Cannot handle data buffers of type %d\n",ent->type);
                     return false;
@@ -1844,10 +2379,53 @@ bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool a
             t_RawDir.first = first_samp;
             t_RawDir.last  = first_samp + nsamp - 1;//ToDo -1 right or is that MATLAB syntax
             t_RawDir.nsamp = nsamp;
+            t_RawDir.file_idx = data.files.size() - 1;
             rawdir.append(t_RawDir);
             first_samp += nsamp;
             ++ndir;
         }
+
+        //
+        //   Continue with the next file of a split recording. Its samples follow the ones of the current file.
+        //
+        if (k == nent - 1)
+        {
+            QString t_sNextName = find_next_raw_file(data.files.last());
+            if (t_sNextName.isEmpty())
+                break;
+
+            bool visited = false;
+            for (qint32 i = 0; i < data.files.size(); ++i)
+                if (QFileInfo(data.files[i]->streamName()) == QFileInfo(t_sNextName))
+                    visited = true;
+            if (visited)
+                break;
+
+            FiffStream::SPtr t_pNextStream(new FiffStream(new QFile(t_sNextName)), delete_split_stream);
+            printf("Opening continuation file %s...\n", t_sNextName.toUtf8().constData());
+            t_pNextStream->setDirIndexEnabled(true);
+            if (!t_pNextStream->open())
+            {
+                printf("Could not open %s, the recording ends at sample %d\n", t_sNextName.toUtf8().constData(), first_samp - 1);
+                break;
+            }
+
+            QList<FiffDirNode::SPtr> nextRaw = t_pNextStream->dirtree()->dir_tree_find(FIFFB_RAW_DATA);
+            if (nextRaw.size() == 0)
+                nextRaw = t_pNextStream->dirtree()->dir_tree_find(allow_maxshield ? FIFFB_SMSH_RAW_DATA : FIFFB_CONTINUOUS_DATA);
+            if (nextRaw.size() == 0)
+            {
+                printf("No raw data in %s\n", t_sNextName.toUtf8().constData());
+                t_pNextStream->close();
+                break;
+            }
+
+            data.files.append(t_pNextStream);
+            dir = nextRaw[0]->dir;
+            nent = nextRaw[0]->nent();
+            t_pStream = t_pNextStream;
+            k = -1;
+        }
     }
     data.last_samp  = first_samp - 1;//ToDo -1 right or is that MATLAB syntax
     //
@@ -1860,6 +2438,7 @@ bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool a
     //
     data.cals       = cals;
     data.rawdir     = rawdir;
+    data.build_rawdir_index();
     //data->proj       = [];
     //data.comp       = [];
     //
@@ -1868,7 +2447,8 @@ bool FiffStream::setup_read_raw(QIODevice &p_IODevice, FiffRawData& data, bool a
            (double)data.first_samp/data.info.sfreq,
            (double)data.last_samp/data.info.sfreq);
     printf("Ready.\n");
-    data.file->close();
+    for (qint32 k = 0; k < data.files.size(); ++k)
+        data.files[k]->close();
 
     return true;
 }
@@ -1987,12 +2567,18 @@ FiffStream::SPtr FiffStream::open_update(QIODevice &p_IODevice)
 
 //*************************************************************************************************************
 
-FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel, bool resetRange)
+FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel, bool resetRange, fiff_int_t data_type, const RowVectorXd& maxValues, bool allowCompressed)
 {
-    //
-    //   We will always write floats
-    //
-    fiff_int_t data_type = 4;
+    if(data_type == FIFFT_INT_DELTA_RICE && !allowCompressed)
+    {
+        printf("Compressed raw data buffers can only be read by MNE-CPP, set allowCompressed to write them\n");
+        return FiffStream::SPtr();
+    }
+    if(data_type != FIFFT_FLOAT && data_type != FIFFT_INT && data_type != FIFFT_DAU_PACK16 && data_type != FIFFT_INT_DELTA_RICE)
+    {
+        printf("Raw data can not be stored as data type %d, writing floats instead\n", data_type);
+        data_type = FIFFT_FLOAT;
+    }
     qint32 k;
 
     if(sel.cols() == 0)
@@ -2009,6 +2595,25 @@ FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const Fiff
 
     fiff_int_t nchan = chs.size();
 
+    //
+    //   Integer storage: the stored calibration has to map the integer range to the signal range
+    //
+    if(data_type != FIFFT_FLOAT)
+    {
+        if(maxValues.size() > 0 && maxValues.size() != nchan)
+            printf("Number of maximal values does not match the number of channels, keeping the channel calibrations\n");
+
+        double intMax = data_type == FIFFT_DAU_PACK16 ? 32767.0 : 2147483647.0;
+        for(k = 0; k < nchan; ++k)
+        {
+            if(maxValues.size() == nchan && maxValues[k] > 0)
+                chs[k].cal = maxValues[k]/intMax;
+            else
+                chs[k].cal *= chs[k].range;
+            chs[k].range = 1.0f;
+        }
+    }
+
     //
     //  Create the file and save the essentials
     //
@@ -2177,10 +2782,41 @@ FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const Fiff
     //
     t_pStream->start_block(FIFFB_RAW_DATA);
 
+    t_pStream->m_iRawDataType = data_type;
+    t_pStream->m_vecRawCals = cals;
+    t_pStream->m_bCompressedRawEnabled = allowCompressed;
+
     return t_pStream;
 }
 
 
+//*************************************************************************************************************
+
+RowVectorXd FiffStream::raw_quantization_error() const
+{
+    if(m_vecRawMaxError.size() == m_vecRawCals.size())
+        return m_vecRawMaxError.cwiseProduct(m_vecRawCals.cwiseAbs());
+
+    return m_vecRawMaxError;
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXi FiffStream::raw_clipped_samples() const
+{
+    return m_vecRawClipped;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::compressedRawEnabled() const
+{
+    return m_bCompressedRawEnabled;
+}
+
+
 //*************************************************************************************************************
 
 fiff_long_t FiffStream::write_tag(const QSharedPointer<FiffTag> &p_pTag, fiff_long_t pos)
@@ -2606,21 +3242,19 @@ fiff_long_t FiffStream::write_dir_entries(const QList<FiffDirEntry::SPtr> &dir,
 
 fiff_long_t FiffStream::write_double(fiff_int_t kind, const double* data, fiff_int_t nel)
 {
-    fiff_long_t pos = this->device()->pos();
-
     qint32 datasize = nel * 8;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_DOUBLE;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-//    this->setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-    for(qint32 i = 0; i < nel; ++i)
-        *this << data[i];
+    //
+    //  Not through operator<<: with SinglePrecision set, QDataStream writes doubles as 32 bit floats
+    //
+    char* payload = this->begin_tag_buffer(kind, FIFFT_DOUBLE, datasize);
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_64(data, payload, nel);
+#else
+    memcpy(payload, data, datasize);
+#endif
 
-    return pos;
+    return this->write_tag_buffer(datasize);
 }
 
 
@@ -2628,21 +3262,16 @@ fiff_long_t FiffStream::write_double(fiff_int_t kind, const double* data, fiff_i
 
 fiff_long_t FiffStream::write_float(fiff_int_t kind, const float* data, fiff_int_t nel)
 {
-    fiff_long_t pos = this->device()->pos();
-
     qint32 datasize = nel * 4;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_FLOAT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-//    this->setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-    for(qint32 i = 0; i < nel; ++i)
-        *this << data[i];
+    char* payload = this->begin_tag_buffer(kind, FIFFT_FLOAT, datasize);
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_32(data, payload, nel);
+#else
+    memcpy(payload, data, datasize);
+#endif
 
-    return pos;
+    return this->write_tag_buffer(datasize);
 }
 
 
@@ -2650,32 +3279,25 @@ fiff_long_t FiffStream::write_float(fiff_int_t kind, const float* data, fiff_int
 
 fiff_long_t FiffStream::write_float_matrix(fiff_int_t kind, const MatrixXf& mat)
 {
-    fiff_long_t pos = this->device()->pos();
-
     qint32 numel = mat.rows() * mat.cols();
 
     fiff_int_t datasize = 4*numel + 4*3;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_MATRIX_FLOAT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
+    char* payload = this->begin_tag_buffer(kind, FIFFT_MATRIX_FLOAT, datasize);
 
-    qint32 i, j;
     // Storage order: row-major
-    for(i = 0; i < mat.rows(); ++i)
-        for(j = 0; j < mat.cols(); ++j)
-            *this << mat(i,j);
+    Map< Matrix<float,Dynamic,Dynamic,RowMajor> >((float*)payload, mat.rows(), mat.cols()) = mat;
 
-    qint32 dims[3];
+    qint32* dims = (qint32*)(payload + 4*numel);
     dims[0] = mat.cols();
     dims[1] = mat.rows();
     dims[2] = 2;
 
-    for(i = 0; i < 3; ++i)
-        *this << dims[i];
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_32(payload, payload, numel + 3);
+#endif
 
-    return pos;
+    return this->write_tag_buffer(datasize);
 }
 
 
@@ -2986,19 +3608,16 @@ fiff_long_t FiffStream::write_info_base(const FiffInfoBase & p_FiffInfoBase)
 
 fiff_long_t FiffStream::write_int(fiff_int_t kind, const fiff_int_t* data, fiff_int_t nel, fiff_int_t next)
 {
-    fiff_long_t pos = this->device()->pos();
-
     fiff_int_t datasize = nel * 4;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_INT;
-    *this << (qint32)datasize;
-    *this << (qint32)next;
-
-    for(qint32 i = 0; i < nel; ++i)
-        *this << data[i];
+    char* payload = this->begin_tag_buffer(kind, FIFFT_INT, datasize, next);
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_32(data, payload, nel);
+#else
+    memcpy(payload, data, datasize);
+#endif
 
-    return pos;
+    return this->write_tag_buffer(datasize);
 }
 
 
@@ -3006,8 +3625,6 @@ fiff_long_t FiffStream::write_int(fiff_int_t kind, const fiff_int_t* data, fiff_
 
 fiff_long_t FiffStream::write_int_matrix(fiff_int_t kind, const MatrixXi& mat)
 {
-    fiff_long_t pos = this->device()->pos();
-
 //    qint32 FIFFT_MATRIX = 1 << 30;
 //    qint32 FIFFT_MATRIX_INT = FIFFT_INT | FIFFT_MATRIX;
 
@@ -3015,26 +3632,21 @@ fiff_long_t FiffStream::write_int_matrix(fiff_int_t kind, const MatrixXi& mat)
 
     fiff_int_t datasize = 4*numel + 4*3;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_MATRIX_INT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
+    char* payload = this->begin_tag_buffer(kind, FIFFT_MATRIX_INT, datasize);
 
-    qint32 i, j;
     // Storage order: row-major
-    for(i = 0; i < mat.rows(); ++i)
-        for(j = 0; j < mat.cols(); ++j)
-            *this << mat(i,j);
+    Map< Matrix<qint32,Dynamic,Dynamic,RowMajor> >((qint32*)payload, mat.rows(), mat.cols()) = mat;
 
-    qint32 dims[3];
+    qint32* dims = (qint32*)(payload + 4*numel);
     dims[0] = mat.cols();
     dims[1] = mat.rows();
     dims[2] = 2;
 
-    for(i = 0; i < 3; ++i)
-        *this << dims[i];
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_32(payload, payload, numel + 3);
+#endif
 
-    return pos;
+    return this->write_tag_buffer(datasize);
 }
 
 
@@ -3122,9 +3734,8 @@ bool FiffStream::write_raw_buffer(const MatrixXd& buf, const RowVectorXd& cals)
     SparseMatrix<double> inv_calsMat(cals.cols(), cals.cols());
     inv_calsMat.setFromTriplets(tripletList.begin(), tripletList.end());
 
-    MatrixXf tmp = (inv_calsMat*buf).cast<float>();
-    this->write_float(FIFF_DATA_BUFFER,tmp.data(),tmp.rows()*tmp.cols());
-    return true;
+    MatrixXd tmp = inv_calsMat*buf;
+    return this->write_raw_data(tmp);
 }
 
 
@@ -3142,9 +3753,8 @@ bool FiffStream::write_raw_buffer(const MatrixXd& buf, const SparseMatrix<double
       for (SparseMatrix<double>::InnerIterator it(mult,k); it; ++it)
         inv_mult.coeffRef(it.row(),it.col()) = 1/it.value();
 
-    MatrixXf tmp = (inv_mult*buf).cast<float>();
-    this->write_float(FIFF_DATA_BUFFER,tmp.data(),tmp.rows()*tmp.cols());
-    return true;
+    MatrixXd tmp = inv_mult*buf;
+    return this->write_raw_data(tmp);
 }
 
 
@@ -3152,12 +3762,51 @@ bool FiffStream::write_raw_buffer(const MatrixXd& buf, const SparseMatrix<double
 
 bool FiffStream::write_raw_buffer(const MatrixXd& buf)
 {
-    MatrixXf tmp = buf.cast<float>();
-    this->write_float(FIFF_DATA_BUFFER,tmp.data(),tmp.rows()*tmp.cols());
+    return this->write_raw_data(buf);
+}
+
+
+//*************************************************************************************************************
+
+bool FiffStream::write_raw_buffer(const MatrixXf& buf, const RowVectorXd& cals)
+{
+    if (buf.rows() != cals.cols())
+    {
+        printf("buffer and calibration sizes do not match\n");
+        return false;
+    }
+
+    if(m_iRawDataType != FIFFT_FLOAT)
+    {
+        MatrixXd tmp = cals.transpose().cwiseInverse().asDiagonal() * buf.cast<double>();
+        return this->write_raw_data(tmp);
+    }
+
+    qint32 numel = buf.rows() * buf.cols();
+    fiff_int_t datasize = 4*numel;
+
+    char* payload = this->begin_tag_buffer(FIFF_DATA_BUFFER, FIFFT_FLOAT, datasize);
+
+    VectorXf inv_cals = cals.transpose().cwiseInverse().cast<float>();
+    Map<MatrixXf>((float*)payload, buf.rows(), buf.cols()) = inv_cals.asDiagonal() * buf;
+
+#ifdef INTEL_X86_ARCH
+    IOUtils::swap_copy_32(payload, payload, numel);
+#endif
+
+    this->write_tag_buffer(datasize);
     return true;
 }
 
 
+//*************************************************************************************************************
+
+bool FiffStream::write_raw_buffer(const MatrixXf& buf)
+{
+    return this->write_raw_data(buf);
+}
+
+
 //*************************************************************************************************************
 
 fiff_long_t FiffStream::write_string(fiff_int_t kind, const QString& data)
@@ -3195,33 +3844,34 @@ void FiffStream::write_rt_command(fiff_int_t command, const QString& data)
 
 QList<FiffDirEntry::SPtr> FiffStream::make_dir(bool *ok)
 {
-    FiffTag::SPtr t_pTag;
     QList<FiffDirEntry::SPtr> dir;
     FiffDirEntry::SPtr t_pFiffDirEntry;
-    fiff_long_t pos;
     if(ok) *ok = false;
     /*
     * Start from the very beginning...
     */
     if(!this->device()->seek(SEEK_SET))
         return dir;
-    while ((pos = this->read_tag_info(t_pTag)) != -1) {
+    /*
+    * Only the tag headers are needed, the payloads are not read
+    */
+    FiffTagIterator t_iterator(this, SEEK_SET);
+    while (t_iterator.next()) {
+        const FiffTagView& t_header = t_iterator.header();
         /*
         * Check that we haven't run into the directory
         */
-        if (t_pTag->kind == FIFF_DIR)
+        if (t_header.kind == FIFF_DIR)
             break;
         /*
         * Put in the new entry
         */
         t_pFiffDirEntry = FiffDirEntry::SPtr(new FiffDirEntry);
-        t_pFiffDirEntry->kind = t_pTag->kind;
-        t_pFiffDirEntry->type = t_pTag->type;
-        t_pFiffDirEntry->size = t_pTag->size();
-        t_pFiffDirEntry->pos = (fiff_long_t)pos;
+        t_pFiffDirEntry->kind = t_header.kind;
+        t_pFiffDirEntry->type = t_header.type;
+        t_pFiffDirEntry->size = t_header.size;
+        t_pFiffDirEntry->pos = (fiff_long_t)t_header.pos;
         dir.append(t_pFiffDirEntry);
-        if (t_pTag->next < 0)
-            break;
     }
     /*
     * Put in the new the terminating entry
@@ -3238,6 +3888,222 @@ QList<FiffDirEntry::SPtr> FiffStream::make_dir(bool *ok)
 }
 
 
+//*************************************************************************************************************
+
+bool FiffStream::read_dir_index(QList<FiffDirNode::SPtr>& p_Blocks)
+{
+    QFile* t_pFile = qobject_cast<QFile*>(this->device());
+    if(!t_pFile)
+        return false;
+
+    QFileInfo t_fileInfo(t_pFile->fileName());
+    QFile t_indexFile(dir_index_name(t_fileInfo.absoluteFilePath()));
+    if(!t_indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray t_baIndex = t_indexFile.readAll();
+    t_indexFile.close();
+
+    QDataStream t_stream(t_baIndex);
+    t_stream.setByteOrder(QDataStream::BigEndian);
+
+    quint32 magic;
+    qint32 version;
+    qint64 fileSize, fileTime;
+    qint32 idVersion, machid0, machid1, secs, usecs;
+    qint32 nent;
+
+    t_stream >> magic >> version;
+    if(t_stream.status() != QDataStream::Ok || magic != FIFF_DIR_INDEX_MAGIC || version != FIFF_DIR_INDEX_VERSION)
+        return false;
+
+    //
+    //   The index is only valid for the unchanged file it was made for
+    //
+    t_stream >> fileSize >> fileTime;
+    t_stream >> idVersion >> machid0 >> machid1 >> secs >> usecs;
+    t_stream >> nent;
+    if(t_stream.status() != QDataStream::Ok
+            || fileSize != t_fileInfo.size()
+            || fileTime != t_fileInfo.lastModified().toMSecsSinceEpoch()
+            || idVersion != m_id.version || machid0 != m_id.machid[0] || machid1 != m_id.machid[1]
+            || secs != m_id.time.secs || usecs != m_id.time.usecs
+            || nent < 2 || (qint64)nent * FiffDirEntry::storageSize() > t_baIndex.size())
+        return false;
+
+    QList<FiffDirEntry::SPtr> t_dir;
+    t_dir.reserve(nent);
+    for(qint32 k = 0; k < nent; ++k) {
+        FiffDirEntry::SPtr t_pEntry(new FiffDirEntry);
+        t_stream >> t_pEntry->kind >> t_pEntry->type >> t_pEntry->size >> t_pEntry->pos;
+        t_dir.append(t_pEntry);
+    }
+
+    //
+    //   Type and id of each block
+    //
+    qint32 nblocks;
+    t_stream >> nblocks;
+    if(t_stream.status() != QDataStream::Ok || nblocks < 1 || (qint64)nblocks * 6 * 4 > t_baIndex.size())
+        return false;
+
+    QList<FiffDirNode::SPtr> t_blocks;
+    t_blocks.reserve(nblocks);
+    for(qint32 k = 0; k < nblocks; ++k) {
+        FiffDirNode::SPtr t_pBlock(new FiffDirNode);
+        t_stream >> t_pBlock->type;
+        t_stream >> t_pBlock->id.version >> t_pBlock->id.machid[0] >> t_pBlock->id.machid[1];
+        t_stream >> t_pBlock->id.time.secs >> t_pBlock->id.time.usecs;
+        t_blocks.append(t_pBlock);
+    }
+
+    if(t_stream.status() != QDataStream::Ok)
+        return false;
+
+    m_dir = t_dir;
+    p_Blocks = t_blocks;
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+char* FiffStream::begin_tag_buffer(fiff_int_t kind, fiff_int_t type, fiff_int_t datasize, fiff_int_t next)
+{
+    if(m_baWriteBuffer.size() < FIFFC_DATA_OFFSET + datasize)
+        m_baWriteBuffer.resize(FIFFC_DATA_OFFSET + datasize);
+
+    qint32* head = (qint32*)m_baWriteBuffer.data();
+    head[0] = qToBigEndian<qint32>(kind);
+    head[1] = qToBigEndian<qint32>(type);
+    head[2] = qToBigEndian<qint32>(datasize);
+    head[3] = qToBigEndian<qint32>(next);
+
+    return m_baWriteBuffer.data() + FIFFC_DATA_OFFSET;
+}
+
+
+//*************************************************************************************************************
+
+fiff_long_t FiffStream::write_tag_buffer(fiff_int_t datasize)
+{
+    fiff_long_t pos = this->device()->pos();
+
+    this->writeRawData(m_baWriteBuffer.constData(), FIFFC_DATA_OFFSET + datasize);
+
+    return pos;
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+bool FiffStream::write_raw_data(const Matrix<T,Dynamic,Dynamic>& buf)
+{
+    qint32 numel = buf.rows() * buf.cols();
+
+    if(m_iRawDataType == FIFFT_INT_DELTA_RICE && !m_bCompressedRawEnabled)
+    {
+        printf("Compressed raw data buffers can only be read by MNE-CPP, see start_writing_raw\n");
+        return false;
+    }
+
+    if(m_iRawDataType == FIFFT_FLOAT)
+    {
+        char* payload = this->begin_tag_buffer(FIFF_DATA_BUFFER, FIFFT_FLOAT, 4*numel);
+        Map<MatrixXf>((float*)payload, buf.rows(), buf.cols()) = buf.template cast<float>();
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_32(payload, payload, numel);
+#endif
+        this->write_tag_buffer(4*numel);
+        return true;
+    }
+
+    if(m_vecRawMaxError.size() != buf.rows())
+    {
+        m_vecRawMaxError = RowVectorXd::Zero(buf.rows());
+        m_vecRawClipped = RowVectorXi::Zero(buf.rows());
+    }
+
+    bool is16 = m_iRawDataType == FIFFT_DAU_PACK16;
+    bool compressed = m_iRawDataType == FIFFT_INT_DELTA_RICE;
+    double maxVal = is16 ? 32767.0 : 2147483647.0;
+    double minVal = is16 ? -32768.0 : -2147483648.0;
+    qint32 elsize = is16 ? 2 : 4;
+
+    //
+    //   Compressed buffers are rounded into a scratch buffer first
+    //
+    char* payload = NULL;
+    if(compressed)
+        m_vecRawInts.resize(numel);
+    else
+        payload = this->begin_tag_buffer(FIFF_DATA_BUFFER, m_iRawDataType, elsize*numel);
+    qint16* pShort = (qint16*)payload;
+    qint32* pInt = compressed ? m_vecRawInts.data() : (qint32*)payload;
+
+    //
+    //   Samples are stored one after the other, all channels of a sample together
+    //
+    qint32 i = 0;
+    for(qint32 c = 0; c < buf.cols(); ++c)
+    {
+        for(qint32 r = 0; r < buf.rows(); ++r, ++i)
+        {
+            double value = buf(r,c);
+            double rounded = std::floor(value + 0.5);
+            if(rounded > maxVal)
+            {
+                rounded = maxVal;
+                ++m_vecRawClipped[r];
+            }
+            else if(rounded < minVal)
+            {
+                rounded = minVal;
+                ++m_vecRawClipped[r];
+            }
+            else if(std::fabs(value - rounded) > m_vecRawMaxError[r])
+            {
+                m_vecRawMaxError[r] = std::fabs(value - rounded);
+            }
+
+            if(is16)
+                pShort[i] = (qint16)rounded;
+            else
+                pInt[i] = (qint32)rounded;
+        }
+    }
+
+    if(compressed)
+    {
+        qint64 maxsize = FiffRawCodec::max_encoded_size(buf.rows(), buf.cols());
+        if(maxsize > INT_MAX)
+        {
+            printf("Raw data buffer is too large to be compressed\n");
+            return false;
+        }
+        payload = this->begin_tag_buffer(FIFF_DATA_BUFFER, FIFFT_INT_DELTA_RICE, (fiff_int_t)maxsize);
+        fiff_int_t datasize = (fiff_int_t)FiffRawCodec::encode_buffer(pInt, buf.rows(), buf.cols(), payload);
+        //
+        //   Rewrite the header with the actual size, the payload stays in place
+        //
+        this->begin_tag_buffer(FIFF_DATA_BUFFER, FIFFT_INT_DELTA_RICE, datasize);
+        this->write_tag_buffer(datasize);
+        return true;
+    }
+
+#ifdef INTEL_X86_ARCH
+    if(is16)
+        IOUtils::swap_copy_16(payload, payload, numel);
+    else
+        IOUtils::swap_copy_32(payload, payload, numel);
+#endif
+
+    this->write_tag_buffer(elsize*numel);
+    return true;
+}
+
+
 //*************************************************************************************************************
 
 bool FiffStream::check_beginning(FiffTag::SPtr &p_pTag)
@@ -44,6 +44,7 @@
 #include "fiff_global.h"
 #include "fiff_types.h"
 #include "fiff_id.h"
+#include "fiff_file.h"
 
 #include "fiff_dir_node.h"
 #include "fiff_dir_entry.h"
@@ -71,6 +72,7 @@
 #include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 
 //*************************************************************************************************************
@@ -88,6 +90,7 @@ namespace FIFFLIB
 
 class FiffStream;
 class FiffTag;
+class FiffTagView;
 class FiffCtfComp;
 class FiffRawData;
 class FiffInfo;
@@ -188,7 +191,6 @@ public:
     //=========================================================================================================
     /**
     * Returns the directory compiled into a tree
-    * tree is set when open() was called.
     *
     * @return the compiled directory
     */
@@ -223,6 +225,32 @@ public:
     */
     void finish_writing_raw();
 
+    //=========================================================================================================
+    /**
+    * Returns the largest rounding error per channel of the raw buffers written so far in integer storage mode
+    * (see start_writing_raw). The error is given in calibrated units. Clipped samples are not included.
+    *
+    * @return the maximal quantization error of each channel, empty for float storage
+    */
+    RowVectorXd raw_quantization_error() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples per channel which exceeded the integer range in integer storage mode and
+    * were clipped.
+    *
+    * @return the number of clipped samples of each channel, empty for float storage
+    */
+    RowVectorXi raw_clipped_samples() const;
+
+    //=========================================================================================================
+    /**
+    * Returns whether this stream may write FIFFT_INT_DELTA_RICE raw data buffers (see start_writing_raw).
+    *
+    * @return true if compressed raw data buffers are enabled
+    */
+    bool compressedRawEnabled() const;
+
     //=========================================================================================================
     /**
     * Helper to get all evoked entries
@@ -255,6 +283,45 @@ public:
     */
     bool open(QIODevice::OpenModeFlag mode = QIODevice::ReadOnly);
 
+    //=========================================================================================================
+    /**
+    * Enables or disables the directory index sidecar for the next open() of this stream. With the index enabled, open()
+    * loads the tag directory and the type and id of each block from the sidecar file (see dir_index_name) instead
+    * of reading or scanning the fif file, provided that the file size, modification time and file id stored in
+    * the index still match. The directory tree is then built without reading a single tag. An invalid or missing
+    * index is (re)written after the directory tree was built. Disabled by default, setup_read_raw enables it.
+    *
+    * @param[in] bEnabled   Whether to use the directory index
+    */
+    void setDirIndexEnabled(bool bEnabled);
+
+    //=========================================================================================================
+    /**
+    * Returns whether the directory index sidecar is used by open().
+    *
+    * @return true if the index is enabled
+    */
+    bool dirIndexEnabled() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the file name of the directory index sidecar which belongs to a fif file.
+    *
+    * @param[in] fileName   The fif file name
+    *
+    * @return the sidecar file name
+    */
+    static QString dir_index_name(const QString& fileName);
+
+    //=========================================================================================================
+    /**
+    * Writes the directory and the block types and ids of the opened file to the directory index sidecar. Only file
+    * devices are supported.
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool write_dir_index();
+
     //=========================================================================================================
     /**
     * Close stream
@@ -265,6 +332,31 @@ public:
     */
     bool close();
 
+    //=========================================================================================================
+    /**
+    * Maps the underlying file into memory. While the stream is mapped, tags are served directly out of the
+    * mapping (see read_tag_view) instead of being read through the QIODevice. The device has to be an opened
+    * QFile, for other devices (e.g. sockets) this function fails and the stream keeps on using regular reads.
+    * The mapping is released when the stream is closed.
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool map();
+
+    //=========================================================================================================
+    /**
+    * Releases the memory mapping of the file, if there is one.
+    */
+    void unmap();
+
+    //=========================================================================================================
+    /**
+    * Returns whether the stream is served from a memory mapped file.
+    *
+    * @return true if the stream is memory mapped
+    */
+    bool isMapped() const;
+
     //=========================================================================================================
     /**
     * Create the directory tree structure
@@ -374,15 +466,32 @@ public:
     *
     * ### MNE toolbox root function ###
     *
-    * Reads a named matrix.
+    * Reads a named matrix. Dense float matrices are converted directly out of the tag (out of the file mapping
+    * if the stream is mapped), so only the resulting double matrix is allocated.
     *
     * @param[in] p_Node     The node of interest
     * @param[in] matkind    The matrix kind to look for
     * @param[out] mat       The named matrix
+    * @param[in] transposed Whether to read the transposed matrix, row and column names are swapped accordingly.
+    *                       This is cheaper than calling FiffNamedMatrix::transpose_named_matrix afterwards.
     *
     * @return true if succeeded, false otherwise
     */
-    bool read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat);
+    bool read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat, bool transposed = false);
+
+    //=========================================================================================================
+    /**
+    * Reads a named matrix in single precision. Only the names and dimensions go to mat, mat.data stays empty.
+    *
+    * @param[in] p_Node     The node of interest
+    * @param[in] matkind    The matrix kind to look for
+    * @param[out] mat       The names and dimensions of the matrix
+    * @param[out] data      The matrix elements
+    * @param[in] transposed Whether to read the transposed matrix, row and column names are swapped accordingly.
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool read_named_matrix(const FiffDirNode::SPtr& p_Node, fiff_int_t matkind, FiffNamedMatrix& mat, MatrixXf& data, bool transposed = false);
 
     //=========================================================================================================
     /**
@@ -425,6 +534,8 @@ public:
     /**
     * Read one tag from a fif real-time stream.
     * difference to the other read tag functions is: that this function has blocking behaviour (waitForReadyRead)
+    * and waits until the complete tag arrived or the device gets closed. For event-driven reading use
+    * FiffTagParser.
     *
     * @param[out] p_pTag the read tag
     *
@@ -445,6 +556,48 @@ public:
     */
     bool read_tag(QSharedPointer<FiffTag>& p_pTag, fiff_long_t pos = -1);
 
+    //=========================================================================================================
+    /**
+    * Read one tag without copying its payload into a FiffTag.
+    * When the stream is mapped the view points directly into the file mapping, otherwise the payload is read
+    * into a scratch buffer owned by the stream. In both cases the payload stays in file byte order, use
+    * FiffTagView::copy_data to convert it into a caller-owned buffer. The view is valid until the next call to
+    * read_tag_view or until the stream gets closed.
+    * if pos is not provided, reading starts from the current file position
+    *
+    * @param[out] p_View    the read tag view
+    * @param[in] pos        position of the tag inside the fif file
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool read_tag_view(FiffTagView& p_View, fiff_long_t pos = -1);
+
+    //=========================================================================================================
+    /**
+    * Read one tag like read_tag_view, but when the stream is not mapped the payload is read into p_baBuffer
+    * instead of the scratch buffer of the stream. The buffer only grows, so reading equally sized tags into the
+    * same buffer does not allocate. The view is valid as long as p_baBuffer is not modified.
+    *
+    * @param[out] p_View            the read tag view
+    * @param[in, out] p_baBuffer    the buffer receiving the payload of an unmapped stream
+    * @param[in] pos                position of the tag inside the fif file
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool read_tag_view(FiffTagView& p_View, QByteArray& p_baBuffer, fiff_long_t pos = -1);
+
+    //=========================================================================================================
+    /**
+    * Reads only the header (kind, type, size and next) of a tag. The data pointer of the view is left empty and
+    * the payload is neither read nor skipped. Nothing is allocated. Use FiffTagIterator to walk a file tag by tag.
+    *
+    * @param[out] p_View    the tag header, data is NULL
+    * @param[in] pos        position of the tag inside the fif file, the current position if omitted
+    *
+    * @return true if succeeded, false otherwise (e.g. at the end of the file)
+    */
+    bool read_tag_header(FiffTagView& p_View, fiff_long_t pos = -1);
+
     //=========================================================================================================
     /**
     * fiff_setup_read_raw
@@ -452,6 +605,11 @@ public:
     * ### MNE toolbox root function ###
     *
     * Read information about raw data file
+    * Split recordings are followed through their FIFF_REF_FILE_NAME links (role FIFFV_ROLE_NEXT_FILE). The
+    * buffers of all files are merged into one raw directory, the samples of each continuation file follow the
+    * ones of the previous file. The streams of all files are kept in data.files.
+    * Files are opened with the directory index enabled (see setDirIndexEnabled), so the first read of a file
+    * leaves a sidecar next to it which spares later reads the directory and block tree reconstruction.
     *
     * @param[in] p_IODevice        An fiff IO device like a fiff QFile or QTCPSocket
     * @param[out] data              The raw data information - contains the opened fiff file
@@ -516,15 +674,27 @@ public:
     *
     * function [fid,cals] = fiff_start_writing_raw(name,info,sel)
     *
+    * The data buffers are stored as floats by default. With FIFFT_INT or FIFFT_DAU_PACK16 the buffers are rounded
+    * to integers, which halves the file size for 16 bit storage. For integer storage the channel calibration is
+    * replaced by cal*range of the channel or, if maxValues are given, by maxValues/(largest integer) so the expected
+    * amplitude range of each channel fits the integer type. The precision lost by the rounding is reported per
+    * channel by raw_quantization_error and raw_clipped_samples. FIFFT_INT_DELTA_RICE stores the 32 bit integers
+    * of FIFFT_INT losslessly compressed (see FiffRawCodec). The samples are rounded exactly like FIFFT_INT, so float
+    * data is only preserved to that precision, the compression itself adds no further loss. Such files can only be
+    * read by MNE-CPP, so the type is refused before anything is written unless allowCompressed is set.
+    *
     * @param[in] p_IODevice    A fiff IO device like a fiff QFile or QTCPSocket
     * @param[in] info           The measurement info block of the source file
     * @param[out] cals          Thecalibration matrix
     * @param[in] sel            Which channels will be included in the output file (optional)
     * @param[in] resetRange     Flag if the channel range is to be resetted to 1.0f (TODO: The flag was introduced due to conformity to the babyMEG system. See Limin commit from Oct 1st 2014)
+    * @param[in] data_type      Storage type of the data buffers: FIFFT_FLOAT (default), FIFFT_INT, FIFFT_DAU_PACK16 or FIFFT_INT_DELTA_RICE
+    * @param[in] maxValues      Expected maximal absolute value of each selected channel, used to rescale the calibration for integer storage (optional)
+    * @param[in] allowCompressed    Whether FIFFT_INT_DELTA_RICE may be written, i.e., the file is only read by MNE-CPP (optional)
     *
-    * @return the started fiff file
+    * @return the started fiff file, an empty pointer if FIFFT_INT_DELTA_RICE is requested without allowCompressed
     */
-    static FiffStream::SPtr start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel = defaultMatrixXi, bool resetRange = false);
+    static FiffStream::SPtr start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel = defaultMatrixXi, bool resetRange = false, fiff_int_t data_type = FIFFT_FLOAT, const RowVectorXd& maxValues = defaultRowVectorXd, bool allowCompressed = false);
 
     //=========================================================================================================
     /**
@@ -845,6 +1015,32 @@ public:
     */
     bool write_raw_buffer(const MatrixXd& buf);
 
+    //=========================================================================================================
+    /**
+    * fiff_write_raw_buffer
+    *
+    * Writes a single precision raw buffer. The calibrated buffer is written straight into the tag buffer
+    * without an intermediate double precision copy.
+    *
+    * @param[in] buf        the buffer to write
+    * @param[in] cals       calibration factors
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool write_raw_buffer(const MatrixXf& buf, const RowVectorXd& cals);
+
+    //=========================================================================================================
+    /**
+    * fiff_write_raw_buffer
+    *
+    * Writes a single precision raw buffer without calibrations.
+    *
+    * @param[in] buf        the buffer to write
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool write_raw_buffer(const MatrixXf& buf);
+
     //=========================================================================================================
     /**
     * Writes a string tag
@@ -889,6 +1085,66 @@ private:
     */
     QList<FiffDirEntry::SPtr> make_dir(bool *ok=Q_NULLPTR);
 
+    //=========================================================================================================
+    /**
+    * Loads the directory from the directory index sidecar if the index is valid for the opened file.
+    *
+    * @param[out] p_Blocks  type and id of each block in the order make_subtree visits them
+    *
+    * @return true if the directory was loaded, false if there is no valid index
+    */
+    bool read_dir_index(QList<FiffDirNode::SPtr>& p_Blocks);
+
+    //=========================================================================================================
+    /**
+    * Create the directory tree structure, taking the type and id of the blocks from p_Blocks instead of
+    * reading them from the file as long as p_Blocks has entries left.
+    *
+    * @param[in] dentry         The dir entries of which the tree should be constructed
+    * @param[in] p_Blocks       type and id of the blocks as loaded from the directory index, may be empty
+    * @param[in, out] p_iBlock  index of the next block in p_Blocks
+    *
+    * @return The created dir tree
+    */
+    FiffDirNode::SPtr make_subtree(QList<FiffDirEntry::SPtr>& dentry, const QList<FiffDirNode::SPtr>& p_Blocks, qint32& p_iBlock);
+
+    //=========================================================================================================
+    /**
+    * Prepares the write scratch buffer for a tag: writes the big endian tag header and makes room for datasize
+    * bytes of payload. The payload has to be filled in file byte order before calling write_tag_buffer.
+    *
+    * @param[in] kind       Tag kind
+    * @param[in] type       Tag type
+    * @param[in] datasize   Size of the payload in bytes
+    * @param[in] next       Next tag pointer
+    *
+    * @return pointer to the payload in the scratch buffer
+    */
+    char* begin_tag_buffer(fiff_int_t kind, fiff_int_t type, fiff_int_t datasize, fiff_int_t next = FIFFV_NEXT_SEQ);
+
+    //=========================================================================================================
+    /**
+    * Writes the tag prepared by begin_tag_buffer with a single device write.
+    *
+    * @param[in] datasize   Size of the payload in bytes, as given to begin_tag_buffer
+    *
+    * @return the position where the tag was written to
+    */
+    fiff_long_t write_tag_buffer(fiff_int_t datasize);
+
+    //=========================================================================================================
+    /**
+    * Writes a raw data buffer in the storage type chosen by start_writing_raw. The buffer has to be in file
+    * units, i.e., divided by the calibration factors already. For integer storage the samples are rounded and
+    * the per channel precision loss is recorded.
+    *
+    * @param[in] buf        The buffer to write (nchan x nsamp)
+    *
+    * @return true if succeeded, false otherwise
+    */
+    template<typename T>
+    bool write_raw_data(const Matrix<T,Dynamic,Dynamic>& buf);
+
 private:
 
 //    char         *file_name;    /**< Name of the file */ -> Use streamName() instead
@@ -897,6 +1153,17 @@ private:
     QList<FiffDirEntry::SPtr>   m_dir;  /**< This is the directory. If no directory exists, open automatically scans the file to create one. */
 //    int         nent;           /**< How many entries? */ -> Use nent() instead
     FiffDirNode::SPtr           m_dirtree; /**< Directory compiled into a tree */
+    uchar*                      m_pMappedData;  /**< Start of the memory mapped file, NULL if the stream is not mapped */
+    qint64                      m_iMappedSize;  /**< Size of the memory mapped region in bytes */
+    QByteArray                  m_baViewBuffer; /**< Scratch buffer holding the payload of read_tag_view when the stream is not mapped */
+    QByteArray                  m_baWriteBuffer; /**< Scratch buffer in which the bulk writers assemble a tag before writing it */
+    fiff_int_t                  m_iRawDataType; /**< Storage type of the raw data buffers, set by start_writing_raw */
+    RowVectorXd                 m_vecRawCals;   /**< Calibration factors of the written raw data channels */
+    RowVectorXd                 m_vecRawMaxError; /**< Largest rounding error per channel in file units (integer storage only) */
+    RowVectorXi                 m_vecRawClipped; /**< Number of clipped samples per channel (integer storage only) */
+    QVector<qint32>             m_vecRawInts;   /**< Scratch buffer holding the rounded samples before they get compressed */
+    bool                        m_bDirIndexEnabled; /**< Whether open() uses the directory index sidecar */
+    bool                        m_bCompressedRawEnabled; /**< Whether FIFFT_INT_DELTA_RICE raw data buffers may be written */
 //    char        *ext_file_name; /**< Name of the file holding the external data */
 //    FILE        *ext_fd;        /**< The file descriptor of the above file if open  */
 
@@ -255,6 +255,9 @@ QString FiffTag::getInfo() const
         case FIFFT_COMPLEX_DOUBLE:
             t_qStringInfo = "Simple type FIFFT_COMPLEX_DOUBLE";
             break;
+        case FIFFT_INT_DELTA_RICE:
+            t_qStringInfo = "Compressed type FIFFT_INT_DELTA_RICE";
+            break;
         //
         //   Structures
         //
@@ -346,9 +349,7 @@ void FiffTag::convert_matrix_from_file_data(FiffTag::SPtr tag)
 {
     int ndim;
     int k;
-    int *dimp,*data,kind,np,nz;
-    float *fdata;
-    double *ddata;
+    int *dimp,kind,np,nz;
     unsigned int tsize = tag->size();
 
     if (fiff_type_fundamental(tag->type) != FIFFTS_FS_MATRIX)
@@ -388,26 +389,21 @@ void FiffTag::convert_matrix_from_file_data(FiffTag::SPtr tag)
         /*
          * Take care of the indices
         */
-        for (data = (int *)(tag->data())+nz, k = 0; k < np; k++)
-            IOUtils::swap_intp(data+k);
+        IOUtils::swap_copy_32((int *)(tag->data())+nz, (int *)(tag->data())+nz, np);
         np = nz;
     }
     /*
      * Now convert data...
      */
     kind = fiff_type_base(tag->type);
-    if (kind == FIFFT_INT) {
-        for (data = (int *)(tag->data()), k = 0; k < np; k++)
-            IOUtils::swap_intp(data+k);
-    }
-    else if (kind == FIFFT_FLOAT) {
-        for (fdata = (float *)(tag->data()), k = 0; k < np; k++)
-            IOUtils::swap_floatp(fdata+k);
-    }
-    else if (kind == FIFFT_DOUBLE) {
-        for (ddata = (double *)(tag->data()), k = 0; k < np; k++)
-            IOUtils::swap_doublep(ddata+k);
-    }
+    if (kind == FIFFT_INT || kind == FIFFT_FLOAT)
+        IOUtils::swap_copy_32(tag->data(), tag->data(), np);
+    else if (kind == FIFFT_DOUBLE)
+        IOUtils::swap_copy_64(tag->data(), tag->data(), np);
+    else if (kind == FIFFT_COMPLEX_FLOAT)
+        IOUtils::swap_copy_32(tag->data(), tag->data(), 2*np);
+    else if (kind == FIFFT_COMPLEX_DOUBLE)
+        IOUtils::swap_copy_64(tag->data(), tag->data(), 2*np);
     return;
 }
 
@@ -421,9 +417,7 @@ void FiffTag::convert_matrix_to_file_data(FiffTag::SPtr tag)
 {
     int ndim;
     int k;
-    int *dimp,*data,kind,np;
-    float *fdata;
-    double *ddata;
+    int *dimp,kind,np;
     unsigned int tsize = tag->size();
 
     if (fiff_type_fundamental(tag->type) != FIFFTS_FS_MATRIX)
@@ -465,26 +459,14 @@ void FiffTag::convert_matrix_to_file_data(FiffTag::SPtr tag)
     * Now convert data...
     */
     kind = fiff_type_base(tag->type);
-    if (kind == FIFFT_INT) {
-        for (data = (int *)(tag->data()), k = 0; k < np; k++)
-            IOUtils::swap_intp(data+k);
-    }
-    else if (kind == FIFFT_FLOAT) {
-        for (fdata = (float *)(tag->data()), k = 0; k < np; k++)
-            IOUtils::swap_floatp(fdata+k);
-    }
-    else if (kind == FIFFT_DOUBLE) {
-        for (ddata = (double *)(tag->data()), k = 0; k < np; k++)
-            IOUtils::swap_doublep(ddata+k);
-    }
-    else if (kind == FIFFT_COMPLEX_FLOAT) {
-        for (fdata = (float *)(tag->data()), k = 0; k < 2*np; k++)
-            IOUtils::swap_floatp(fdata+k);
-    }
-    else if (kind == FIFFT_COMPLEX_DOUBLE) {
-        for (ddata = (double *)(tag->data()), k = 0; k < 2*np; k++)
-            IOUtils::swap_doublep(ddata+k);
-    }
+    if (kind == FIFFT_INT || kind == FIFFT_FLOAT)
+        IOUtils::swap_copy_32(tag->data(), tag->data(), np);
+    else if (kind == FIFFT_DOUBLE)
+        IOUtils::swap_copy_64(tag->data(), tag->data(), np);
+    else if (kind == FIFFT_COMPLEX_FLOAT)
+        IOUtils::swap_copy_32(tag->data(), tag->data(), 2*np);
+    else if (kind == FIFFT_COMPLEX_DOUBLE)
+        IOUtils::swap_copy_64(tag->data(), tag->data(), 2*np);
     return;
 }
 
@@ -497,10 +479,7 @@ void FiffTag::convert_tag_data(FiffTag::SPtr tag, int from_endian, int to_endian
     int            k,r;//,c;
     char           *offset;
     fiff_int_t     *ithis;
-    fiff_short_t   *sthis;
-    fiff_long_t    *lthis;
     float          *fthis;
-    double         *dthis;
 //    fiffDirEntry   dethis;
 //    fiffId         idthis;
 //    fiffChInfoRec* chthis;//FiffChInfo*     chthis;//ToDo adapt parsing to the new class
@@ -533,38 +512,28 @@ void FiffTag::convert_tag_data(FiffTag::SPtr tag, int from_endian, int to_endian
     case FIFFT_INT :
     case FIFFT_JULIAN :
     case FIFFT_UINT :
-        np = tag->size()/sizeof(fiff_int_t);
-        for (ithis = (fiff_int_t *)tag->data(), k = 0; k < np; k++, ithis++)
-            IOUtils::swap_intp(ithis);
+        IOUtils::swap_copy_32(tag->data(), tag->data(), tag->size()/sizeof(fiff_int_t));
         break;
 
     case FIFFT_LONG :
     case FIFFT_ULONG :
-        np = tag->size()/sizeof(fiff_long_t);
-        for (lthis = (fiff_long_t *)tag->data(), k = 0; k < np; k++, lthis++)
-            IOUtils::swap_longp(lthis);
+        IOUtils::swap_copy_64(tag->data(), tag->data(), tag->size()/sizeof(fiff_long_t));
         break;
 
     case FIFFT_SHORT :
     case FIFFT_DAU_PACK16 :
     case FIFFT_USHORT :
-        np = tag->size()/sizeof(fiff_short_t);
-        for (sthis = (fiff_short_t *)tag->data(), k = 0; k < np; k++, sthis++)
-            *sthis = IOUtils::swap_short(*sthis);
+        IOUtils::swap_copy_16(tag->data(), tag->data(), tag->size()/sizeof(fiff_short_t));
         break;
 
     case FIFFT_FLOAT :
     case FIFFT_COMPLEX_FLOAT :
-        np = tag->size()/sizeof(fiff_float_t);
-        for (fthis = (fiff_float_t *)tag->data(), k = 0; k < np; k++, fthis++)
-            IOUtils::swap_floatp(fthis);
+        IOUtils::swap_copy_32(tag->data(), tag->data(), tag->size()/sizeof(fiff_float_t));
         break;
 
     case FIFFT_DOUBLE :
     case FIFFT_COMPLEX_DOUBLE :
-        np = tag->size()/sizeof(fiff_double_t);
-        for (dthis = (fiff_double_t *)tag->data(), k = 0; k < np; k++, dthis++)
-            IOUtils::swap_doublep(dthis);
+        IOUtils::swap_copy_64(tag->data(), tag->data(), tag->size()/sizeof(fiff_double_t));
         break;
 
     case FIFFT_OLD_PACK :
@@ -574,10 +543,7 @@ void FiffTag::convert_tag_data(FiffTag::SPtr tag, int from_endian, int to_endian
      */
         IOUtils::swap_floatp(fthis+0);
         IOUtils::swap_floatp(fthis+1);
-        sthis = (short *)(fthis+2);
-        np = (tag->size() - 2*sizeof(float))/sizeof(short);
-        for (k = 0; k < np; k++,sthis++)
-            *sthis = IOUtils::swap_short(*sthis);
+        IOUtils::swap_copy_16(fthis+2, fthis+2, (tag->size() - 2*sizeof(float))/sizeof(short));
         break;
 
     case FIFFT_DIR_ENTRY_STRUCT :
@@ -0,0 +1,106 @@
+//=============================================================================================================
+/**
+* @file     fiff_tag_iterator.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffTagIterator class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_tag_iterator.h"
+#include "fiff_stream.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffTagIterator::FiffTagIterator(FiffStream* p_pStream, fiff_long_t startPos)
+: m_pStream(p_pStream)
+, m_iNextPos(startPos)
+, m_bPayload(false)
+, m_iCount(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+bool FiffTagIterator::next()
+{
+    m_bPayload = false;
+
+    if (m_iNextPos < 0 || !m_pStream->read_tag_header(m_view, m_iNextPos)) {
+        m_view.clear();
+        m_iNextPos = -1;
+        return false;
+    }
+
+    //
+    //   Follow the next pointer, sequential tags are stored right after the payload
+    //
+    if (m_view.next == FIFFV_NEXT_SEQ)
+        m_iNextPos = m_view.pos + FIFFC_DATA_OFFSET + m_view.size;
+    else if (m_view.next > 0)
+        m_iNextPos = m_view.next;
+    else
+        m_iNextPos = -1;
+
+    ++m_iCount;
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+const FiffTagView& FiffTagIterator::payload()
+{
+    if (!m_bPayload && !m_view.isEmpty()) {
+        if (!m_pStream->read_tag_view(m_view, m_view.pos))
+            m_view.clear();
+        m_bPayload = true;
+    }
+
+    return m_view;
+}
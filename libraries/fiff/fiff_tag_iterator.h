@@ -0,0 +1,159 @@
+//=============================================================================================================
+/**
+* @file     fiff_tag_iterator.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffTagIterator class declaration.
+*
+*/
+
+#ifndef FIFF_TAG_ITERATOR_H
+#define FIFF_TAG_ITERATOR_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_tag_view.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class FiffStream;
+
+
+//=============================================================================================================
+/**
+* Walks a fif file tag by tag following the next pointers of the tags. Only the tag headers are read while
+* iterating, the payload of the current tag is read on request into the scratch buffer of the stream (or taken
+* directly from the mapping of a memory mapped stream). Neither iterating nor reading payloads allocates per
+* tag, so arbitrarily long files are scanned with constant memory. The stream has to be opened on a random
+* access device (e.g. a QFile); the iterator does not take ownership of the stream.
+*
+* @code
+* FiffTagIterator it(stream.data());
+* while(it.next()) {
+*     if(it.header().kind == FIFF_BLOCK_START) {
+*         qint32 block;
+*         it.payload().copy_data((char*)&block);
+*     }
+* }
+* @endcode
+*
+* @brief Allocation free, pull style iterator over the tags of a fif file
+*/
+class FIFFSHARED_EXPORT FiffTagIterator
+{
+public:
+    //=========================================================================================================
+    /**
+    * Constructs the iterator. The first call to next() moves to the tag at startPos.
+    *
+    * @param[in] p_pStream  The stream to iterate
+    * @param[in] startPos   Position of the first tag (default = start of the file)
+    */
+    FiffTagIterator(FiffStream* p_pStream, fiff_long_t startPos = 0);
+
+    //=========================================================================================================
+    /**
+    * Moves to the next tag and reads its header.
+    *
+    * @return true if a tag was read, false at the end of the tag sequence or on a read error
+    */
+    bool next();
+
+    //=========================================================================================================
+    /**
+    * The header of the current tag. The data pointer is only set after payload() was called.
+    *
+    * @return the current tag
+    */
+    inline const FiffTagView& header() const;
+
+    //=========================================================================================================
+    /**
+    * Reads the payload of the current tag, if not already done. The payload stays valid until the iterator
+    * moves on or the stream reads another tag view.
+    *
+    * @return the current tag including its payload in file byte order, an empty view on a read error
+    */
+    const FiffTagView& payload();
+
+    //=========================================================================================================
+    /**
+    * Number of tags visited so far.
+    *
+    * @return the number of tags
+    */
+    inline qint64 count() const;
+
+private:
+    FiffStream*     m_pStream;      /**< The iterated stream. */
+    FiffTagView     m_view;         /**< The current tag. */
+    fiff_long_t     m_iNextPos;     /**< Position of the next tag, -1 if the current tag is the last one. */
+    bool            m_bPayload;     /**< Whether the payload of the current tag was read. */
+    qint64          m_iCount;       /**< Number of visited tags. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline const FiffTagView& FiffTagIterator::header() const
+{
+    return m_view;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffTagIterator::count() const
+{
+    return m_iCount;
+}
+
+} // NAMESPACE
+
+#endif // FIFF_TAG_ITERATOR_H
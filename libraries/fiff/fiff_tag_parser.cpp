@@ -0,0 +1,242 @@
+//=============================================================================================================
+/**
+* @file     fiff_tag_parser.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffTagParser Class.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_tag_parser.h"
+#include "fiff_tag_view.h"
+#include "fiff_constants.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QtEndian>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <cstring>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffTagParser::FiffTagParser(QObject *parent)
+: QObject(parent)
+, m_iBufferStart(0)
+, m_iBufferEnd(0)
+, m_iStreamPos(0)
+, m_iTagArrival(-1)
+, m_iTagCount(0)
+, m_iLastLatency(0)
+, m_iMaxLatency(0)
+, m_iSumLatency(0)
+{
+    m_timer.start();
+}
+
+
+//*************************************************************************************************************
+
+void FiffTagParser::attach(QIODevice* p_pDevice)
+{
+    if(m_pDevice)
+        disconnect(m_pDevice.data(), &QIODevice::readyRead, this, &FiffTagParser::readDevice);
+
+    m_pDevice = p_pDevice;
+
+    if(m_pDevice) {
+        connect(m_pDevice.data(), &QIODevice::readyRead, this, &FiffTagParser::readDevice);
+        if(m_pDevice->bytesAvailable() > 0)
+            readDevice();
+    }
+}
+
+
+//*************************************************************************************************************
+
+bool FiffTagParser::append(const char* p_pData, qint64 size)
+{
+    if(size <= 0)
+        return true;
+
+    qint64 arrival = m_timer.nsecsElapsed();
+    memcpy(reserve(size), p_pData, size);
+    m_iBufferEnd += size;
+
+    return parse(arrival);
+}
+
+
+//*************************************************************************************************************
+
+void FiffTagParser::reset()
+{
+    m_iStreamPos += m_iBufferEnd - m_iBufferStart;
+    m_iBufferStart = 0;
+    m_iBufferEnd = 0;
+    m_iTagArrival = -1;
+}
+
+
+//*************************************************************************************************************
+
+void FiffTagParser::resetStatistics()
+{
+    m_iTagCount = 0;
+    m_iLastLatency = 0;
+    m_iMaxLatency = 0;
+    m_iSumLatency = 0;
+}
+
+
+//*************************************************************************************************************
+
+void FiffTagParser::readDevice()
+{
+    if(!m_pDevice)
+        return;
+
+    //
+    //   Read straight into the receive buffer
+    //
+    qint64 size;
+    while((size = m_pDevice->bytesAvailable()) > 0) {
+        qint64 arrival = m_timer.nsecsElapsed();
+        qint64 nread = m_pDevice->read(reserve(size), size);
+        if(nread <= 0)
+            return;
+        m_iBufferEnd += nread;
+
+        if(!parse(arrival))
+            return;
+    }
+}
+
+
+//*************************************************************************************************************
+
+char* FiffTagParser::reserve(qint64 size)
+{
+    if(m_iBufferStart == m_iBufferEnd) {
+        m_iBufferStart = 0;
+        m_iBufferEnd = 0;
+    }
+
+    if(m_iBufferEnd + size > m_baBuffer.size()) {
+        //
+        //   Move the pending bytes to the front, grow only if that is not enough
+        //
+        qint64 pending = m_iBufferEnd - m_iBufferStart;
+        if(m_iBufferStart > 0 && pending > 0)
+            memmove(m_baBuffer.data(), m_baBuffer.constData() + m_iBufferStart, pending);
+        m_iBufferStart = 0;
+        m_iBufferEnd = pending;
+
+        if(pending + size > m_baBuffer.size())
+            m_baBuffer.resize((int)qMax(pending + size, 2 * (qint64)m_baBuffer.size()));
+    }
+
+    return m_baBuffer.data() + m_iBufferEnd;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffTagParser::parse(qint64 arrival)
+{
+    if(m_iTagArrival < 0)
+        m_iTagArrival = arrival;
+
+    while(m_iBufferEnd - m_iBufferStart >= FIFFC_DATA_OFFSET) {
+        const uchar* head = (const uchar*)m_baBuffer.constData() + m_iBufferStart;
+
+        FiffTagView t_view;
+        t_view.pos  = m_iStreamPos;
+        t_view.kind = qFromBigEndian<qint32>(head);
+        t_view.type = qFromBigEndian<qint32>(head + 4);
+        t_view.size = qFromBigEndian<qint32>(head + 8);
+        t_view.next = qFromBigEndian<qint32>(head + 12);
+
+        if(t_view.size < 0) {
+            qWarning("FiffTagParser::parse - Negative tag size at stream position %lld, dropping %lld bytes.", (long long)m_iStreamPos, (long long)(m_iBufferEnd - m_iBufferStart));
+            reset();
+            return false;
+        }
+
+        qint64 tagsize = FIFFC_DATA_OFFSET + (qint64)t_view.size;
+        if(m_iBufferEnd - m_iBufferStart < tagsize)
+            break;
+
+        t_view.data = (const char*)head + FIFFC_DATA_OFFSET;
+        FiffTag::SPtr t_pTag = t_view.toFiffTag();
+
+        m_iBufferStart += tagsize;
+        m_iStreamPos += tagsize;
+
+        m_iLastLatency = m_timer.nsecsElapsed() - m_iTagArrival;
+        m_iMaxLatency = qMax(m_iMaxLatency, m_iLastLatency);
+        m_iSumLatency += m_iLastLatency;
+        ++m_iTagCount;
+
+        //
+        //   Bytes behind the tag came with the last chunk
+        //
+        m_iTagArrival = m_iBufferEnd > m_iBufferStart ? arrival : -1;
+
+        emit tagReceived(t_pTag);
+    }
+
+    return true;
+}
@@ -0,0 +1,288 @@
+//=============================================================================================================
+/**
+* @file     fiff_tag_parser.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffTagParser class declaration.
+*
+*/
+
+#ifndef FIFF_TAG_PARSER_H
+#define FIFF_TAG_PARSER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_tag.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QIODevice>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+
+//=============================================================================================================
+/**
+* Incremental decoder for fiff tag streams arriving over sequential devices (e.g. the sockets of mne_rt_server).
+* Bytes are handed over as they arrive, either with append or by attaching the parser to a device whose
+* readyRead signal then drives the parser. The bytes are accumulated in a buffer that is reused for the whole
+* stream, and every complete tag is emitted with tagReceived right away. Nothing waits for data, there is no
+* polling.
+*
+* For each tag the latency between the arrival of its first byte and its emission is measured, see
+* lastLatency, maxLatency and meanLatency.
+*
+* Slots connected to tagReceived must not call append or reset of the same parser.
+*
+* @brief Event-driven fiff tag decoder
+*/
+class FIFFSHARED_EXPORT FiffTagParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef QSharedPointer<FiffTagParser> SPtr;             /**< Shared pointer type for FiffTagParser. */
+    typedef QSharedPointer<const FiffTagParser> ConstSPtr;  /**< Const shared pointer type for FiffTagParser. */
+
+    //=========================================================================================================
+    /**
+    * Constructs the parser.
+    *
+    * @param[in] parent     Parent QObject (optional)
+    */
+    explicit FiffTagParser(QObject *parent = 0);
+
+    //=========================================================================================================
+    /**
+    * Reads from p_pDevice whenever it emits readyRead. Bytes which are already available are parsed right away.
+    * A previously attached device is detached. The parser does not take ownership of the device.
+    *
+    * @param[in] p_pDevice  The device to read from, NULL to detach
+    */
+    void attach(QIODevice* p_pDevice);
+
+    //=========================================================================================================
+    /**
+    * Appends received bytes and emits tagReceived for every tag completed by them.
+    *
+    * @param[in] p_pData    The received bytes
+    * @param[in] size       Number of bytes
+    *
+    * @return false if the stream is damaged (negative tag size), the pending bytes are dropped in that case
+    */
+    bool append(const char* p_pData, qint64 size);
+
+    //=========================================================================================================
+    /**
+    * Appends received bytes and emits tagReceived for every tag completed by them.
+    *
+    * @param[in] p_baData   The received bytes
+    *
+    * @return false if the stream is damaged (negative tag size), the pending bytes are dropped in that case
+    */
+    inline bool append(const QByteArray& p_baData);
+
+    //=========================================================================================================
+    /**
+    * Drops pending bytes, e.g. after reconnecting. The latency statistics are kept.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Returns the number of received bytes which do not form a complete tag yet.
+    *
+    * @return the number of pending bytes
+    */
+    inline qint64 pendingBytes() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of emitted tags.
+    *
+    * @return the number of tags
+    */
+    inline qint64 tagCount() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the latency of the last emitted tag, measured from the arrival of its first byte to its emission.
+    *
+    * @return the latency in nanoseconds
+    */
+    inline qint64 lastLatency() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the largest latency of all emitted tags.
+    *
+    * @return the latency in nanoseconds
+    */
+    inline qint64 maxLatency() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the mean latency of all emitted tags.
+    *
+    * @return the latency in nanoseconds, 0 if no tag was emitted yet
+    */
+    inline double meanLatency() const;
+
+    //=========================================================================================================
+    /**
+    * Resets the tag count and the latency statistics.
+    */
+    void resetStatistics();
+
+signals:
+    //=========================================================================================================
+    /**
+    * Emitted for every complete tag. The tag data is converted to the native byte order.
+    *
+    * @param[in] p_pTag     The received tag
+    */
+    void tagReceived(const QSharedPointer<FIFFLIB::FiffTag>& p_pTag);
+
+private slots:
+    //=========================================================================================================
+    /**
+    * Parses all bytes available at the attached device.
+    */
+    void readDevice();
+
+private:
+    //=========================================================================================================
+    /**
+    * Makes room for size more bytes behind the pending bytes, moving the pending bytes to the front of the
+    * buffer first.
+    *
+    * @param[in] size       Number of bytes to make room for
+    *
+    * @return where to put the bytes
+    */
+    char* reserve(qint64 size);
+
+    //=========================================================================================================
+    /**
+    * Emits all complete tags among the pending bytes.
+    *
+    * @param[in] arrival    Arrival time of the bytes appended last
+    *
+    * @return false if the stream is damaged
+    */
+    bool parse(qint64 arrival);
+
+    QPointer<QIODevice> m_pDevice;      /**< The attached device */
+    QByteArray          m_baBuffer;     /**< Reused receive buffer */
+    qint64              m_iBufferStart; /**< Start of the pending bytes within the buffer */
+    qint64              m_iBufferEnd;   /**< End of the pending bytes within the buffer */
+    qint64              m_iStreamPos;   /**< Stream position of the first pending byte */
+    QElapsedTimer       m_timer;        /**< Clock of the latency measurement */
+    qint64              m_iTagArrival;  /**< Arrival time of the first byte of the pending tag, -1 if none */
+    qint64              m_iTagCount;    /**< Number of emitted tags */
+    qint64              m_iLastLatency; /**< Latency of the last tag in ns */
+    qint64              m_iMaxLatency;  /**< Maximal latency in ns */
+    qint64              m_iSumLatency;  /**< Summed latency in ns */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool FiffTagParser::append(const QByteArray& p_baData)
+{
+    return append(p_baData.constData(), p_baData.size());
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffTagParser::pendingBytes() const
+{
+    return m_iBufferEnd - m_iBufferStart;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffTagParser::tagCount() const
+{
+    return m_iTagCount;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffTagParser::lastLatency() const
+{
+    return m_iLastLatency;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 FiffTagParser::maxLatency() const
+{
+    return m_iMaxLatency;
+}
+
+
+//*************************************************************************************************************
+
+inline double FiffTagParser::meanLatency() const
+{
+    return m_iTagCount > 0 ? (double)m_iSumLatency / m_iTagCount : 0.0;
+}
+
+} // NAMESPACE
+
+#endif // FIFF_TAG_PARSER_H
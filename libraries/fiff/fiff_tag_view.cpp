@@ -0,0 +1,194 @@
+//=============================================================================================================
+/**
+* @file     fiff_tag_view.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the FiffTagView Class.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_tag_view.h"
+#include "fiff_tag.h"
+
+#include <utils/ioutils.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <string.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffTagView::FiffTagView()
+: pos(-1)
+, kind(-1)
+, type(-1)
+, size(0)
+, next(0)
+, data(NULL)
+{
+}
+
+
+//*************************************************************************************************************
+
+void FiffTagView::clear()
+{
+    pos = -1;
+    kind = -1;
+    type = -1;
+    size = 0;
+    next = 0;
+    data = NULL;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffTagView::isMatrix() const
+{
+    return (IS_MATRIX & type) != 0;
+}
+
+
+//*************************************************************************************************************
+
+fiff_int_t FiffTagView::getType() const
+{
+    if (this->isMatrix())
+        return DATA_TYPE & type;
+    else
+        return type;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffTagView::copy_data(char* p_pDest) const
+{
+    if(this->isMatrix())
+        return false;
+
+    if(size <= 0 || data == NULL)
+        return true;
+
+    //
+    //  Copy and swap in one pass
+    //
+    switch (type) {
+
+    case FIFFT_BYTE :
+    case FIFFT_STRING :
+    case FIFFT_VOID :
+        memcpy(p_pDest, data, size);
+        break;
+
+    case FIFFT_INT :
+    case FIFFT_JULIAN :
+    case FIFFT_UINT :
+    case FIFFT_FLOAT :
+    case FIFFT_COMPLEX_FLOAT :
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_32(data, p_pDest, size/4);
+#else
+        memcpy(p_pDest, data, size);
+#endif
+        break;
+
+    case FIFFT_LONG :
+    case FIFFT_ULONG :
+    case FIFFT_DOUBLE :
+    case FIFFT_COMPLEX_DOUBLE :
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_64(data, p_pDest, size/8);
+#else
+        memcpy(p_pDest, data, size);
+#endif
+        break;
+
+    case FIFFT_SHORT :
+    case FIFFT_DAU_PACK16 :
+    case FIFFT_USHORT :
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_16(data, p_pDest, size/2);
+#else
+        memcpy(p_pDest, data, size);
+#endif
+        break;
+
+    default :
+        return false;
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+FiffTag::SPtr FiffTagView::toFiffTag() const
+{
+    if(this->isEmpty())
+        return FiffTag::SPtr();
+
+    FiffTag::SPtr t_pTag(new FiffTag());
+    t_pTag->kind = kind;
+    t_pTag->type = type;
+    t_pTag->next = next;
+    t_pTag->resize(size);
+
+    if(size > 0 && data != NULL)
+    {
+        memcpy(t_pTag->data(), data, size);
+        FiffTag::convert_tag_data(t_pTag,FIFFV_BIG_ENDIAN,FIFFV_NATIVE_ENDIAN);
+    }
+
+    return t_pTag;
+}
@@ -0,0 +1,166 @@
+//=============================================================================================================
+/**
+* @file     fiff_tag_view.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    FiffTagView class declaration.
+*
+*/
+
+#ifndef FIFF_TAG_VIEW_H
+#define FIFF_TAG_VIEW_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class FiffTag;
+
+
+//=============================================================================================================
+/**
+* A tag view describes a tag without owning its payload. The data pointer refers either to a memory mapped
+* fiff file or to a scratch buffer of the stream which produced the view. The payload is kept in file byte
+* order (big endian), the conversion to the native byte order is done when the data are copied out of the view.
+* A view is only valid until the next read on the stream which created it or until the stream gets closed.
+*
+* @brief Non-owning view on a FIFF data tag
+*/
+class FIFFSHARED_EXPORT FiffTagView
+{
+public:
+    typedef QSharedPointer<FiffTagView> SPtr;               /**< Shared pointer type for FiffTagView. */
+    typedef QSharedPointer<const FiffTagView> ConstSPtr;    /**< Const shared pointer type for FiffTagView. */
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty tag view.
+    */
+    FiffTagView();
+
+    //=========================================================================================================
+    /**
+    * Resets the view.
+    */
+    void clear();
+
+    //=========================================================================================================
+    /**
+    * True if the view does not refer to a tag.
+    *
+    * @return true if view is empty
+    */
+    inline bool isEmpty() const;
+
+    //=========================================================================================================
+    /**
+    * Provides information if the viewed tag contains a matrix
+    *
+    * @return true if tag contains a matrix
+    */
+    bool isMatrix() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the data type of the viewed tag. For matrices the element type is returned.
+    *
+    * @return the data type
+    */
+    fiff_int_t getType() const;
+
+    //=========================================================================================================
+    /**
+    * Copies the payload to a caller-owned buffer and converts it to the native byte order on the fly.
+    * Supported are all simple (non-structure, non-matrix) types. The destination has to provide at least
+    * size bytes.
+    *
+    * @param[out] p_pDest   Destination buffer
+    *
+    * @return true if succeeded, false if the tag type can not be converted without a FiffTag
+    */
+    bool copy_data(char* p_pDest) const;
+
+    //=========================================================================================================
+    /**
+    * Materializes the viewed tag into a self-contained FiffTag which is converted to the native byte order.
+    * This works for all tag types but involves an allocation.
+    *
+    * @return the materialized tag, an empty pointer if the view is empty
+    */
+    QSharedPointer<FiffTag> toFiffTag() const;
+
+public:
+    fiff_long_t         pos;    /**< Position of the tag header inside the file */
+    fiff_int_t          kind;   /**< Tag number */
+    fiff_int_t          type;   /**< Data type */
+    fiff_int_t          size;   /**< Size of the payload in bytes */
+    fiff_int_t          next;   /**< Pointer to the next object */
+    const char*         data;   /**< Payload in file byte order; not owned by the view */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool FiffTagView::isEmpty() const
+{
+    return kind == -1;
+}
+
+} // NAMESPACE
+
+#endif // FIFF_TAG_VIEW_H
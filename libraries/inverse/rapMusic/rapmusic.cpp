@@ -135,24 +135,26 @@ bool RapMusic::init(MNEForwardSolution& p_pFwd, bool p_bSparsed, int p_iN, doubl
 //    m_pMatGrid = p_pMatGrid;
 
 
+    //The search works on a double precision gain matrix
+    m_ForwardSolution = p_pFwd;
+    m_ForwardSolution.to_double_gain();
+
     //Lead Field check
-    if ( p_pFwd.sol->data.cols() % 3 != 0 )
+    if ( m_ForwardSolution.sol->data.cols() % 3 != 0 )
     {
         std::cout << "Gain matrix is not associated with a 3D grid!\n";
         return false;
     }
 
-    m_iNumGridPoints = p_pFwd.sol->data.cols()/3;
+    m_iNumGridPoints = m_ForwardSolution.sol->data.cols()/3;
 
-    m_iNumChannels = p_pFwd.sol->data.rows();
+    m_iNumChannels = m_ForwardSolution.sol->data.rows();
 
 //    m_pMappedMatLeadField = new Eigen::Map<MatrixXT>
 //        (   p_pMatLeadField->data(),
 //            p_pMatLeadField->rows(),
 //            p_pMatLeadField->cols() );
 
-    m_ForwardSolution = p_pFwd;
-
     //##### Calc lead field combination #####
 
     std::cout << "Calculate gain matrix combinations. \n";
@@ -91,6 +91,7 @@ SOURCES += \
     mne_inverse_operator.cpp \
     mne_epoch_data.cpp \
     mne_epoch_data_list.cpp \
+    mne_epoch_data_file.cpp \
     mne_cluster_info.cpp \
     mne_surface.cpp \
     mne_corsourceestimate.cpp\
@@ -141,6 +142,7 @@ HEADERS += \
     mne_inverse_operator.h \
     mne_epoch_data.h \
     mne_epoch_data_list.h \
+    mne_epoch_data_file.h \
     mne_cluster_info.h \
     mne_surface.h \
     mne_corsourceestimate.h\
@@ -56,6 +56,7 @@ using namespace MNELIB;
 
 MNEEpochData::MNEEpochData()
 : event(-1)
+, sample(-1)
 , tmin(-1)
 , tmax(-1)
 {
@@ -68,6 +69,7 @@ MNEEpochData::MNEEpochData()
 MNEEpochData::MNEEpochData(const MNEEpochData &p_MNEEpochData)
 : epoch(p_MNEEpochData.epoch)
 , event(p_MNEEpochData.event)
+, sample(p_MNEEpochData.sample)
 , tmin(p_MNEEpochData.tmin)
 , tmax(p_MNEEpochData.tmax)
 {
@@ -132,6 +132,7 @@ public:
 public:
     MatrixXd    epoch;          /**< The data */
     FIFFLIB::fiff_int_t  event; /**< The event code */
+    FIFFLIB::fiff_int_t  sample;    /**< The sample of the event, including the first sample of the recording; -1 if unknown */
     float       tmin;           /**< New start time (must be >= 0). */
     float       tmax;           /**< New end time of the data (cannot exceed data duration). */
 
@@ -0,0 +1,389 @@
+//=============================================================================================================
+/**
+* @file     mne_epoch_data_file.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the MNEEpochDataFile Class.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_epoch_data_file.h"
+
+#include <fiff/fiff_tag.h>
+#include <fiff/fiff_tag_view.h>
+#include <fiff/fiff_dir_node.h>
+#include <utils/ioutils.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QtEndian>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace MNELIB;
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+MNEEpochDataFile::MNEEpochDataFile(QIODevice& p_IODevice)
+: m_iNumEpochs(0)
+, m_iNchan(0)
+, m_iNsamp(0)
+, m_fTmin(0.0f)
+, m_fTmax(0.0f)
+, m_bValid(false)
+{
+    m_lStreams.append(FiffStream::SPtr(new FiffStream(&p_IODevice)));
+    m_bValid = open();
+    if(!m_bValid)
+        for(qint32 k = 0; k < m_lStreams.size(); ++k)
+            m_lStreams[k]->close();
+}
+
+
+//*************************************************************************************************************
+
+MNEEpochDataFile::~MNEEpochDataFile()
+{
+    for(qint32 k = 0; k < m_lStreams.size(); ++k)
+        m_lStreams[k]->close();
+}
+
+
+//*************************************************************************************************************
+
+MNEEpochData::SPtr MNEEpochDataFile::epoch(qint32 idx) const
+{
+    if(!m_bValid || idx < 0 || idx >= m_iNumEpochs) {
+        printf("Epoch %d does not exist\n", idx);
+        return MNEEpochData::SPtr();
+    }
+
+    //
+    //   Find the tag holding the epoch
+    //
+    qint32 tag = (qint32)(std::upper_bound(m_vecTagFirst.constBegin(), m_vecTagFirst.constEnd(), idx) - m_vecTagFirst.constBegin()) - 1;
+    qint64 numel = (qint64)m_iNchan * m_iNsamp;
+    qint64 offset = (idx - m_vecTagFirst[tag]) * numel * 4;
+    Matrix<float, Dynamic, Dynamic, RowMajor> buffer(m_iNchan, m_iNsamp);
+
+    if(!m_vecPayload.isEmpty()) {
+        //
+        //   Convert straight out of the mapping
+        //
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_32(m_vecPayload[tag] + offset, buffer.data(), numel);
+#else
+        memcpy(buffer.data(), m_vecPayload[tag] + offset, numel * 4);
+#endif
+    }
+    else {
+        if(!read_payload(tag, offset, (char*)buffer.data(), numel * 4))
+            return MNEEpochData::SPtr();
+#ifdef INTEL_X86_ARCH
+        IOUtils::swap_copy_32(buffer.data(), buffer.data(), numel);
+#endif
+    }
+
+    MNEEpochData::SPtr t_pEpoch(new MNEEpochData());
+    t_pEpoch->epoch = buffer.cast<double>();
+    t_pEpoch->event = m_vecEvents.size() == m_iNumEpochs ? m_vecEvents[idx] : 0;
+    t_pEpoch->sample = m_vecEventSamples.size() == m_iNumEpochs ? m_vecEventSamples[idx] : -1;
+    t_pEpoch->tmin = m_fTmin;
+    t_pEpoch->tmax = m_fTmax;
+
+    return t_pEpoch;
+}
+
+
+//*************************************************************************************************************
+
+static void delete_split_stream(FiffStream* p_pStream)
+{
+    //
+    //   Streams of continuation files own their file
+    //
+    QIODevice* t_pDevice = p_pStream->device();
+    delete p_pStream;
+    delete t_pDevice;
+}
+
+
+//*************************************************************************************************************
+
+static QString find_next_epochs_file(const FiffStream::SPtr& p_pStream)
+{
+    FiffTag::SPtr t_pTag;
+    QList<FiffDirNode::SPtr> refs = p_pStream->dirtree()->dir_tree_find(FIFFB_REF);
+
+    for(qint32 k = 0; k < refs.size(); ++k) {
+        if(!refs[k]->find_tag(p_pStream.data(), FIFF_REF_ROLE, t_pTag) || *t_pTag->toInt() != FIFFV_ROLE_NEXT_FILE)
+            continue;
+        if(!refs[k]->find_tag(p_pStream.data(), FIFF_REF_FILE_NAME, t_pTag))
+            continue;
+
+        //
+        //   Continuation files are looked up next to the current file
+        //
+        QString t_sName = t_pTag->toString();
+        if(QFileInfo(t_sName).isRelative())
+            t_sName = QFileInfo(p_pStream->streamName()).absoluteDir().filePath(t_sName);
+
+        return t_sName;
+    }
+
+    return QString();
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEpochDataFile::open()
+{
+    FiffStream::SPtr t_pStream = m_lStreams[0];
+    QString t_sFileName = t_pStream->streamName();
+
+    if(!t_pStream->open())
+        return false;
+
+    //
+    //   Measurement info
+    //
+    FiffDirNode::SPtr t_pMeas;
+    if(!t_pStream->read_meas_info(t_pStream->dirtree(), m_info, t_pMeas)) {
+        printf("Could not find measurement info in %s\n", t_sFileName.toUtf8().constData());
+        return false;
+    }
+
+    QList<FiffDirNode::SPtr> t_epochs = t_pMeas->dir_tree_find(FIFFB_MNE_EPOCHS);
+    if(t_epochs.isEmpty()) {
+        printf("Could not find epochs in %s\n", t_sFileName.toUtf8().constData());
+        return false;
+    }
+
+    FiffTag::SPtr t_pTag;
+    fiff_int_t first = 0;
+    fiff_int_t last = -1;
+    if(t_epochs[0]->find_tag(t_pStream, FIFF_FIRST_SAMPLE, t_pTag))
+        first = *t_pTag->toInt();
+    if(t_epochs[0]->find_tag(t_pStream, FIFF_LAST_SAMPLE, t_pTag))
+        last = *t_pTag->toInt();
+
+    //
+    //   Collect the epoch data of this and all continuation files
+    //
+    QVector<qint32> t_vecEvents;
+    QVector<qint32> t_vecEventSamples;
+    bool t_bEvents = true;
+    for(qint32 iStream = 0; ; ++iStream) {
+        qint32 t_iFirstEpoch = m_iNumEpochs;
+        if(!read_epoch_tags(iStream))
+            return false;
+
+        //
+        //   One event per epoch, the sample in the first and the code in the third column
+        //
+        QList<FiffDirNode::SPtr> t_events = m_lStreams[iStream]->dirtree()->dir_tree_find(FIFFB_MNE_EVENTS);
+        if(t_bEvents && !t_events.isEmpty() && t_events[0]->find_tag(m_lStreams[iStream], FIFF_MNE_EVENT_LIST, t_pTag)
+                && t_pTag->size() / (3 * 4) == m_iNumEpochs - t_iFirstEpoch) {
+            for(qint32 k = 0; k < m_iNumEpochs - t_iFirstEpoch; ++k) {
+                t_vecEventSamples.append(t_pTag->toInt()[3*k]);
+                t_vecEvents.append(t_pTag->toInt()[3*k+2]);
+            }
+        }
+        else {
+            t_bEvents = false;
+        }
+
+        QString t_sNextName = find_next_epochs_file(m_lStreams[iStream]);
+        if(t_sNextName.isEmpty())
+            break;
+
+        for(qint32 k = 0; k < m_lStreams.size(); ++k) {
+            if(QFileInfo(m_lStreams[k]->streamName()) == QFileInfo(t_sNextName)) {
+                printf("Continuation files of %s link back to %s\n", t_sFileName.toUtf8().constData(), t_sNextName.toUtf8().constData());
+                return false;
+            }
+        }
+
+        FiffStream::SPtr t_pNextStream(new FiffStream(new QFile(t_sNextName)), delete_split_stream);
+        if(!t_pNextStream->open()) {
+            printf("Could not open continuation file %s\n", t_sNextName.toUtf8().constData());
+            return false;
+        }
+        m_lStreams.append(t_pNextStream);
+    }
+
+    if(last < first)
+        last = first + m_iNsamp - 1;
+    m_fTmin = (float)first / m_info.sfreq;
+    m_fTmax = (float)last / m_info.sfreq;
+
+    if(t_bEvents) {
+        m_vecEvents = Map<VectorXi>(t_vecEvents.data(), t_vecEvents.size());
+        m_vecEventSamples = Map<VectorXi>(t_vecEventSamples.data(), t_vecEventSamples.size());
+    }
+
+    //
+    //   Serve the epochs from memory mappings if all files can be mapped
+    //
+    QVector<const char*> t_vecPayload;
+    FiffTagView t_view;
+    for(qint32 k = 0; k < m_vecPayloadPos.size(); ++k) {
+        FiffStream::SPtr t_pTagStream = m_lStreams[m_vecTagStream[k]];
+        if(!t_pTagStream->map() || !t_pTagStream->read_tag_view(t_view, m_vecPayloadPos[k] - FIFFC_DATA_OFFSET))
+            break;
+        t_vecPayload.append(t_view.data);
+    }
+    if(t_vecPayload.size() == m_vecPayloadPos.size())
+        m_vecPayload = t_vecPayload;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEpochDataFile::read_epoch_tags(qint32 iStream)
+{
+    FiffStream::SPtr t_pStream = m_lStreams[iStream];
+    QString t_sFileName = t_pStream->streamName();
+
+    QList<FiffDirNode::SPtr> t_epochs = t_pStream->dirtree()->dir_tree_find(FIFFB_MNE_EPOCHS);
+    if(t_epochs.isEmpty()) {
+        printf("Could not find epochs in %s\n", t_sFileName.toUtf8().constData());
+        return false;
+    }
+
+    //
+    //   Locate the epoch data without reading it. The epochs may be spread over several FIFF_EPOCH tags which
+    //   all share the same number of channels and samples.
+    //
+    qint32 t_iNumTags = m_vecPayloadPos.size();
+    for(qint32 k = 0; k < t_epochs[0]->nent(); ++k) {
+        FiffDirEntry::SPtr t_pEntry = t_epochs[0]->dir[k];
+        if(t_pEntry->kind != FIFF_EPOCH)
+            continue;
+
+        if(t_pEntry->type != (fiff_int_t)FIFFT_MATRIX_FLOAT) {
+            printf("Only single precision epoch data is supported\n");
+            return false;
+        }
+        if(t_pEntry->size < 4 * 4) {
+            printf("Epoch data in %s is damaged\n", t_sFileName.toUtf8().constData());
+            return false;
+        }
+        qint32 tag = m_vecPayloadPos.size();
+        m_vecPayloadPos.append(t_pEntry->pos + FIFFC_DATA_OFFSET);
+        m_vecTagStream.append(iStream);
+
+        //
+        //   Dimensions are stored in reverse order behind the data, followed by the number of dimensions
+        //
+        qint32 dims[4];
+        if(!read_payload(tag, t_pEntry->size - 4 * 4, (char*)dims, 4 * 4))
+            return false;
+        for(qint32 j = 0; j < 4; ++j)
+            dims[j] = qFromBigEndian<qint32>((const uchar*)&dims[j]);
+
+        if(dims[3] != 3) {
+            printf("Epoch data has to be three-dimensional\n");
+            return false;
+        }
+        if(tag == 0) {
+            m_iNsamp = dims[0];
+            m_iNchan = dims[1];
+        }
+        if(dims[0] != m_iNsamp || dims[1] != m_iNchan || m_iNsamp < 0 || m_iNchan < 0 || dims[2] < 0
+                || 4 * (qint64)m_iNsamp * m_iNchan * dims[2] + 4 * 4 != t_pEntry->size
+                || (qint64)m_iNumEpochs + dims[2] > INT_MAX) {
+            printf("Epoch data dimensions do not match the tag size in %s\n", t_sFileName.toUtf8().constData());
+            return false;
+        }
+        m_vecTagFirst.append(m_iNumEpochs);
+        m_iNumEpochs += dims[2];
+    }
+    if(m_vecPayloadPos.size() == t_iNumTags) {
+        printf("Epoch data missing in %s\n", t_sFileName.toUtf8().constData());
+        return false;
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEpochDataFile::read_payload(qint32 tag, qint64 offset, char* p_pDest, qint64 size) const
+{
+    if(!m_vecPayload.isEmpty()) {
+        memcpy(p_pDest, m_vecPayload[tag] + offset, size);
+        return true;
+    }
+
+    FiffStream::SPtr t_pStream = m_lStreams[m_vecTagStream[tag]];
+    if(!t_pStream->device()->seek(m_vecPayloadPos[tag] + offset)
+            || t_pStream->device()->read(p_pDest, size) != size) {
+        printf("Could not read epoch data from %s\n", t_pStream->streamName().toUtf8().constData());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,315 @@
+//=============================================================================================================
+/**
+* @file     mne_epoch_data_file.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    MNEEpochDataFile class declaration.
+*
+*/
+
+#ifndef MNE_EPOCH_DATA_FILE_H
+#define MNE_EPOCH_DATA_FILE_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_global.h"
+#include "mne_epoch_data.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FIFF INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff_types.h>
+#include <fiff/fiff_info.h>
+#include <fiff/fiff_stream.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QList>
+#include <QSharedPointer>
+#include <QIODevice>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNELIB
+//=============================================================================================================
+
+namespace MNELIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Random access to the epochs of an epochs fif file as written by MNEEpochDataList::save. Only the measurement
+* info, the event list and the location of the FIFF_EPOCH tags are read on opening; single epochs are decoded
+* on demand. Epochs split over several files are followed through their FIFF_REF_FILE_NAME links. If the
+* underlying devices are files they get memory mapped and epochs are converted straight out of the mappings,
+* which makes epoch() safe to call from several threads. Otherwise epochs are read through the devices and
+* calls to epoch() have to be serialized.
+*
+* @brief Lazy reader for epochs fif files
+*/
+class MNESHARED_EXPORT MNEEpochDataFile
+{
+public:
+    typedef QSharedPointer<MNEEpochDataFile> SPtr;              /**< Shared pointer type for MNEEpochDataFile. */
+    typedef QSharedPointer<const MNEEpochDataFile> ConstSPtr;   /**< Const shared pointer type for MNEEpochDataFile. */
+
+    //=========================================================================================================
+    /**
+    * Opens an epochs fif file. Use isValid to check whether this succeeded.
+    *
+    * @param[in] p_IODevice     IO device to read the epochs from; has to stay alive as long as this object
+    */
+    explicit MNEEpochDataFile(QIODevice& p_IODevice);
+
+    //=========================================================================================================
+    /**
+    * Closes the file.
+    */
+    ~MNEEpochDataFile();
+
+    //=========================================================================================================
+    /**
+    * Returns whether the file was opened successfully.
+    *
+    * @return true if the epochs can be read
+    */
+    inline bool isValid() const;
+
+    //=========================================================================================================
+    /**
+    * Returns whether the epochs are served from a memory mapped file.
+    *
+    * @return true if mapped
+    */
+    inline bool isMapped() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of epochs.
+    *
+    * @return the number of epochs
+    */
+    inline qint32 size() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of channels per epoch.
+    *
+    * @return the number of channels
+    */
+    inline qint32 nchan() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples per epoch.
+    *
+    * @return the number of samples
+    */
+    inline qint32 nsamp() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the event codes of all epochs.
+    *
+    * @return the event codes
+    */
+    inline const VectorXi& events() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the event samples of all epochs.
+    *
+    * @return the event samples
+    */
+    inline const VectorXi& eventSamples() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the measurement info.
+    *
+    * @return the measurement info
+    */
+    inline const FIFFLIB::FiffInfo& info() const;
+
+    //=========================================================================================================
+    /**
+    * Reads a single epoch.
+    *
+    * @param[in] idx    index of the epoch, in the range [0, size())
+    *
+    * @return the epoch, an empty pointer if idx is out of range or reading failed
+    */
+    MNEEpochData::SPtr epoch(qint32 idx) const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Locates the epoch data within the file and its continuation files.
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool open();
+
+    //=========================================================================================================
+    /**
+    * Locates the FIFF_EPOCH tags of a file and appends them to the epoch table.
+    *
+    * @param[in] iStream    index of the file stream
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool read_epoch_tags(qint32 iStream);
+
+    //=========================================================================================================
+    /**
+    * Copies a part of the payload of a FIFF_EPOCH tag in file byte order.
+    *
+    * @param[in] tag        index of the FIFF_EPOCH tag
+    * @param[in] offset     offset into the payload in bytes
+    * @param[out] p_pDest   destination buffer
+    * @param[in] size       number of bytes
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool read_payload(qint32 tag, qint64 offset, char* p_pDest, qint64 size) const;
+
+    QList<FIFFLIB::FiffStream::SPtr> m_lStreams;    /**< The file stream, followed by the streams of the continuation files */
+    FIFFLIB::FiffInfo           m_info;             /**< Measurement info */
+    VectorXi                    m_vecEvents;        /**< Event code of each epoch */
+    VectorXi                    m_vecEventSamples;  /**< Event sample of each epoch */
+    qint32                      m_iNumEpochs;       /**< Number of epochs */
+    qint32                      m_iNchan;           /**< Number of channels */
+    qint32                      m_iNsamp;           /**< Number of samples per epoch */
+    float                       m_fTmin;            /**< Start time of the epochs */
+    float                       m_fTmax;            /**< End time of the epochs */
+    QVector<qint32>             m_vecTagFirst;      /**< Index of the first epoch of each FIFF_EPOCH tag */
+    QVector<qint32>             m_vecTagStream;     /**< Stream of each FIFF_EPOCH tag */
+    QVector<FIFFLIB::fiff_long_t> m_vecPayloadPos;  /**< File position of the data of each FIFF_EPOCH tag */
+    QVector<const char*>        m_vecPayload;       /**< Data of each FIFF_EPOCH tag inside the mapping, empty if not mapped */
+    bool                        m_bValid;           /**< Whether the file was opened successfully */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool MNEEpochDataFile::isValid() const
+{
+    return m_bValid;
+}
+
+
+//*************************************************************************************************************
+
+inline bool MNEEpochDataFile::isMapped() const
+{
+    return !m_vecPayload.isEmpty();
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 MNEEpochDataFile::size() const
+{
+    return m_iNumEpochs;
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 MNEEpochDataFile::nchan() const
+{
+    return m_iNchan;
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 MNEEpochDataFile::nsamp() const
+{
+    return m_iNsamp;
+}
+
+
+//*************************************************************************************************************
+
+inline const VectorXi& MNEEpochDataFile::events() const
+{
+    return m_vecEvents;
+}
+
+
+//*************************************************************************************************************
+
+inline const VectorXi& MNEEpochDataFile::eventSamples() const
+{
+    return m_vecEventSamples;
+}
+
+
+//*************************************************************************************************************
+
+inline const FIFFLIB::FiffInfo& MNEEpochDataFile::info() const
+{
+    return m_info;
+}
+
+} // NAMESPACE
+
+#endif // MNE_EPOCH_DATA_FILE_H
@@ -39,6 +39,28 @@
 //=============================================================================================================
 
 #include "mne_epoch_data_list.h"
+#include "mne_epoch_data_file.h"
+
+#include <fiff/fiff_stream.h>
+#include <fiff/fiff_tag.h>
+#include <utils/ioutils.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QFile>
+#include <QFileInfo>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <climits>
 
 
 //*************************************************************************************************************
@@ -48,6 +70,7 @@
 
 using namespace FIFFLIB;
 using namespace MNELIB;
+using namespace UTILSLIB;
 
 
 //*************************************************************************************************************
@@ -132,3 +155,178 @@ FiffEvoked MNEEpochDataList::average(FiffInfo& info, fiff_int_t first, fiff_int_
 
     return p_evoked;
 }
+
+
+//*************************************************************************************************************
+
+bool MNEEpochDataList::save(QIODevice& p_IODevice, const FiffInfo& p_info, qint64 iMaxTagSize, qint64 iMaxFileSize) const
+{
+    if(this->isEmpty()) {
+        printf("No epochs to save\n");
+        return false;
+    }
+
+    qint32 nchan = this->at(0)->epoch.rows();
+    qint32 nsamp = this->at(0)->epoch.cols();
+    for(qint32 i = 1; i < this->size(); ++i) {
+        if(this->at(i)->epoch.rows() != nchan || this->at(i)->epoch.cols() != nsamp) {
+            printf("All epochs have to have the same dimensions (epoch %d is %d x %d, expected %d x %d)\n", i, (int)this->at(i)->epoch.rows(), (int)this->at(i)->epoch.cols(), nchan, nsamp);
+            return false;
+        }
+    }
+
+    //
+    //   Each FIFF_EPOCH tag holds as many epochs as fit into iMaxTagSize, but at least one
+    //
+    qint64 numel = (qint64)nchan * nsamp;
+    qint64 epochsize = 4 * numel;
+    if(epochsize + 4 * 4 > INT_MAX) {
+        printf("A single epoch exceeds the maximum tag size\n");
+        return false;
+    }
+    qint32 nPerTag = (qint32)qBound((qint64)1, (qMin(iMaxTagSize, (qint64)INT_MAX) - 4 * 4) / epochsize, (qint64)this->size());
+
+    //
+    //   Room for the block tags, the first and last sample, the link to the next file and the end of the file
+    //
+    const qint64 reserve = 4096;
+    iMaxFileSize = qMin(iMaxFileSize, (qint64)INT_MAX);
+
+    QFile* t_pFirstFile = qobject_cast<QFile*>(&p_IODevice);
+    QFile t_fileNext;
+    QIODevice* t_pDevice = &p_IODevice;
+    fiff_int_t first = (fiff_int_t)qRound(this->at(0)->tmin * p_info.sfreq);
+    fiff_int_t last = first + nsamp - 1;
+    Matrix<float, Dynamic, Dynamic, RowMajor> buffer(nchan, nsamp);
+
+    qint32 i = 0;
+    for(qint32 iFile = 0; i < this->size(); ++iFile) {
+        FiffStream::SPtr t_pStream = FiffStream::start_file(*t_pDevice);
+        if(!t_pStream)
+            return false;
+
+        p_info.writeToStream(t_pStream.data());
+
+        //
+        //   Fill the file with whole tags, the first tag always goes in
+        //
+        qint64 t_iFree = iMaxFileSize - t_pStream->device()->pos() - reserve;
+        qint32 nInFile = 0;
+        while(i + nInFile < this->size()) {
+            qint32 n = qMin(nPerTag, this->size() - i - nInFile);
+            qint64 t_iTagCost = FIFFC_DATA_OFFSET + n * (epochsize + 3 * 4) + 4 * 4;
+            if(nInFile > 0 && t_iTagCost > t_iFree)
+                break;
+            t_iFree -= t_iTagCost;
+            nInFile += n;
+        }
+
+        QString t_sNextFile;
+        if(i + nInFile < this->size()) {
+            //
+            //   Continuation files are named like the split files of MNE-Python: name-epo.fif, name-epo-1.fif, ...
+            //
+            if(!t_pFirstFile) {
+                printf("Epochs exceed the maximum file size and %s cannot be split\n", t_pStream->streamName().toUtf8().constData());
+                t_pStream->close();
+                return false;
+            }
+            t_sNextFile = t_pFirstFile->fileName();
+            if(t_sNextFile.endsWith(".fif"))
+                t_sNextFile.chop(4);
+            t_sNextFile += QString("-%1.fif").arg(iFile + 1);
+        }
+
+        //
+        //   Events of the epochs in this file
+        //
+        VectorXi events(3 * nInFile);
+        for(qint32 k = 0; k < nInFile; ++k) {
+            events[3*k] = this->at(i + k)->sample;
+            events[3*k+1] = 0;
+            events[3*k+2] = this->at(i + k)->event;
+        }
+        t_pStream->start_block(FIFFB_MNE_EVENTS);
+        t_pStream->write_int(FIFF_MNE_EVENT_LIST, events.data(), events.size());
+        t_pStream->end_block(FIFFB_MNE_EVENTS);
+
+        //
+        //   Epochs
+        //
+        t_pStream->start_block(FIFFB_MNE_EPOCHS);
+        t_pStream->write_int(FIFF_FIRST_SAMPLE, &first);
+        t_pStream->write_int(FIFF_LAST_SAMPLE, &last);
+
+        for(qint32 iEnd = i + nInFile; i < iEnd; ) {
+            qint32 n = qMin(nPerTag, iEnd - i);
+
+            *t_pStream << (qint32)FIFF_EPOCH;
+            *t_pStream << (qint32)FIFFT_MATRIX_FLOAT;
+            *t_pStream << (qint32)(epochsize * n + 4 * 4);
+            *t_pStream << (qint32)FIFFV_NEXT_SEQ;
+
+            for(qint32 k = 0; k < n; ++k, ++i) {
+                buffer = this->at(i)->epoch.cast<float>();
+#ifdef INTEL_X86_ARCH
+                IOUtils::swap_copy_32(buffer.data(), buffer.data(), numel);
+#endif
+                t_pStream->writeRawData((const char*)buffer.data(), (int)epochsize);
+            }
+
+            //
+            //   Dimensions in reverse order, followed by the number of dimensions
+            //
+            *t_pStream << (qint32)nsamp;
+            *t_pStream << (qint32)nchan;
+            *t_pStream << (qint32)n;
+            *t_pStream << (qint32)3;
+        }
+
+        t_pStream->end_block(FIFFB_MNE_EPOCHS);
+
+        if(!t_sNextFile.isEmpty()) {
+            fiff_int_t data = FIFFV_ROLE_NEXT_FILE;
+            t_pStream->start_block(FIFFB_REF);
+            t_pStream->write_int(FIFF_REF_ROLE, &data);
+            t_pStream->write_string(FIFF_REF_FILE_NAME, QFileInfo(t_sNextFile).fileName());
+            data = iFile;
+            t_pStream->write_int(FIFF_REF_FILE_NUM, &data);
+            t_pStream->end_block(FIFFB_REF);
+        }
+
+        t_pStream->end_block(FIFFB_MEAS);
+        t_pStream->end_file();
+        t_pStream->close();
+
+        if(!t_sNextFile.isEmpty()) {
+            t_fileNext.setFileName(t_sNextFile);
+            t_pDevice = &t_fileNext;
+        }
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEpochDataList::read(QIODevice& p_IODevice, MNEEpochDataList& p_Epochs, FiffInfo& p_info)
+{
+    MNEEpochDataFile t_file(p_IODevice);
+    if(!t_file.isValid())
+        return false;
+
+    p_Epochs.clear();
+    p_Epochs.reserve(t_file.size());
+    for(qint32 i = 0; i < t_file.size(); ++i) {
+        MNEEpochData::SPtr t_pEpoch = t_file.epoch(i);
+        if(!t_pEpoch) {
+            p_Epochs.clear();
+            return false;
+        }
+        p_Epochs.append(t_pEpoch);
+    }
+    p_info = t_file.info();
+
+    return true;
+}
@@ -61,6 +61,15 @@
 
 #include <QList>
 #include <QSharedPointer>
+#include <QIODevice>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <climits>
 
 
 //*************************************************************************************************************
@@ -116,6 +125,44 @@ public:
                                 FIFFLIB::fiff_int_t last,
                                 VectorXi sel = FIFFLIB::defaultVectorXi,
                                 bool proj = false);
+
+    //=========================================================================================================
+    /**
+    * Writes the epochs to an epochs fif file. All epochs have to share the same number of channels and samples.
+    * The file contains the measurement info, the event list and the epoch data as 3D single precision matrices
+    * (epochs x channels x samples), such that each epoch is stored contiguously and can be read back
+    * individually (see MNEEpochDataFile).
+    * The epochs are spread over several FIFF_EPOCH tags of at most iMaxTagSize bytes each. Since fif file
+    * positions are 32 bit, epochs which do not fit into iMaxFileSize continue in further files next to the
+    * first one (name-epo-1.fif, name-epo-2.fif, ...), linked through FIFF_REF_FILE_NAME as split raw files are.
+    * Splitting requires p_IODevice to be a QFile.
+    * The event list of each file holds the event sample and the event code of its epochs, in the order of the
+    * epochs.
+    *
+    * @param[in] p_IODevice     IO device to write the epochs to
+    * @param[in] p_info         measurement info of the epochs
+    * @param[in] iMaxTagSize    maximum size of a FIFF_EPOCH tag in bytes (optional, at least one epoch per tag)
+    * @param[in] iMaxFileSize   maximum size of a file in bytes (optional, at least one tag per file)
+    *
+    * @return true if succeeded, false otherwise
+    */
+    bool save(QIODevice& p_IODevice,
+              const FIFFLIB::FiffInfo& p_info,
+              qint64 iMaxTagSize = INT_MAX,
+              qint64 iMaxFileSize = INT_MAX) const;
+
+    //=========================================================================================================
+    /**
+    * Reads all epochs of an epochs fif file into memory. Use MNEEpochDataFile to access single epochs without
+    * loading the whole file.
+    *
+    * @param[in] p_IODevice     IO device to read the epochs from
+    * @param[out] p_Epochs      the read epochs
+    * @param[out] p_info        measurement info of the epochs
+    *
+    * @return true if succeeded, false otherwise
+    */
+    static bool read(QIODevice& p_IODevice, MNEEpochDataList& p_Epochs, FIFFLIB::FiffInfo& p_info);
 };
 
 } // NAMESPACE
@@ -108,7 +108,7 @@ MNEForwardSolution::MNEForwardSolution()
 
 //*************************************************************************************************************
 
-MNEForwardSolution::MNEForwardSolution(QIODevice &p_IODevice, bool force_fixed, bool surf_ori, const QStringList& include, const QStringList& exclude, bool bExcludeBads)
+MNEForwardSolution::MNEForwardSolution(QIODevice &p_IODevice, bool force_fixed, bool surf_ori, const QStringList& include, const QStringList& exclude, bool bExcludeBads, bool bFloatGain)
 : source_ori(-1)
 , surf_ori(surf_ori)
 , coord_frame(-1)
@@ -121,7 +121,7 @@ MNEForwardSolution::MNEForwardSolution(QIODevice &p_IODevice, bool force_fixed,
 , source_rr(MatrixX3f::Zero(0,3))
 , source_nn(MatrixX3f::Zero(0,3))
 {
-    if(!read(p_IODevice, *this, force_fixed, surf_ori, include, exclude, bExcludeBads))
+    if(!read(p_IODevice, *this, force_fixed, surf_ori, include, exclude, bExcludeBads, bFloatGain))
     {
         printf("\tForward solution not found.\n");//ToDo Throw here
         return;
@@ -140,6 +140,9 @@ MNEForwardSolution::MNEForwardSolution(const MNEForwardSolution &p_MNEForwardSol
 , nchan(p_MNEForwardSolution.nchan)
 , sol(p_MNEForwardSolution.sol)
 , sol_grad(p_MNEForwardSolution.sol_grad)
+, sol_float(p_MNEForwardSolution.sol_float)
+, sol_float_rows(p_MNEForwardSolution.sol_float_rows)
+, sol_float_cols(p_MNEForwardSolution.sol_float_cols)
 , mri_head_t(p_MNEForwardSolution.mri_head_t)
 , src(p_MNEForwardSolution.src)
 , source_rr(p_MNEForwardSolution.source_rr)
@@ -169,6 +172,9 @@ void MNEForwardSolution::clear()
     nchan = -1;
     sol = FiffNamedMatrix::SDPtr(new FiffNamedMatrix());
     sol_grad = FiffNamedMatrix::SDPtr(new FiffNamedMatrix());
+    sol_float.clear();
+    sol_float_rows.resize(0);
+    sol_float_cols.resize(0);
     mri_head_t.clear();
     src.clear();
     source_rr = MatrixX3f(0,3);
@@ -180,6 +186,16 @@ void MNEForwardSolution::clear()
 
 MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const AnnotationSet &p_AnnotationSet, qint32 p_iClusterSize, MatrixXd& p_D, const FiffCov &p_pNoise_cov, const FiffInfo &p_pInfo, QString p_sMethod) const
 {
+    //
+    //   Clustering needs the gain matrix in double precision
+    //
+    if(this->isFloatGain())
+    {
+        MNEForwardSolution t_fwd(*this);
+        t_fwd.to_double_gain();
+        return t_fwd.cluster_forward_solution(p_AnnotationSet, p_iClusterSize, p_D, p_pNoise_cov, p_pInfo, p_sMethod);
+    }
+
     printf("Cluster forward solution using %s.\n", p_sMethod.toUtf8().constData());
 
     MNEForwardSolution p_fwdOut = MNEForwardSolution(*this);
@@ -726,6 +742,7 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
 MNEForwardSolution MNEForwardSolution::reduce_forward_solution(qint32 p_iNumDipoles, MatrixXd& p_D) const
 {
     MNEForwardSolution p_fwdOut = MNEForwardSolution(*this);
+    p_fwdOut.to_double_gain();
 
     bool isFixed = p_fwdOut.isFixedOrient();
     qint32 np = isFixed ? p_fwdOut.sol->data.cols() : p_fwdOut.sol->data.cols()/3;
@@ -944,7 +961,7 @@ FiffCov MNEForwardSolution::compute_depth_prior(const MatrixXd &Gain, const Fiff
 FiffCov MNEForwardSolution::compute_orient_prior(float loose)
 {
     bool is_fixed_ori = this->isFixedOrient();
-    qint32 n_sources = this->sol->data.cols();
+    qint32 n_sources = this->isFloatGain() ? this->sol_float_cols.size() : this->sol->data.cols();
 
     if (0 <= loose && loose <= 1)
     {
@@ -988,6 +1005,85 @@ FiffCov MNEForwardSolution::compute_orient_prior(float loose)
 }
 
 
+//*************************************************************************************************************
+
+static FiffNamedMatrix::SDPtr pick_rows(const FiffNamedMatrix& mat, const RowVectorXi& sel)
+{
+    FiffNamedMatrix::SDPtr t_pMat(new FiffNamedMatrix());
+
+    //
+    //   The data of single precision gain matrices is not held in mat
+    //
+    if(mat.data.size() > 0)
+    {
+        t_pMat->data.resize(sel.size(), mat.data.cols());
+        for(qint32 i = 0; i < sel.size(); ++i)
+            t_pMat->data.row(i) = mat.data.row(sel[i]);
+    }
+
+    for(qint32 i = 0; i < sel.size(); ++i)
+        t_pMat->row_names << mat.row_names[sel[i]];
+    t_pMat->col_names = mat.col_names;
+
+    t_pMat->nrow = sel.size();
+    t_pMat->ncol = mat.ncol;
+
+    return t_pMat;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd MNEForwardSolution::gain() const
+{
+    if(!this->isFloatGain())
+        return this->sol->data;
+
+    return this->gain(VectorXi::LinSpaced(this->sol_float_rows.size(), 0, this->sol_float_rows.size() - 1));
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd MNEForwardSolution::gain(const VectorXi& sel) const
+{
+    if(!this->isFloatGain())
+    {
+        MatrixXd t_matGain(sel.size(), this->sol->data.cols());
+        for(qint32 i = 0; i < sel.size(); ++i)
+            t_matGain.row(i) = this->sol->data.row(sel[i]);
+        return t_matGain;
+    }
+
+    //
+    //   Gather column by column, the single precision matrix is column major
+    //
+    MatrixXd t_matGain(sel.size(), this->sol_float_cols.size());
+    for(qint32 j = 0; j < this->sol_float_cols.size(); ++j)
+    {
+        const float* t_pCol = this->sol_float->data() + (qint64)this->sol_float_cols[j] * this->sol_float->rows();
+        for(qint32 i = 0; i < sel.size(); ++i)
+            t_matGain(i, j) = t_pCol[this->sol_float_rows[sel[i]]];
+    }
+
+    return t_matGain;
+}
+
+
+//*************************************************************************************************************
+
+void MNEForwardSolution::to_double_gain()
+{
+    if(!this->isFloatGain())
+        return;
+
+    this->sol->data = this->gain();
+    this->sol_float.clear();
+    this->sol_float_rows.resize(0);
+    this->sol_float_cols.resize(0);
+}
+
+
 //*************************************************************************************************************
 
 MNEForwardSolution MNEForwardSolution::pick_channels(const QStringList& include, const QStringList& exclude) const
@@ -997,7 +1093,11 @@ MNEForwardSolution MNEForwardSolution::pick_channels(const QStringList& include,
     if(include.size() == 0 && exclude.size() == 0)
         return fwd;
 
-    RowVectorXi sel = FiffInfo::pick_channels(fwd.sol->row_names, include, exclude);
+    //
+    //   The solutions are read through this, non-const access through fwd would detach a full copy of the
+    //   shared gain matrix before it gets replaced
+    //
+    RowVectorXi sel = FiffInfo::pick_channels(this->sol->row_names, include, exclude);
 
     // Do we have something?
     quint32 nuse = sel.size();
@@ -1009,23 +1109,25 @@ MNEForwardSolution MNEForwardSolution::pick_channels(const QStringList& include,
     }
     printf("\t%d out of %d channels remain after picking\n", nuse, fwd.nchan);
 
-    //   Pick the correct rows of the forward operator
-    MatrixXd newData(nuse, fwd.sol->data.cols());
-    for(quint32 i = 0; i < nuse; ++i)
-        newData.row(i) = fwd.sol->data.row(sel[i]);
+    //   All channels in their original order, keep sharing the gain matrix
+    if (nuse == (quint32)this->sol->nrow && sel == RowVectorXi::LinSpaced(nuse, 0, nuse-1))
+        return fwd;
 
-    fwd.sol->data = newData;
-    fwd.sol->nrow = nuse;
+    //   Pick the correct rows of the forward operator, a single precision gain matrix stays shared
+    fwd.sol = pick_rows(*this->sol, sel);
+    if(this->isFloatGain())
+    {
+        fwd.sol_float_rows.resize(nuse);
+        for(qint32 i = 0; i < sel.size(); ++i)
+            fwd.sol_float_rows[i] = this->sol_float_rows[sel[i]];
+    }
 
-    QStringList ch_names;
-    for(qint32 i = 0; i < sel.cols(); ++i)
-        ch_names << fwd.sol->row_names[sel(i)];
+    QStringList ch_names = fwd.sol->row_names;
     fwd.nchan = nuse;
-    fwd.sol->row_names = ch_names;
 
     QList<FiffChInfo> chs;
     for(qint32 i = 0; i < sel.cols(); ++i)
-        chs.append(fwd.info.chs[sel(i)]);
+        chs.append(this->info.chs.at(sel(i)));
     fwd.info.chs = chs;
     fwd.info.nchan = nuse;
 
@@ -1035,18 +1137,8 @@ MNEForwardSolution MNEForwardSolution::pick_channels(const QStringList& include,
             bads.append(fwd.info.bads[i]);
     fwd.info.bads = bads;
 
-    if(!fwd.sol_grad->isEmpty())
-    {
-        newData.resize(nuse, fwd.sol_grad->data.cols());
-        for(quint32 i = 0; i < nuse; ++i)
-            newData.row(i) = fwd.sol_grad->data.row(sel[i]);
-        fwd.sol_grad->data = newData;
-        fwd.sol_grad->nrow = nuse;
-        QStringList row_names;
-        for(qint32 i = 0; i < sel.cols(); ++i)
-            row_names << fwd.sol_grad->row_names[sel(i)];
-        fwd.sol_grad->row_names = row_names;
-    }
+    if(!this->sol_grad->isEmpty())
+        fwd.sol_grad = pick_rows(*this->sol_grad, sel);
 
     return fwd;
 }
@@ -1086,16 +1178,28 @@ MNEForwardSolution MNEForwardSolution::pick_regions(const QList<Label> &p_qListL
     selectedFwd.source_nn = nn;
 
     VectorXi selSolIdcs = tripletSelection(selVertices);
-    MatrixXd G(selectedFwd.sol->data.rows(),selSolIdcs.size());
 //    selectedFwd.sol_grad; //ToDo
-    qint32 rows = G.rows();
+    if(selectedFwd.isFloatGain())
+    {
+        //   Only the column indices of the shared single precision gain matrix are picked
+        VectorXi t_vecCols(selSolIdcs.size());
+        for(qint32 i = 0; i < selSolIdcs.size(); ++i)
+            t_vecCols[i] = this->sol_float_cols[selSolIdcs[i]];
+        selectedFwd.sol_float_cols = t_vecCols;
+        selectedFwd.sol->ncol = t_vecCols.size();
+    }
+    else
+    {
+        MatrixXd G(selectedFwd.sol->data.rows(),selSolIdcs.size());
+        qint32 rows = G.rows();
 
-    for(qint32 i = 0; i < selSolIdcs.size(); ++i)
-        G.block(0, i, rows, 1) = selectedFwd.sol->data.col(selSolIdcs[i]);
+        for(qint32 i = 0; i < selSolIdcs.size(); ++i)
+            G.block(0, i, rows, 1) = selectedFwd.sol->data.col(selSolIdcs[i]);
 
-    selectedFwd.sol->data = G;
-    selectedFwd.sol->nrow = selectedFwd.sol->data.rows();
-    selectedFwd.sol->ncol = selectedFwd.sol->data.cols();
+        selectedFwd.sol->data = G;
+        selectedFwd.sol->nrow = selectedFwd.sol->data.rows();
+        selectedFwd.sol->ncol = selectedFwd.sol->data.cols();
+    }
     selectedFwd.nsource = selectedFwd.sol->ncol / 3;
 
     selectedFwd.src = selectedFwd.src.pick_regions(p_qListLabels);
@@ -1200,9 +1304,7 @@ void MNEForwardSolution::prepare_forward(const FiffInfo &p_info, const FiffCov &
     fwd_idx.conservativeResize(count_fwd_idx);
     info_idx.conservativeResize(count_info_idx);
 
-    gain.resize(count_fwd_idx, this->sol->data.cols());
-    for(qint32 i = 0; i < count_fwd_idx; ++i)
-        gain.row(i) = this->sol->data.row(fwd_idx[i]);
+    gain = this->gain(fwd_idx);
 
     p_outFwdInfo = p_info.pick_info(info_idx);
 
@@ -1212,7 +1314,7 @@ void MNEForwardSolution::prepare_forward(const FiffInfo &p_info, const FiffCov &
 
 //*************************************************************************************************************
 
-bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bool force_fixed, bool surf_ori, const QStringList& include, const QStringList& exclude, bool bExcludeBads)
+bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bool force_fixed, bool surf_ori, const QStringList& include, const QStringList& exclude, bool bExcludeBads, bool bFloatGain)
 {
     FiffStream::SPtr t_pStream(new FiffStream(&p_IODevice));
 
@@ -1220,6 +1322,11 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
     if(!t_pStream->open())
         return false;
     //
+    //   Read the solution matrices straight out of the file mapping, if the device can be mapped. This saves the
+    //   temporary tag copies.
+    //
+    t_pStream->map();
+    //
     //   Find all forward solutions
     //
     QList<FiffDirNode::SPtr> fwds = t_pStream->dirtree()->dir_tree_find(FIFFB_MNE_FORWARD_SOLUTION);
@@ -1297,7 +1404,7 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
 
     MNEForwardSolution megfwd;
     QString ori;
-    if (read_one(t_pStream, megnode, megfwd))
+    if (read_one(t_pStream, megnode, megfwd, bFloatGain))
     {
         if (megfwd.source_ori == FIFFV_MNE_FIXED_ORI)
             ori = QString("fixed");
@@ -1306,7 +1413,7 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
         printf("\tRead MEG forward solution (%d sources, %d channels, %s orientations)\n", megfwd.nsource,megfwd.nchan,ori.toUtf8().constData());
     }
     MNEForwardSolution eegfwd;
-    if (read_one(t_pStream, eegnode, eegfwd))
+    if (read_one(t_pStream, eegnode, eegfwd, bFloatGain))
     {
         if (eegfwd.source_ori == FIFFV_MNE_FIXED_ORI)
             ori = QString("fixed");
@@ -1322,7 +1429,7 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
 
     if (!megfwd.isEmpty() && !eegfwd.isEmpty())
     {
-        if (megfwd.sol->data.cols() != eegfwd.sol->data.cols() ||
+        if (megfwd.sol->ncol != eegfwd.sol->ncol ||
                 megfwd.source_ori != eegfwd.source_ori ||
                 megfwd.nsource != eegfwd.nsource ||
                 megfwd.coord_frame != eegfwd.coord_frame)
@@ -1332,25 +1439,42 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
             return false;
         }
 
-        fwd = MNEForwardSolution(megfwd);
-        fwd.sol->data = MatrixXd(megfwd.sol->nrow + eegfwd.sol->nrow, megfwd.sol->ncol);
-
-        fwd.sol->data.block(0,0,megfwd.sol->nrow,megfwd.sol->ncol) = megfwd.sol->data;
-        fwd.sol->data.block(megfwd.sol->nrow,0,eegfwd.sol->nrow,eegfwd.sol->ncol) = eegfwd.sol->data;
-        fwd.sol->nrow = megfwd.sol->nrow + eegfwd.sol->nrow;
-        fwd.sol->row_names.append(eegfwd.sol->row_names);
-
-        if (!fwd.sol_grad->isEmpty())
+        //
+        //   Assemble the merged matrices in place of the MEG ones, so only one copy of each is kept
+        //
+        MatrixXd t_matMerged;
+        if (bFloatGain)
+        {
+            MatrixXf* t_pMergedFloat = new MatrixXf(megfwd.sol->nrow + eegfwd.sol->nrow, megfwd.sol->ncol);
+            t_pMergedFloat->topRows(megfwd.sol->nrow) = *megfwd.sol_float;
+            t_pMergedFloat->bottomRows(eegfwd.sol->nrow) = *eegfwd.sol_float;
+            megfwd.sol_float = QSharedPointer<const MatrixXf>(t_pMergedFloat);
+            megfwd.sol_float_rows = VectorXi::LinSpaced(t_pMergedFloat->rows(), 0, t_pMergedFloat->rows() - 1);
+            megfwd.sol->nrow = t_pMergedFloat->rows();
+        }
+        else
         {
-            fwd.sol_grad->data.resize(megfwd.sol_grad->data.rows() + eegfwd.sol_grad->data.rows(), megfwd.sol_grad->data.cols());
+            t_matMerged.resize(megfwd.sol->nrow + eegfwd.sol->nrow, megfwd.sol->ncol);
+            t_matMerged.topRows(megfwd.sol->nrow) = megfwd.sol->data;
+            t_matMerged.bottomRows(eegfwd.sol->nrow) = eegfwd.sol->data;
+            megfwd.sol->data.swap(t_matMerged);
+            megfwd.sol->nrow = megfwd.sol->data.rows();
+        }
+        megfwd.sol->row_names.append(eegfwd.sol->row_names);
 
-            fwd.sol->data.block(0,0,megfwd.sol_grad->data.rows(),megfwd.sol_grad->data.cols()) = megfwd.sol_grad->data;
-            fwd.sol->data.block(megfwd.sol_grad->data.rows(),0,eegfwd.sol_grad->data.rows(),eegfwd.sol_grad->data.cols()) = eegfwd.sol_grad->data;
+        if (!megfwd.sol_grad->isEmpty())
+        {
+            t_matMerged.resize(megfwd.sol_grad->data.rows() + eegfwd.sol_grad->data.rows(), megfwd.sol_grad->data.cols());
+            t_matMerged.topRows(megfwd.sol_grad->data.rows()) = megfwd.sol_grad->data;
+            t_matMerged.bottomRows(eegfwd.sol_grad->data.rows()) = eegfwd.sol_grad->data;
+            megfwd.sol_grad->data.swap(t_matMerged);
 
-            fwd.sol_grad->nrow      = megfwd.sol_grad->nrow + eegfwd.sol_grad->nrow;
-            fwd.sol_grad->row_names.append(eegfwd.sol_grad->row_names);
+            megfwd.sol_grad->nrow      = megfwd.sol_grad->data.rows();
+            megfwd.sol_grad->row_names.append(eegfwd.sol_grad->row_names);
         }
-        fwd.nchan  = megfwd.nchan + eegfwd.nchan;
+        megfwd.nchan  = megfwd.nchan + eegfwd.nchan;
+
+        fwd = megfwd;
         printf("\tMEG and EEG forward solutions combined\n");
     }
     else if (!megfwd.isEmpty())
@@ -1358,6 +1482,12 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
     else
         fwd = eegfwd; //new MNEForwardSolution(eegfwd);//not copied for the sake of speed
 
+    //
+    //   Release the single solutions, otherwise modifying fwd below would detach full copies of the matrices
+    //
+    megfwd.clear();
+    eegfwd.clear();
+
     //
     //   Get the MRI <-> head coordinate transformation
     //
@@ -1438,7 +1568,14 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
 
             MatrixXd tmp = fwd.source_nn.transpose().cast<double>();
             SparseMatrix<double>* fix_rot = MNEMath::make_block_diag(tmp,1);
-            fwd.sol->data *= (*fix_rot);
+            if (fwd.isFloatGain())
+            {
+                SparseMatrix<float> t_fixRot = fix_rot->cast<float>();
+                fwd.sol_float = QSharedPointer<const MatrixXf>(new MatrixXf(*fwd.sol_float * t_fixRot));
+                fwd.sol_float_cols = VectorXi::LinSpaced(fwd.nsource, 0, fwd.nsource - 1);
+            }
+            else
+                fwd.sol->data *= (*fix_rot);
             fwd.sol->ncol  = fwd.nsource;
             fwd.source_ori = FIFFV_MNE_FIXED_ORI;
 
@@ -1522,7 +1659,13 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
         MatrixXd tmp = fwd.source_nn.transpose().cast<double>();
         SparseMatrix<double>* surf_rot = MNEMath::make_block_diag(tmp,3);
 
-        fwd.sol->data *= *surf_rot;
+        if (fwd.isFloatGain())
+        {
+            SparseMatrix<float> t_surfRot = surf_rot->cast<float>();
+            fwd.sol_float = QSharedPointer<const MatrixXf>(new MatrixXf(*fwd.sol_float * t_surfRot));
+        }
+        else
+            fwd.sol->data *= *surf_rot;
 
         if (!fwd.sol_grad->isEmpty())
         {
@@ -1700,7 +1843,7 @@ bool MNEForwardSolution::read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bo
 
 //*************************************************************************************************************
 
-bool MNEForwardSolution::read_one(FiffStream::SPtr& p_pStream, const FiffDirNode::SPtr& p_Node, MNEForwardSolution& one)
+bool MNEForwardSolution::read_one(FiffStream::SPtr& p_pStream, const FiffDirNode::SPtr& p_Node, MNEForwardSolution& one, bool bFloatGain)
 {
     //
     //   Read all interesting stuff for one forward solution
@@ -1747,9 +1890,26 @@ bool MNEForwardSolution::read_one(FiffStream::SPtr& p_pStream, const FiffDirNode
 
     one.nchan = *t_pTag->toInt();
 
-    if(p_pStream->read_named_matrix(p_Node, FIFF_MNE_FORWARD_SOLUTION, *one.sol.data()))
-        one.sol->transpose_named_matrix();
+    //
+    //   A single precision gain matrix is read into its own shared matrix, sol->data stays empty
+    //
+    bool t_bRead;
+    if(bFloatGain)
+    {
+        MatrixXf* t_pGain = new MatrixXf();
+        QSharedPointer<const MatrixXf> t_pSharedGain(t_pGain);
+        t_bRead = p_pStream->read_named_matrix(p_Node, FIFF_MNE_FORWARD_SOLUTION, *one.sol.data(), *t_pGain, true);
+        if(t_bRead)
+        {
+            one.sol_float = t_pSharedGain;
+            one.sol_float_rows = VectorXi::LinSpaced(t_pGain->rows(), 0, t_pGain->rows() - 1);
+            one.sol_float_cols = VectorXi::LinSpaced(t_pGain->cols(), 0, t_pGain->cols() - 1);
+        }
+    }
     else
+        t_bRead = p_pStream->read_named_matrix(p_Node, FIFF_MNE_FORWARD_SOLUTION, *one.sol.data(), true);
+
+    if(!t_bRead)
     {
         p_pStream->close();
         printf("Forward solution data not found ."); //ToDo: throw error.
@@ -1757,14 +1917,12 @@ bool MNEForwardSolution::read_one(FiffStream::SPtr& p_pStream, const FiffDirNode
         return false;
     }
 
-    if(p_pStream->read_named_matrix(p_Node, FIFF_MNE_FORWARD_SOLUTION_GRAD, *one.sol_grad.data()))
-        one.sol_grad->transpose_named_matrix();
-    else
+    if(!p_pStream->read_named_matrix(p_Node, FIFF_MNE_FORWARD_SOLUTION_GRAD, *one.sol_grad.data(), true))
         one.sol_grad->clear();
 
 
-    if (one.sol->data.rows() != one.nchan ||
-            (one.sol->data.cols() != one.nsource && one.sol->data.cols() != 3*one.nsource))
+    if (one.sol->nrow != one.nchan ||
+            (one.sol->ncol != one.nsource && one.sol->ncol != 3*one.nsource))
     {
         p_pStream->close();
         printf("Forward solution matrix has wrong dimensions.\n"); //ToDo: throw error.
@@ -1840,10 +1998,21 @@ void MNEForwardSolution::to_fixed_ori()
         qWarning("Warning: Only surface-oriented, free-orientation forward solutions can be converted to fixed orientaton.\n");//ToDo: Throw here//qCritical//qFatal
         return;
     }
-    qint32 count = 0;
-    for(qint32 i = 2; i < this->sol->data.cols(); i += 3)
-        this->sol->data.col(count) = this->sol->data.col(i);//ToDo: is this right? - just take z?
-    this->sol->data.conservativeResize(this->sol->data.rows(), count);
+    if(this->isFloatGain())
+    {
+        //   Only the column indices of the shared single precision gain matrix change
+        VectorXi t_vecCols(this->sol_float_cols.size() / 3);
+        for(qint32 i = 0; i < t_vecCols.size(); ++i)
+            t_vecCols[i] = this->sol_float_cols[3*i + 2];
+        this->sol_float_cols = t_vecCols;
+    }
+    else
+    {
+        qint32 count = 0;
+        for(qint32 i = 2; i < this->sol->data.cols(); i += 3)
+            this->sol->data.col(count++) = this->sol->data.col(i);//ToDo: is this right? - just take z?
+        this->sol->data.conservativeResize(this->sol->data.rows(), count);
+    }
     this->sol->ncol = this->sol->ncol / 3;
     this->source_ori = FIFFV_MNE_FIXED_ORI;
     printf("\tConverted the forward solution into the fixed-orientation mode.\n");
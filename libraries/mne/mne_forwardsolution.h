@@ -222,9 +222,10 @@ public:
     * @param[in] include       Include these channels (optional)
     * @param[in] exclude       Exclude these channels (optional)
     * @param[in] bExcludeBads  If true bads are also read; default = false (optional)
+    * @param[in] bFloatGain    Keep the gain matrix in single precision, see read (optional)
     *
     */
-    MNEForwardSolution(QIODevice &p_IODevice, bool force_fixed = false, bool surf_ori = false, const QStringList& include = defaultQStringList, const QStringList& exclude = defaultQStringList, bool bExcludeBads = false);
+    MNEForwardSolution(QIODevice &p_IODevice, bool force_fixed = false, bool surf_ori = false, const QStringList& include = defaultQStringList, const QStringList& exclude = defaultQStringList, bool bExcludeBads = false, bool bFloatGain = false);
 
     //=========================================================================================================
     /**
@@ -312,11 +313,47 @@ public:
     */
     inline bool isFixedOrient() const;
 
+    //=========================================================================================================
+    /**
+    * Is the gain matrix held in single precision? Then sol->data is empty and the gain matrix consists of the
+    * rows sol_float_rows and the columns sol_float_cols of sol_float.
+    *
+    * @return true if the gain matrix is held in single precision, false otherwise
+    */
+    inline bool isFloatGain() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the gain matrix in double precision, regardless of how it is held.
+    *
+    * @return the gain matrix
+    */
+    MatrixXd gain() const;
+
+    //=========================================================================================================
+    /**
+    * Returns rows of the gain matrix in double precision, regardless of how the gain matrix is held.
+    *
+    * @param[in] sel    Rows to return
+    *
+    * @return the selected rows of the gain matrix
+    */
+    MatrixXd gain(const VectorXi& sel) const;
+
+    //=========================================================================================================
+    /**
+    * Converts a single precision gain matrix into a double precision sol->data. Solutions which are held in
+    * double precision are left untouched.
+    */
+    void to_double_gain();
+
     //=========================================================================================================
     /**
     * mne.fiff.pick_channels_forward
     *
-    * Pick channels from forward operator
+    * Pick channels from forward operator. Only the selected rows of the gain matrices are copied, picking all channels
+    * in their original order shares the gain matrices with this solution. A single precision gain matrix is
+    * never copied, the picked solution shares it and only keeps the indices of the selected rows.
     *
     * @param[in] include    List of channels to include. (if None, include all available).
     * @param[in] exclude    Channels to exclude (if None, do not exclude any).
@@ -426,7 +463,14 @@ public:
     /**
     * ### MNE toolbox root function ###: Implementation of the mne_read_forward_solution function
     *
-    * Reads a forward solution from a fif file
+    * Reads a forward solution from a fif file. The gain matrices are held in double precision unless bFloatGain
+    * is set. If the device can be memory mapped they are converted straight out of the mapping, which avoids
+    * temporary copies while reading.
+    * With bFloatGain the gain matrix is kept in single precision, as stored in the file, in sol_float and sol->data
+    * stays empty. This halves the memory of the solution, and channel picks, source picks and to_fixed_ori only
+    * select indices of the shared matrix instead of copying it. prepare_forward, and with it
+    * MNEInverseOperator::make_inverse_operator, read such solutions directly. Use gain or to_double_gain where a
+    * double matrix is needed. The gradient sol_grad is always held in double precision.
     *
     * @param[in] p_IODevice    A fiff IO device like a fiff QFile or QTCPSocket
     * @param[out] fwd          A forward solution from a fif file
@@ -435,10 +479,11 @@ public:
     * @param[in] include       Include these channels (optional)
     * @param[in] exclude       Exclude these channels (optional)
     * @param[in] bExcludeBads  If true bads are also read; default = false (optional)
+    * @param[in] bFloatGain    Keep the gain matrix in single precision (optional, default = false)
     *
     * @return true if succeeded, false otherwise
     */
-    static bool read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bool force_fixed = false, bool surf_ori = false, const QStringList& include = defaultQStringList, const QStringList& exclude = defaultQStringList, bool bExcludeBads = true);
+    static bool read(QIODevice& p_IODevice, MNEForwardSolution& fwd, bool force_fixed = false, bool surf_ori = false, const QStringList& include = defaultQStringList, const QStringList& exclude = defaultQStringList, bool bExcludeBads = true, bool bFloatGain = false);
 
     //ToDo readFromStream
 
@@ -492,10 +537,11 @@ private:
     * @param[in] p_pStream  The opened fif file to read from
     * @param[in] p_Node     The forward solution node
     * @param[out] one       The read forward solution
+    * @param[in] bFloatGain Read the gain matrix into one.sol_float
     *
     * @return True if succeeded, false otherwise
     */
-    static bool read_one(FiffStream::SPtr& p_pStream, const FiffDirNode::SPtr& p_Node, MNEForwardSolution& one);
+    static bool read_one(FiffStream::SPtr& p_pStream, const FiffDirNode::SPtr& p_Node, MNEForwardSolution& one, bool bFloatGain = false);
 
 public:
     FiffInfoBase info;                  /**< light weighted measurement info */
@@ -506,6 +552,9 @@ public:
     fiff_int_t nchan;                   /**< Number of channels */
     FiffNamedMatrix::SDPtr sol;         /**< Forward solution */
     FiffNamedMatrix::SDPtr sol_grad;    /**< ToDo... */
+    QSharedPointer<const MatrixXf> sol_float;   /**< Single precision gain matrix shared between picks, NULL if the gain matrix is sol->data */
+    VectorXi sol_float_rows;            /**< Rows of sol_float which form the gain matrix */
+    VectorXi sol_float_cols;            /**< Columns of sol_float which form the gain matrix */
     FiffCoordTrans mri_head_t;          /**< MRI head coordinate transformation */
     MNESourceSpace src;                 /**< Geometric description of the source spaces (hemispheres) */
     MatrixX3f source_rr;                /**< Source locations */
@@ -539,6 +588,14 @@ inline bool MNEForwardSolution::isFixedOrient() const
 }
 
 
+//*************************************************************************************************************
+
+inline bool MNEForwardSolution::isFloatGain() const
+{
+    return !this->sol_float.isNull();
+}
+
+
 //*************************************************************************************************************
 
 inline std::ostream& operator<<(std::ostream& out, const MNELIB::MNEForwardSolution &p_MNEForwardSolution)
@@ -1196,22 +1196,18 @@ bool MNEInverseOperator::read_inverse_operator(QIODevice& p_IODevice, MNEInverse
     inv.sing = Map<VectorXf>(t_pTag->toFloat(), t_pTag->size()/4).cast<double>();
     inv.nchan = inv.sing.rows();
     //
-    //   The eigenleads and eigenfields
+    //   The eigenleads and eigenfields, having the eigenleads as columns is better for the inverse calculations
     //
     inv.eigen_leads_weighted = false;
-    if(!t_pStream->read_named_matrix(invs, FIFF_MNE_INVERSE_LEADS, *inv.eigen_leads.data()))
+    if(!t_pStream->read_named_matrix(invs, FIFF_MNE_INVERSE_LEADS, *inv.eigen_leads.data(), true))
     {
         inv.eigen_leads_weighted = true;
-        if(!t_pStream->read_named_matrix(invs, FIFF_MNE_INVERSE_LEADS_WEIGHTED, *inv.eigen_leads.data()))
+        if(!t_pStream->read_named_matrix(invs, FIFF_MNE_INVERSE_LEADS_WEIGHTED, *inv.eigen_leads.data(), true))
         {
             printf("Error reading eigenleads named matrix.\n");
             return false;
         }
     }
-    //
-    //   Having the eigenleads as columns is better for the inverse calculations
-    //
-    inv.eigen_leads->transpose_named_matrix();
 
     if(!t_pStream->read_named_matrix(invs, FIFF_MNE_INVERSE_FIELDS, *inv.eigen_fields.data()))
     {
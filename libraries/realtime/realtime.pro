@@ -100,7 +100,8 @@ SOURCES += \
     rtProcessing/rtave.cpp \
     rtProcessing/rtnoise.cpp \
     rtProcessing/rthpis.cpp \
-    rtProcessing/rtfilter.cpp
+    rtProcessing/rtfilter.cpp \
+    rtProcessing/rtdecimator.cpp
 
 HEADERS +=  \
     realtime_global.h \
@@ -116,7 +117,8 @@ HEADERS +=  \
     rtProcessing/rtave.h \
     rtProcessing/rtnoise.h \
     rtProcessing/rthpis.h \
-    rtProcessing/rtfilter.h
+    rtProcessing/rtfilter.h \
+    rtProcessing/rtdecimator.h
 
 INCLUDEPATH += $${EIGEN_INCLUDE_DIR}
 INCLUDEPATH += $${MNE_INCLUDE_DIR}
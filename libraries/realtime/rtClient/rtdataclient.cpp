@@ -61,6 +61,10 @@ RtDataClient::RtDataClient(QObject *parent)
 : QTcpSocket(parent)
 , m_clientID(-1)
 {
+    connect(&m_tagParser, &FiffTagParser::tagReceived,
+            this, &RtDataClient::onTagReceived);
+    m_tagParser.attach(this);
+
     getClientId();
 }
 
@@ -95,11 +99,9 @@ qint32 RtDataClient::getClientId()
         QString t_sCommand("");
         t_fiffStream.write_rt_command(1, t_sCommand);
 
-        this->waitForReadyRead(100);
         // ID is send as answer
         FiffTag::SPtr t_pTag;
-        t_fiffStream.read_tag(t_pTag);
-        if (t_pTag->kind == FIFF_MNE_RT_CLIENT_ID)
+        if (this->readTag(t_pTag, 100) && t_pTag->kind == FIFF_MNE_RT_CLIENT_ID)
             m_clientID = *t_pTag->toInt();
     }
     return m_clientID;
@@ -115,14 +117,14 @@ FiffInfo::SPtr RtDataClient::readInfo()
     bool t_bReadMeasBlockEnd = false;
     QString col_names, row_names;
 
-    FiffStream t_fiffStream(this);
     //
     // Find the start
     //
     FiffTag::SPtr t_pTag;
     while(!t_bReadMeasBlockStart)
     {
-        t_fiffStream.read_rt_tag(t_pTag);
+        if(!this->readTag(t_pTag))
+            return p_pFiffInfo;
         if(t_pTag->kind == FIFF_BLOCK_START && *(t_pTag->toInt()) == FIFFB_MEAS_INFO)
         {
             printf("FIFF_BLOCK_START FIFFB_MEAS_INFO\n");
@@ -139,7 +141,8 @@ FiffInfo::SPtr RtDataClient::readInfo()
 
     while(!t_bReadMeasBlockEnd)
     {
-        t_fiffStream.read_rt_tag(t_pTag);
+        if(!this->readTag(t_pTag))
+            return p_pFiffInfo;
         //
         //  megacq parameters
         //
@@ -147,7 +150,8 @@ FiffInfo::SPtr RtDataClient::readInfo()
         {
             while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_DACQ_PARS)
             {
-                t_fiffStream.read_rt_tag(t_pTag);
+                if(!this->readTag(t_pTag))
+                    return p_pFiffInfo;
                 if(t_pTag->kind == FIFF_DACQ_PARS)
                     p_pFiffInfo->acq_pars = t_pTag->toString();
                 else if(t_pTag->kind == FIFF_DACQ_STIM)
@@ -177,7 +181,8 @@ FiffInfo::SPtr RtDataClient::readInfo()
         {
             while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_ISOTRAK)
             {
-                t_fiffStream.read_rt_tag(t_pTag);
+                if(!this->readTag(t_pTag))
+                    return p_pFiffInfo;
 
                 if(t_pTag->kind == FIFF_DIG_POINT)
                     p_pFiffInfo->dig.append(t_pTag->toDigPoint());
@@ -190,14 +195,16 @@ FiffInfo::SPtr RtDataClient::readInfo()
         {
             while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_PROJ)
             {
-                t_fiffStream.read_rt_tag(t_pTag);
+                if(!this->readTag(t_pTag))
+                    return p_pFiffInfo;
                 if(t_pTag->kind == FIFF_BLOCK_START && *(t_pTag->toInt()) == FIFFB_PROJ_ITEM)
                 {
                     FiffProj proj;
                     qint32 countProj = p_pFiffInfo->projs.size();
                     while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_PROJ_ITEM)
                     {
-                        t_fiffStream.read_rt_tag(t_pTag);
+                        if(!this->readTag(t_pTag))
+                            return p_pFiffInfo;
                         switch (t_pTag->kind)
                         {
                         case FIFF_NAME: // First proj -> Proj is created
@@ -243,14 +250,16 @@ FiffInfo::SPtr RtDataClient::readInfo()
         {
             while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_MNE_CTF_COMP)
             {
-                t_fiffStream.read_rt_tag(t_pTag);
+                if(!this->readTag(t_pTag))
+                    return p_pFiffInfo;
                 if(t_pTag->kind == FIFF_BLOCK_START && *(t_pTag->toInt()) == FIFFB_MNE_CTF_COMP_DATA)
                 {
                     FiffCtfComp comp;
                     qint32 countComp = p_pFiffInfo->comps.size();
                     while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_MNE_CTF_COMP_DATA)
                     {
-                        t_fiffStream.read_rt_tag(t_pTag);
+                        if(!this->readTag(t_pTag))
+                            return p_pFiffInfo;
                         switch (t_pTag->kind)
                         {
                         case FIFF_MNE_CTF_COMP_KIND: //First comp -> create comp
@@ -306,7 +315,8 @@ FiffInfo::SPtr RtDataClient::readInfo()
         {
             while(t_pTag->kind != FIFF_BLOCK_END || *(t_pTag->toInt()) != FIFFB_MNE_BAD_CHANNELS)
             {
-                t_fiffStream.read_rt_tag(t_pTag);
+                if(!this->readTag(t_pTag))
+                    return p_pFiffInfo;
                 if(t_pTag->kind == FIFF_MNE_CH_NAME_LIST)
                     p_pFiffInfo->bads = FiffStream::split_name_list(t_pTag->data());
             }
@@ -362,13 +372,12 @@ void RtDataClient::readRawBuffer(qint32 p_nChannels, MatrixXf& data, fiff_int_t&
 {
 //        data = [];
 
-    FiffStream t_fiffStream(this);
-    //
-    // Find the start
-    //
     FiffTag::SPtr t_pTag;
-
-    t_fiffStream.read_rt_tag(t_pTag);
+    if(!this->readTag(t_pTag))
+    {
+        kind = -1;
+        return;
+    }
 
     kind = t_pTag->kind;
 
@@ -390,3 +399,31 @@ void RtDataClient::setClientAlias(const QString &p_sAlias)
     t_fiffStream.write_rt_command(2, p_sAlias);//MNE_RT.MNE_RT_SET_CLIENT_ALIAS, alias);
     this->flush();
 }
+
+
+//*************************************************************************************************************
+
+bool RtDataClient::readTag(FiffTag::SPtr& p_pTag, int msecs)
+{
+    //
+    //   readyRead drives the parser, also while waiting here
+    //
+    if(m_qTagQueue.isEmpty() && this->bytesAvailable() > 0)
+        m_tagParser.append(this->readAll());
+
+    while(m_qTagQueue.isEmpty())
+        if(!this->waitForReadyRead(msecs))
+            return false;
+
+    p_pTag = m_qTagQueue.dequeue();
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void RtDataClient::onTagReceived(const FiffTag::SPtr& p_pTag)
+{
+    m_qTagQueue.enqueue(p_pTag);
+    emit tagsAvailable();
+}
@@ -54,6 +54,7 @@
 #include <fiff/fiff_stream.h>
 #include <fiff/fiff_info.h>
 #include <fiff/fiff_tag.h>
+#include <fiff/fiff_tag_parser.h>
 
 
 //*************************************************************************************************************
@@ -64,6 +65,7 @@
 #include <QSharedPointer>
 #include <QString>
 #include <QTcpSocket>
+#include <QQueue>
 
 
 //*************************************************************************************************************
@@ -86,6 +88,8 @@ using namespace FIFFLIB;
 //=============================================================================================================
 /**
 * The real-time data client class provides an interface to communicate with the data port 4218 of a running mne_rt_server.
+* Received bytes are decoded by a FiffTagParser as soon as the socket signals readyRead; complete tags are queued
+* and announced with tagsAvailable. The blocking read functions wait for the socket instead of polling it.
 *
 * @brief Real-time data client
 */
@@ -132,7 +136,7 @@ public:
     /**
     * Reads fiff measurement information of a data the connection
     *
-    * @return the read fiff measurement information
+    * @return the read fiff measurement information, incomplete if the connection was closed meanwhile
     */
     FiffInfo::SPtr readInfo();
 
@@ -142,7 +146,7 @@ public:
     *
     * @param[in] p_nChannels    Number of channels to reshape the received data
     * @param[out] data          The read data - ToDo change this to raw buffer data object
-    * @param[out] kind          Data kind
+    * @param[out] kind          Data kind, -1 if the connection was closed
     */
     void readRawBuffer(qint32 p_nChannels, MatrixXf& data, fiff_int_t& kind);
 
@@ -154,15 +158,61 @@ public:
     */
     void setClientAlias(const QString &p_sAlias);
 
+    //=========================================================================================================
+    /**
+    * Takes the next received tag. If no tag is queued, waits until one arrives. Event-driven clients call
+    * this with msecs = 0 from a slot connected to tagsAvailable.
+    *
+    * @param[out] p_pTag    The received tag
+    * @param[in] msecs      Maximal time to wait for a tag in milliseconds, -1 waits forever (default)
+    *
+    * @return true if a tag was taken, false on timeout or when the connection was closed
+    */
+    bool readTag(FiffTag::SPtr& p_pTag, int msecs = -1);
+
+    //=========================================================================================================
+    /**
+    * Returns the tag decoder of the connection, e.g. to read its latency statistics.
+    *
+    * @return the tag decoder
+    */
+    inline const FiffTagParser& tagParser() const;
+
 private:
+    //=========================================================================================================
+    /**
+    * Queues a tag decoded by the tag parser.
+    *
+    * @param[in] p_pTag     The received tag
+    */
+    void onTagReceived(const FiffTag::SPtr& p_pTag);
+
     qint32 m_clientID;  /**< Corresponding client id of the data client at mne_rt_server */
+    FiffTagParser           m_tagParser;    /**< Decodes the received bytes */
+    QQueue<FiffTag::SPtr>   m_qTagQueue;    /**< Received tags which were not read yet */
 
 signals:
-    
+    //=========================================================================================================
+    /**
+    * Emitted when received tags were queued, see readTag.
+    */
+    void tagsAvailable();
+
 public slots:
     
 };
 
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline const FiffTagParser& RtDataClient::tagParser() const
+{
+    return m_tagParser;
+}
+
 } // NAMESPACE
 
 #endif // RTDATACLIENT_H
@@ -44,7 +44,6 @@
 
 #include <utils/ioutils.h>
 #include <utils/detecttrigger.h>
-#include <utils/mnemath.h>
 
 #include <iostream>
 
@@ -298,6 +297,9 @@ void RtAve::run()
     //Do initial reset
     reset();
 
+    //The segment storage is swapped with the buffer slots, popping does not copy or allocate
+    MatrixXd rawSegment;
+
     //Enter the main loop
     while(m_bIsRunning) {
         //Wait for first data block to arrive
@@ -310,7 +312,7 @@ void RtAve::run()
             //time.start();
 
             //Acquire Data m_pRawMatrixBuffer is thread safe
-            MatrixXd rawSegment = m_pRawMatrixBuffer->pop();
+            m_pRawMatrixBuffer->pop(rawSegment);
 
             //QMutexLocker locker(&m_qMutex);
             doAveraging(rawSegment);
@@ -386,7 +388,7 @@ void RtAve::doAveraging(const MatrixXd& rawSegment)
                 generateEvoked(dTriggerType);
 
                 //If number of averages was reached emit new average
-                if(m_mapStimAve[dTriggerType].size() > 0) {
+                if(m_mapStimAveSum.contains(dTriggerType)) {
                     emit evokedStim(m_pStimEvokedSet);
                 }
 
@@ -516,17 +518,47 @@ void RtAve::mergeData(double dTriggerType)
     bool bArtifactedDetected = checkForArtifact(mergedData);
 
     if(bArtifactedDetected == false) {
-        //Add cut data to average buffer
-        m_mapStimAve[dTriggerType].append(mergedData);
-
-        //Pop data from buffer
-        if(m_mapStimAve[dTriggerType].size() > m_iNumAverages && m_iNumAverages >= 1) {
-            m_mapStimAve[dTriggerType].pop_front();
+        if(!m_mapStimAveSum.contains(dTriggerType)) {
+            m_mapStimAveSum[dTriggerType] = MatrixXd::Zero(mergedData.rows(), mergedData.cols());
+            m_mapStimAveIdx[dTriggerType] = 0;
         }
 
-        //Proceed a bit different if we use zero number of averages
-        if(m_mapStimAve[dTriggerType].size() > 1 && m_iNumAverages == 0) {
-            m_mapStimAve[dTriggerType].pop_front();
+        MatrixXd& matSum = m_mapStimAveSum[dTriggerType];
+
+        if(m_iAverageMode == 0) {
+            //Keep the newest epoch only if the number of averages is zero
+            int iRingSize = m_iNumAverages >= 1 ? m_iNumAverages : 1;
+            QList<MatrixXd>& lEpochs = m_mapStimAve[dTriggerType];
+
+            if(lEpochs.size() < iRingSize) {
+                //Add cut data to average buffer
+                lEpochs.append(mergedData);
+                matSum += mergedData;
+            } else {
+                //Replace the oldest epoch
+                qint32& iIdx = m_mapStimAveIdx[dTriggerType];
+
+                matSum += mergedData - lEpochs.at(iIdx);
+                lEpochs[iIdx] = mergedData;
+
+                iIdx = (iIdx + 1) % iRingSize;
+
+                //Sum the ring up again once per turn, the rounding errors of the updates do not accumulate
+                if(iIdx == 0) {
+                    matSum = lEpochs.at(0);
+                    for(int i = 1; i < lEpochs.size(); ++i) {
+                        matSum += lEpochs.at(i);
+                    }
+                }
+            }
+
+            if(m_mapNumberCalcAverages[dTriggerType] < m_iNumAverages) {
+                m_mapNumberCalcAverages[dTriggerType]++;
+            }
+        } else if(m_iAverageMode == 1) {
+            matSum += mergedData;
+
+            m_mapNumberCalcAverages[dTriggerType]++;
         }
     }
 }
@@ -647,17 +679,14 @@ void RtAve::generateEvoked(double dTriggerType)
 {
     QMutexLocker locker(&m_qMutex);
 
-    if(m_mapStimAve[dTriggerType].isEmpty()) {
+    if(!m_mapStimAveSum.contains(dTriggerType)) {
         return;
     }
 
-    //Init evoked
-    FiffEvoked evoked;    
     int iEvokedIdx = -1;
 
     for(int i = 0; i < m_pStimEvokedSet->evoked.size(); ++i) {
         if(m_pStimEvokedSet->evoked.at(i).comment == QString::number(dTriggerType)) {
-            evoked = m_pStimEvokedSet->evoked.at(i);
             iEvokedIdx = i;
             break;
         }
@@ -665,6 +694,7 @@ void RtAve::generateEvoked(double dTriggerType)
 
     //If the evoked is not yet present add it here
     if(iEvokedIdx == -1) {
+        FiffEvoked evoked;
         float T = 1.0/m_pFiffInfo->sfreq;
 
         evoked.setInfo(*m_pFiffInfo.data());
@@ -676,53 +706,59 @@ void RtAve::generateEvoked(double dTriggerType)
         evoked.first = evoked.times[0];
         evoked.last = evoked.times[evoked.times.size()-1];
         evoked.comment = QString::number(dTriggerType);
+
+        m_pStimEvokedSet->evoked.append(evoked);
+        iEvokedIdx = m_pStimEvokedSet->evoked.size() - 1;
     }
 
-    // Generate final evoked
-    MatrixXd finalAverage = MatrixXd::Zero(m_mapStimAve[dTriggerType].first().rows(), m_iPreStimSamples+m_iPostStimSamples);
+    //Update the evoked data in place
+    FiffEvoked& evoked = m_pStimEvokedSet->evoked[iEvokedIdx];
+    const MatrixXd& matSum = m_mapStimAveSum[dTriggerType];
 
-    if(m_iAverageMode == 0) {
-        for(int i = 0; i < m_mapStimAve[dTriggerType].size(); ++i) {
-            finalAverage += m_mapStimAve[dTriggerType].at(i);
-        }
+    double dNorm = 1.0;
 
-        if(m_mapStimAve[dTriggerType].isEmpty()) {
-            finalAverage = finalAverage/1;
-        } else {
-            finalAverage = finalAverage/m_mapStimAve[dTriggerType].size();
-        }
+    if(m_iAverageMode == 0) {
+        dNorm = 1.0/m_mapStimAve[dTriggerType].size();
+    } else if(m_iAverageMode == 1) {
+        dNorm = 1.0/m_mapNumberCalcAverages[dTriggerType];
+    }
 
-        if(m_bDoBaselineCorrection) {
-            finalAverage = MNEMath::rescale(finalAverage, evoked.times, m_pairBaselineSec, QString("mean"));
-        }
+    evoked.nave = m_mapNumberCalcAverages[dTriggerType];
 
-        evoked.data = finalAverage;
+    if(m_bDoBaselineCorrection) {
+        //The baseline window as in MNEMath::rescale
+        qint32 iFrom = 0;
+        qint32 iTo = evoked.times.size();
 
-        if(m_mapNumberCalcAverages[dTriggerType] < m_iNumAverages) {
-            m_mapNumberCalcAverages[dTriggerType]++;
+        if(m_pairBaselineSec.first.isValid()) {
+            float fFrom = m_pairBaselineSec.first.toFloat();
+            for(qint32 i = 0; i < evoked.times.size(); ++i) {
+                if(evoked.times[i] >= fFrom) {
+                    iFrom = i;
+                    break;
+                }
+            }
         }
 
-        evoked.nave = m_mapNumberCalcAverages[dTriggerType];
-    } else if(m_iAverageMode == 1) {
-        MatrixXd tempMatrix = m_mapStimAve[dTriggerType].last();
-
-        if(m_bDoBaselineCorrection) {
-            tempMatrix = MNEMath::rescale(tempMatrix, evoked.times, m_pairBaselineSec, QString("mean"));
+        if(m_pairBaselineSec.second.isValid()) {
+            float fTo = m_pairBaselineSec.second.toFloat();
+            for(qint32 i = evoked.times.size()-1; i >= 0; --i) {
+                if(evoked.times[i] <= fTo) {
+                    iTo = i+1;
+                    break;
+                }
+            }
         }
 
-        evoked += tempMatrix;
-
-        m_mapNumberCalcAverages[dTriggerType]++;
+        //The baseline of the average is the baseline of the sum scaled by dNorm
+        if(iTo > iFrom) {
+            m_vecBaseline = matSum.middleCols(iFrom, iTo - iFrom).rowwise().mean();
+            evoked.data = (matSum.colwise() - m_vecBaseline) * dNorm;
+            return;
+        }
     }
 
-    //Add new data to evoked data set
-    if(iEvokedIdx != -1) {
-        //Evoked data is already present
-        m_pStimEvokedSet->evoked[iEvokedIdx] = evoked;
-    } else {
-        //Evoked data is not present yet
-        m_pStimEvokedSet->evoked.append(evoked);
-    }
+    evoked.data = matSum * dNorm;
 }
 
 
@@ -758,6 +794,8 @@ void RtAve::reset()
 
     m_qMapDetectedTrigger.clear();
     m_mapStimAve.clear();
+    m_mapStimAveIdx.clear();
+    m_mapStimAveSum.clear();
     m_mapDataPre.clear();
     m_mapDataPost.clear();
     m_mapMatDataPostIdx.clear();
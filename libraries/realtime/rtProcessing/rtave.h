@@ -275,13 +275,15 @@ private:
 
     //=========================================================================================================
     /**
-    * Packs the buffers togehter as one and calcualtes the current running average and emits the result if number of averages has been reached.
+    * Packs the buffers togehter as one epoch and adds it to the running sum of its trigger type. In the running
+    * mode the epoch replaces the oldest one of the epoch ring and the oldest epoch is subtracted from the sum.
     */
     void mergeData(double dTriggerType);
 
     //=========================================================================================================
     /**
-    * Generates the final evoke variable.
+    * Updates the evoked of the trigger type in place from its running sum. The baseline is taken from the
+    * baseline window of the sum, the cost does not depend on the number of averages.
     */
     void generateEvoked(double dTriggerType);
 
@@ -345,7 +347,10 @@ private:
     FIFFLIB::FiffEvokedSet::SPtr                    m_pStimEvokedSet;           /**< Holds the evoked information. */
 
     QMap<int,QList<int> >                           m_qMapDetectedTrigger;      /**< Detected trigger for each trigger channel. */
-    QMap<double,QList<Eigen::MatrixXd> >            m_mapStimAve;               /**< the current stimulus average buffer. Holds m_iNumAverages vectors */
+    QMap<double,QList<Eigen::MatrixXd> >            m_mapStimAve;               /**< The epoch ring of the running average. Holds up to m_iNumAverages epochs */
+    QMap<double,qint32>                             m_mapStimAveIdx;            /**< The index of the oldest epoch inside of the epoch ring, it is overwritten next. */
+    QMap<double,Eigen::MatrixXd>                    m_mapStimAveSum;            /**< The sum of the averaged epochs for each trigger type. */
+    Eigen::VectorXd                                 m_vecBaseline;              /**< The baseline of the running sum, one value per channel. */
     QMap<double,Eigen::MatrixXd>                    m_mapDataPre;               /**< The matrix holding the pre stim data. */
     QMap<double,Eigen::MatrixXd>                    m_mapDataPost;              /**< The matrix holding the post stim data. */
     QMap<double,qint32>                             m_mapMatDataPostIdx;        /**< Current index inside of the matrix m_matDataPost */
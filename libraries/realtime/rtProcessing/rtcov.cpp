@@ -155,12 +155,13 @@ void RtCov::run()
 
     FiffCov::SPtr cov(new FiffCov());
     VectorXd mu;
+    MatrixXd rawSegment;
 
     while(m_bIsRunning)
     {
         if(m_pRawMatrixBuffer)
         {
-            MatrixXd rawSegment = m_pRawMatrixBuffer->pop();
+            m_pRawMatrixBuffer->pop(rawSegment);
 
             if(n_samples == 0)
             {
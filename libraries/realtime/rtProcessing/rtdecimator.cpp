@@ -0,0 +1,210 @@
+//=============================================================================================================
+/**
+* @file     rtdecimator.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    RtDecimator class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rtdecimator.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RtDecimator::RtDecimator(int iFactor, int iHalfLength, double dRolloff)
+: m_iFactor(qMax(iFactor, 1))
+, m_iHalfLength(qMax(iHalfLength, 1))
+, m_dRolloff(dRolloff)
+, m_iDelay(0)
+, m_iNextOutput(0)
+{
+    design();
+}
+
+
+//*************************************************************************************************************
+
+RtDecimator::~RtDecimator()
+{
+}
+
+
+//*************************************************************************************************************
+
+void RtDecimator::setFactor(int iFactor)
+{
+    m_iFactor = qMax(iFactor, 1);
+    design();
+}
+
+
+//*************************************************************************************************************
+
+double RtDecimator::cutoff(double sfreq) const
+{
+    if(m_iFactor == 1)
+        return sfreq / 2.0;
+
+    return m_dRolloff * sfreq / (2.0 * m_iFactor);
+}
+
+
+//*************************************************************************************************************
+
+void RtDecimator::setStimChannels(const QVector<int>& lStimChannels)
+{
+    m_lStimChannels = lStimChannels;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd RtDecimator::decimate(const MatrixXd& matDataIn)
+{
+    MatrixXd matDataOut;
+    decimate(matDataIn, matDataOut);
+    return matDataOut;
+}
+
+
+//*************************************************************************************************************
+
+void RtDecimator::decimate(const MatrixXd& matDataIn, MatrixXd& matDataOut)
+{
+    int iRows = matDataIn.rows();
+    int iBlockSize = matDataIn.cols();
+    int iTaps = m_vecTaps.rows();
+    int iHistory = iTaps - 1;
+
+    if(m_matHistory.rows() != iRows || m_matHistory.cols() != iHistory) {
+        m_matHistory = MatrixXd::Zero(iRows, iHistory);
+        m_iNextOutput = 0;
+    }
+
+    if(m_matBuffer.rows() != iRows || m_matBuffer.cols() != iHistory + iBlockSize)
+        m_matBuffer.resize(iRows, iHistory + iBlockSize);
+
+    m_matBuffer.leftCols(iHistory) = m_matHistory;
+    m_matBuffer.rightCols(iBlockSize) = matDataIn;
+
+    //
+    //   Only the output samples which fall into this block are computed
+    //
+    int iOutputs = m_iNextOutput < iBlockSize ? (iBlockSize - m_iNextOutput + m_iFactor - 1) / m_iFactor : 0;
+
+    if(matDataOut.rows() != iRows || matDataOut.cols() != iOutputs)
+        matDataOut.resize(iRows, iOutputs);
+
+    for(int j = 0; j < iOutputs; ++j) {
+        int p = m_iNextOutput + j * m_iFactor;
+
+        //The input samples up to p meet the reversed filter, all channels at once
+        matDataOut.col(j).noalias() = m_matBuffer.middleCols(p, iTaps) * m_vecTaps;
+
+        //Stimulus channels hold the maximum of the delayed input samples this output sample replaces
+        for(int i = 0; i < m_lStimChannels.size(); ++i) {
+            int r = m_lStimChannels.at(i);
+            if(r < iRows)
+                matDataOut(r, j) = m_matBuffer.row(r).segment(p + m_iDelay - m_iFactor + 1, m_iFactor).maxCoeff();
+        }
+    }
+
+    m_iNextOutput += iOutputs * m_iFactor - iBlockSize;
+
+    m_matHistory = m_matBuffer.rightCols(iHistory);
+}
+
+
+//*************************************************************************************************************
+
+void RtDecimator::reset()
+{
+    m_matHistory.setZero();
+    m_iNextOutput = 0;
+}
+
+
+//*************************************************************************************************************
+
+void RtDecimator::design()
+{
+    if(m_iFactor == 1) {
+        m_vecFilter = RowVectorXd::Ones(1);
+    } else {
+        //
+        //   Windowed sinc, cutting off below the Nyquist frequency of the output
+        //
+        int iCenter = m_iHalfLength * m_iFactor;
+        int iTaps = 2 * iCenter + 1;
+        double fc = m_dRolloff / (2.0 * m_iFactor);
+
+        m_vecFilter.resize(iTaps);
+        for(int i = 0; i < iTaps; ++i) {
+            double t = i - iCenter;
+            double sinc = (t == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+            double window = 0.54 - 0.46 * cos(2.0 * M_PI * i / (iTaps - 1));
+            m_vecFilter[i] = sinc * window;
+        }
+        m_vecFilter /= m_vecFilter.sum();
+    }
+
+    m_vecTaps = m_vecFilter.reverse().transpose();
+    m_iDelay = (m_vecFilter.cols() - 1) / 2;
+
+    m_matHistory.resize(0, 0);
+    m_iNextOutput = 0;
+}
@@ -0,0 +1,242 @@
+//=============================================================================================================
+/**
+* @file     rtdecimator.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    RtDecimator class declaration.
+*
+*/
+
+#ifndef RTDECIMATOR_H
+#define RTDECIMATOR_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../realtime_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE REALTIMELIB
+//=============================================================================================================
+
+namespace REALTIMELIB
+{
+
+
+//=============================================================================================================
+/**
+* Real-time decimation of data blocks by an integer factor. The anti-alias filter is a Hamming windowed sinc
+* which is evaluated in its polyphase form: only every factor-th output sample is computed, so the work per
+* input sample does not grow with the factor. The last input samples of every channel and the position of the
+* next output sample are kept between the calls, so consecutive blocks of any size continue the stream and the
+* output does not depend on how the input is split into blocks.
+*
+* The filter is linear phase, the output is delayed by delay() input samples. Stimulus channels are not
+* filtered, each output sample holds the maximum of the (equally delayed) input samples it replaces, so short
+* trigger pulses survive the decimation.
+*
+* @code
+* RtDecimator decimator(5);                     // e.g. 5 kHz -> 1 kHz
+* decimator.setStimChannels(lStimChannels);
+* decimator.decimate(matBlock, matDecimated);   // for every incoming block
+* @endcode
+*
+* @brief Real-time polyphase decimation
+*/
+class REALTIMESHARED_EXPORT RtDecimator
+{
+
+public:
+    typedef QSharedPointer<RtDecimator> SPtr;             /**< Shared pointer type for RtDecimator. */
+    typedef QSharedPointer<const RtDecimator> ConstSPtr;  /**< Const shared pointer type for RtDecimator. */
+
+    //=========================================================================================================
+    /**
+    * Creates the decimator and designs the anti-alias filter.
+    *
+    * @param [in] iFactor       the decimation factor
+    * @param [in] iHalfLength   half length of the filter in output samples
+    * @param [in] dRolloff      cutoff of the filter relative to the Nyquist frequency of the output
+    */
+    explicit RtDecimator(int iFactor = 1, int iHalfLength = 16, double dRolloff = 0.9);
+
+    //=========================================================================================================
+    /**
+    * Destroys the decimator.
+    */
+    ~RtDecimator();
+
+    //=========================================================================================================
+    /**
+    * Sets the decimation factor, redesigns the filter and resets the state.
+    *
+    * @param [in] iFactor       the decimation factor
+    */
+    void setFactor(int iFactor);
+
+    //=========================================================================================================
+    /**
+    * Returns the decimation factor.
+    *
+    * @return the decimation factor
+    */
+    inline int factor() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the anti-alias filter at the input rate. Its gain is 1.
+    *
+    * @return the filter coefficients
+    */
+    inline const Eigen::RowVectorXd& filter() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the delay of the output, which is the group delay of the filter.
+    *
+    * @return the delay in input samples
+    */
+    inline int delay() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the cutoff frequency of the anti-alias filter.
+    *
+    * @param [in] sfreq     sampling frequency of the input
+    *
+    * @return the cutoff frequency in Hz
+    */
+    double cutoff(double sfreq) const;
+
+    //=========================================================================================================
+    /**
+    * Sets the rows which are stimulus channels. They are not filtered, each output sample holds the maximum of
+    * the input samples it replaces.
+    *
+    * @param [in] lStimChannels     the stimulus rows
+    */
+    void setStimChannels(const QVector<int>& lStimChannels);
+
+    //=========================================================================================================
+    /**
+    * Decimates the next block of the stream.
+    *
+    * @param [in] matDataIn     the next block, one channel per row
+    *
+    * @return the decimated samples
+    */
+    Eigen::MatrixXd decimate(const Eigen::MatrixXd& matDataIn);
+
+    //=========================================================================================================
+    /**
+    * Decimates the next block of the stream into matDataOut. The block holds the output samples which fall into
+    * it: blockSize/factor if the block size is a multiple of the factor, otherwise one more or less. The state
+    * is reset if the number of rows changes.
+    *
+    * @param [in] matDataIn     the next block, one channel per row
+    * @param [out] matDataOut   the decimated samples, it is only resized if its size does not match
+    */
+    void decimate(const Eigen::MatrixXd& matDataIn, Eigen::MatrixXd& matDataOut);
+
+    //=========================================================================================================
+    /**
+    * Resets the state, the next block is decimated as if the stream started with it.
+    */
+    void reset();
+
+private:
+    //=========================================================================================================
+    /**
+    * Designs the anti-alias filter for the current factor.
+    */
+    void design();
+
+    int                 m_iFactor;          /**< The decimation factor */
+    int                 m_iHalfLength;      /**< Half length of the filter in output samples */
+    double              m_dRolloff;         /**< Cutoff relative to the Nyquist frequency of the output */
+    int                 m_iDelay;           /**< Group delay of the filter in input samples */
+    int                 m_iNextOutput;      /**< Position of the next output sample in the next block */
+
+    Eigen::RowVectorXd  m_vecFilter;        /**< The anti-alias filter */
+    Eigen::VectorXd     m_vecTaps;          /**< The filter in reversed time order, applied to the past input samples */
+    QVector<int>        m_lStimChannels;    /**< The stimulus rows */
+    Eigen::MatrixXd     m_matHistory;       /**< Last input samples of every row */
+    Eigen::MatrixXd     m_matBuffer;        /**< The last input samples followed by the current block */
+};
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int RtDecimator::factor() const
+{
+    return m_iFactor;
+}
+
+
+//*************************************************************************************************************
+
+inline const Eigen::RowVectorXd& RtDecimator::filter() const
+{
+    return m_vecFilter;
+}
+
+
+//*************************************************************************************************************
+
+inline int RtDecimator::delay() const
+{
+    return m_iDelay;
+}
+
+} // NAMESPACE
+
+#endif // RTDECIMATOR_H
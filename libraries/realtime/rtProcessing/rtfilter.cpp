@@ -40,6 +40,17 @@
 
 #include "rtfilter.h"
 
+#include <utils/filterTools/iirfilter.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtConcurrent/QtConcurrent>
+#include <QThread>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -54,101 +65,288 @@ using namespace FIFFLIB;
 
 //*************************************************************************************************************
 //=============================================================================================================
-// DEFINE GLOBAL METHODS
+// DEFINE MEMBER METHODS
 //=============================================================================================================
 
-void doFilterPerChannelRTMSA(QPair<QList<FilterData>,QPair<int,RowVectorXd> > &channelDataTime)
+RtFilter::RtFilter()
+: m_iImpulseLength(1)
+, m_iFFTLength(0)
+, m_iBlockSize(0)
+, m_iDelay(0)
 {
-    for(int i = 0; i < channelDataTime.first.size(); ++i) {
-        //channelDataTime.second.second = channelDataTime.first.at(i).applyConvFilter(channelDataTime.second.second, true, FilterData::ZeroPad);
-        channelDataTime.second.second = channelDataTime.first.at(i).applyFFTFilter(channelDataTime.second.second, true, FilterData::ZeroPad); //FFT Convolution for rt is not suitable. FFT make the signal filtering non causal.
-    }
 }
 
 
 //*************************************************************************************************************
-//=============================================================================================================
-// DEFINE MEMBER METHODS
-//=============================================================================================================
 
-RtFilter::RtFilter()
+RtFilter::~RtFilter()
 {
 }
 
 
 //*************************************************************************************************************
 
-RtFilter::~RtFilter()
+MatrixXd RtFilter::filterChannelsConcurrently(const MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
 {
+    MatrixXd matDataOut;
+    filterChannelsConcurrently(matDataIn, matDataOut, iMaxFilterLength, lFilterChannelList, lFilterData);
+    return matDataOut;
 }
 
 
 //*************************************************************************************************************
 
-MatrixXd RtFilter::filterChannelsConcurrently(const MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
+void RtFilter::filterChannelsConcurrently(const MatrixXd& matDataIn, MatrixXd& matDataOut, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
 {
-    //Initialise the overlay matrix
-    if(m_matOverlap.cols() != iMaxFilterLength || m_matOverlap.rows() < matDataIn.rows()) {
-        m_matOverlap.resize(matDataIn.rows(), iMaxFilterLength);
-        m_matOverlap.setZero();
+    //Resize output matrix to match input matrix
+    if(matDataOut.rows() != matDataIn.rows() || matDataOut.cols() != matDataIn.cols())
+        matDataOut.resize(matDataIn.rows(), matDataIn.cols());
+
+    if(matDataIn.cols() == 0)
+        return;
+
+    update(matDataIn, iMaxFilterLength, lFilterChannelList, lFilterData);
+
+    //Do the concurrent filtering, every worker writes its own rows
+    for(int i = 0; i < m_lWorkers.size(); ++i) {
+        m_lWorkers[i].pDataIn = &matDataIn;
+        m_lWorkers[i].pDataOut = &matDataOut;
     }
 
-    if(m_matDelay.cols() != iMaxFilterLength/2 || m_matOverlap.rows() < matDataIn.rows()) {
-        m_matDelay.resize(matDataIn.rows(), iMaxFilterLength/2);
-        m_matDelay.setZero();
+    if(m_lFilterCoeffs.isEmpty()) {
+        //Only IIR filters, the rows enter the sections unchanged
+        for(int i = 0; i < m_lFilterRows.size(); ++i)
+            matDataOut.row(m_lFilterRows.at(i)) = matDataIn.row(m_lFilterRows.at(i));
+    } else if(m_lWorkers.size() == 1) {
+        filterRows(m_lWorkers[0]);
+    } else if(m_lWorkers.size() > 1) {
+        QtConcurrent::blockingMap(m_lWorkers, filterRows);
     }
 
-    //Resize output matrix to match input matrix
-    MatrixXd matDataOut(matDataIn.rows(), matDataIn.cols());
+    int iBlockSize = matDataIn.cols();
+
+    //
+    //   IIR sections after the FIR stage, linear time-invariant filters can be applied in any order
+    //
+    if(m_matSOS.rows() > 0 && !m_lFilterRows.isEmpty()) {
+        if(m_lDelayRows.isEmpty()) {
+            IIRFilter::filter(m_matSOS, matDataOut, m_matIIRState);
+        } else {
+            if(m_matIIRData.rows() != m_lFilterRows.size() || m_matIIRData.cols() != iBlockSize)
+                m_matIIRData.resize(m_lFilterRows.size(), iBlockSize);
+
+            for(int i = 0; i < m_lFilterRows.size(); ++i)
+                m_matIIRData.row(i) = matDataOut.row(m_lFilterRows.at(i));
 
-    //Generate QList structure which can be handled by the QConcurrent framework
-    QList<QPair<QList<FilterData>,QPair<int,RowVectorXd> > > timeData;
-    QList<int> notFilterChannelIndex;
+            IIRFilter::filter(m_matSOS, m_matIIRData, m_matIIRState);
 
-    //Only select channels specified in lFilterChannelList
-    for(qint32 i = 0; i < matDataIn.rows(); ++i) {
-        int pos = lFilterChannelList.indexOf(i);
-        if(pos != -1 && pos < matDataIn.rows()) {
-            timeData.append(QPair<QList<FilterData>,QPair<int,RowVectorXd> >(lFilterData,QPair<int,RowVectorXd>(pos,matDataIn.row(pos))));
+            for(int i = 0; i < m_lFilterRows.size(); ++i)
+                matDataOut.row(m_lFilterRows.at(i)) = m_matIIRData.row(i);
+        }
+    }
+
+    //Fill filtered data with the delayed raw data if the channel was not filtered
+    for(int i = 0; i < m_lDelayRows.size(); ++i) {
+        int r = m_lDelayRows.at(i);
+
+        if(m_iDelay <= iBlockSize) {
+            matDataOut.row(r).head(m_iDelay) = m_matDelay.row(r);
+            matDataOut.row(r).tail(iBlockSize - m_iDelay) = matDataIn.row(r).head(iBlockSize - m_iDelay);
+            m_matDelay.row(r) = matDataIn.row(r).tail(m_iDelay);
         } else {
-            notFilterChannelIndex.append(i);
+            //The delay is longer than the block
+            matDataOut.row(r) = m_matDelay.row(r).head(iBlockSize);
+            RowVectorXd vecDelay(m_iDelay);
+            vecDelay << m_matDelay.row(r).tail(m_iDelay - iBlockSize), matDataIn.row(r);
+            m_matDelay.row(r) = vecDelay;
         }
     }
+}
+
+
+//*************************************************************************************************************
+
+void RtFilter::reset()
+{
+    m_matHistory.setZero();
+    m_matDelay.setZero();
+    m_matIIRState.setZero();
+}
+
+
+//*************************************************************************************************************
+
+void RtFilter::filterRows(FilterWorker& worker)
+{
+    int iBlockSize = worker.pDataIn->cols();
+    int iHistory = worker.iHistory;
+    int iPadding = worker.vecTime.cols() - iHistory - iBlockSize;
+
+    for(int i = worker.iFirst; i < worker.iFirst + worker.iCount; ++i) {
+        int r = worker.pRows->at(i);
+
+        //The past samples in front of the new ones, zero padded to the FFT length
+        worker.vecTime.head(iHistory) = worker.pHistory->row(r);
+        worker.vecTime.segment(iHistory, iBlockSize) = worker.pDataIn->row(r);
+        worker.vecTime.tail(iPadding).setZero();
+
+        worker.fft.fwd(worker.vecFreq, worker.vecTime);
+        worker.vecFreq.array() *= worker.pSpectrum->array();
+        worker.fft.inv(worker.vecFiltered, worker.vecFreq);
+
+        //The first iHistory samples are wrapped around, the following ones are the linear convolution
+        worker.pDataOut->row(r) = worker.vecFiltered.segment(iHistory, iBlockSize);
+
+        //Keep the last input samples for the next block
+        worker.pHistory->row(r) = worker.vecTime.segment(iBlockSize, iHistory);
+    }
+}
 
-    //Do the concurrent filtering
-    if(!timeData.isEmpty()) {
-        QFuture<void> future = QtConcurrent::map(timeData,
-                                             doFilterPerChannelRTMSA);
 
-        future.waitForFinished();
+//*************************************************************************************************************
 
-        //Do the overlap add method and store in matDataOut
-        int iFilteredNumberCols = timeData.at(0).second.second.cols();
+void RtFilter::update(const MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<FilterData>& lFilterData)
+{
+    int iRows = matDataIn.rows();
+    int iBlockSize = matDataIn.cols();
+    bool bUpdateWorkers = false;
+
+    //
+    //   Spectrum of the cascaded FIR filters, only computed if the filters or the block size change
+    //
+    bool bFilterChanged = iBlockSize != m_iBlockSize;
+    bool bSectionsChanged = false;
+    int iNumFIR = 0;
+    int iNumSections = 0;
+    for(int i = 0; i < lFilterData.size(); ++i) {
+        const FilterData& filter = lFilterData.at(i);
+        int iSections = filter.m_matSOS.rows();
+
+        if(iSections > 0) {
+            bSectionsChanged = bSectionsChanged
+                               || iNumSections + iSections > m_matSOS.rows()
+                               || filter.m_matSOS != m_matSOS.middleRows(iNumSections, iSections);
+            iNumSections += iSections;
+        } else {
+            bFilterChanged = bFilterChanged
+                             || iNumFIR >= m_lFilterCoeffs.size()
+                             || filter.m_dCoeffA.cols() != m_lFilterCoeffs.at(iNumFIR).cols()
+                             || filter.m_dCoeffA != m_lFilterCoeffs.at(iNumFIR);
+            ++iNumFIR;
+        }
+    }
+    bFilterChanged = bFilterChanged || iNumFIR != m_lFilterCoeffs.size();
+    bSectionsChanged = bSectionsChanged || iNumSections != m_matSOS.rows();
+
+    if(bFilterChanged) {
+        m_lFilterCoeffs.clear();
 
-        for(int r = 0; r < timeData.size(); r++) {
-            //Get the currently filtered data. This data has a delay of filterLength/2 in front and back.
-            RowVectorXd tempData = timeData.at(r).second.second;
+        RowVectorXd vecImpulse = RowVectorXd::Ones(1);
+        for(int i = 0; i < lFilterData.size(); ++i) {
+            if(lFilterData.at(i).m_matSOS.rows() > 0)
+                continue;
 
-            //Perform the actual overlap add by adding the last filterlength data to the newly filtered one
-            tempData.head(iMaxFilterLength) += m_matOverlap.row(timeData.at(r).second.first);
+            const RowVectorXd& vecCoeffs = lFilterData.at(i).m_dCoeffA;
+            m_lFilterCoeffs.append(vecCoeffs);
 
-            //Write the newly calulated filtered data to the filter data matrix. Keep in mind that the current block also effect last part of the last block (begin at dataIndex-iFilterDelay).
-            int start = 0;
-            matDataOut.row(timeData.at(r).second.first).segment(start,iFilteredNumberCols-iMaxFilterLength) = tempData.head(iFilteredNumberCols-iMaxFilterLength);
+            if(vecCoeffs.cols() == 0)
+                continue;
 
-            //Refresh the m_matOverlap with the new calculated filtered data.
-            m_matOverlap.row(timeData.at(r).second.first) = timeData.at(r).second.second.tail(iMaxFilterLength);
+            RowVectorXd vecCascade = RowVectorXd::Zero(vecImpulse.cols() + vecCoeffs.cols() - 1);
+            for(int k = 0; k < vecCoeffs.cols(); ++k)
+                vecCascade.segment(k, vecImpulse.cols()) += vecCoeffs(k) * vecImpulse;
+            vecImpulse = vecCascade;
         }
+
+        m_iImpulseLength = vecImpulse.cols();
+        m_iBlockSize = iBlockSize;
+
+        //The FFT has to hold the past samples and the new block without wrapping into the new block
+        int iFFTLength = 2;
+        while(iFFTLength < m_iImpulseLength - 1 + m_iBlockSize)
+            iFFTLength *= 2;
+
+        RowVectorXd vecPadded = RowVectorXd::Zero(iFFTLength);
+        vecPadded.head(m_iImpulseLength) = vecImpulse;
+
+        FFT<double> fft;
+        fft.SetFlag(fft.HalfSpectrum);
+        fft.fwd(m_vecSpectrum, vecPadded);
+
+        bUpdateWorkers = iFFTLength != m_iFFTLength;
+        m_iFFTLength = iFFTLength;
     }
 
-    //Fill filtered data with raw data if the channel was not filtered
-    for(int i = 0; i < notFilterChannelIndex.size(); ++i) {
-        matDataOut.row(notFilterChannelIndex.at(i)) << m_matDelay.row(notFilterChannelIndex.at(i)), matDataIn.row(notFilterChannelIndex.at(i)).head(matDataIn.cols() - iMaxFilterLength/2);
+    //
+    //   Sections of all IIR filters in one cascade
+    //
+    if(bSectionsChanged) {
+        m_matSOS.resize(iNumSections, 6);
+
+        iNumSections = 0;
+        for(int i = 0; i < lFilterData.size(); ++i) {
+            const MatrixXd& matSOS = lFilterData.at(i).m_matSOS;
+            if(matSOS.rows() > 0) {
+                m_matSOS.middleRows(iNumSections, matSOS.rows()) = matSOS;
+                iNumSections += matSOS.rows();
+            }
+        }
 
-        //matDataOut.row(notFilterChannelIndex.at(i)).segment(0, matDataIn.row(notFilterChannelIndex.at(i)).cols()) = matDataIn.row(notFilterChannelIndex.at(i));
+        //The next block starts the sections from rest
+        m_matIIRState.resize(0, 0);
     }
 
-    m_matDelay = matDataIn.block(0, matDataIn.cols()-iMaxFilterLength/2, matDataIn.rows(), iMaxFilterLength/2);
+    //
+    //   Filter state, the past input samples stay valid as long as the impulse response length is kept
+    //
+    if(m_matHistory.rows() != iRows || m_matHistory.cols() != m_iImpulseLength - 1) {
+        m_matHistory = MatrixXd::Zero(iRows, m_iImpulseLength - 1);
+        bUpdateWorkers = true;
+    }
 
-    return matDataOut;
+    m_iDelay = qMax(iMaxFilterLength/2, 0);
+    if(m_matDelay.rows() != iRows || m_matDelay.cols() != m_iDelay)
+        m_matDelay = MatrixXd::Zero(iRows, m_iDelay);
+
+    //
+    //   Only select channels specified in lFilterChannelList
+    //
+    if(m_lFilterRows.size() + m_lDelayRows.size() != iRows || lFilterChannelList != m_lFilterChannelList) {
+        m_lFilterChannelList = lFilterChannelList;
+        m_lFilterRows.clear();
+        m_lDelayRows.clear();
+
+        for(int i = 0; i < iRows; ++i) {
+            if(lFilterChannelList.contains(i))
+                m_lFilterRows.append(i);
+            else
+                m_lDelayRows.append(i);
+        }
+
+        m_lWorkers.clear();
+        m_matIIRState.resize(0, 0);
+        bUpdateWorkers = true;
+    }
+
+    //
+    //   Split the filtered rows across the threads, every worker keeps its FFT plans and buffers
+    //
+    if(bUpdateWorkers) {
+        int iNumWorkers = qMin(qMax(QThread::idealThreadCount(), 1), m_lFilterRows.size());
+        m_lWorkers.resize(iNumWorkers);
+
+        for(int i = 0; i < iNumWorkers; ++i) {
+            FilterWorker& worker = m_lWorkers[i];
+            worker.pRows = &m_lFilterRows;
+            worker.iFirst = i * m_lFilterRows.size() / iNumWorkers;
+            worker.iCount = (i + 1) * m_lFilterRows.size() / iNumWorkers - worker.iFirst;
+            worker.iHistory = m_iImpulseLength - 1;
+            worker.pHistory = &m_matHistory;
+            worker.pSpectrum = &m_vecSpectrum;
+            worker.fft.SetFlag(worker.fft.HalfSpectrum);
+            worker.vecTime.resize(m_iFFTLength);
+            worker.vecFiltered.resize(m_iFFTLength);
+            worker.vecFreq.resize(m_iFFTLength/2 + 1);
+        }
+    }
 }
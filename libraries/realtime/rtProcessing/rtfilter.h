@@ -52,8 +52,8 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
-#include <QtConcurrent/QtConcurrent>
-#include <QFuture>
+#include <QVector>
+#include <QList>
 
 
 //*************************************************************************************************************
@@ -82,9 +82,15 @@ namespace REALTIMELIB
 
 //=============================================================================================================
 /**
-* Real-time noise Spectrum estimation
+* Real-time filtering of data blocks with the overlap-save method. The object keeps the spectrum of the cascaded
+* filters, the last input samples of every channel and one FFT plan and buffer set per worker thread between the
+* calls, so that filtering a stream of equally sized blocks does not allocate data buffers. The filtered channels
+* are split across the worker threads.
 *
-* @brief Real-time Noise estimation
+* IIR filters (FilterData::m_matSOS) are not part of the spectrum, their second-order sections run as one cascade
+* after the FIR stage on all filtered channels at once and keep their own state.
+*
+* @brief Real-time overlap-save FIR and second-order section IIR filtering
 */
 class REALTIMESHARED_EXPORT RtFilter
 {
@@ -95,13 +101,13 @@ public:
 
     //=========================================================================================================
     /**
-    * Creates the real-time covariance estimation object.
+    * Creates the real-time filter object.
     */
     explicit RtFilter();
 
     //=========================================================================================================
     /**
-    * Destroys the Real-time noise estimation object.
+    * Destroys the real-time filter object.
     */
     ~RtFilter();
 
@@ -109,18 +115,91 @@ public:
     /**
     * Calculates the filtered version of the raw input data
     *
-    * @param [in] matDataIn     data which is to be filtered
-    * @param [out] matDataOut    data which is to be filtered
-    * @param [in] iDataIndex    current position in the global data matrix
+    * @param [in] matDataIn             data which is to be filtered
+    * @param [in] iMaxFilterLength      the maximal filter length, the channels which are not filtered are delayed by half of it
+    * @param [in] lFilterChannelList    the rows which are to be filtered
+    * @param [in] lFilterData           the filters, they are applied one after the other
+    *
+    * @return the filtered data
     */
     Eigen::MatrixXd filterChannelsConcurrently(const Eigen::MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
 
+    //=========================================================================================================
+    /**
+    * Calculates the filtered version of the raw input data into matDataOut. The filtered rows are the causal
+    * convolution of the input stream with the cascaded filter coefficients, consecutive calls continue the
+    * stream. The filter state is only reset if the number of rows or the length of the cascaded impulse
+    * response changes. IIR filters follow the FIR filters, their state is reset if the sections or the filtered
+    * rows change. IIR filters have no constant delay, use iMaxFilterLength 0 if only IIR filters are applied.
+    *
+    * @param [in] matDataIn             data which is to be filtered
+    * @param [out] matDataOut           the filtered data, it is only resized if its size does not match matDataIn
+    * @param [in] iMaxFilterLength      the maximal filter length, the channels which are not filtered are delayed by half of it
+    * @param [in] lFilterChannelList    the rows which are to be filtered
+    * @param [in] lFilterData           the filters, they are applied one after the other
+    */
+    void filterChannelsConcurrently(const Eigen::MatrixXd& matDataIn, Eigen::MatrixXd& matDataOut, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
+
+    //=========================================================================================================
+    /**
+    * Resets the filter state, the next block is filtered as if the stream started with it.
+    */
+    void reset();
+
 protected:
-    Eigen::MatrixXd                 m_matOverlap;                   /**< Last overlap block */
     Eigen::MatrixXd                 m_matDelay;                     /**< Last delay block */
 
 private:
+    //=========================================================================================================
+    /**
+    * The filtered rows which are processed on one thread. Every worker owns its FFT plans and buffers.
+    */
+    struct FilterWorker
+    {
+        const QVector<int>*         pRows;          /**< The filtered rows. */
+        int                         iFirst;         /**< First entry of pRows of this worker. */
+        int                         iCount;         /**< Number of entries of pRows of this worker. */
+        int                         iHistory;       /**< Number of past input samples kept per row. */
+
+        const Eigen::MatrixXd*      pDataIn;        /**< The input block. */
+        Eigen::MatrixXd*            pDataOut;       /**< The output block. */
+        Eigen::MatrixXd*            pHistory;       /**< The past input samples of every row. */
+        const Eigen::RowVectorXcd*  pSpectrum;      /**< The half spectrum of the cascaded impulse response. */
+
+        Eigen::FFT<double>          fft;            /**< The FFT object, it caches its plans. */
+        Eigen::RowVectorXd          vecTime;        /**< The past and the new input samples of one row. */
+        Eigen::RowVectorXd          vecFiltered;    /**< The circularly convolved samples of one row. */
+        Eigen::RowVectorXcd         vecFreq;        /**< The spectrum of one row. */
+    };
 
+    //=========================================================================================================
+    /**
+    * Filters the rows of a worker.
+    *
+    * @param [in, out] worker   The worker.
+    */
+    static void filterRows(FilterWorker& worker);
+
+    //=========================================================================================================
+    /**
+    * Updates the filter spectrum, the row lists, the state and the workers for the given block and filters.
+    */
+    void update(const Eigen::MatrixXd& matDataIn, int iMaxFilterLength, const QVector<int>& lFilterChannelList, const QList<UTILSLIB::FilterData> &lFilterData);
+
+    QList<Eigen::RowVectorXd>       m_lFilterCoeffs;                /**< Coefficients of the FIR filters the spectrum was computed for */
+    QVector<int>                    m_lFilterChannelList;           /**< The requested filter channel list */
+    QVector<int>                    m_lFilterRows;                  /**< The rows which are filtered */
+    QVector<int>                    m_lDelayRows;                   /**< The rows which are only delayed */
+    Eigen::RowVectorXcd             m_vecSpectrum;                  /**< Half spectrum of the cascaded impulse response, zero padded to m_iFFTLength */
+    Eigen::MatrixXd                 m_matHistory;                   /**< Last input samples of every row, the overlap of the overlap-save method */
+    QVector<FilterWorker>           m_lWorkers;                     /**< The workers, one per thread */
+    Eigen::MatrixXd                 m_matSOS;                       /**< Second-order sections of all IIR filters */
+    Eigen::MatrixXd                 m_matIIRState;                  /**< State of the sections, one filtered row per row */
+    Eigen::MatrixXd                 m_matIIRData;                   /**< The filtered rows gathered for the sections */
+    int                             m_iImpulseLength;               /**< Length of the cascaded impulse response */
+    int                             m_iFFTLength;                   /**< The FFT length */
+    int                             m_iBlockSize;                   /**< The number of samples per block */
+    int                             m_iDelay;                       /**< The delay of the rows which are not filtered */
 };
 
 //*************************************************************************************************************
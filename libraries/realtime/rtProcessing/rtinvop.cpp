@@ -112,13 +112,13 @@ void RtInvOp::run()
 {
     m_bIsRunning = true;
 
+    // Restrict forward solution as necessary for MEG, once for all noise covariances
+    MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
+
     while(m_bIsRunning)
     {
         if(m_vecNoiseCov.size() > 0)
         {
-            // Restrict forward solution as necessary for MEG
-            MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
-
             mutex.lock();
             MNEInverseOperator::SPtr t_invOpMeg(new MNEInverseOperator(*m_pFiffInfo.data(), t_forwardMeg, m_vecNoiseCov[0], 0.2f, 0.8f));
             m_vecNoiseCov.pop_front();
@@ -200,12 +200,13 @@ bool RtNoise::stop()
 void RtNoise::run()
 {
     bool FirstStart = true;
+    MatrixXd block;
 
     while(m_bIsRunning)
     {
         if(m_pRawMatrixBuffer)
         {
-            MatrixXd block = m_pRawMatrixBuffer->pop();
+            m_pRawMatrixBuffer->pop(block);
 
             if(FirstStart){
                 //init the circ buffer and parameters
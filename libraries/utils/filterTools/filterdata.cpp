@@ -46,6 +46,7 @@
 
 #include "parksmcclellan.h"
 #include "cosinefilter.h"
+#include "iirfilter.h"
 
 
 //*************************************************************************************************************
@@ -92,6 +93,7 @@ FilterData::FilterData()
 , m_iFFTlength(512)
 , m_sName("Unknown")
 , m_dParksWidth(0.1)
+, m_dRipple(0.5)
 , m_designMethod(External)
 , m_dCenterFreq(0.5)
 , m_dBandwidth(0.1)
@@ -111,6 +113,7 @@ FilterData::FilterData(QString unique_name, FilterType type, int order, double c
 , m_iFFTlength(fftlength)
 , m_sName(unique_name)
 , m_dParksWidth(parkswidth)
+, m_dRipple(0.5)
 , m_designMethod(designMethod)
 , m_dCenterFreq(centerfreq)
 , m_dBandwidth(bandwidth)
@@ -124,6 +127,10 @@ FilterData::FilterData(QString unique_name, FilterType type, int order, double c
 
 void FilterData::designFilter()
 {
+    //Only the IIR designs have sections and backward coefficients
+    m_matSOS.resize(0, 6);
+    m_dCoeffB.resize(0);
+
     switch(m_designMethod) {
         case Tschebyscheff: {
             ParksMcClellan filter(m_iFilterOrder, m_dCenterFreq, m_dBandwidth, m_dParksWidth, (ParksMcClellan::TPassType)m_Type);
@@ -183,6 +190,24 @@ void FilterData::designFilter()
 
             break;
         }
+
+        case ButterworthIIR:
+        case ChebyshevIIR: {
+            IIRFilter filter(m_iFilterOrder,
+                             m_dCenterFreq,
+                             m_dBandwidth,
+                             (IIRFilter::TPassType)m_Type,
+                             m_designMethod == ChebyshevIIR ? IIRFilter::Chebyshev : IIRFilter::Butterworth,
+                             m_dRipple);
+            m_matSOS = filter.m_matSOS;
+            m_dCoeffA = filter.m_dCoeffA;
+            m_dCoeffB = filter.m_dCoeffB;
+
+            //The frequency response of the sections on the fft grid, so the filter can be displayed like the FIR filters
+            m_dFFTCoeffA = IIRFilter::frequencyResponse(m_matSOS, m_iFFTlength);
+
+            break;
+        }
     }
 
     switch(m_Type) {
@@ -227,6 +252,10 @@ void FilterData::fftTransformCoeffs()
 
 RowVectorXd FilterData::applyConvFilter(const RowVectorXd& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
 {
+    //IIR filters have no taps to convolve with, run their sections causally instead
+    if(m_matSOS.rows() > 0)
+        return applyIIRFilter(data, false, keepOverhead);
+
     if(data.cols()<m_dCoeffA.cols() && compensateEdgeEffects==MirrorData){
         qDebug()<<QString("Error in FilterData: Number of filter taps(%1) bigger then data size(%2). Not enough data to perform mirroring!").arg(m_dCoeffA.cols()).arg(data.cols());
         return data;
@@ -268,6 +297,10 @@ RowVectorXd FilterData::applyConvFilter(const RowVectorXd& data, bool keepOverhe
 
 RowVectorXd FilterData::applyFFTFilter(const RowVectorXd& data, bool keepOverhead, CompensateEdgeEffects compensateEdgeEffects) const
 {
+    //The spectrum of an IIR filter is only its displayed response, filter acausally with the sections instead
+    if(m_matSOS.rows() > 0)
+        return applyIIRFilter(data, true, keepOverhead);
+
     if(data.cols()<m_dCoeffA.cols() && compensateEdgeEffects==MirrorData) {
         qDebug()<<QString("Error in FilterData: Number of filter taps(%1) bigger then data size(%2). Not enough data to perform mirroring!").arg(m_dCoeffA.cols()).arg(data.cols());
         return data;
@@ -323,6 +356,35 @@ RowVectorXd FilterData::applyFFTFilter(const RowVectorXd& data, bool keepOverhea
 }
 
 
+//*************************************************************************************************************
+
+RowVectorXd FilterData::applyIIRFilter(const RowVectorXd& data, bool zeroPhase, bool keepOverhead) const
+{
+    if(m_matSOS.rows() == 0) {
+        qDebug()<<"Error in FilterData: applyIIRFilter called for a filter without second-order sections.";
+        return data;
+    }
+
+    MatrixXd t_matData = data;
+
+    if(zeroPhase) {
+        IIRFilter::filtfilt(m_matSOS, t_matData);
+    } else {
+        MatrixXd t_matState;
+        IIRFilter::filter(m_matSOS, t_matData, t_matState);
+    }
+
+    if(!keepOverhead)
+        return t_matData.row(0);
+
+    //Same layout as the FIR filters: m_iFilterOrder samples of overhead with the data delayed by half of it
+    RowVectorXd t_filteredTime = RowVectorXd::Zero(data.cols() + m_iFilterOrder);
+    t_filteredTime.segment(m_iFilterOrder/2, data.cols()) = t_matData.row(0);
+
+    return t_filteredTime;
+}
+
+
 //*************************************************************************************************************
 
 QString FilterData::getStringForDesignMethod(const FilterData::DesignMethod &designMethod)
@@ -338,6 +400,12 @@ QString FilterData::getStringForDesignMethod(const FilterData::DesignMethod &des
     if(designMethod == FilterData::Tschebyscheff)
         designMethodString = "Tschebyscheff";
 
+    if(designMethod == FilterData::ButterworthIIR)
+        designMethodString = "Butterworth IIR";
+
+    if(designMethod == FilterData::ChebyshevIIR)
+        designMethodString = "Chebyshev IIR";
+
     return designMethodString;
 }
 
@@ -379,6 +447,12 @@ FilterData::DesignMethod FilterData::getDesignMethodForString(const QString &des
     if(designMethodString == "Cosine")
         designMethod = FilterData::Cosine;
 
+    if(designMethodString == "Butterworth IIR")
+        designMethod = FilterData::ButterworthIIR;
+
+    if(designMethodString == "Chebyshev IIR")
+        designMethod = FilterData::ChebyshevIIR;
+
     return designMethod;
 }
 
@@ -102,7 +102,9 @@ public:
     enum DesignMethod {
         Tschebyscheff,
         Cosine,
-        External
+        External,
+        ButterworthIIR,
+        ChebyshevIIR
     } m_designMethod;
 
     enum FilterType {
@@ -134,7 +136,7 @@ public:
     * @param [in] parkswidth determines the width of the filter slopes (steepness)
     * @param [in] sFreq sampling frequency
     * @param [in] fftlength length of the fft (multiple integer of 2^x)
-    * @param [in] designMethod specifies the design method to use. Choose between Cosind and Tschebyscheff
+    * @param [in] designMethod specifies the design method to use. Choose between Cosind and Tschebyscheff (FIR) or ButterworthIIR and ChebyshevIIR (IIR)
     */
     FilterData(QString unique_name, FilterType type, int order, double centerfreq, double bandwidth, double parkswidth, double sFreq, qint32 fftlength=4096, DesignMethod designMethod = Cosine);
 
@@ -150,6 +152,7 @@ public:
 
     /**
     * Applies the current filter to the input data using convolution in time domain. Pro: Uses only past samples (real-time capable) Con: Might not be as ideal as acausal version (steepness etc.)
+    * IIR filters are run causally through applyIIRFilter, compensateEdgeEffects is ignored for them.
     *
     * @param [in] data holds the data to be filtered
     * @param [in] keepOverhead whether the result should still include the overhead information in front and back of the data
@@ -160,6 +163,8 @@ public:
 
     /**
     * Applies the current filter to the input data using multiplication in frequency domain. Pro: Fast, good filter parameters Con: Smears in error from future samples. Uses future samples (nor real time capable)
+    * IIR filters are run forward and backward through applyIIRFilter, compensateEdgeEffects is ignored for them. Their overhead is
+    * zero, so blocks filtered this way can not be joined by overlap-add; block wise filtering has to keep an IIRFilter::filter state.
     *
     * @param [in] data holds the data to be filtered
     * @param [in] keepOverhead whether the result should still include the overhead information in front and back of the data
@@ -169,6 +174,19 @@ public:
     */
     RowVectorXd applyFFTFilter(const RowVectorXd& data, bool keepOverhead = false, CompensateEdgeEffects compensateEdgeEffects = MirrorData) const;
 
+    /**
+    * Applies the second-order sections of an IIR filter (ButterworthIIR, ChebyshevIIR) to the input data. The causal version is real-time capable,
+    * the zero-phase version filters forward and backward and doubles the attenuation.
+    *
+    * @param [in] data holds the data to be filtered
+    * @param [in] zeroPhase whether the data should be filtered forward and backward
+    * @param [in] keepOverhead whether the result should be laid out like the FIR results with overhead: m_iFilterOrder zeros
+    *                          around the filtered data, which is delayed by m_iFilterOrder/2
+    *
+    * @return the filtered data in form of a RowVectorXd, the unchanged data if this is no IIR filter
+    */
+    RowVectorXd applyIIRFilter(const RowVectorXd& data, bool zeroPhase = false, bool keepOverhead = false) const;
+
     /**
      * @brief getStringForDesignMethod returns the current design method as a string
      */
@@ -195,6 +213,7 @@ public:
     double          m_dCenterFreq;      /**< contains center freq of the filter. */
     double          m_dBandwidth;       /**< contains bandwidth of the filter. */
     double          m_dParksWidth;      /**< contains the parksmcallen width. */
+    double          m_dRipple;          /**< passband ripple in dB of the ChebyshevIIR design. */
 
     double          m_dLowpassFreq;     /**< lowpass freq (higher cut off) of the filter. */
     double          m_dHighpassFreq;        /**< lowpass freq (lower cut off) of the filter. */
@@ -203,6 +222,7 @@ public:
 
     RowVectorXd     m_dCoeffA;          /**< contains the forward filter coefficient set. */
     RowVectorXd     m_dCoeffB;          /**< contains the backward filter coefficient set (empty if FIR filter). */
+    MatrixXd        m_matSOS;           /**< the IIR filter as second-order sections b0 b1 b2 a0 a1 a2, one per row (empty if FIR filter). */
 
     RowVectorXcd    m_dFFTCoeffA;       /**< the FFT-transformed forward filter coefficient set, required for frequency-domain filtering, zero-padded to m_iFFTlength. */
     RowVectorXcd    m_dFFTCoeffB;       /**< the FFT-transformed backward filter coefficient set, required for frequency-domain filtering, zero-padded to m_iFFTlength. */
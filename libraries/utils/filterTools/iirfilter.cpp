@@ -0,0 +1,572 @@
+//=============================================================================================================
+/**
+* @file     iirfilter.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Definition of the IIRFilter class
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "iirfilter.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QVector>
+#include <QtAlgorithms>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <complex>
+#include <algorithm>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE LOCAL TYPES
+//=============================================================================================================
+
+typedef std::complex<double> Complex;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Returns the product of the negated values, 1 for an empty list.
+*/
+static Complex prod_neg(const QVector<Complex>& values)
+{
+    Complex result(1.0, 0.0);
+    for(int i = 0; i < values.size(); ++i)
+        result *= -values.at(i);
+    return result;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Transforms the analog lowpass prototype with cutoff 1 rad/s into a lowpass with cutoff wo.
+*/
+static void lp2lp(QVector<Complex>& zeros, QVector<Complex>& poles, double& gain, double wo)
+{
+    int degree = poles.size() - zeros.size();
+
+    for(int i = 0; i < zeros.size(); ++i)
+        zeros[i] *= wo;
+    for(int i = 0; i < poles.size(); ++i)
+        poles[i] *= wo;
+
+    gain *= pow(wo, degree);
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Transforms the analog lowpass prototype with cutoff 1 rad/s into a highpass with cutoff wo.
+*/
+static void lp2hp(QVector<Complex>& zeros, QVector<Complex>& poles, double& gain, double wo)
+{
+    int degree = poles.size() - zeros.size();
+
+    gain *= (prod_neg(zeros) / prod_neg(poles)).real();
+
+    for(int i = 0; i < zeros.size(); ++i)
+        zeros[i] = wo / zeros.at(i);
+    for(int i = 0; i < poles.size(); ++i)
+        poles[i] = wo / poles.at(i);
+
+    for(int i = 0; i < degree; ++i)
+        zeros.append(Complex(0.0, 0.0));
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Transforms the analog lowpass prototype with cutoff 1 rad/s into a bandpass with center wo and bandwidth bw.
+*/
+static void lp2bp(QVector<Complex>& zeros, QVector<Complex>& poles, double& gain, double wo, double bw)
+{
+    int degree = poles.size() - zeros.size();
+
+    QVector<Complex> bandZeros, bandPoles;
+    for(int i = 0; i < zeros.size(); ++i) {
+        Complex z = zeros.at(i) * bw / 2.0;
+        Complex root = std::sqrt(z*z - wo*wo);
+        bandZeros << z + root << z - root;
+    }
+    for(int i = 0; i < poles.size(); ++i) {
+        Complex p = poles.at(i) * bw / 2.0;
+        Complex root = std::sqrt(p*p - wo*wo);
+        bandPoles << p + root << p - root;
+    }
+
+    for(int i = 0; i < degree; ++i)
+        bandZeros.append(Complex(0.0, 0.0));
+
+    zeros = bandZeros;
+    poles = bandPoles;
+    gain *= pow(bw, degree);
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Transforms the analog lowpass prototype with cutoff 1 rad/s into a bandstop with center wo and bandwidth bw.
+*/
+static void lp2bs(QVector<Complex>& zeros, QVector<Complex>& poles, double& gain, double wo, double bw)
+{
+    int degree = poles.size() - zeros.size();
+
+    gain *= (prod_neg(zeros) / prod_neg(poles)).real();
+
+    QVector<Complex> bandZeros, bandPoles;
+    for(int i = 0; i < zeros.size(); ++i) {
+        Complex z = (bw / 2.0) / zeros.at(i);
+        Complex root = std::sqrt(z*z - wo*wo);
+        bandZeros << z + root << z - root;
+    }
+    for(int i = 0; i < poles.size(); ++i) {
+        Complex p = (bw / 2.0) / poles.at(i);
+        Complex root = std::sqrt(p*p - wo*wo);
+        bandPoles << p + root << p - root;
+    }
+
+    for(int i = 0; i < degree; ++i)
+        bandZeros << Complex(0.0, wo) << Complex(0.0, -wo);
+
+    zeros = bandZeros;
+    poles = bandPoles;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Maps the analog zeros, poles and gain to the z-plane with the bilinear transform, zeros at infinity are moved
+* to the Nyquist frequency.
+*/
+static void bilinear(QVector<Complex>& zeros, QVector<Complex>& poles, double& gain, double fs)
+{
+    int degree = poles.size() - zeros.size();
+    double fs2 = 2.0 * fs;
+
+    Complex num(1.0, 0.0), den(1.0, 0.0);
+    for(int i = 0; i < zeros.size(); ++i)
+        num *= fs2 - zeros.at(i);
+    for(int i = 0; i < poles.size(); ++i)
+        den *= fs2 - poles.at(i);
+    gain *= (num / den).real();
+
+    for(int i = 0; i < zeros.size(); ++i)
+        zeros[i] = (fs2 + zeros.at(i)) / (fs2 - zeros.at(i));
+    for(int i = 0; i < poles.size(); ++i)
+        poles[i] = (fs2 + poles.at(i)) / (fs2 - poles.at(i));
+
+    for(int i = 0; i < degree; ++i)
+        zeros.append(Complex(-1.0, 0.0));
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Splits values into the real ones and one representative (positive imaginary part) of each conjugate pair.
+*/
+static void split_conjugates(const QVector<Complex>& values, QVector<Complex>& complexes, QVector<double>& reals)
+{
+    for(int i = 0; i < values.size(); ++i) {
+        const Complex& v = values.at(i);
+        if(fabs(v.imag()) <= 1e-10 * qMax(1.0, std::abs(v)))
+            reals.append(v.real());
+        else if(v.imag() > 0)
+            complexes.append(v);
+    }
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Takes the value nearest to target out of the list.
+*/
+static Complex take_nearest(QVector<Complex>& values, const Complex& target)
+{
+    int best = 0;
+    for(int i = 1; i < values.size(); ++i)
+        if(std::abs(values.at(i) - target) < std::abs(values.at(best) - target))
+            best = i;
+    return values.takeAt(best);
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Takes the real value nearest to target out of the list.
+*/
+static double take_nearest(QVector<double>& values, const Complex& target)
+{
+    int best = 0;
+    for(int i = 1; i < values.size(); ++i)
+        if(std::abs(values.at(i) - target) < std::abs(values.at(best) - target))
+            best = i;
+    return values.takeAt(best);
+}
+
+
+//*************************************************************************************************************
+
+static bool magnitude_greater(double a, double b)
+{
+    return fabs(a) > fabs(b);
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Groups the digital zeros and poles into second-order sections. Poles closest to the unit circle get the
+* nearest zeros first and end up in the last sections, which keeps the intermediate signals bounded.
+*/
+static MatrixXd zpk2sos(const QVector<Complex>& zeros, const QVector<Complex>& poles, double gain)
+{
+    QVector<Complex> complexZeros, complexPoles;
+    QVector<double> realZeros, realPoles;
+    split_conjugates(zeros, complexZeros, realZeros);
+    split_conjugates(poles, complexPoles, realPoles);
+
+    //
+    //   Pole groups: the conjugate pairs and the real poles two by two, the farthest from the unit circle first
+    //
+    QVector<QPair<Complex, Complex> > groups;
+    QVector<int> groupSizes;
+    for(int i = 0; i < complexPoles.size(); ++i) {
+        groups.append(qMakePair(complexPoles.at(i), std::conj(complexPoles.at(i))));
+        groupSizes.append(2);
+    }
+
+    std::sort(realPoles.begin(), realPoles.end(), magnitude_greater);
+    for(int i = 0; i < realPoles.size(); i += 2) {
+        bool bPair = i + 1 < realPoles.size();
+        groups.append(qMakePair(Complex(realPoles.at(i), 0.0), Complex(bPair ? realPoles.at(i + 1) : 0.0, 0.0)));
+        groupSizes.append(bPair ? 2 : 1);
+    }
+
+    //Order by the distance of the outermost pole to the unit circle
+    QVector<int> order;
+    for(int i = 0; i < groups.size(); ++i)
+        order.append(i);
+    for(int i = 1; i < order.size(); ++i)
+        for(int j = i; j > 0 && std::abs(groups.at(order.at(j)).first) > std::abs(groups.at(order.at(j - 1)).first); --j)
+            qSwap(order[j], order[j - 1]);
+
+    MatrixXd matSOS = MatrixXd::Zero(groups.size(), 6);
+
+    for(int k = 0; k < order.size(); ++k) {
+        int g = order.at(k);
+        Complex p1 = groups.at(g).first;
+        Complex p2 = groups.at(g).second;
+        int iPoles = groupSizes.at(g);
+
+        //
+        //   Zeros nearest to the poles, pairs stay together
+        //
+        Complex z1(0.0, 0.0), z2(0.0, 0.0);
+        int iZeros = 0;
+        if(iPoles == 2 && p1.imag() != 0.0 && !complexZeros.isEmpty()) {
+            z1 = take_nearest(complexZeros, p1);
+            z2 = std::conj(z1);
+            iZeros = 2;
+        } else if(realZeros.size() >= iPoles) {
+            z1 = Complex(take_nearest(realZeros, p1), 0.0);
+            if(iPoles == 2)
+                z2 = Complex(take_nearest(realZeros, p2), 0.0);
+            iZeros = iPoles;
+        } else if(iPoles == 2 && !complexZeros.isEmpty()) {
+            z1 = take_nearest(complexZeros, p1);
+            z2 = std::conj(z1);
+            iZeros = 2;
+        } else if(!realZeros.isEmpty()) {
+            z1 = Complex(take_nearest(realZeros, p1), 0.0);
+            iZeros = 1;
+        }
+
+        //The poles closest to the unit circle go last
+        int row = order.size() - 1 - k;
+        matSOS(row, 0) = 1.0;
+        matSOS(row, 1) = iZeros >= 1 ? -(z1 + (iZeros == 2 ? z2 : Complex(0.0, 0.0))).real() : 0.0;
+        matSOS(row, 2) = iZeros == 2 ? (z1 * z2).real() : 0.0;
+        matSOS(row, 3) = 1.0;
+        matSOS(row, 4) = -(p1 + (iPoles == 2 ? p2 : Complex(0.0, 0.0))).real();
+        matSOS(row, 5) = iPoles == 2 ? (p1 * p2).real() : 0.0;
+    }
+
+    if(matSOS.rows() > 0)
+        matSOS.block(0, 0, 1, 3) *= gain;
+
+    return matSOS;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+IIRFilter::IIRFilter()
+: m_iFilterOrder(0)
+{
+
+}
+
+
+//*************************************************************************************************************
+
+IIRFilter::IIRFilter(int order, double centerfreq, double bandwidth, TPassType type, TPrototype prototype, double ripple)
+: m_iFilterOrder(qMax(order, 1))
+{
+    QVector<Complex> zeros, poles;
+    double gain = 1.0;
+
+    //
+    //   Analog lowpass prototype with a cutoff of 1 rad/s
+    //
+    if(prototype == Chebyshev) {
+        double eps = sqrt(pow(10.0, ripple / 10.0) - 1.0);
+        double mu = asinh(1.0 / eps) / m_iFilterOrder;
+
+        for(int k = 0; k < m_iFilterOrder; ++k) {
+            double theta = M_PI * (2*k + 1) / (2.0 * m_iFilterOrder);
+            poles.append(Complex(-sinh(mu) * sin(theta), cosh(mu) * cos(theta)));
+        }
+
+        gain = prod_neg(poles).real();
+        if(m_iFilterOrder % 2 == 0)
+            gain /= sqrt(1.0 + eps*eps);
+    } else {
+        for(int k = 0; k < m_iFilterOrder; ++k)
+            poles.append(std::exp(Complex(0.0, M_PI * (2*k + m_iFilterOrder + 1) / (2.0 * m_iFilterOrder))));
+    }
+
+    //
+    //   Prewarped band edges, with a sampling frequency of 2 the frequencies are normed to the Nyquist frequency
+    //
+    const double fs = 2.0;
+    double wLow = 2.0 * fs * tan(M_PI * (centerfreq - bandwidth/2) / fs);
+    double wHigh = 2.0 * fs * tan(M_PI * (centerfreq + bandwidth/2) / fs);
+
+    switch(type) {
+        case HPF:
+            lp2hp(zeros, poles, gain, 2.0 * fs * tan(M_PI * centerfreq / fs));
+            break;
+
+        case BPF:
+            lp2bp(zeros, poles, gain, sqrt(wLow * wHigh), wHigh - wLow);
+            break;
+
+        case NOTCH:
+            lp2bs(zeros, poles, gain, sqrt(wLow * wHigh), wHigh - wLow);
+            break;
+
+        default:
+            lp2lp(zeros, poles, gain, 2.0 * fs * tan(M_PI * centerfreq / fs));
+            break;
+    }
+
+    bilinear(zeros, poles, gain, fs);
+
+    m_matSOS = zpk2sos(zeros, poles, gain);
+
+    //
+    //   Polynomials of the whole cascade
+    //
+    m_dCoeffA = RowVectorXd::Ones(1);
+    m_dCoeffB = RowVectorXd::Ones(1);
+    for(int s = 0; s < m_matSOS.rows(); ++s) {
+        RowVectorXd vecA = RowVectorXd::Zero(m_dCoeffA.cols() + 2);
+        RowVectorXd vecB = RowVectorXd::Zero(m_dCoeffB.cols() + 2);
+        for(int k = 0; k < 3; ++k) {
+            vecA.segment(k, m_dCoeffA.cols()) += m_matSOS(s, k) * m_dCoeffA;
+            vecB.segment(k, m_dCoeffB.cols()) += m_matSOS(s, 3 + k) * m_dCoeffB;
+        }
+        m_dCoeffA = vecA;
+        m_dCoeffB = vecB;
+    }
+
+    //First-order sections leave zero coefficients at the end
+    m_dCoeffA.conservativeResize(poles.size() + 1);
+    m_dCoeffB.conservativeResize(poles.size() + 1);
+}
+
+
+//*************************************************************************************************************
+
+void IIRFilter::filter(const MatrixXd& matSOS, MatrixXd& matData, MatrixXd& matState)
+{
+    int iChannels = matData.rows();
+
+    if(matState.rows() != iChannels || matState.cols() != stateSize(matSOS))
+        matState = MatrixXd::Zero(iChannels, stateSize(matSOS));
+
+    for(int n = 0; n < matData.cols(); ++n) {
+        double* x = matData.data() + (qint64)n * iChannels;
+
+        for(int s = 0; s < matSOS.rows(); ++s) {
+            const double b0 = matSOS(s, 0);
+            const double b1 = matSOS(s, 1);
+            const double b2 = matSOS(s, 2);
+            const double a1 = matSOS(s, 4);
+            const double a2 = matSOS(s, 5);
+
+            double* z1 = matState.data() + (qint64)(2*s) * iChannels;
+            double* z2 = z1 + iChannels;
+
+            //Direct form II transposed, one time point of all channels
+            for(int c = 0; c < iChannels; ++c) {
+                double y = b0 * x[c] + z1[c];
+                z1[c] = b1 * x[c] - a1 * y + z2[c];
+                z2[c] = b2 * x[c] - a2 * y;
+                x[c] = y;
+            }
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void IIRFilter::filtfilt(const MatrixXd& matSOS, MatrixXd& matData)
+{
+    int iSamples = matData.cols();
+    if(iSamples < 2 || matSOS.rows() == 0)
+        return;
+
+    //
+    //   Odd reflection at both ends
+    //
+    int iPad = qMin(3 * (2 * (int)matSOS.rows() + 1), iSamples - 1);
+    MatrixXd matExt(matData.rows(), iSamples + 2*iPad);
+    for(int k = 0; k < iPad; ++k) {
+        matExt.col(k) = 2.0 * matData.col(0) - matData.col(iPad - k);
+        matExt.col(iPad + iSamples + k) = 2.0 * matData.col(iSamples - 1) - matData.col(iSamples - 2 - k);
+    }
+    matExt.middleCols(iPad, iSamples) = matData;
+
+    RowVectorXd vecSteadyState = steadyState(matSOS);
+
+    //Forward
+    MatrixXd matState = matExt.col(0) * vecSteadyState;
+    filter(matSOS, matExt, matState);
+
+    //Backward
+    MatrixXd matReversed = matExt.rowwise().reverse();
+    matState = matReversed.col(0) * vecSteadyState;
+    filter(matSOS, matReversed, matState);
+
+    matData = matReversed.middleCols(iPad, iSamples).rowwise().reverse();
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd IIRFilter::steadyState(const MatrixXd& matSOS)
+{
+    RowVectorXd vecState(stateSize(matSOS));
+    double dInput = 1.0;
+
+    for(int s = 0; s < matSOS.rows(); ++s) {
+        double dGain = (matSOS(s, 0) + matSOS(s, 1) + matSOS(s, 2)) / (1.0 + matSOS(s, 4) + matSOS(s, 5));
+
+        //The delay values for a constant input with the constant output dGain of the section
+        vecState(2*s + 1) = dInput * (matSOS(s, 2) - matSOS(s, 5) * dGain);
+        vecState(2*s) = dInput * (matSOS(s, 1) - matSOS(s, 4) * dGain) + vecState(2*s + 1);
+
+        dInput *= dGain;
+    }
+
+    return vecState;
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXcd IIRFilter::frequencyResponse(const MatrixXd& matSOS, int nfft)
+{
+    RowVectorXcd vecResponse = RowVectorXcd::Ones(nfft/2 + 1);
+
+    for(int k = 0; k < vecResponse.cols(); ++k) {
+        Complex e1 = std::polar(1.0, -2.0 * M_PI * k / nfft);
+        Complex e2 = e1 * e1;
+
+        for(int s = 0; s < matSOS.rows(); ++s)
+            vecResponse(k) *= (matSOS(s, 0) + matSOS(s, 1) * e1 + matSOS(s, 2) * e2) / (matSOS(s, 3) + matSOS(s, 4) * e1 + matSOS(s, 5) * e2);
+    }
+
+    return vecResponse;
+}
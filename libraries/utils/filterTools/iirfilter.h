@@ -0,0 +1,183 @@
+//=============================================================================================================
+/**
+* @file     iirfilter.h
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Declaration of the IIRFilter class
+*
+*/
+
+#ifndef IIRFILTER_H
+#define IIRFILTER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../utils_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE UTILSLIB
+//=============================================================================================================
+
+namespace UTILSLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Designs Butterworth and Chebyshev (type I) IIR filters by the bilinear transform of the analog prototype and
+* stores them as a cascade of second-order sections. The sections are applied in direct form II transposed,
+* either causally with a per channel state or forward and backward for zero-phase offline filtering.
+*
+* Data is filtered in place with one channel per row. The samples of one time point are adjacent in memory
+* (column-major), so every filter step runs over all channels at once and is vectorized by the compiler.
+*
+* @brief Creates IIR filters in second-order sections.
+*/
+class UTILSSHARED_EXPORT IIRFilter
+{
+public:
+    enum TPassType {LPF, HPF, BPF, NOTCH };
+    enum TPrototype {Butterworth, Chebyshev };
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty IIRFilter object.
+    */
+    IIRFilter();
+
+    //=========================================================================================================
+    /**
+    * Constructs an IIRFilter object and designs the filter.
+    *
+    * @param order          order of the analog prototype, band pass and band stop filters have twice the order
+    * @param centerfreq     cutoff frequency of LPF and HPF, center frequency of BPF and NOTCH, normed to the Nyquist frequency
+    * @param bandwidth      ignored if type is LPF or HPF. if NOTCH/BPF: bandwidth of stop-/passband, normed to the Nyquist frequency
+    * @param type           filter type (lowpass, highpass, etc.)
+    * @param prototype      Butterworth (maximally flat) or Chebyshev (passband ripple, steeper slopes)
+    * @param ripple         passband ripple of the Chebyshev prototype in dB
+    */
+    IIRFilter(int order, double centerfreq, double bandwidth, TPassType type, TPrototype prototype = Butterworth, double ripple = 0.5);
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples a causal state needs per channel.
+    *
+    * @param matSOS     second-order sections
+    *
+    * @return the number of state values per channel
+    */
+    static inline int stateSize(const MatrixXd& matSOS);
+
+    //=========================================================================================================
+    /**
+    * Filters the rows of matData causally and in place. The state holds the delay values of every channel and
+    * section and is updated, so that consecutive blocks continue the stream.
+    *
+    * @param [in] matSOS            second-order sections, one per row: b0 b1 b2 a0 a1 a2 with a0 = 1
+    * @param [in, out] matData      data to filter, one channel per row
+    * @param [in, out] matState     filter state, one channel per row, stateSize(matSOS) columns
+    */
+    static void filter(const MatrixXd& matSOS, MatrixXd& matData, MatrixXd& matState);
+
+    //=========================================================================================================
+    /**
+    * Filters the rows of matData forward and backward in place, which doubles the attenuation and cancels the
+    * phase shift. The data is extended by odd reflection at both ends and the state starts in the steady state
+    * of the first sample, which keeps the edge transients small.
+    *
+    * @param [in] matSOS            second-order sections, one per row: b0 b1 b2 a0 a1 a2 with a0 = 1
+    * @param [in, out] matData      data to filter, one channel per row
+    */
+    static void filtfilt(const MatrixXd& matSOS, MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Returns the state of a step response in its steady state, multiplied by the step height it is the initial
+    * state which does not produce a transient for a constant signal.
+    *
+    * @param [in] matSOS    second-order sections
+    *
+    * @return the state of one channel
+    */
+    static RowVectorXd steadyState(const MatrixXd& matSOS);
+
+    //=========================================================================================================
+    /**
+    * Evaluates the frequency response of the sections on nfft/2+1 equally spaced frequencies between zero and
+    * the Nyquist frequency, the same grid a half spectrum FFT of nfft samples has.
+    *
+    * @param [in] matSOS    second-order sections
+    * @param [in] nfft      the FFT length
+    *
+    * @return the complex frequency response
+    */
+    static RowVectorXcd frequencyResponse(const MatrixXd& matSOS, int nfft);
+
+    MatrixXd        m_matSOS;       /**< the second-order sections, one per row: b0 b1 b2 a0 a1 a2. */
+    RowVectorXd     m_dCoeffA;      /**< the numerator coefficients of the whole cascade. */
+    RowVectorXd     m_dCoeffB;      /**< the denominator coefficients of the whole cascade. */
+
+    int             m_iFilterOrder;
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int IIRFilter::stateSize(const MatrixXd& matSOS)
+{
+    return 2*matSOS.rows();
+}
+
+} // NAMESPACE UTILSLIB
+
+#endif // IIRFILTER_H
@@ -52,6 +52,8 @@
 //=============================================================================================================
 
 #include <typeinfo>
+#include <limits.h>
+#include <string.h>
 
 
 //*************************************************************************************************************
@@ -68,7 +70,10 @@
 //=============================================================================================================
 
 #include <QPair>
-#include <QSemaphore>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
 #include <QSharedPointer>
 #include <stdio.h>
 
@@ -94,6 +99,11 @@ using namespace Eigen;
 /**
 * Circular Matrix buffer provides a template for thread safe circular matrix buffers.
 *
+* The buffer is a single producer, single consumer ring of preallocated matrix slots. A push copies the whole
+* block into the next free slot, a pop into a caller owned matrix swaps the matrix with the slot, so that no
+* data is copied. Producer and consumer only synchronize through the atomic read and write indices, the mutex
+* is only taken when one of both has to wait for a full or an empty buffer.
+*
 * @brief The circular matrix buffer
 */
 template<typename _Tp>
@@ -122,7 +132,7 @@ public:
 
     //=========================================================================================================
     /**
-    * Adds a whole matrix at the end buffer.
+    * Adds a whole matrix at the end buffer. Blocks until a slot is free.
     *
     * @param [in] pMatrix pointer to a Matrix which should be apend to the end.
     */
@@ -130,7 +140,19 @@ public:
 
     //=========================================================================================================
     /**
-    * Returns the first matrix (first in first out).
+    * Adds a whole matrix at the end buffer, waits at most iMsecs milliseconds for a free slot.
+    *
+    * @param [in] matrix    Matrix which should be apend to the end.
+    * @param [in] iMsecs    Maximal waiting time in milliseconds, 0 does not wait, a negative value waits until
+    *                       a slot is free or the buffer gets released (optional, default 0).
+    *
+    * @return true if the matrix was added, false on timeout, release, pause or wrong dimensions.
+    */
+    inline bool tryPush(const Matrix<_Tp, Dynamic, Dynamic>& matrix, int iMsecs = 0);
+
+    //=========================================================================================================
+    /**
+    * Returns the first matrix (first in first out). Blocks until a matrix is available.
     *
     * @return the first matrix
     */
@@ -138,7 +160,33 @@ public:
 
     //=========================================================================================================
     /**
-    * Clears the buffer.
+    * Moves the first matrix (first in first out) into matrix without copying it. Blocks until a matrix is
+    * available. Reusing the same matrix for every pop does not allocate.
+    *
+    * @param [out] matrix   The first matrix, a zero matrix if the buffer was released or paused.
+    *
+    * @return true if a matrix was popped, false if the buffer was released or paused.
+    */
+    inline bool pop(Matrix<_Tp, Dynamic, Dynamic>& matrix);
+
+    //=========================================================================================================
+    /**
+    * Moves the first matrix (first in first out) into matrix without copying it, waits at most iMsecs
+    * milliseconds for a matrix.
+    *
+    * @param [out] matrix   The first matrix, left untouched if nothing was popped.
+    * @param [in] iMsecs    Maximal waiting time in milliseconds, 0 does not wait, a negative value waits until
+    *                       a matrix is available or the buffer gets released (optional, default 0).
+    *
+    * @return true if a matrix was popped, false on timeout, release or pause.
+    */
+    inline bool tryPop(Matrix<_Tp, Dynamic, Dynamic>& matrix, int iMsecs = 0);
+
+    //=========================================================================================================
+    /**
+    * Clears the buffer. Must not be called while data is pushed or popped. A side which was released by
+    * releaseFromPop() or releaseFromPush() and is still on its way out of the wait leaves it first, the
+    * release is reset afterwards.
     */
     void clear();
 
@@ -183,23 +231,58 @@ public:
 private:
     //=========================================================================================================
     /**
-    * Returns the current circular index to the corresponding given index.
+    * Returns the number of filled slots for the given write and read indices.
+    *
+    * @param [in] iWriteIndex   The write index.
+    * @param [in] iReadIndex    The read index.
+    * @return the number of filled slots.
+    */
+    inline int filled(int iWriteIndex, int iReadIndex) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the index which follows the given ring index. Indices run over twice the number of slots, so that
+    * a full and an empty buffer can be told apart.
+    *
+    * @param [in] iIndex    The ring index.
+    * @return the next ring index.
+    */
+    inline int nextIndex(int iIndex) const;
+
+    //=========================================================================================================
+    /**
+    * Waits until the producer finds a free slot or the consumer finds a filled slot.
     *
-    * @param [in] index which should be mapped.
-    * @return the mapped index.
+    * @param [in] bPush     Whether the producer (true) or the consumer (false) waits.
+    * @param [in] iMsecs    Maximal waiting time in milliseconds, 0 does not wait, a negative value waits until
+    *                       the slot is available or the buffer gets released.
+    * @return true if the slot is available, false on timeout or release.
     */
-    inline unsigned int mapIndex(int& index);
-
-    unsigned int    m_uiMaxNumMatrices;         /**< Holds the maximal number of matrices.*/
-    unsigned int    m_uiRows;                   /**< Holds the number rows.*/
-    unsigned int    m_uiCols;                   /**< Holds the number cols.*/
-    unsigned int    m_uiMaxNumElements;         /**< Holds the maximal number of buffer elements.*/
-    _Tp*            m_pBuffer;                  /**< Holds the circular buffer.*/
-    int             m_iCurrentReadIndex;        /**< Holds the current read index.*/
-    int             m_iCurrentWriteIndex;       /**< Holds the current write index.*/
-    QSemaphore*     m_pFreeElements;            /**< Holds a semaphore which acquires free elements for thread safe writing. A semaphore is a generalization of a mutex.*/
-    QSemaphore*     m_pUsedElements;            /**< Holds a semaphore which acquires written semaphore for thread safe reading.*/
-    bool            m_bPause;
+    inline bool waitForSlot(bool bPush, int iMsecs);
+
+    //=========================================================================================================
+    /**
+    * Wakes the other side after an index was advanced, if it waits.
+    *
+    * @param [in] bPush     Whether the producer (true) or the consumer (false) advanced its index.
+    */
+    inline void wakeOther(bool bPush);
+
+    unsigned int                    m_uiMaxNumMatrices;     /**< Holds the maximal number of matrices.*/
+    unsigned int                    m_uiRows;               /**< Holds the number rows.*/
+    unsigned int                    m_uiCols;               /**< Holds the number cols.*/
+    Matrix<_Tp, Dynamic, Dynamic>*  m_pSlots;               /**< Holds the preallocated matrix slots.*/
+    QAtomicInt                      m_iWriteIndex;          /**< Holds the write index, it is only advanced by the producer.*/
+    QAtomicInt                      m_iReadIndex;           /**< Holds the read index, it is only advanced by the consumer.*/
+    QAtomicInt                      m_iPushWaiting;         /**< Holds whether the producer waits for a free slot.*/
+    QAtomicInt                      m_iPopWaiting;          /**< Holds whether the consumer waits for a filled slot.*/
+    QAtomicInt                      m_iReleasePush;         /**< Holds whether a waiting producer should give up.*/
+    QAtomicInt                      m_iReleasePop;          /**< Holds whether a waiting consumer should give up.*/
+    QMutex                          m_qMutex;               /**< Holds the mutex the waiting side sleeps on.*/
+    QWaitCondition                  m_qNotFull;             /**< Holds the condition a waiting producer sleeps on.*/
+    QWaitCondition                  m_qNotEmpty;            /**< Holds the condition a waiting consumer sleeps on.*/
+    QWaitCondition                  m_qLeft;                /**< Holds the condition clear() waits on until a released side left its wait.*/
+    bool                            m_bPause;
 };
 
 
@@ -211,18 +294,20 @@ private:
 template<typename _Tp>
 CircularMatrixBuffer<_Tp>::CircularMatrixBuffer(unsigned int uiMaxNumMatrices, unsigned int uiRows, unsigned int uiCols)
 : Buffer(typeid(_Tp).name())
-, m_uiMaxNumMatrices(uiMaxNumMatrices)
+, m_uiMaxNumMatrices(uiMaxNumMatrices > 0 ? uiMaxNumMatrices : 1)
 , m_uiRows(uiRows)
 , m_uiCols(uiCols)
-, m_uiMaxNumElements(m_uiMaxNumMatrices*m_uiRows*m_uiCols)
-, m_pBuffer(new _Tp[m_uiMaxNumElements])
-, m_iCurrentReadIndex(-1)
-, m_iCurrentWriteIndex(-1)
-, m_pFreeElements(new QSemaphore(m_uiMaxNumElements))
-, m_pUsedElements(new QSemaphore(0))
+, m_pSlots(new Matrix<_Tp, Dynamic, Dynamic>[m_uiMaxNumMatrices])
+, m_iWriteIndex(0)
+, m_iReadIndex(0)
+, m_iPushWaiting(0)
+, m_iPopWaiting(0)
+, m_iReleasePush(0)
+, m_iReleasePop(0)
 , m_bPause(false)
 {
-
+    for(unsigned int i = 0; i < m_uiMaxNumMatrices; ++i)
+        m_pSlots[i].resize(m_uiRows, m_uiCols);
 }
 
 
@@ -231,9 +316,7 @@ CircularMatrixBuffer<_Tp>::CircularMatrixBuffer(unsigned int uiMaxNumMatrices, u
 template<typename _Tp>
 CircularMatrixBuffer<_Tp>::~CircularMatrixBuffer()
 {
-    delete m_pFreeElements;
-    delete m_pUsedElements;
-    delete [] m_pBuffer;
+    delete [] m_pSlots;
 }
 
 
@@ -242,21 +325,35 @@ CircularMatrixBuffer<_Tp>::~CircularMatrixBuffer()
 template<typename _Tp>
 inline void CircularMatrixBuffer<_Tp>::push(const Matrix<_Tp, Dynamic, Dynamic>* pMatrix)
 {
-    if(!m_bPause)
-    {
-        unsigned int t_size = pMatrix->size();
-        if(t_size == m_uiRows*m_uiCols)
-        {
-            m_pFreeElements->acquire(t_size);
-            for(unsigned int i = 0; i < t_size; ++i)
-                m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = pMatrix->data()[i];
-            m_pUsedElements->release(t_size);
-        }
+    tryPush(*pMatrix, -1);
+}
 
-        else {
-            printf("Error: Matrix not appended to CircularMatrixBuffer - wrong dimensions\n");
-        }
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline bool CircularMatrixBuffer<_Tp>::tryPush(const Matrix<_Tp, Dynamic, Dynamic>& matrix, int iMsecs)
+{
+    if(m_bPause)
+        return false;
+
+    if(matrix.size() != m_uiRows*m_uiCols)
+    {
+        printf("Error: Matrix not appended to CircularMatrixBuffer - wrong dimensions\n");
+        return false;
     }
+
+    if(!waitForSlot(true, iMsecs))
+        return false;
+
+    //The slot is owned by the producer until the write index is advanced
+    int iWriteIndex = m_iWriteIndex.load();
+    memcpy(m_pSlots[iWriteIndex % m_uiMaxNumMatrices].data(), matrix.data(), matrix.size()*sizeof(_Tp));
+
+    m_iWriteIndex.fetchAndStoreOrdered(nextIndex(iWriteIndex));
+    wakeOther(true);
+
+    return true;
 }
 
 
@@ -266,30 +363,129 @@ template<typename _Tp>
 inline Matrix<_Tp, Dynamic, Dynamic> CircularMatrixBuffer<_Tp>::pop()
 {
     Matrix<_Tp, Dynamic, Dynamic> matrix(m_uiRows, m_uiCols);
+    pop(matrix);
+    return matrix;
+}
+
+
+//*************************************************************************************************************
 
-    if(!m_bPause)
+template<typename _Tp>
+inline bool CircularMatrixBuffer<_Tp>::pop(Matrix<_Tp, Dynamic, Dynamic>& matrix)
+{
+    if(tryPop(matrix, -1))
+        return true;
+
+    matrix.setZero(m_uiRows, m_uiCols);
+    return false;
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline bool CircularMatrixBuffer<_Tp>::tryPop(Matrix<_Tp, Dynamic, Dynamic>& matrix, int iMsecs)
+{
+    if(m_bPause)
+        return false;
+
+    if(!waitForSlot(false, iMsecs))
+        return false;
+
+    //Hand the slot storage to the caller and keep the storage of the caller's matrix as new slot
+    int iReadIndex = m_iReadIndex.load();
+    matrix.resize(m_uiRows, m_uiCols);
+    matrix.swap(m_pSlots[iReadIndex % m_uiMaxNumMatrices]);
+
+    m_iReadIndex.fetchAndStoreOrdered(nextIndex(iReadIndex));
+    wakeOther(false);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline int CircularMatrixBuffer<_Tp>::filled(int iWriteIndex, int iReadIndex) const
+{
+    return (iWriteIndex - iReadIndex + 2*m_uiMaxNumMatrices) % (2*m_uiMaxNumMatrices);
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline int CircularMatrixBuffer<_Tp>::nextIndex(int iIndex) const
+{
+    return (iIndex + 1) % (2*m_uiMaxNumMatrices);
+}
+
+
+//*************************************************************************************************************
+
+template<typename _Tp>
+inline bool CircularMatrixBuffer<_Tp>::waitForSlot(bool bPush, int iMsecs)
+{
+    //Fast path without any lock
+    int iFilled = filled(m_iWriteIndex.loadAcquire(), m_iReadIndex.loadAcquire());
+    if(bPush ? iFilled < (int)m_uiMaxNumMatrices : iFilled > 0)
+        return true;
+
+    if(iMsecs == 0)
+        return false;
+
+    QAtomicInt& iWaiting = bPush ? m_iPushWaiting : m_iPopWaiting;
+    QAtomicInt& iRelease = bPush ? m_iReleasePush : m_iReleasePop;
+    QWaitCondition& condition = bPush ? m_qNotFull : m_qNotEmpty;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker locker(&m_qMutex);
+
+    //Announce the waiting before the indices are checked again, the other side checks the flag after it
+    //advanced its index, so that either this check or the other side sees the change
+    iWaiting.fetchAndStoreOrdered(1);
+
+    bool bAvailable = false;
+    forever
     {
-        m_pUsedElements->acquire(m_uiRows*m_uiCols);
-        for(quint32 i = 0; i < m_uiRows*m_uiCols; ++i)
-            matrix.data()[i] = m_pBuffer[mapIndex(m_iCurrentReadIndex)];
-        m_pFreeElements->release(m_uiRows*m_uiCols);
+        iFilled = filled(m_iWriteIndex.fetchAndAddOrdered(0), m_iReadIndex.fetchAndAddOrdered(0));
+        bAvailable = bPush ? iFilled < (int)m_uiMaxNumMatrices : iFilled > 0;
+
+        if(bAvailable || iRelease.fetchAndStoreOrdered(0))
+            break;
+
+        unsigned long ulTime = ULONG_MAX;
+        if(iMsecs > 0)
+        {
+            qint64 iRemaining = iMsecs - timer.elapsed();
+            if(iRemaining <= 0)
+                break;
+            ulTime = (unsigned long)iRemaining;
+        }
+
+        condition.wait(&m_qMutex, ulTime);
     }
-    else
-        matrix.setZero();
 
-    return matrix;
+    iWaiting.fetchAndStoreOrdered(0);
+    m_qLeft.wakeAll();
+
+    return bAvailable;
 }
 
 
 //*************************************************************************************************************
 
 template<typename _Tp>
-inline unsigned int CircularMatrixBuffer<_Tp>::mapIndex(int& index)
+inline void CircularMatrixBuffer<_Tp>::wakeOther(bool bPush)
 {
-    int AuxIndex;
-    AuxIndex = ++index;
-    return index = AuxIndex % m_uiMaxNumElements;
-
+    if((bPush ? m_iPopWaiting : m_iPushWaiting).fetchAndAddOrdered(0))
+    {
+        QMutexLocker locker(&m_qMutex);
+        (bPush ? m_qNotEmpty : m_qNotFull).wakeAll();
+    }
 }
 
 
@@ -298,13 +494,17 @@ inline unsigned int CircularMatrixBuffer<_Tp>::mapIndex(int& index)
 template<typename _Tp>
 void CircularMatrixBuffer<_Tp>::clear()
 {
-    delete m_pFreeElements;
-    m_pFreeElements = new QSemaphore(m_uiMaxNumElements);
-    delete m_pUsedElements;
-    m_pUsedElements = new QSemaphore(0);
+    QMutexLocker locker(&m_qMutex);
+
+    //A woken side has to see its release before it is reset, otherwise it finds an empty buffer and waits again
+    while((m_iPopWaiting.fetchAndAddOrdered(0) && m_iReleasePop.fetchAndAddOrdered(0))
+          || (m_iPushWaiting.fetchAndAddOrdered(0) && m_iReleasePush.fetchAndAddOrdered(0)))
+        m_qLeft.wait(&m_qMutex);
 
-    m_iCurrentReadIndex = -1;
-    m_iCurrentWriteIndex = -1;
+    m_iWriteIndex.fetchAndStoreOrdered(0);
+    m_iReadIndex.fetchAndStoreOrdered(0);
+    m_iReleasePush.fetchAndStoreOrdered(0);
+    m_iReleasePop.fetchAndStoreOrdered(0);
 }
 
 
@@ -349,15 +549,13 @@ inline void CircularMatrixBuffer<_Tp>::pause(bool bPause)
 template<typename _Tp>
 inline bool CircularMatrixBuffer<_Tp>::releaseFromPop()
 {
-   if((uint)m_pUsedElements->available() < m_uiRows*m_uiCols)
+    if(filled(m_iWriteIndex.fetchAndAddOrdered(0), m_iReadIndex.fetchAndAddOrdered(0)) == 0)
     {
-        //The last matrix which is to be popped from the buffer is supposed to be a zero matrix
-        unsigned int t_size = m_uiRows*m_uiCols;
-        for(unsigned int i = 0; i < t_size; ++i)
-            m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = 0;
+        //The pop function leaves its waiting with a zero matrix
+        m_iReleasePop.fetchAndStoreOrdered(1);
 
-        //Release (create) values from m_pUsedElements so that the pop function can leave the acquire statement in the pop function
-        m_pUsedElements->release(m_uiRows*m_uiCols);
+        QMutexLocker locker(&m_qMutex);
+        m_qNotEmpty.wakeAll();
 
         return true;
     }
@@ -371,15 +569,13 @@ inline bool CircularMatrixBuffer<_Tp>::releaseFromPop()
 template<typename _Tp>
 inline bool CircularMatrixBuffer<_Tp>::releaseFromPush()
 {
-    if((uint)m_pFreeElements->available() < m_uiRows*m_uiCols)
+    if(filled(m_iWriteIndex.fetchAndAddOrdered(0), m_iReadIndex.fetchAndAddOrdered(0)) == (int)m_uiMaxNumMatrices)
     {
-        //The last matrix which is to be pushed to the buffer is supposed to be a zero matrix
-        unsigned int t_size = m_uiRows*m_uiCols;
-        for(unsigned int i = 0; i < t_size; ++i)
-            m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = 0;
+        //The push function leaves its waiting and skips its matrix
+        m_iReleasePush.fetchAndStoreOrdered(1);
 
-        //Release (create) values from m_pFreeElements so that the push function can leave the acquire statement in the push function
-        m_pFreeElements->release(m_uiRows*m_uiCols);
+        QMutexLocker locker(&m_qMutex);
+        m_qNotFull.wakeAll();
 
         return true;
     }
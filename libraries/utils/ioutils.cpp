@@ -47,6 +47,23 @@
 //=============================================================================================================
 
 #include <QDataStream>
+#include <QtEndian>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// SIMD INCLUDES
+//=============================================================================================================
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
 
 
 //*************************************************************************************************************
@@ -253,6 +270,139 @@ void IOUtils::swap_doublep(double *source)
 }
 
 
+//*************************************************************************************************************
+
+void IOUtils::swap_copy_16(const void* src, void* dest, qint64 count)
+{
+    const uchar* s = (const uchar*)src;
+    uchar* d = (uchar*)dest;
+    qint64 i = 0;
+
+#if defined(__AVX2__)
+    const __m256i mask256 = _mm256_set_epi8(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1,
+                                            14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+    for(; i + 16 <= count; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + 2*i));
+        _mm256_storeu_si256((__m256i*)(d + 2*i), _mm256_shuffle_epi8(v, mask256));
+    }
+#endif
+#if defined(__SSSE3__)
+    const __m128i mask = _mm_set_epi8(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 2*i));
+        _mm_storeu_si128((__m128i*)(d + 2*i), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(__SSE2__)
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 2*i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(d + 2*i), v);
+    }
+#endif
+
+    quint16 v;
+    for(; i < count; ++i)
+    {
+        memcpy(&v, s + 2*i, 2);
+        v = qbswap(v);
+        memcpy(d + 2*i, &v, 2);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void IOUtils::swap_copy_32(const void* src, void* dest, qint64 count)
+{
+    const uchar* s = (const uchar*)src;
+    uchar* d = (uchar*)dest;
+    qint64 i = 0;
+
+#if defined(__AVX2__)
+    const __m256i mask256 = _mm256_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3,
+                                            12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + 4*i));
+        _mm256_storeu_si256((__m256i*)(d + 4*i), _mm256_shuffle_epi8(v, mask256));
+    }
+#endif
+#if defined(__SSSE3__)
+    const __m128i mask = _mm_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 4*i));
+        _mm_storeu_si128((__m128i*)(d + 4*i), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(__SSE2__)
+    for(; i + 4 <= count; i += 4)
+    {
+        //swap the 16 bit halves, then the bytes within them
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 4*i));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(d + 4*i), v);
+    }
+#endif
+
+    quint32 v;
+    for(; i < count; ++i)
+    {
+        memcpy(&v, s + 4*i, 4);
+        v = qbswap(v);
+        memcpy(d + 4*i, &v, 4);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void IOUtils::swap_copy_64(const void* src, void* dest, qint64 count)
+{
+    const uchar* s = (const uchar*)src;
+    uchar* d = (uchar*)dest;
+    qint64 i = 0;
+
+#if defined(__AVX2__)
+    const __m256i mask256 = _mm256_set_epi8(8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7,
+                                            8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + 8*i));
+        _mm256_storeu_si256((__m256i*)(d + 8*i), _mm256_shuffle_epi8(v, mask256));
+    }
+#endif
+#if defined(__SSSE3__)
+    const __m128i mask = _mm_set_epi8(8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7);
+    for(; i + 2 <= count; i += 2)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 8*i));
+        _mm_storeu_si128((__m128i*)(d + 8*i), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(__SSE2__)
+    for(; i + 2 <= count; i += 2)
+    {
+        //reverse the 16 bit words of each half, then the bytes within them
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 8*i));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0,1,2,3)), _MM_SHUFFLE(0,1,2,3));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(d + 8*i), v);
+    }
+#endif
+
+    quint64 v;
+    for(; i < count; ++i)
+    {
+        memcpy(&v, s + 8*i, 8);
+        v = qbswap(v);
+        memcpy(d + 8*i, &v, 8);
+    }
+}
+
+
 //*************************************************************************************************************
 
 QStringList IOUtils::get_new_chnames_conventions(const QStringList& chNames)
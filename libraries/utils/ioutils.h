@@ -202,6 +202,36 @@ public:
     */
     static void swap_doublep(double *source);
 
+    //=========================================================================================================
+    /**
+    * Copies count 16 bit values and reverses the byte order of each. Uses SSE2/SSSE3/AVX2 where available.
+    *
+    * @param[in] src        values to swap
+    * @param[out] dest      swapped values, may be identical to src for an in place swap
+    * @param[in] count      number of values
+    */
+    static void swap_copy_16(const void* src, void* dest, qint64 count);
+
+    //=========================================================================================================
+    /**
+    * Copies count 32 bit values (int, float) and reverses the byte order of each. Uses SSE2/SSSE3/AVX2 where available.
+    *
+    * @param[in] src        values to swap
+    * @param[out] dest      swapped values, may be identical to src for an in place swap
+    * @param[in] count      number of values
+    */
+    static void swap_copy_32(const void* src, void* dest, qint64 count);
+
+    //=========================================================================================================
+    /**
+    * Copies count 64 bit values (long, double) and reverses the byte order of each. Uses SSE2/SSSE3/AVX2 where available.
+    *
+    * @param[in] src        values to swap
+    * @param[out] dest      swapped values, may be identical to src for an in place swap
+    * @param[in] count      number of values
+    */
+    static void swap_copy_64(const void* src, void* dest, qint64 count);
+
     //=========================================================================================================
     /**
     * Write Eigen Matrix to file
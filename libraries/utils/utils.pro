@@ -84,6 +84,7 @@ SOURCES += \
     selectionio.cpp \
     filterTools/cosinefilter.cpp \
     filterTools/parksmcclellan.cpp \
+    filterTools/iirfilter.cpp \
     filterTools/filterdata.cpp \
     filterTools/filterio.cpp \
     detecttrigger.cpp \
@@ -111,6 +112,7 @@ HEADERS += \
     layoutmaker.h \
     filterTools/cosinefilter.h \
     filterTools/parksmcclellan.h \
+    filterTools/iirfilter.h \
     filterTools/filterdata.h \
     filterTools/filterio.h \
     detecttrigger.h \
@@ -42,6 +42,7 @@ QMAKE_TARGET_COPYRIGHT = Copyright (C) 2018 Authors of mne-cpp. All rights reser
 ## To disable examples run: qmake MNECPP_CONFIG+=noExamples
 ## To build basic MNE Scan version run: qmake MNECPP_CONFIG+=buildBasicMneScanVersion
 ## To build MNE-CPP libraries as static libs: qmake MNECPP_CONFIG+=buildStaticLibraries
+## To compile for the instruction set of the build machine (e.g. AVX2 byte swapping in fiff IO): qmake MNECPP_CONFIG+=useNativeArch
 
 ## Build MNE-CPP Deep library
 MNECPP_CONFIG += buildDeep
@@ -52,6 +53,15 @@ MNECPP_CONFIG += buildDeep
     MNECPP_CONFIG += minimalVersion
 }
 
+#Compile everything with the same flags, Eigen's alignment depends on the instruction set
+contains(MNECPP_CONFIG, useNativeArch) {
+    win32-msvc* {
+        QMAKE_CXXFLAGS += /arch:AVX2
+    } else {
+        QMAKE_CXXFLAGS += -march=native
+    }
+}
+
 
 ########################################### DIRECTORY DEFINITIONS #############################################
 
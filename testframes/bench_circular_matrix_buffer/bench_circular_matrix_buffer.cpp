@@ -0,0 +1,392 @@
+//=============================================================================================================
+/**
+* @file     bench_circular_matrix_buffer.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Benchmark of the circular matrix buffer against the former element wise implementation.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/generics/circularmatrixbuffer.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtCore/QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSemaphore>
+#include <QThread>
+#include <QFile>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <stdio.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace IOBUFFER;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS LegacyMatrixBuffer
+*
+* @brief The former circular matrix buffer, which copies every element through a mapped index and counts the
+*        elements with semaphores. It is kept here as the reference of the benchmark.
+*/
+class LegacyMatrixBuffer
+{
+public:
+    LegacyMatrixBuffer(unsigned int uiMaxNumMatrices, unsigned int uiRows, unsigned int uiCols)
+    : m_uiRows(uiRows)
+    , m_uiCols(uiCols)
+    , m_uiMaxNumElements(uiMaxNumMatrices*uiRows*uiCols)
+    , m_pBuffer(new double[m_uiMaxNumElements])
+    , m_iCurrentReadIndex(-1)
+    , m_iCurrentWriteIndex(-1)
+    , m_pFreeElements(new QSemaphore(m_uiMaxNumElements))
+    , m_pUsedElements(new QSemaphore(0))
+    {
+    }
+
+    ~LegacyMatrixBuffer()
+    {
+        delete m_pFreeElements;
+        delete m_pUsedElements;
+        delete [] m_pBuffer;
+    }
+
+    void push(const MatrixXd* pMatrix)
+    {
+        unsigned int t_size = pMatrix->size();
+        m_pFreeElements->acquire(t_size);
+        for(unsigned int i = 0; i < t_size; ++i)
+            m_pBuffer[mapIndex(m_iCurrentWriteIndex)] = pMatrix->data()[i];
+        m_pUsedElements->release(t_size);
+    }
+
+    MatrixXd pop()
+    {
+        MatrixXd matrix(m_uiRows, m_uiCols);
+        m_pUsedElements->acquire(m_uiRows*m_uiCols);
+        for(quint32 i = 0; i < m_uiRows*m_uiCols; ++i)
+            matrix.data()[i] = m_pBuffer[mapIndex(m_iCurrentReadIndex)];
+        m_pFreeElements->release(m_uiRows*m_uiCols);
+        return matrix;
+    }
+
+private:
+    unsigned int mapIndex(int& index)
+    {
+        int AuxIndex;
+        AuxIndex = ++index;
+        return index = AuxIndex % m_uiMaxNumElements;
+    }
+
+    unsigned int    m_uiRows;
+    unsigned int    m_uiCols;
+    unsigned int    m_uiMaxNumElements;
+    double*         m_pBuffer;
+    int             m_iCurrentReadIndex;
+    int             m_iCurrentWriteIndex;
+    QSemaphore*     m_pFreeElements;
+    QSemaphore*     m_pUsedElements;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS BlockProducer
+*
+* @brief The BlockProducer thread pushes the same block a given number of times into a buffer.
+*/
+template<class BufferType>
+class BlockProducer : public QThread
+{
+public:
+    BlockProducer(BufferType* pBuffer, const MatrixXd& matBlock, qint32 iNumBlocks)
+    : m_pBuffer(pBuffer)
+    , m_matBlock(matBlock)
+    , m_iNumBlocks(iNumBlocks)
+    {
+    }
+
+protected:
+    void run()
+    {
+        for(qint32 i = 0; i < m_iNumBlocks; ++i)
+            m_pBuffer->push(&m_matBlock);
+    }
+
+private:
+    BufferType*     m_pBuffer;      /**< The buffer to fill. */
+    MatrixXd        m_matBlock;     /**< The pushed block. */
+    qint32          m_iNumBlocks;   /**< Number of blocks to push. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Pops one block, the legacy buffer can only return a new matrix.
+*/
+static void pop_block(LegacyMatrixBuffer& buffer, MatrixXd& matBlock, bool bZeroCopy)
+{
+    Q_UNUSED(bZeroCopy);
+    matBlock = buffer.pop();
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Pops one block, either as a new matrix or by swapping it into the given matrix.
+*/
+static void pop_block(CircularMatrixBuffer<double>& buffer, MatrixXd& matBlock, bool bZeroCopy)
+{
+    if(bZeroCopy)
+        buffer.pop(matBlock);
+    else
+        matBlock = buffer.pop();
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Creates the result entry of one measurement.
+*
+* @param[in] nsecs      Elapsed time in nanoseconds
+* @param[in] nblocks    Number of blocks which went through the buffer
+* @param[in] nbytes     Number of bytes of one block
+* @param[in] dChecksum  Sum over the popped blocks, it has to match between the implementations
+*
+* @return the result entry
+*/
+static QJsonObject throughput(qint64 nsecs, qint32 nblocks, qint64 nbytes, double dChecksum)
+{
+    double secs = qMax<qint64>(nsecs, 1) / 1e9;
+
+    QJsonObject result;
+    result["seconds"] = secs;
+    result["blocks_per_sec"] = nblocks / secs;
+    result["mb_per_sec"] = nblocks * nbytes / secs / (1024.0 * 1024.0);
+    result["usec_per_block"] = secs * 1e6 / nblocks;
+    result["checksum"] = dChecksum;
+    return result;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Streams the blocks from a producer thread through the buffer to the calling thread.
+*/
+template<class BufferType>
+static QJsonObject streamed(BufferType& buffer, const MatrixXd& matBlock, qint32 nblocks, bool bZeroCopy)
+{
+    BlockProducer<BufferType> producer(&buffer, matBlock, nblocks);
+    MatrixXd matPopped;
+    double dChecksum = 0.0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    producer.start();
+    for(qint32 i = 0; i < nblocks; ++i)
+    {
+        pop_block(buffer, matPopped, bZeroCopy);
+        dChecksum += matPopped(0, 0) + matPopped(matPopped.rows() - 1, matPopped.cols() - 1);
+    }
+    producer.wait();
+
+    return throughput(timer.nsecsElapsed(), nblocks, matBlock.size() * sizeof(double), dChecksum);
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Pushes and pops the blocks alternately in the calling thread, this is the cost of the buffer without any
+* waiting.
+*/
+template<class BufferType>
+static QJsonObject alternating(BufferType& buffer, const MatrixXd& matBlock, qint32 nblocks, bool bZeroCopy)
+{
+    MatrixXd matPopped;
+    double dChecksum = 0.0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for(qint32 i = 0; i < nblocks; ++i)
+    {
+        buffer.push(&matBlock);
+        pop_block(buffer, matPopped, bZeroCopy);
+        dChecksum += matPopped(0, 0) + matPopped(matPopped.rows() - 1, matPopped.cols() - 1);
+    }
+
+    return throughput(timer.nsecsElapsed(), nblocks, matBlock.size() * sizeof(double), dChecksum);
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Moves blocks of the given size through the former and the current circular matrix buffer, once from a
+* producer thread to the main thread and once alternately within the main thread. The results are printed (or
+* written to a file) as JSON, so they can be compared between builds.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return 0 on success, 1 on an error.
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Circular Matrix Buffer Benchmark");
+    parser.addHelpOption();
+    QCommandLineOption rowsOption("rows", "Number of rows (channels) of a block.", "count", "306");
+    QCommandLineOption colsOption("cols", "Number of columns (samples) of a block.", "count", "200");
+    QCommandLineOption blocksOption("blocks", "Number of blocks per measurement.", "count", "2000");
+    QCommandLineOption capacityOption("capacity", "Number of blocks the buffers hold.", "count", "8");
+    QCommandLineOption outOption("out", "Write the JSON results to <file> instead of stdout.", "file");
+
+    parser.addOption(rowsOption);
+    parser.addOption(colsOption);
+    parser.addOption(blocksOption);
+    parser.addOption(capacityOption);
+    parser.addOption(outOption);
+
+    parser.process(a);
+
+    qint32 nrows = parser.value(rowsOption).toInt();
+    qint32 ncols = parser.value(colsOption).toInt();
+    qint32 nblocks = parser.value(blocksOption).toInt();
+    qint32 capacity = parser.value(capacityOption).toInt();
+
+    if(nrows <= 0 || ncols <= 0 || nblocks <= 0 || capacity <= 0)
+    {
+        printf("Invalid benchmark configuration, see --help.\n");
+        return 1;
+    }
+
+    QJsonObject config;
+    config["rows"] = nrows;
+    config["cols"] = ncols;
+    config["blocks"] = nblocks;
+    config["capacity"] = capacity;
+
+    MatrixXd matBlock = MatrixXd::Random(nrows, ncols);
+
+    //
+    //   Former implementation
+    //
+    QJsonObject legacy;
+    {
+        LegacyMatrixBuffer buffer(capacity, nrows, ncols);
+        legacy["streamed"] = streamed(buffer, matBlock, nblocks, false);
+        legacy["alternating"] = alternating(buffer, matBlock, nblocks, false);
+    }
+
+    //
+    //   Current implementation, returning a new matrix and popping into the caller's matrix
+    //
+    QJsonObject current;
+    {
+        CircularMatrixBuffer<double> buffer(capacity, nrows, ncols);
+        current["streamed"] = streamed(buffer, matBlock, nblocks, false);
+        current["streamed_zero_copy"] = streamed(buffer, matBlock, nblocks, true);
+        current["alternating"] = alternating(buffer, matBlock, nblocks, false);
+        current["alternating_zero_copy"] = alternating(buffer, matBlock, nblocks, true);
+    }
+
+    QJsonObject results;
+    results["legacy"] = legacy;
+    results["current"] = current;
+
+    //
+    //   Report
+    //
+    QJsonObject report;
+    report["benchmark"] = QString("bench_circular_matrix_buffer");
+    report["config"] = config;
+    report["results"] = results;
+    QByteArray json = QJsonDocument(report).toJson();
+
+    if(parser.isSet(outOption))
+    {
+        QFile t_fileOut(parser.value(outOption));
+        if(!t_fileOut.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            printf("Could not open %s for writing.\n", t_fileOut.fileName().toUtf8().constData());
+            return 1;
+        }
+        t_fileOut.write(json);
+    }
+    else
+        printf("%s", json.constData());
+
+    return 0;
+}
@@ -0,0 +1,515 @@
+//=============================================================================================================
+/**
+* @file     bench_fiff_io.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Throughput benchmark of the fiff raw data io
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <fiff/fiff_tag_iterator.h>
+#include <fiff/fiff_tag_parser.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtCore/QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QDir>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <math.h>
+#include <stdio.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Creates the measurement info of a synthetic recording with miscellaneous channels of unit calibration, so the
+* synthetic amplitudes can be stored with every data type without rescaling.
+*
+* @param[in] nchan  Number of channels
+* @param[in] sfreq  Sampling frequency
+*
+* @return the measurement info
+*/
+static FiffInfo synthetic_info(qint32 nchan, float sfreq)
+{
+    FiffInfo info;
+    info.sfreq = sfreq;
+    info.highpass = 0.0f;
+    info.lowpass = sfreq / 2.0f;
+    info.nchan = nchan;
+
+    for(qint32 k = 0; k < nchan; ++k)
+    {
+        FiffChInfo ch;
+        ch.scanNo = k + 1;
+        ch.logNo = k + 1;
+        ch.kind = FIFFV_MISC_CH;
+        ch.range = 1.0f;
+        ch.cal = 1.0f;
+        ch.unit = FIFF_UNIT_V;
+        ch.unit_mul = FIFF_UNITM_NONE;
+        ch.ch_name = QString("BENCH %1").arg(k + 1, 4, 10, QChar('0'));
+        info.chs.append(ch);
+        info.ch_names.append(ch.ch_name);
+    }
+
+    return info;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Fills a data block with a deterministic, band limited signal plus noise, similar to sensor data.
+*
+* @param[out] data      The block to fill, channels x samples
+* @param[in] first      Index of the first sample of the block
+* @param[in] sfreq      Sampling frequency
+*/
+static void synthetic_block(MatrixXd& data, qint64 first, float sfreq)
+{
+    for(qint32 j = 0; j < data.cols(); ++j)
+    {
+        double t = (double)(first + j) / sfreq;
+        for(qint32 i = 0; i < data.rows(); ++i)
+            data(i, j) = floor(1000.0 * sin(2.0 * M_PI * (5.0 + 0.1 * i) * t) + 20.0 * ((qrand() % 1000) / 1000.0 - 0.5));
+    }
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Maps the storage type names of the command line to the fiff data types.
+*
+* @param[in] name   float, int, short or rice
+*
+* @return the fiff data type, -1 for an unknown name
+*/
+static fiff_int_t storage_type(const QString& name)
+{
+    if(name == "float")
+        return FIFFT_FLOAT;
+    if(name == "int")
+        return FIFFT_INT;
+    if(name == "short")
+        return FIFFT_DAU_PACK16;
+    if(name == "rice")
+        return FIFFT_INT_DELTA_RICE;
+    return -1;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Converts a measured duration into the result entry of a benchmark.
+*
+* @param[in] nsecs      Elapsed time in nanoseconds
+* @param[in] nbytes     Number of processed file bytes
+* @param[in] nsamples   Number of processed samples (channels times time points), 0 if not applicable
+*
+* @return the result entry
+*/
+static QJsonObject throughput(qint64 nsecs, qint64 nbytes, qint64 nsamples)
+{
+    double secs = qMax<qint64>(nsecs, 1) / 1e9;
+
+    QJsonObject result;
+    result["seconds"] = secs;
+    result["mb_per_sec"] = nbytes / secs / (1024.0 * 1024.0);
+    if(nsamples > 0)
+        result["samples_per_sec"] = nsamples / secs;
+    return result;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Writes the synthetic recording to a raw file, repeating the pre-generated blocks until nsamp samples are written.
+*
+* @param[in] t_file     The file to write
+* @param[in] info       Measurement info of the recording
+* @param[in] blocks     Pre-generated data blocks of nbuffer samples each
+* @param[in] nsamp      Total number of samples
+* @param[in] nbuffer    Number of samples per data buffer
+* @param[in] type       Storage type of the data buffers
+*
+* @return true if the file was written
+*/
+static bool write_synthetic_raw(QFile& t_file, const FiffInfo& info, const QList<MatrixXd>& blocks, qint64 nsamp, qint32 nbuffer, fiff_int_t type)
+{
+    RowVectorXd cals;
+    //
+    //   The benchmark files are only read back by MNE-CPP itself, so compressed storage is allowed
+    //
+    FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_file, info, cals, defaultMatrixXi, false, type, defaultRowVectorXd, true);
+    if(!outfid)
+    {
+        printf("Could not open %s for writing.\n", t_file.fileName().toUtf8().constData());
+        return false;
+    }
+
+    bool ok = true;
+    qint32 b = 0;
+    for(qint64 first = 0; first < nsamp && ok; first += nbuffer, ++b)
+    {
+        const MatrixXd& block = blocks[b % blocks.size()];
+        if(first + nbuffer <= nsamp)
+            ok = outfid->write_raw_buffer(block, cals);
+        else
+            ok = outfid->write_raw_buffer(block.leftCols(nsamp - first).eval(), cals);
+    }
+    outfid->finish_writing_raw();
+
+    if(!ok)
+        printf("Could not write the data buffers of %s.\n", t_file.fileName().toUtf8().constData());
+    return ok;
+}
+
+
+//*************************************************************************************************************
+
+//=============================================================================================================
+/**
+* Reads a whole recording with consecutive read_raw_segment calls.
+*
+* @param[in] raw        The raw data to read
+* @param[in] nsegment   Number of samples per read_raw_segment call
+* @param[out] nread     Number of samples read
+*
+* @return true if all segments were read
+*/
+static bool read_sequential(FiffRawData& raw, qint32 nsegment, qint64& nread)
+{
+    MatrixXd data, times;
+    qint64 nsamp = raw.last_samp - raw.first_samp + 1;
+    nread = 0;
+    for(qint64 first = 0; first < nsamp; first += nsegment)
+    {
+        fiff_int_t from = raw.first_samp + first;
+        fiff_int_t to = raw.first_samp + qMin<qint64>(first + nsegment, nsamp) - 1;
+        if(!raw.read_raw_segment(data, times, from, to))
+        {
+            printf("Sequential read of samples %d to %d failed.\n", from, to);
+            return false;
+        }
+        nread += data.cols();
+    }
+    return true;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Writes a synthetic raw file and measures the throughput of the fiff io hot paths on it: writing, opening,
+* sequential and random read_raw_segment calls as well as walking and parsing the tags. The results are printed
+* (or written to a file) as JSON, so they can be compared between builds.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return 0 on success, 1 on an error.
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fiff IO Benchmark");
+    parser.addHelpOption();
+    QCommandLineOption nchanOption("nchan", "Number of channels of the synthetic recording.", "count", "306");
+    QCommandLineOption durationOption("duration", "Duration of the synthetic recording in seconds.", "seconds", "60");
+    QCommandLineOption sfreqOption("sfreq", "Sampling frequency in Hz.", "hz", "1000");
+    QCommandLineOption typeOption("type", "Storage type of the data buffers: float, int, short or rice.", "type", "float");
+    QCommandLineOption bufferOption("buffer", "Number of samples per written data buffer.", "samples", "1000");
+    QCommandLineOption segmentOption("segment", "Number of samples per read_raw_segment call.", "samples", "1000");
+    QCommandLineOption readsOption("reads", "Number of random read_raw_segment calls.", "count", "200");
+    QCommandLineOption fileOption("file", "Path of the synthetic raw <file>.", "file", QDir::tempPath() + "/bench_fiff_io_raw.fif");
+    QCommandLineOption outOption("out", "Write the JSON results to <file> instead of stdout.", "file");
+    QCommandLineOption keepOption("keep", "Keep the synthetic raw file.");
+
+    parser.addOption(nchanOption);
+    parser.addOption(durationOption);
+    parser.addOption(sfreqOption);
+    parser.addOption(typeOption);
+    parser.addOption(bufferOption);
+    parser.addOption(segmentOption);
+    parser.addOption(readsOption);
+    parser.addOption(fileOption);
+    parser.addOption(outOption);
+    parser.addOption(keepOption);
+
+    parser.process(a);
+
+    qint32 nchan = parser.value(nchanOption).toInt();
+    float sfreq = parser.value(sfreqOption).toFloat();
+    qint64 nsamp = (qint64)(parser.value(durationOption).toDouble() * sfreq);
+    qint32 nbuffer = parser.value(bufferOption).toInt();
+    qint32 nsegment = parser.value(segmentOption).toInt();
+    qint32 nreads = parser.value(readsOption).toInt();
+    fiff_int_t type = storage_type(parser.value(typeOption));
+
+    if(nchan <= 0 || sfreq <= 0 || nsamp <= 0 || nbuffer <= 0 || nsegment <= 0 || nsegment > nsamp || nreads < 0 || type < 0)
+    {
+        printf("Invalid benchmark configuration, see --help.\n");
+        return 1;
+    }
+
+    QJsonObject config;
+    config["nchan"] = nchan;
+    config["sfreq"] = sfreq;
+    config["nsamp"] = nsamp;
+    config["type"] = parser.value(typeOption);
+    config["buffer"] = nbuffer;
+    config["segment"] = nsegment;
+    config["reads"] = nreads;
+
+    QJsonObject results;
+    QElapsedTimer timer;
+    QFile t_file(parser.value(fileOption));
+
+    //
+    //   Write: the synthetic blocks are generated up front, so only the writing is timed
+    //
+    qsrand(0);
+    QList<MatrixXd> blocks;
+    for(qint64 first = 0; first < qMin<qint64>(nsamp, 10 * nbuffer); first += nbuffer)
+    {
+        MatrixXd block(nchan, qMin<qint64>(nbuffer, nsamp - first));
+        synthetic_block(block, first, sfreq);
+        blocks.append(block);
+    }
+
+    FiffInfo info = synthetic_info(nchan, sfreq);
+
+    timer.start();
+    if(!write_synthetic_raw(t_file, info, blocks, nsamp, nbuffer, type))
+        return 1;
+    qint64 nsecsWrite = timer.nsecsElapsed();
+
+    qint64 fileSize = t_file.size();
+    config["file_bytes"] = fileSize;
+    results["write"] = throughput(nsecsWrite, fileSize, nchan * nsamp);
+
+    //
+    //   Open: reading the directory, the measurement info and setting up the raw buffer index
+    //
+    timer.start();
+    FiffRawData raw(t_file);
+    qint64 nsecsOpen = timer.nsecsElapsed();
+
+    if(raw.info.nchan != nchan || raw.last_samp - raw.first_samp + 1 != nsamp)
+    {
+        printf("Could not read back %s.\n", t_file.fileName().toUtf8().constData());
+        return 1;
+    }
+
+    QJsonObject open;
+    open["seconds"] = nsecsOpen / 1e9;
+    results["open"] = open;
+
+    //
+    //   Sequential reads covering the whole recording
+    //
+    qint64 nread = 0;
+    timer.start();
+    if(!read_sequential(raw, nsegment, nread))
+        return 1;
+    results["read_sequential"] = throughput(timer.nsecsElapsed(), fileSize, nchan * nread);
+
+    //
+    //   Random reads at reproducible positions
+    //
+    MatrixXd data, times;
+    qsrand(1);
+    timer.start();
+    for(qint32 k = 0; k < nreads; ++k)
+    {
+        fiff_int_t from = raw.first_samp + (fiff_int_t)(((qint64)qrand() * (RAND_MAX + 1LL) + qrand()) % (nsamp - nsegment + 1));
+        if(!raw.read_raw_segment(data, times, from, from + nsegment - 1))
+        {
+            printf("Random read of samples %d to %d failed.\n", from, from + nsegment - 1);
+            return 1;
+        }
+    }
+    qint64 nsecsRandom = timer.nsecsElapsed();
+    QJsonObject random = throughput(nsecsRandom, (qint64)nreads * nsegment * fileSize / nsamp, (qint64)nreads * nsegment * nchan);
+    random["reads_per_sec"] = nreads / (qMax<qint64>(nsecsRandom, 1) / 1e9);
+    results["read_random"] = random;
+
+    //
+    //   Walking the tags with the allocation free iterator, including the payloads
+    //
+    {
+        QFile t_fileTags(t_file.fileName());
+        FiffStream t_stream(&t_fileTags);
+        if(!t_stream.open())
+        {
+            printf("Could not open %s.\n", t_file.fileName().toUtf8().constData());
+            return 1;
+        }
+
+        timer.start();
+        FiffTagIterator it(&t_stream);
+        while(it.next())
+            it.payload();
+        qint64 nsecsIterate = timer.nsecsElapsed();
+
+        QJsonObject iterate = throughput(nsecsIterate, fileSize, 0);
+        iterate["tags_per_sec"] = it.count() / (qMax<qint64>(nsecsIterate, 1) / 1e9);
+        results["tag_iterate"] = iterate;
+        t_stream.close();
+    }
+
+    //
+    //   Parsing the byte stream into tags as done for real-time data
+    //
+    {
+        QFile t_fileTags(t_file.fileName());
+        if(!t_fileTags.open(QIODevice::ReadOnly))
+        {
+            printf("Could not open %s.\n", t_file.fileName().toUtf8().constData());
+            return 1;
+        }
+        QByteArray bytes = t_fileTags.readAll();
+        t_fileTags.close();
+
+        FiffTagParser t_parser;
+        const qint64 chunk = 64 * 1024;
+        timer.start();
+        for(qint64 pos = 0; pos < bytes.size(); pos += chunk)
+            t_parser.append(bytes.constData() + pos, qMin(chunk, bytes.size() - pos));
+        qint64 nsecsParse = timer.nsecsElapsed();
+
+        QJsonObject parse = throughput(nsecsParse, bytes.size(), 0);
+        parse["tags_per_sec"] = t_parser.tagCount() / (qMax<qint64>(nsecsParse, 1) / 1e9);
+        results["tag_parse"] = parse;
+    }
+
+    if(!parser.isSet(keepOption))
+        QFile::remove(t_file.fileName());
+
+    //
+    //   Decoding the same recording stored as float, int and rice coded int, sizes and sequential read speed
+    //
+    {
+        QStringList names;
+        names << "float" << "int" << "rice";
+
+        QJsonObject compare;
+        for(qint32 k = 0; k < names.size(); ++k)
+        {
+            QFile t_fileType(t_file.fileName() + "." + names[k]);
+            if(!write_synthetic_raw(t_fileType, info, blocks, nsamp, nbuffer, storage_type(names[k])))
+                return 1;
+
+            FiffRawData t_raw(t_fileType);
+            qint64 nreadType = 0;
+            timer.start();
+            if(!read_sequential(t_raw, nsegment, nreadType))
+                return 1;
+            QJsonObject decode = throughput(timer.nsecsElapsed(), t_fileType.size(), nchan * nreadType);
+            decode["file_bytes"] = t_fileType.size();
+            compare[names[k]] = decode;
+
+            if(!parser.isSet(keepOption))
+                QFile::remove(t_fileType.fileName());
+        }
+        results["decode_compare"] = compare;
+    }
+
+    //
+    //   Report
+    //
+    QJsonObject report;
+    report["benchmark"] = QString("bench_fiff_io");
+    report["config"] = config;
+    report["results"] = results;
+    QByteArray json = QJsonDocument(report).toJson();
+
+    if(parser.isSet(outOption))
+    {
+        QFile t_fileOut(parser.value(outOption));
+        if(!t_fileOut.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            printf("Could not open %s for writing.\n", t_fileOut.fileName().toUtf8().constData());
+            return 1;
+        }
+        t_fileOut.write(json);
+    }
+    else
+        printf("%s", json.constData());
+
+    return 0;
+}
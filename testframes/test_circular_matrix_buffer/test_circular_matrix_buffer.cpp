@@ -0,0 +1,387 @@
+//=============================================================================================================
+/**
+* @file     test_circular_matrix_buffer.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the waiting, release, pause and clear behavior of the circular matrix buffer.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/generics/circularmatrixbuffer.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QThread>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace IOBUFFER;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS BlockConsumer
+*
+* @brief The BlockConsumer thread pops one block with the blocking pop and keeps it.
+*/
+class BlockConsumer : public QThread
+{
+public:
+    BlockConsumer(CircularMatrixBuffer<double>* pBuffer)
+    : m_pBuffer(pBuffer)
+    , m_bPopped(false)
+    {
+    }
+
+    MatrixXd    m_matBlock;     /**< The popped block. */
+
+    bool popped() const
+    {
+        return m_bPopped;
+    }
+
+protected:
+    void run()
+    {
+        m_bPopped = m_pBuffer->pop(m_matBlock);
+    }
+
+private:
+    CircularMatrixBuffer<double>*   m_pBuffer;      /**< The buffer to pop from. */
+    bool                            m_bPopped;      /**< Whether a block was popped. */
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS BlockProducer
+*
+* @brief The BlockProducer thread pushes one block, waiting until a slot is free.
+*/
+class BlockProducer : public QThread
+{
+public:
+    BlockProducer(CircularMatrixBuffer<double>* pBuffer, const MatrixXd& matBlock)
+    : m_pBuffer(pBuffer)
+    , m_matBlock(matBlock)
+    , m_bPushed(false)
+    {
+    }
+
+    bool pushed() const
+    {
+        return m_bPushed;
+    }
+
+protected:
+    void run()
+    {
+        m_bPushed = m_pBuffer->tryPush(m_matBlock, -1);
+    }
+
+private:
+    CircularMatrixBuffer<double>*   m_pBuffer;      /**< The buffer to push to. */
+    MatrixXd                        m_matBlock;     /**< The pushed block. */
+    bool                            m_bPushed;      /**< Whether the block was pushed. */
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestCircularMatrixBuffer
+*
+* @brief The TestCircularMatrixBuffer class checks the waiting of the push and pop functions, the release of a
+*        waiting side, the pause and the reuse of the buffer after clear().
+*
+*/
+class TestCircularMatrixBuffer: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestCircularMatrixBuffer();
+
+private slots:
+    void initTestCase();
+    void pushPopOrder();
+    void tryPushTimeout();
+    void tryPopTimeout();
+    void releaseFromPop();
+    void releaseFromPush();
+    void releaseAndClear();
+    void pause();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns a block whose elements all equal dValue.
+    */
+    MatrixXd block(double dValue) const;
+
+    int         m_iRows;        /**< Rows of the blocks. */
+    int         m_iCols;        /**< Columns of the blocks. */
+    int         m_iWaitMsecs;   /**< The waiting time of the timeout tests. */
+};
+
+
+//*************************************************************************************************************
+
+TestCircularMatrixBuffer::TestCircularMatrixBuffer()
+: m_iRows(4)
+, m_iCols(16)
+, m_iWaitMsecs(50)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::initTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::pushPopOrder()
+{
+    CircularMatrixBuffer<double> buffer(3, m_iRows, m_iCols);
+    MatrixXd matBlock;
+
+    //Wrap around the ring a few times
+    for(int i = 0; i < 10; ++i) {
+        QVERIFY(buffer.tryPush(block(i)));
+        QVERIFY(buffer.tryPush(block(i + 0.5)));
+
+        QVERIFY(buffer.tryPop(matBlock));
+        QCOMPARE(matBlock, block(i));
+        QVERIFY(buffer.tryPop(matBlock));
+        QCOMPARE(matBlock, block(i + 0.5));
+    }
+
+    //Wrong dimensions are rejected
+    QVERIFY(!buffer.tryPush(MatrixXd::Zero(m_iRows + 1, m_iCols)));
+    QVERIFY(!buffer.tryPop(matBlock));
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::tryPushTimeout()
+{
+    CircularMatrixBuffer<double> buffer(2, m_iRows, m_iCols);
+
+    QVERIFY(buffer.tryPush(block(1)));
+    QVERIFY(buffer.tryPush(block(2)));
+
+    //A full buffer does not take a block, without and with waiting
+    QVERIFY(!buffer.tryPush(block(3)));
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(!buffer.tryPush(block(3), m_iWaitMsecs));
+    QVERIFY(timer.elapsed() >= m_iWaitMsecs - 5);
+
+    //The rejected block did not overwrite a slot
+    MatrixXd matBlock;
+    QVERIFY(buffer.tryPop(matBlock));
+    QCOMPARE(matBlock, block(1));
+    QVERIFY(buffer.tryPush(block(3), m_iWaitMsecs));
+    QVERIFY(buffer.tryPop(matBlock));
+    QCOMPARE(matBlock, block(2));
+    QVERIFY(buffer.tryPop(matBlock));
+    QCOMPARE(matBlock, block(3));
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::tryPopTimeout()
+{
+    CircularMatrixBuffer<double> buffer(2, m_iRows, m_iCols);
+    MatrixXd matBlock = block(7);
+
+    QVERIFY(!buffer.tryPop(matBlock));
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(!buffer.tryPop(matBlock, m_iWaitMsecs));
+    QVERIFY(timer.elapsed() >= m_iWaitMsecs - 5);
+
+    //Nothing popped, the matrix is untouched
+    QCOMPARE(matBlock, block(7));
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseFromPop()
+{
+    CircularMatrixBuffer<double> buffer(2, m_iRows, m_iCols);
+    BlockConsumer consumer(&buffer);
+
+    consumer.start();
+    QVERIFY(!consumer.wait(m_iWaitMsecs));
+
+    QVERIFY(buffer.releaseFromPop());
+    QVERIFY(consumer.wait(2000));
+
+    //The released pop returns a zero matrix
+    QVERIFY(!consumer.popped());
+    QCOMPARE(consumer.m_matBlock, MatrixXd(MatrixXd::Zero(m_iRows, m_iCols)));
+
+    //A buffer holding data does not need to be released
+    QVERIFY(buffer.tryPush(block(1)));
+    QVERIFY(!buffer.releaseFromPop());
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseFromPush()
+{
+    CircularMatrixBuffer<double> buffer(1, m_iRows, m_iCols);
+    QVERIFY(buffer.tryPush(block(1)));
+
+    BlockProducer producer(&buffer, block(2));
+
+    producer.start();
+    QVERIFY(!producer.wait(m_iWaitMsecs));
+
+    QVERIFY(buffer.releaseFromPush());
+    QVERIFY(producer.wait(2000));
+
+    //The released push skipped its block
+    QVERIFY(!producer.pushed());
+
+    MatrixXd matBlock;
+    QVERIFY(buffer.tryPop(matBlock));
+    QCOMPARE(matBlock, block(1));
+    QVERIFY(!buffer.tryPop(matBlock));
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::releaseAndClear()
+{
+    //The plugins stop with a release immediately followed by clear(), the waiting consumer has to leave
+    CircularMatrixBuffer<double> buffer(2, m_iRows, m_iCols);
+
+    for(int i = 0; i < 20; ++i) {
+        BlockConsumer consumer(&buffer);
+
+        consumer.start();
+        QVERIFY(!consumer.wait(5));
+
+        buffer.releaseFromPop();
+        buffer.clear();
+
+        QVERIFY(consumer.wait(2000));
+        QVERIFY(!consumer.popped());
+    }
+
+    //The release does not outlive clear(), the next consumer waits for data again
+    BlockConsumer consumer(&buffer);
+
+    consumer.start();
+    QVERIFY(!consumer.wait(m_iWaitMsecs));
+
+    QVERIFY(buffer.tryPush(block(3)));
+    QVERIFY(consumer.wait(2000));
+    QVERIFY(consumer.popped());
+    QCOMPARE(consumer.m_matBlock, block(3));
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::pause()
+{
+    CircularMatrixBuffer<double> buffer(2, m_iRows, m_iCols);
+    MatrixXd matBlock = block(5);
+
+    QVERIFY(buffer.tryPush(block(1)));
+
+    //A paused buffer skips pushed blocks and pops zero matrices
+    buffer.pause(true);
+    QVERIFY(!buffer.tryPush(block(2)));
+    QVERIFY(!buffer.tryPop(matBlock, m_iWaitMsecs));
+    QCOMPARE(matBlock, block(5));
+    QVERIFY(!buffer.pop(matBlock));
+    QCOMPARE(matBlock, MatrixXd(MatrixXd::Zero(m_iRows, m_iCols)));
+
+    //The data pushed before the pause is still there
+    buffer.pause(false);
+    QVERIFY(buffer.tryPop(matBlock));
+    QCOMPARE(matBlock, block(1));
+    QVERIFY(!buffer.tryPop(matBlock));
+}
+
+
+//*************************************************************************************************************
+
+void TestCircularMatrixBuffer::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestCircularMatrixBuffer::block(double dValue) const
+{
+    return MatrixXd::Constant(m_iRows, m_iCols, dValue);
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestCircularMatrixBuffer)
+#include "test_circular_matrix_buffer.moc"
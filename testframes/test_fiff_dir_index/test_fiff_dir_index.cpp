@@ -0,0 +1,367 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_dir_index.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    The directory index sidecar unit test
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <fiff/fiff_tag_iterator.h>
+
+#include <iostream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffDirIndex
+*
+* @brief The TestFiffDirIndex class verifies that the directory index sidecar reproduces the tag directory, is
+*        rejected when it does not belong to the file and that the directory tree compiled by open(), also from the
+*        block types and ids stored in the index, matches.
+*
+*/
+class TestFiffDirIndex: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffDirIndex();
+
+private slots:
+    void initTestCase();
+    void createIndex();
+    void loadIndex();
+    void rejectInvalidIndex();
+    void dirTree();
+    void blockTreeFromIndex();
+    void tagIterator();
+    void cleanupTestCase();
+
+private:
+    bool sameDir(const QList<FiffDirEntry::SPtr>& dir) const;
+
+    QFile m_fileIn;
+    QString m_sIndexName;
+
+    QList<FiffDirEntry::SPtr> m_refDir;
+    qint32 m_iRefRawBlocks;
+};
+
+
+//*************************************************************************************************************
+
+TestFiffDirIndex::TestFiffDirIndex()
+: m_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif")
+, m_iRefRawBlocks(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::initTestCase()
+{
+    m_sIndexName = FiffStream::dir_index_name(QFileInfo(m_fileIn).absoluteFilePath());
+    QFile::remove(m_sIndexName);
+
+    //
+    //   Reference directory read without the index
+    //
+    FiffStream t_stream(&m_fileIn);
+    QVERIFY(t_stream.open());
+    m_refDir = t_stream.dir();
+    m_iRefRawBlocks = t_stream.dirtree()->dir_tree_find(FIFFB_RAW_DATA).size();
+    t_stream.close();
+
+    QVERIFY(m_refDir.size() > 2);
+    QVERIFY(!QFile::exists(m_sIndexName));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::createIndex()
+{
+    FiffStream t_stream(&m_fileIn);
+    t_stream.setDirIndexEnabled(true);
+    QVERIFY(t_stream.open());
+    t_stream.close();
+
+    QVERIFY(QFile::exists(m_sIndexName));
+    QVERIFY(sameDir(t_stream.dir()));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::loadIndex()
+{
+    //
+    //   Patch the size of the second entry to see that the directory really comes from the index
+    //
+    QFile t_indexFile(m_sIndexName);
+    QVERIFY(t_indexFile.open(QIODevice::ReadWrite));
+    QByteArray t_baIndex = t_indexFile.readAll();
+    qint32 offset = 48 + 16 + 8;
+    QVERIFY(t_baIndex.size() >= offset + 4);
+    qToBigEndian<qint32>(12345, (uchar*)t_baIndex.data() + offset);
+    t_indexFile.seek(0);
+    t_indexFile.write(t_baIndex);
+    t_indexFile.close();
+
+    FiffStream t_stream(&m_fileIn);
+    t_stream.setDirIndexEnabled(true);
+    QVERIFY(t_stream.open());
+    t_stream.close();
+
+    QCOMPARE(t_stream.dir().size(), m_refDir.size());
+    QCOMPARE(t_stream.dir()[1]->size, 12345);
+
+    QFile::remove(m_sIndexName);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::rejectInvalidIndex()
+{
+    //
+    //   An index which belongs to another file is replaced by a valid one
+    //
+    QFile t_indexFile(m_sIndexName);
+    QVERIFY(t_indexFile.open(QIODevice::WriteOnly));
+    QDataStream t_out(&t_indexFile);
+    t_out << (quint32)0x46444958 << (qint32)2 << (qint64)1 << (qint64)0;
+    t_indexFile.close();
+
+    FiffStream t_stream(&m_fileIn);
+    t_stream.setDirIndexEnabled(true);
+    QVERIFY(t_stream.open());
+    t_stream.close();
+    QVERIFY(sameDir(t_stream.dir()));
+
+    FiffStream t_stream2(&m_fileIn);
+    t_stream2.setDirIndexEnabled(true);
+    QVERIFY(t_stream2.open());
+    t_stream2.close();
+    QVERIFY(sameDir(t_stream2.dir()));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::dirTree()
+{
+    //
+    //   The index is a setting of the stream, a stream without it neither reads nor writes the sidecar
+    //
+    QFile::remove(m_sIndexName);
+
+    FiffStream t_stream(&m_fileIn);
+    QVERIFY(!t_stream.dirIndexEnabled());
+    QVERIFY(t_stream.open());
+    t_stream.close();
+
+    QVERIFY(!QFile::exists(m_sIndexName));
+
+    //
+    //   The tree is compiled by open() and stays valid after the stream was closed
+    //
+    QVERIFY(!t_stream.dirtree().isNull());
+    QCOMPARE(t_stream.dirtree()->dir_tree_find(FIFFB_RAW_DATA).size(), m_iRefRawBlocks);
+    QVERIFY(!m_fileIn.isOpen());
+
+    //
+    //   Raw data readers use the index
+    //
+    FiffRawData t_raw(m_fileIn);
+    QVERIFY(!t_raw.isEmpty());
+    QVERIFY(QFile::exists(m_sIndexName));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::blockTreeFromIndex()
+{
+    QFile::remove(m_sIndexName);
+
+    FiffStream t_refStream(&m_fileIn);
+    t_refStream.setDirIndexEnabled(true);
+    QVERIFY(t_refStream.open());
+    t_refStream.close();
+    QVERIFY(QFile::exists(m_sIndexName));
+
+    //
+    //   The tree built from the index matches the one built from the file
+    //
+    FiffStream t_stream(&m_fileIn);
+    t_stream.setDirIndexEnabled(true);
+    QVERIFY(t_stream.open());
+    t_stream.close();
+
+    QList<FiffDirNode::SPtr> t_refNodes;
+    QList<FiffDirNode::SPtr> t_nodes;
+    t_refNodes.append(t_refStream.dirtree());
+    t_nodes.append(t_stream.dirtree());
+    for(qint32 k = 0; k < t_refNodes.size(); ++k) {
+        QVERIFY(k < t_nodes.size());
+        QCOMPARE(t_nodes[k]->type, t_refNodes[k]->type);
+        QCOMPARE(t_nodes[k]->id.version, t_refNodes[k]->id.version);
+        QCOMPARE(t_nodes[k]->id.machid[0], t_refNodes[k]->id.machid[0]);
+        QCOMPARE(t_nodes[k]->id.machid[1], t_refNodes[k]->id.machid[1]);
+        QCOMPARE(t_nodes[k]->id.time.secs, t_refNodes[k]->id.time.secs);
+        QCOMPARE(t_nodes[k]->id.time.usecs, t_refNodes[k]->id.time.usecs);
+        QCOMPARE(t_nodes[k]->nent(), t_refNodes[k]->nent());
+        QCOMPARE(t_nodes[k]->nent_tree, t_refNodes[k]->nent_tree);
+        QCOMPARE(t_nodes[k]->children.size(), t_refNodes[k]->children.size());
+        t_refNodes.append(t_refNodes[k]->children);
+        t_nodes.append(t_nodes[k]->children);
+    }
+    QCOMPARE(t_nodes.size(), t_refNodes.size());
+
+    //
+    //   Patch the type of the first block below the root to see that block types really come from the index
+    //
+    QFile t_indexFile(m_sIndexName);
+    QVERIFY(t_indexFile.open(QIODevice::ReadWrite));
+    QByteArray t_baIndex = t_indexFile.readAll();
+    qint32 offset = 48 + 16 * m_refDir.size() + 4 + 6 * 4;
+    QVERIFY(t_baIndex.size() >= offset + 4);
+    qToBigEndian<qint32>(12345, (uchar*)t_baIndex.data() + offset);
+    t_indexFile.seek(0);
+    t_indexFile.write(t_baIndex);
+    t_indexFile.close();
+
+    FiffStream t_patchedStream(&m_fileIn);
+    t_patchedStream.setDirIndexEnabled(true);
+    QVERIFY(t_patchedStream.open());
+    t_patchedStream.close();
+
+    QVERIFY(!t_patchedStream.dirtree()->children.isEmpty());
+    QCOMPARE(t_patchedStream.dirtree()->children[0]->type, 12345);
+
+    QFile::remove(m_sIndexName);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::tagIterator()
+{
+    //
+    //   Walking the file tag by tag has to visit the directory entries in order
+    //
+    FiffStream t_stream(&m_fileIn);
+    QVERIFY(t_stream.open());
+
+    FiffTagIterator t_iterator(&t_stream);
+    FiffTag::SPtr t_pTag;
+    qint32 k = 0;
+    while(k < m_refDir.size() && m_refDir[k]->kind != -1)
+    {
+        QVERIFY(t_iterator.next());
+        QCOMPARE(t_iterator.header().kind, m_refDir[k]->kind);
+        QCOMPARE(t_iterator.header().type, m_refDir[k]->type);
+        QCOMPARE(t_iterator.header().size, m_refDir[k]->size);
+        QCOMPARE((fiff_int_t)t_iterator.header().pos, m_refDir[k]->pos);
+
+        //
+        //   The lazily read payload matches the allocating read
+        //
+        if(t_iterator.header().type == FIFFT_INT && t_iterator.header().size == 4)
+        {
+            qint32 value;
+            QVERIFY(t_iterator.payload().copy_data((char*)&value));
+            QVERIFY(t_stream.read_tag(t_pTag, m_refDir[k]->pos));
+            QCOMPARE(value, *t_pTag->toInt());
+        }
+        ++k;
+    }
+    t_stream.close();
+
+    QVERIFY(k > 0);
+    QCOMPARE(t_iterator.count(), (qint64)k);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffDirIndex::cleanupTestCase()
+{
+    QFile::remove(m_sIndexName);
+}
+
+
+//*************************************************************************************************************
+
+bool TestFiffDirIndex::sameDir(const QList<FiffDirEntry::SPtr>& dir) const
+{
+    if(dir.size() != m_refDir.size())
+        return false;
+
+    for(qint32 k = 0; k < dir.size(); ++k)
+        if(dir[k]->kind != m_refDir[k]->kind || dir[k]->type != m_refDir[k]->type
+                || dir[k]->size != m_refDir[k]->size || dir[k]->pos != m_refDir[k]->pos)
+            return false;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffDirIndex)
+#include "test_fiff_dir_index.moc"
@@ -0,0 +1,418 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_info_sharing.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the implicit sharing of the measurement info lists.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <fiff/fiff_evoked_set.h>
+#include <realtime/rtProcessing/rtave.h>
+
+#include <new>
+#include <stdlib.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace REALTIMELIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+static QAtomicInt g_iAllocations(0);   /**< Number of operator new calls, the list elements are allocated this way. RtAve allocates from its own thread. */
+
+
+//*************************************************************************************************************
+
+void* operator new(size_t size)
+{
+    g_iAllocations.ref();
+    void* p = malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+
+//*************************************************************************************************************
+
+void operator delete(void* p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+
+//*************************************************************************************************************
+
+void operator delete(void* p, size_t) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS BlockAllocationCounter
+*
+* @brief The BlockAllocationCounter class counts the allocations made between two evoked sets emitted by RtAve.
+*        Like the display it keeps a copy of each set, so RtAve updates a set which is shared. It has to be
+*        connected directly, its own allocations are not counted.
+*/
+class BlockAllocationCounter : public QObject
+{
+    Q_OBJECT
+
+public:
+    BlockAllocationCounter()
+    : m_iLast(-1)
+    {
+    }
+
+    //=========================================================================================================
+    /**
+    * Waits until iCount intervals were counted or iMsecs passed.
+    *
+    * @return true if iCount intervals were counted.
+    */
+    bool waitFor(int iCount, int iMsecs)
+    {
+        QMutexLocker locker(&m_qMutex);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        while(m_lAllocations.size() < iCount && timer.elapsed() < iMsecs) {
+            m_qCounted.wait(&m_qMutex, 100);
+        }
+
+        return m_lAllocations.size() >= iCount;
+    }
+
+    QList<int>          m_lAllocations;     /**< The allocations between consecutive emissions. */
+
+public slots:
+    void onEvokedStim(FIFFLIB::FiffEvokedSet::SPtr pEvokedSet)
+    {
+        int iNow = g_iAllocations.load();
+        QMutexLocker locker(&m_qMutex);
+
+        if(m_iLast >= 0) {
+            m_lAllocations.append(iNow - m_iLast);
+            m_qCounted.wakeAll();
+        }
+
+        m_evokedSet = *pEvokedSet;
+        m_iLast = g_iAllocations.load();
+    }
+
+private:
+    FiffEvokedSet       m_evokedSet;        /**< The copy of the last emitted set, as held by the display. */
+    int                 m_iLast;            /**< The allocation count when the last emission was handled, -1 before. */
+    QMutex              m_qMutex;           /**< Guards the counts. */
+    QWaitCondition      m_qCounted;         /**< Signaled for each counted interval. */
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffInfoSharing
+*
+* @brief The TestFiffInfoSharing class verifies that copies of a measurement info share the channel, digitizer
+*        and projector lists until one of the copies modifies them.
+*
+*/
+class TestFiffInfoSharing: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffInfoSharing();
+
+private slots:
+    void initTestCase();
+    void copyAllocations();
+    void evokedSetInfo();
+    void realtimeBlockAllocations();
+    void copyOnWrite();
+    void activateProjs();
+    void cleanupTestCase();
+
+private:
+    FiffInfo m_info;    /**< A Neuromag like measurement info. */
+};
+
+
+//*************************************************************************************************************
+
+TestFiffInfoSharing::TestFiffInfoSharing()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::initTestCase()
+{
+    //
+    //   306 MEG channels, 100 digitizer points and 3 active projectors
+    //
+    m_info.sfreq = 1000.0f;
+    m_info.nchan = 306;
+    for(qint32 k = 0; k < m_info.nchan; ++k)
+    {
+        FiffChInfo ch;
+        ch.scanNo = k + 1;
+        ch.logNo = k + 1;
+        ch.kind = FIFFV_MEG_CH;
+        ch.range = 1.0f;
+        ch.cal = 1.0f;
+        ch.unit = (k % 3 == 2) ? FIFF_UNIT_T : FIFF_UNIT_T_M;
+        ch.chpos.coil_type = (k % 3 == 2) ? FIFFV_COIL_VV_MAG_T3 : FIFFV_COIL_VV_PLANAR_T1;
+        ch.ch_name = QString("MEG %1").arg(k + 1, 4, 10, QChar('0'));
+        m_info.chs.append(ch);
+        m_info.ch_names.append(ch.ch_name);
+    }
+
+    for(qint32 k = 0; k < 100; ++k)
+    {
+        FiffDigPoint point;
+        point.kind = FIFFV_POINT_EXTRA;
+        point.ident = k + 1;
+        point.r[0] = point.r[1] = point.r[2] = 0.001f * k;
+        m_info.dig.append(point);
+    }
+
+    for(qint32 k = 0; k < 3; ++k)
+    {
+        FiffProj proj;
+        proj.kind = FIFFV_MNE_PROJ_ITEM_EEG_AVREF + k;
+        proj.active = true;
+        proj.desc = QString("PCA-v%1").arg(k + 1);
+        proj.data->nrow = 1;
+        proj.data->ncol = m_info.nchan;
+        proj.data->col_names = m_info.ch_names;
+        proj.data->data = MatrixXd::Constant(1, m_info.nchan, 1.0 / (k + 1));
+        m_info.projs.append(proj);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::copyAllocations()
+{
+    //
+    //   Copying and assigning must not allocate the list elements
+    //
+    g_iAllocations.store(0);
+    FiffInfo infoCopy(m_info);
+    FiffInfo infoAssigned;
+    infoAssigned = infoCopy;
+    FiffInfoBase infoBase(m_info);
+    int iAllocations = g_iAllocations.load();
+
+    QCOMPARE(iAllocations, 0);
+    QCOMPARE(infoCopy.chs.size(), m_info.chs.size());
+    QCOMPARE(infoAssigned.dig.size(), m_info.dig.size());
+    QCOMPARE(infoBase.chs.size(), m_info.chs.size());
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::evokedSetInfo()
+{
+    //
+    //   Handing the info to an evoked and storing the evoked in a set shares the lists
+    //
+    FiffEvoked evoked;
+    g_iAllocations.store(0);
+    evoked.setInfo(m_info, false);
+    int iSetInfo = g_iAllocations.load();
+
+    FiffEvokedSet evokedSet;
+    evokedSet.evoked.append(evoked);
+    g_iAllocations.store(0);
+    FiffEvokedSet evokedSetCopy(evokedSet);
+    evokedSetCopy.evoked[0].nave = 1;
+    int iDetach = g_iAllocations.load();
+
+    qDebug() << "Allocations of FiffEvoked::setInfo" << iSetInfo << "and of detaching a set with one evoked" << iDetach;
+    QCOMPARE(iSetInfo, 0);
+    QVERIFY(iDetach <= evokedSet.evoked.size());
+    QCOMPARE(evokedSet.evoked.at(0).nave, evoked.nave);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::realtimeBlockAllocations()
+{
+    //
+    //   RtAve updates the evoked of every completed epoch while the display holds a copy of the set. Each update
+    //   must not copy the channel, digitizer or projector lists, i.e., cost fewer allocations than channels.
+    //
+    FiffInfo::SPtr pFiffInfo(new FiffInfo(m_info));
+    int iTriggerCh = pFiffInfo->nchan - 1;
+    int iPreStim = 20;
+    int iPostStim = 50;
+    int iBlockSize = 100;
+    int iNumEpochs = 10;
+
+    RtAve rtAve(4, iPreStim, iPostStim, 0, 0, iTriggerCh, pFiffInfo);
+    rtAve.setAverageMode(0);
+
+    BlockAllocationCounter counter;
+    connect(&rtAve, &RtAve::evokedStim, &counter, &BlockAllocationCounter::onEvokedStim, Qt::DirectConnection);
+
+    //
+    //   Every epoch starts a group of four blocks, the trigger is at sample 50 of the first block
+    //
+    QList<MatrixXd> lBlocks;
+    for(int k = 0; k < iNumEpochs; ++k) {
+        for(int i = 0; i < 4; ++i) {
+            MatrixXd matBlock = MatrixXd::Random(pFiffInfo->nchan, iBlockSize);
+            matBlock.row(iTriggerCh).setZero();
+            if(i == 0) {
+                matBlock(iTriggerCh, 50) = 1.0;
+            }
+            lBlocks.append(matBlock);
+        }
+    }
+
+    rtAve.start();
+
+    for(int i = 0; i < lBlocks.size(); ++i) {
+        rtAve.append(lBlocks.at(i));
+    }
+
+    bool bCounted = counter.waitFor(iNumEpochs - 1, 10000);
+
+    rtAve.stop();
+    rtAve.wait();
+
+    QVERIFY(bCounted);
+
+    int iMax = 0;
+    for(int k = 0; k < counter.m_lAllocations.size(); ++k) {
+        iMax = qMax(iMax, counter.m_lAllocations.at(k));
+    }
+
+    qDebug() << "Allocations per evoked update (four blocks each):" << counter.m_lAllocations;
+    QVERIFY2(iMax < pFiffInfo->chs.size(), QString("%1 allocations for an evoked update of %2 channels").arg(iMax).arg(pFiffInfo->chs.size()).toUtf8().constData());
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::copyOnWrite()
+{
+    //
+    //   Modifying a copy detaches it and leaves the original untouched
+    //
+    FiffInfo infoCopy(m_info);
+
+    infoCopy.chs[0].ch_name = QString("MEG XXXX");
+    infoCopy.dig[0].ident = -1;
+    infoCopy.projs[0].active = false;
+    infoCopy.set_current_comp(3);
+
+    QCOMPARE(m_info.chs.at(0).ch_name, QString("MEG 0001"));
+    QCOMPARE(m_info.dig.at(0).ident, 1);
+    QCOMPARE(m_info.projs.at(0).active, true);
+    QCOMPARE(m_info.chs.at(1).chpos.coil_type, FIFFV_COIL_VV_PLANAR_T1);
+
+    QCOMPARE(infoCopy.chs.at(0).ch_name, QString("MEG XXXX"));
+    QCOMPARE(infoCopy.dig.at(0).ident, -1);
+    QCOMPARE(infoCopy.projs.at(0).active, false);
+    QCOMPARE(infoCopy.chs.at(1).chpos.coil_type >> 16, 3);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::activateProjs()
+{
+    //
+    //   Activating already active projectors keeps the list shared
+    //
+    QList<FiffProj> projs = m_info.projs;
+
+    g_iAllocations.store(0);
+    FiffProj::activate_projs(projs);
+    int iAllocations = g_iAllocations.load();
+    QCOMPARE(iAllocations, 0);
+
+    projs[1].active = false;
+    FiffProj::activate_projs(projs);
+    QCOMPARE(projs.at(1).active, true);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffInfoSharing::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffInfoSharing)
+#include "test_fiff_info_sharing.moc"
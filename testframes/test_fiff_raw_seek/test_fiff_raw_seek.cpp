@@ -0,0 +1,526 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_raw_seek.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the indexed raw buffer lookup of FiffRawData and benchmark of the seek cost across file offsets
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <fiff/fiff_tag_view.h>
+
+#include <iostream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QThreadPool>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffRawSeek
+*
+* @brief The TestFiffRawSeek class verifies the sample-to-buffer lookup of FiffRawData, compares memory mapped
+*        with device reads and benchmarks read_raw_segment at different file offsets. The reported latency should
+*        not depend on the offset.
+*
+*/
+class TestFiffRawSeek: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffRawSeek();
+
+private slots:
+    void initTestCase();
+    void findRawdirEntry();
+    void compareSeekedSegments();
+    void compareFloatSegments();
+    void cachedOperator();
+    void bufferCache();
+    void memoryMapped();
+    void mappedTagPosition();
+    void benchmarkSeek_data();
+    void benchmarkSeek();
+    void benchmarkFullRead_data();
+    void benchmarkFullRead();
+    void cleanupTestCase();
+
+private:
+    double epsilon;
+
+    QFile m_fileIn;
+    FiffRawData m_raw;
+
+    MatrixXd m_matFullData;
+};
+
+
+//*************************************************************************************************************
+
+TestFiffRawSeek::TestFiffRawSeek()
+: epsilon(0.000001)
+, m_fileIn("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif")
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::initTestCase()
+{
+    qDebug() << "Epsilon" << epsilon;
+
+    m_raw = FiffRawData(m_fileIn);
+    QVERIFY(!m_raw.isEmpty());
+    QVERIFY(m_raw.rawdir.size() > 2);
+
+    //
+    //   Decode the buffers tag by tag as reference, independent of the buffer lookup and the readers under test.
+    //   The sample file has neither projectors nor compensation set up, so calibration is all that is applied.
+    //
+    QVERIFY(m_raw.proj.size() == 0);
+    QVERIFY(m_raw.comp.kind == -1);
+
+    QFile t_fileRef(m_fileIn.fileName());
+    FiffStream t_streamRef(&t_fileRef);
+    QVERIFY(t_streamRef.open());
+
+    fiff_int_t nchan = m_raw.info.nchan;
+    m_matFullData = MatrixXd::Zero(nchan, m_raw.last_samp - m_raw.first_samp + 1);
+    for(qint32 k = 0; k < m_raw.rawdir.size(); ++k)
+    {
+        const FiffRawDir& dir = m_raw.rawdir[k];
+        if(!dir.ent || dir.ent->kind == -1)
+            continue;
+
+        FiffTag::SPtr t_pTag;
+        QVERIFY(t_streamRef.read_tag(t_pTag, dir.ent->pos));
+
+        MatrixXd buf;
+        if(t_pTag->type == FIFFT_DAU_PACK16)
+            buf = Map< Matrix<qint16,Dynamic,Dynamic> >(t_pTag->toDauPack16(), nchan, dir.nsamp).cast<double>();
+        else if(t_pTag->type == FIFFT_INT)
+            buf = Map< Matrix<qint32,Dynamic,Dynamic> >(t_pTag->toInt(), nchan, dir.nsamp).cast<double>();
+        else if(t_pTag->type == FIFFT_FLOAT)
+            buf = Map< MatrixXf >(t_pTag->toFloat(), nchan, dir.nsamp).cast<double>();
+        else
+            QFAIL("Unexpected raw data buffer type");
+
+        m_matFullData.middleCols(dir.first - m_raw.first_samp, dir.nsamp) = m_raw.cals.asDiagonal() * buf;
+    }
+    t_streamRef.close();
+
+    //
+    //   Reading the whole file has to reproduce it
+    //
+    MatrixXd data, times;
+    QVERIFY(m_raw.read_raw_segment(data, times, m_raw.first_samp, m_raw.last_samp));
+    QCOMPARE(data.rows(), m_matFullData.rows());
+    QCOMPARE(data.cols(), m_matFullData.cols());
+    QVERIFY((data - m_matFullData).cwiseAbs().maxCoeff() < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::findRawdirEntry()
+{
+    for(qint32 k = 0; k < m_raw.rawdir.size(); ++k)
+    {
+        QCOMPARE(m_raw.find_rawdir_entry(m_raw.rawdir[k].first), k);
+        QCOMPARE(m_raw.find_rawdir_entry(m_raw.rawdir[k].last), k);
+    }
+
+    QCOMPARE(m_raw.find_rawdir_entry(m_raw.first_samp - 1), -1);
+    QCOMPARE(m_raw.find_rawdir_entry(m_raw.last_samp + 1), -1);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::compareSeekedSegments()
+{
+    MatrixXd data, times;
+    fiff_int_t nsamp = m_raw.rawdir[0].nsamp;
+
+    //
+    //   Segments starting at the beginning, the middle and the last sample of a buffer
+    //
+    for(qint32 k = 0; k < m_raw.rawdir.size() - 1; ++k)
+    {
+        const FiffRawDir& dir = m_raw.rawdir[k];
+        QList<fiff_int_t> starts;
+        starts << dir.first << dir.first + dir.nsamp/2 << dir.last;
+
+        for(qint32 i = 0; i < starts.size(); ++i)
+        {
+            fiff_int_t from = starts[i];
+            fiff_int_t to = qMin(from + nsamp, m_raw.last_samp);
+
+            QVERIFY(m_raw.read_raw_segment(data, times, from, to));
+            QCOMPARE((fiff_int_t)data.cols(), to - from + 1);
+
+            MatrixXd diff = data - m_matFullData.block(0, from - m_raw.first_samp, data.rows(), data.cols());
+            QVERIFY(diff.cwiseAbs().maxCoeff() < epsilon);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::compareFloatSegments()
+{
+    fiff_int_t nsamp = m_raw.rawdir[0].nsamp;
+    fiff_int_t from = m_raw.rawdir[1].first + nsamp/3;
+    fiff_int_t to = from + 2*nsamp;
+
+    MatrixXd ref = m_matFullData.block(0, from - m_raw.first_samp, m_matFullData.rows(), to - from + 1);
+    double tol = ref.cwiseAbs().maxCoeff() * 1e-6;
+
+    //
+    //   Column major, written into a sub block of a larger matrix
+    //
+    MatrixXf block(m_raw.info.nchan, to - from + 11);
+    QVERIFY(m_raw.read_raw_segment(block.rightCols(to - from + 1), from, to));
+    QVERIFY((block.rightCols(to - from + 1).cast<double>() - ref).cwiseAbs().maxCoeff() < tol);
+
+    //
+    //   Row major
+    //
+    Matrix<float,Dynamic,Dynamic,RowMajor> rowMajor(m_raw.info.nchan, to - from + 1);
+    QVERIFY(m_raw.read_raw_segment(rowMajor, from, to));
+    QVERIFY((rowMajor.cast<double>() - ref).cwiseAbs().maxCoeff() < tol);
+
+    //
+    //   Channel selection
+    //
+    RowVectorXi sel(3);
+    sel << 0, 2, m_raw.info.nchan - 1;
+    MatrixXf selData(sel.size(), to - from + 1);
+    QVERIFY(m_raw.read_raw_segment(selData, from, to, sel));
+    for(qint32 r = 0; r < sel.size(); ++r)
+        QVERIFY((selData.row(r).cast<double>() - ref.row(sel[r])).cwiseAbs().maxCoeff() < tol);
+
+    //
+    //   Wrong output size and out of range requests are rejected
+    //
+    MatrixXf wrong(m_raw.info.nchan, to - from);
+    QVERIFY(!m_raw.read_raw_segment(wrong, from, to));
+    QVERIFY(!m_raw.read_raw_segment(block.leftCols(10), m_raw.last_samp - 4, m_raw.last_samp + 5));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::cachedOperator()
+{
+    FiffRawData raw(m_raw);
+    fiff_int_t from = raw.rawdir[1].first;
+    fiff_int_t to = from + raw.rawdir[1].nsamp - 1;
+
+    MatrixXd data, times;
+    MatrixXd ref = m_matFullData.block(0, from - raw.first_samp, m_matFullData.rows(), to - from + 1);
+
+    //
+    //   A changed projector has to be picked up by the next read, and dropped again when it is removed
+    //
+    MatrixXd proj = 2.0*MatrixXd::Identity(raw.info.nchan, raw.info.nchan);
+    raw.proj = proj;
+    QVERIFY(raw.read_raw_segment(data, times, from, to));
+    QVERIFY((data - 2.0*ref).cwiseAbs().maxCoeff() < epsilon);
+
+    raw.proj(0,0) = 3.0;
+    QVERIFY(raw.read_raw_segment(data, times, from, to));
+    QVERIFY((data.row(0) - 3.0*ref.row(0)).cwiseAbs().maxCoeff() < epsilon);
+
+    raw.proj = MatrixXd();
+    QVERIFY(raw.read_raw_segment(data, times, from, to));
+    QVERIFY((data - ref).cwiseAbs().maxCoeff() < epsilon);
+
+    //
+    //   Same for the selection
+    //
+    RowVectorXi sel(2);
+    sel << 1, 0;
+    QVERIFY(raw.read_raw_segment(data, times, from, to, sel));
+    QVERIFY((data.row(0) - ref.row(1)).cwiseAbs().maxCoeff() < epsilon);
+    QVERIFY((data.row(1) - ref.row(0)).cwiseAbs().maxCoeff() < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::bufferCache()
+{
+    FiffRawData raw(m_raw);
+    QVERIFY(raw.rawdir.size() > 5);
+    raw.setBufferCacheSize(64*1024*1024);
+    QCOMPARE(raw.bufferCacheHits(), (qint64)0);
+
+    fiff_int_t from = raw.rawdir[1].first + raw.rawdir[1].nsamp/2;
+    fiff_int_t to = raw.rawdir[3].first + raw.rawdir[3].nsamp/2;
+
+    MatrixXd data, times;
+    MatrixXd ref = m_matFullData.block(0, from - raw.first_samp, m_matFullData.rows(), to - from + 1);
+
+    //
+    //   First read fills the cache, the overlapping second read is served from it
+    //
+    QVERIFY(raw.read_raw_segment(data, times, from, to));
+    QCOMPARE(raw.bufferCacheHits(), (qint64)0);
+    QCOMPARE(raw.bufferCacheMisses(), (qint64)3);
+
+    QVERIFY(raw.read_raw_segment(data, times, from + 1, to + raw.rawdir[4].nsamp));
+    QCOMPARE(raw.bufferCacheHits(), (qint64)3);
+    QCOMPARE(raw.bufferCacheMisses(), (qint64)4);
+
+    QVERIFY(raw.read_raw_segment(data, times, from, to));
+    QVERIFY((data - ref).cwiseAbs().maxCoeff() < epsilon);
+
+    //
+    //   Cached buffers are not calibrated yet, a selection still applies
+    //
+    RowVectorXi sel(1);
+    sel << 2;
+    QVERIFY(raw.read_raw_segment(data, times, from, to, sel));
+    QVERIFY((data.row(0) - ref.row(2)).cwiseAbs().maxCoeff() < epsilon);
+
+    raw.clearBufferCache();
+    QCOMPARE(raw.bufferCacheHits(), (qint64)0);
+    QCOMPARE(raw.bufferCacheMisses(), (qint64)0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::memoryMapped()
+{
+    //
+    //   A raw data object of its own, copies share the streams and would map the reference as well
+    //
+    QFile t_fileMapped(m_fileIn.fileName());
+    FiffRawData rawMapped(t_fileMapped);
+    QVERIFY(!rawMapped.isEmpty());
+    rawMapped.setMemoryMapped(true);
+    QVERIFY(rawMapped.isMemoryMapped());
+
+    MatrixXd data, dataMapped, times;
+    fiff_int_t nsamp = m_raw.rawdir[0].nsamp;
+
+    //
+    //   Within one buffer, across buffers and the whole file
+    //
+    QList<QPair<fiff_int_t,fiff_int_t> > segments;
+    segments << qMakePair(m_raw.first_samp, m_raw.first_samp + nsamp/2)
+             << qMakePair(m_raw.rawdir[1].first + nsamp/3, m_raw.rawdir[1].first + 3*nsamp)
+             << qMakePair(m_raw.first_samp, m_raw.last_samp);
+
+    for(qint32 i = 0; i < segments.size(); ++i)
+    {
+        QVERIFY(m_raw.read_raw_segment(data, times, segments[i].first, segments[i].second));
+        QVERIFY(rawMapped.read_raw_segment(dataMapped, times, segments[i].first, segments[i].second));
+        QVERIFY(rawMapped.file->isMapped());
+        QVERIFY(!m_raw.file->isMapped());
+
+        QCOMPARE(dataMapped.rows(), data.rows());
+        QCOMPARE(dataMapped.cols(), data.cols());
+        QVERIFY(dataMapped == data);
+    }
+
+    //
+    //   Single precision
+    //
+    fiff_int_t from = segments[1].first;
+    fiff_int_t to = segments[1].second;
+    MatrixXf dataF(m_raw.info.nchan, to - from + 1), dataMappedF(m_raw.info.nchan, to - from + 1);
+    QVERIFY(m_raw.read_raw_segment(dataF, from, to));
+    QVERIFY(rawMapped.read_raw_segment(dataMappedF, from, to));
+    QVERIFY(dataMappedF == dataF);
+
+    //
+    //   Unmapping falls back to the device
+    //
+    rawMapped.setMemoryMapped(false);
+    QVERIFY(!rawMapped.file->isMapped());
+    QVERIFY(rawMapped.read_raw_segment(dataMapped, times, from, to));
+    QVERIFY(m_raw.read_raw_segment(data, times, from, to));
+    QVERIFY(dataMapped == data);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::mappedTagPosition()
+{
+    QFile t_file(m_fileIn.fileName());
+    QFile t_fileMapped(m_fileIn.fileName());
+    FiffStream t_stream(&t_file);
+    FiffStream t_streamMapped(&t_fileMapped);
+    QVERIFY(t_stream.open());
+    QVERIFY(t_streamMapped.open());
+    QVERIFY(t_streamMapped.map());
+
+    //
+    //   A positioned read followed by sequential reads has to visit the same tags whether mapped or not
+    //
+    FiffTag::SPtr t_pTag, t_pTagMapped;
+    QList<FiffDirEntry::SPtr> dir = t_stream.dir();
+    for(qint32 k = 0; k < dir.size() && dir[k]->kind != -1; k += qMax(1, dir.size()/50))
+    {
+        QVERIFY(t_stream.read_tag(t_pTag, dir[k]->pos));
+        QVERIFY(t_streamMapped.read_tag(t_pTagMapped, dir[k]->pos));
+        QCOMPARE(t_pTagMapped->kind, t_pTag->kind);
+
+        for(qint32 i = 0; i < 2 && k + i + 1 < dir.size() && dir[k + i + 1]->kind != -1; ++i)
+        {
+            QCOMPARE(t_streamMapped.device()->pos(), t_stream.device()->pos());
+
+            QVERIFY(t_stream.read_tag(t_pTag));
+            QVERIFY(t_streamMapped.read_tag(t_pTagMapped));
+            QCOMPARE(t_pTagMapped->kind, t_pTag->kind);
+            QCOMPARE(t_pTagMapped->type, t_pTag->type);
+            QCOMPARE(t_pTagMapped->size(), t_pTag->size());
+            QVERIFY(*t_pTagMapped == *t_pTag);
+        }
+
+        //
+        //   The header only read leaves the device behind the header
+        //
+        FiffTagView t_view, t_viewMapped;
+        QVERIFY(t_stream.read_tag_header(t_view, dir[k]->pos));
+        QVERIFY(t_streamMapped.read_tag_header(t_viewMapped, dir[k]->pos));
+        QCOMPARE(t_viewMapped.kind, t_view.kind);
+        QCOMPARE(t_streamMapped.device()->pos(), t_stream.device()->pos());
+    }
+
+    t_stream.close();
+    t_streamMapped.close();
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::benchmarkSeek_data()
+{
+    QTest::addColumn<double>("offset");
+
+    QTest::newRow("begin") << 0.0;
+    QTest::newRow("25%") << 0.25;
+    QTest::newRow("50%") << 0.5;
+    QTest::newRow("75%") << 0.75;
+    QTest::newRow("end") << 0.95;
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::benchmarkSeek()
+{
+    QFETCH(double, offset);
+
+    fiff_int_t nsamp = m_raw.rawdir[0].nsamp;
+    fiff_int_t from = m_raw.first_samp + (fiff_int_t)(offset * (m_raw.last_samp - m_raw.first_samp - nsamp));
+    fiff_int_t to = from + nsamp - 1;
+
+    MatrixXd data, times;
+
+    QBENCHMARK {
+        m_raw.read_raw_segment(data, times, from, to);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::benchmarkFullRead_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all threads") << QThread::idealThreadCount();
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::benchmarkFullRead()
+{
+    QFETCH(int, threads);
+
+    int iMaxThreads = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    MatrixXd data, times;
+
+    QBENCHMARK {
+        m_raw.read_raw_segment(data, times, m_raw.first_samp, m_raw.last_samp);
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(iMaxThreads);
+
+    QVERIFY((data - m_matFullData).cwiseAbs().maxCoeff() < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawSeek::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffRawSeek)
+#include "test_fiff_raw_seek.moc"
@@ -0,0 +1,297 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_resample.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    The raw data resampling test implementation
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <fiff/fiff_raw_resampler.h>
+
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffResample
+*
+* @brief The TestFiffResample class resamples a synthetic recording and verifies the signals, the time axis and
+*        the trigger positions of the output.
+*
+*/
+class TestFiffResample: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffResample();
+
+private slots:
+    void initTestCase();
+    void decimate();
+    void bufferSizes();
+    void rationalFactor();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Resamples the synthetic recording and reads the output back.
+    */
+    bool resample(const FiffRawResampler& resampler, const QString& fileName, qint32 nBufferSize, FiffRawData& rawOut, MatrixXd& dataOut);
+
+    //=========================================================================================================
+    /**
+    * Compares the filtered channels of the output with the signals at the output sampling times.
+    */
+    void compareSignals(const FiffRawData& rawOut, const MatrixXd& dataOut, double dTolerance);
+
+    QString     m_sFileIn;      /**< The synthetic recording. */
+    QStringList m_listFiles;    /**< The written files. */
+    fiff_int_t  m_iFirstSamp;   /**< First sample of the synthetic recording. */
+    float       m_fSFreq;       /**< Sampling frequency of the synthetic recording. */
+    MatrixXi    m_matEvents;    /**< Trigger events of the synthetic recording. */
+};
+
+
+//*************************************************************************************************************
+
+TestFiffResample::TestFiffResample()
+: m_sFileIn("./mne-cpp-test-data/MEG/sample/test_fiff_resample_raw.fif")
+, m_iFirstSamp(1000)
+, m_fSFreq(1000.0f)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffResample::initTestCase()
+{
+    //
+    //   10 s with a 5 Hz signal plus a 400 Hz signal (which folds onto DC at 200 Hz), a 30 Hz signal and a
+    //   stimulus channel with two short triggers
+    //
+    qint32 nsamp = 10007;
+
+    FiffInfo info;
+    info.sfreq = m_fSFreq;
+    info.lowpass = 330.0f;
+    info.nchan = 3;
+    for(qint32 k = 0; k < info.nchan; ++k)
+    {
+        FiffChInfo ch;
+        ch.scanNo = k + 1;
+        ch.logNo = k + 1;
+        ch.kind = (k == 2) ? FIFFV_STIM_CH : FIFFV_MISC_CH;
+        ch.range = 1.0f;
+        ch.cal = 1.0f;
+        ch.unit = FIFF_UNIT_V;
+        ch.ch_name = (k == 2) ? QString("STI 014") : QString("MISC %1").arg(k + 1);
+        info.chs.append(ch);
+        info.ch_names.append(ch.ch_name);
+    }
+
+    m_matEvents.resize(2, 3);
+    m_matEvents << m_iFirstSamp + 3003, 0, 5,
+                   m_iFirstSamp + 7777, 0, 3;
+
+    MatrixXd data = MatrixXd::Zero(info.nchan, nsamp);
+    for(qint32 i = 0; i < nsamp; ++i)
+    {
+        double t = (m_iFirstSamp + i) / m_fSFreq;
+        data(0, i) = sin(2.0 * M_PI * 5.0 * t) + sin(2.0 * M_PI * 400.0 * t) + 0.5;
+        data(1, i) = sin(2.0 * M_PI * 30.0 * t);
+    }
+    for(qint32 e = 0; e < m_matEvents.rows(); ++e)
+        data.block(2, m_matEvents(e, 0) - m_iFirstSamp, 1, 2).setConstant(m_matEvents(e, 2));
+
+    QFile t_fileIn(m_sFileIn);
+    RowVectorXd cals;
+    FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_fileIn, info, cals);
+    QVERIFY(outfid);
+    outfid->write_int(FIFF_FIRST_SAMPLE, &m_iFirstSamp);
+    for(qint32 first = 0; first < nsamp; first += 1000)
+        outfid->write_raw_buffer(data.middleCols(first, qMin(1000, nsamp - first)).eval(), cals);
+    outfid->finish_writing_raw();
+    m_listFiles << m_sFileIn;
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffResample::decimate()
+{
+    FiffRawResampler resampler(1, 5);
+    FiffRawData rawOut;
+    MatrixXd dataOut;
+    QVERIFY(resample(resampler, "./mne-cpp-test-data/MEG/sample/test_fiff_resample_1_5_raw.fif", 1000, rawOut, dataOut));
+
+    QCOMPARE(rawOut.info.sfreq, 200.0f);
+    QVERIFY(rawOut.info.lowpass <= 90.0f + 1e-3f);
+    QCOMPARE(rawOut.first_samp, m_iFirstSamp / 5);
+    QCOMPARE((qint32)dataOut.cols(), (10007 + 4) / 5);
+
+    //
+    //   The 5 Hz and 30 Hz signals pass, the 400 Hz signal must not fold onto DC
+    //
+    compareSignals(rawOut, dataOut, 1e-3);
+
+    //
+    //   The triggers are found where the mapped events are
+    //
+    MatrixXi events = resampler.resample_events(m_matEvents, m_iFirstSamp);
+    for(qint32 e = 0; e < events.rows(); ++e)
+    {
+        qint32 col = events(e, 0) - rawOut.first_samp;
+        QCOMPARE((qint32)dataOut(2, col), m_matEvents(e, 2));
+        QCOMPARE((qint32)dataOut(2, col - 1), 0);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffResample::bufferSizes()
+{
+    //
+    //   The output must not depend on how the recording is split into buffers
+    //
+    FiffRawResampler resampler(1, 5);
+    FiffRawData rawLarge, rawSmall;
+    MatrixXd dataLarge, dataSmall;
+    QVERIFY(resample(resampler, "./mne-cpp-test-data/MEG/sample/test_fiff_resample_large_raw.fif", 2000, rawLarge, dataLarge));
+    QVERIFY(resample(resampler, "./mne-cpp-test-data/MEG/sample/test_fiff_resample_small_raw.fif", 97, rawSmall, dataSmall));
+
+    QCOMPARE(dataSmall.cols(), dataLarge.cols());
+    QVERIFY(dataSmall == dataLarge);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffResample::rationalFactor()
+{
+    FiffRawResampler resampler(2, 3);
+    FiffRawData rawOut;
+    MatrixXd dataOut;
+    QVERIFY(resample(resampler, "./mne-cpp-test-data/MEG/sample/test_fiff_resample_2_3_raw.fif", 500, rawOut, dataOut));
+
+    QVERIFY(qAbs(rawOut.info.sfreq - 2000.0f / 3.0f) < 1e-3f);
+    QCOMPARE((qint32)dataOut.cols(), (10007 * 2 + 2) / 3);
+    compareSignals(rawOut, dataOut, 5e-3);
+
+    MatrixXi events = resampler.resample_events(m_matEvents, m_iFirstSamp);
+    for(qint32 e = 0; e < events.rows(); ++e)
+    {
+        qint32 col = events(e, 0) - rawOut.first_samp;
+        QCOMPARE((qint32)dataOut(2, col), m_matEvents(e, 2));
+        QCOMPARE((qint32)dataOut(2, col - 1), 0);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffResample::cleanupTestCase()
+{
+    for(qint32 i = 0; i < m_listFiles.size(); ++i)
+        QFile::remove(m_listFiles[i]);
+}
+
+
+//*************************************************************************************************************
+
+bool TestFiffResample::resample(const FiffRawResampler& resampler, const QString& fileName, qint32 nBufferSize, FiffRawData& rawOut, MatrixXd& dataOut)
+{
+    QFile t_fileIn(m_sFileIn);
+    FiffRawData rawIn(t_fileIn);
+
+    QFile t_fileOut(fileName);
+    m_listFiles << fileName;
+    if(!resampler.resample(rawIn, t_fileOut, FIFFT_FLOAT, nBufferSize))
+        return false;
+
+    QFile t_fileRead(fileName);
+    rawOut = FiffRawData(t_fileRead);
+    MatrixXd times;
+    return rawOut.read_raw_segment(dataOut, times, rawOut.first_samp, rawOut.last_samp);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffResample::compareSignals(const FiffRawData& rawOut, const MatrixXd& dataOut, double dTolerance)
+{
+    //
+    //   The output keeps the time axis of the input, away from the edges the signals have to match
+    //
+    double dStep = m_fSFreq / rawOut.info.sfreq;
+    double dMaxError = 0.0;
+    for(qint32 n = 100; n < dataOut.cols() - 100; ++n)
+    {
+        double t = (m_iFirstSamp + n * dStep) / m_fSFreq;
+        dMaxError = qMax(dMaxError, qAbs(dataOut(0, n) - sin(2.0 * M_PI * 5.0 * t) - 0.5));
+        dMaxError = qMax(dMaxError, qAbs(dataOut(1, n) - sin(2.0 * M_PI * 30.0 * t)));
+    }
+    QVERIFY2(dMaxError < dTolerance, QString("Maximal error %1").arg(dMaxError).toUtf8().constData());
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffResample)
+#include "test_fiff_resample.moc"
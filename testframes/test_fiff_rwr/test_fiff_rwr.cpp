@@ -40,6 +40,7 @@
 //=============================================================================================================
 
 #include <fiff/fiff.h>
+#include <fiff/fiff_raw_writer.h>
 
 #include <iostream>
 
@@ -78,6 +79,11 @@ private slots:
     void compareData();
     void compareTimes();
     void compareInfo();
+    void compareBulkWriters();
+    void asyncRawWriter();
+    void compactRawStorage();
+    void compressedRawStorage();
+    void splitRawFiles();
     void cleanupTestCase();
 
 private:
@@ -319,6 +325,273 @@ void TestFiffRWR::compareInfo()
     }
 }
 
+//*************************************************************************************************************
+
+void TestFiffRWR::compareBulkWriters()
+{
+    //
+    //   The block based writers have to produce the same bytes as element wise big endian serialization
+    //
+    qint32 nel = 1001;
+    VectorXf vecFloat = VectorXf::Random(nel);
+    VectorXi vecInt = VectorXi::Random(nel);
+    VectorXd vecDouble = VectorXd::Random(nel);
+    MatrixXf matFloat = MatrixXf::Random(7, 13);
+    MatrixXi matInt = MatrixXi::Random(5, 3);
+
+    QByteArray baOut;
+    FiffStream t_Stream(&baOut, QIODevice::WriteOnly);
+    t_Stream.write_float(FIFF_DATA_BUFFER, vecFloat.data(), nel);
+    t_Stream.write_int(FIFF_FIRST_SAMPLE, vecInt.data(), nel);
+    t_Stream.write_double(FIFF_MNE_COV, vecDouble.data(), nel);
+    t_Stream.write_float_matrix(FIFF_PROJ_ITEM_VECTORS, matFloat);
+    t_Stream.write_int_matrix(FIFF_MNE_SOURCE_SPACE_TRIANGLES, matInt);
+
+    QByteArray baRef;
+    QDataStream t_Ref(&baRef, QIODevice::WriteOnly);
+    t_Ref.setByteOrder(QDataStream::BigEndian);
+    t_Ref.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    qint32 i, j;
+
+    t_Ref << (qint32)FIFF_DATA_BUFFER << (qint32)FIFFT_FLOAT << (qint32)(4*nel) << (qint32)FIFFV_NEXT_SEQ;
+    for(i = 0; i < nel; ++i)
+        t_Ref << vecFloat[i];
+
+    t_Ref << (qint32)FIFF_FIRST_SAMPLE << (qint32)FIFFT_INT << (qint32)(4*nel) << (qint32)FIFFV_NEXT_SEQ;
+    for(i = 0; i < nel; ++i)
+        t_Ref << vecInt[i];
+
+    t_Ref << (qint32)FIFF_MNE_COV << (qint32)FIFFT_DOUBLE << (qint32)(8*nel) << (qint32)FIFFV_NEXT_SEQ;
+    t_Ref.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    for(i = 0; i < nel; ++i)
+        t_Ref << vecDouble[i];
+    t_Ref.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    t_Ref << (qint32)FIFF_PROJ_ITEM_VECTORS << (qint32)FIFFT_MATRIX_FLOAT << (qint32)(4*matFloat.size() + 12) << (qint32)FIFFV_NEXT_SEQ;
+    for(i = 0; i < matFloat.rows(); ++i)
+        for(j = 0; j < matFloat.cols(); ++j)
+            t_Ref << matFloat(i,j);
+    t_Ref << (qint32)matFloat.cols() << (qint32)matFloat.rows() << (qint32)2;
+
+    t_Ref << (qint32)FIFF_MNE_SOURCE_SPACE_TRIANGLES << (qint32)FIFFT_MATRIX_INT << (qint32)(4*matInt.size() + 12) << (qint32)FIFFV_NEXT_SEQ;
+    for(i = 0; i < matInt.rows(); ++i)
+        for(j = 0; j < matInt.cols(); ++j)
+            t_Ref << matInt(i,j);
+    t_Ref << (qint32)matInt.cols() << (qint32)matInt.rows() << (qint32)2;
+
+    QCOMPARE(baOut.size(), baRef.size());
+    QVERIFY(baOut == baRef);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::asyncRawWriter()
+{
+    //
+    //   Buffers written by the writer thread have to end up exactly like synchronously written ones
+    //
+    qint32 nchan = 16;
+    qint32 nsamp = 100;
+    QList<MatrixXf> buffers;
+    for(qint32 i = 0; i < 50; ++i)
+        buffers.append(MatrixXf::Random(nchan, nsamp));
+
+    QByteArray baRef;
+    FiffStream t_Ref(&baRef, QIODevice::WriteOnly);
+    for(qint32 i = 0; i < buffers.size(); ++i)
+        t_Ref.write_raw_buffer(buffers[i]);
+
+    QByteArray baOut;
+    FiffStream::SPtr t_pStream(new FiffStream(&baOut, QIODevice::WriteOnly));
+    FiffRawWriter t_Writer(t_pStream, nchan, nsamp, 4);
+    t_Writer.start();
+    for(qint32 i = 0; i < buffers.size(); ++i)
+        QVERIFY(t_Writer.write_raw_buffer(buffers[i]));
+    QVERIFY(t_Writer.flush());
+    t_Writer.stop();
+
+    QCOMPARE(t_Writer.writtenBuffers(), (qint64)buffers.size());
+    QCOMPARE(t_Writer.droppedBuffers(), (qint64)0);
+    QCOMPARE(t_Writer.queueDepth(), 0);
+    QVERIFY(t_Writer.maxQueueDepth() <= 4);
+    QVERIFY(baOut == baRef);
+
+    //
+    //   A full ring drops buffers in non-blocking mode
+    //
+    QByteArray baDrop;
+    FiffStream::SPtr t_pDropStream(new FiffStream(&baDrop, QIODevice::WriteOnly));
+    FiffRawWriter t_DropWriter(t_pDropStream, nchan, nsamp, 2);
+    t_DropWriter.setBlocking(false);
+    QVERIFY(t_DropWriter.write_raw_buffer(buffers[0]));
+    QVERIFY(t_DropWriter.write_raw_buffer(buffers[1]));
+    QVERIFY(!t_DropWriter.write_raw_buffer(buffers[2]));
+    QCOMPARE(t_DropWriter.droppedBuffers(), (qint64)1);
+    QCOMPARE(t_DropWriter.maxQueueDepth(), 2);
+
+    t_DropWriter.start();
+    t_DropWriter.stop();
+    QCOMPARE(t_DropWriter.writtenBuffers(), (qint64)2);
+    QCOMPARE(baDrop.size(), 2*(16 + 4*nchan*nsamp));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compactRawStorage()
+{
+    //
+    //   Integer storage has to reproduce the data within the reported per channel rounding error
+    //
+    RowVectorXd maxValues = first_in_data.cwiseAbs().rowwise().maxCoeff().transpose();
+
+    QList<fiff_int_t> types;
+    types << FIFFT_INT << FIFFT_DAU_PACK16;
+
+    for(qint32 t = 0; t < types.size(); ++t)
+    {
+        QFile t_fileOut(QString("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_type%1_out.fif").arg(types[t]));
+
+        RowVectorXd cals;
+        FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_fileOut, first_in_raw.info, cals, defaultMatrixXi, false, types[t], maxValues);
+        outfid->write_raw_buffer(first_in_data, cals);
+
+        RowVectorXd error = outfid->raw_quantization_error();
+        RowVectorXi clipped = outfid->raw_clipped_samples();
+        outfid->finish_writing_raw();
+
+        QCOMPARE(error.size(), (int)first_in_data.rows());
+        QCOMPARE(clipped.sum(), 0);
+
+        FiffRawData t_raw(t_fileOut);
+        MatrixXd data, times;
+        QVERIFY(t_raw.read_raw_segment(data, times, t_raw.first_samp, t_raw.first_samp + first_in_data.cols() - 1));
+        QCOMPARE(data.cols(), first_in_data.cols());
+
+        for(qint32 k = 0; k < data.rows(); ++k)
+        {
+            double tol = 1e-6 * maxValues[k];
+            QVERIFY((data.row(k) - first_in_data.row(k)).cwiseAbs().maxCoeff() <= error[k] + tol);
+            if(types[t] == FIFFT_DAU_PACK16 && maxValues[k] > 0)
+                QVERIFY(error[k] <= 0.5 * maxValues[k] / 32767.0 + tol);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compressedRawStorage()
+{
+    //
+    //   The compressed integer storage has to be lossless with respect to the plain integer storage
+    //
+    QList<fiff_int_t> types;
+    types << FIFFT_INT << FIFFT_INT_DELTA_RICE;
+
+    qint32 nsamp = 100;
+    QList<MatrixXd> data;
+    QList<qint64> sizes;
+    for(qint32 t = 0; t < types.size(); ++t)
+    {
+        QFile t_fileOut(QString("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_type%1_out.fif").arg(types[t]));
+
+        RowVectorXd cals;
+        if(types[t] == FIFFT_INT_DELTA_RICE)
+        {
+            //
+            //   Compressed storage is refused before anything is written unless allowed explicitly
+            //
+            t_fileOut.remove();
+            QVERIFY(!FiffStream::start_writing_raw(t_fileOut, first_in_raw.info, cals, defaultMatrixXi, false, types[t]));
+            QVERIFY(!t_fileOut.isOpen());
+            QVERIFY(!t_fileOut.exists());
+        }
+        FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_fileOut, first_in_raw.info, cals, defaultMatrixXi, false, types[t], defaultRowVectorXd, true);
+        QVERIFY(outfid);
+        for(qint32 first = 0; first < first_in_data.cols(); first += nsamp)
+            outfid->write_raw_buffer(first_in_data.middleCols(first, qMin(nsamp, (qint32)first_in_data.cols() - first)).eval(), cals);
+        outfid->finish_writing_raw();
+        sizes << t_fileOut.size();
+
+        FiffRawData t_raw(t_fileOut);
+        MatrixXd t_data, times;
+        QVERIFY(t_raw.read_raw_segment(t_data, times, t_raw.first_samp, t_raw.first_samp + first_in_data.cols() - 1));
+        QCOMPARE(t_data.cols(), first_in_data.cols());
+        data << t_data;
+
+        //
+        //   Segments starting within a buffer
+        //
+        MatrixXd t_segment;
+        QVERIFY(t_raw.read_raw_segment(t_segment, times, t_raw.first_samp + 3*nsamp/2, t_raw.first_samp + 5*nsamp/2));
+        QVERIFY(t_segment == t_data.middleCols(3*nsamp/2, t_segment.cols()));
+    }
+
+    QVERIFY(data[0] == data[1]);
+    QVERIFY(sizes[1] < sizes[0]);
+    printf("Compressed size: %.1f%% of the integer storage\n", 100.0*sizes[1]/sizes[0]);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::splitRawFiles()
+{
+    //
+    //   Write the data into two linked files and read them back as one recording
+    //
+    QFile t_fileFirst("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_split_raw.fif");
+    QFile t_fileSecond("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short_test_rwr_split-1_raw.fif");
+
+    qint32 nsamp = first_in_data.cols() / 2;
+    MatrixXd firstPart = first_in_data.leftCols(nsamp);
+    MatrixXd secondPart = first_in_data.rightCols(first_in_data.cols() - nsamp);
+
+    RowVectorXd cals;
+    FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_fileFirst, first_in_raw.info, cals, defaultMatrixXi, true);
+    outfid->write_raw_buffer(firstPart, cals);
+
+    fiff_int_t data = FIFFV_ROLE_NEXT_FILE;
+    outfid->start_block(FIFFB_REF);
+    outfid->write_int(FIFF_REF_ROLE, &data);
+    outfid->write_string(FIFF_REF_FILE_NAME, QFileInfo(t_fileSecond).fileName());
+    data = 1;
+    outfid->write_int(FIFF_REF_FILE_NUM, &data);
+    outfid->end_block(FIFFB_REF);
+    outfid->finish_writing_raw();
+
+    outfid = FiffStream::start_writing_raw(t_fileSecond, first_in_raw.info, cals, defaultMatrixXi, true);
+    fiff_int_t first = 0;
+    outfid->write_int(FIFF_FIRST_SAMPLE, &first);
+    outfid->write_raw_buffer(secondPart, cals);
+    outfid->finish_writing_raw();
+
+    FiffRawData t_raw(t_fileFirst);
+    QCOMPARE(t_raw.files.size(), 2);
+    QCOMPARE(t_raw.rawdir.size(), 2);
+    QCOMPARE(t_raw.last_samp - t_raw.first_samp + 1, (int)first_in_data.cols());
+
+    //
+    //   A segment across the file boundary
+    //
+    MatrixXd segment, times;
+    QVERIFY(t_raw.read_raw_segment(segment, times, t_raw.first_samp + nsamp - 10, t_raw.first_samp + nsamp + 9));
+    QVERIFY((segment - first_in_data.middleCols(nsamp - 10, 20)).cwiseAbs().maxCoeff() < epsilon);
+
+    QVERIFY(t_raw.read_raw_segment(segment, times));
+    QVERIFY((segment - first_in_data).cwiseAbs().maxCoeff() < epsilon);
+
+    //
+    //   A buffer referring to a file which is not there fails instead of reading another file
+    //
+    FiffRawData t_rawMissing(t_raw);
+    t_rawMissing.rawdir[1].file_idx = 2;
+    QVERIFY(!t_rawMissing.read_raw_segment(segment, times, t_raw.first_samp + nsamp, t_raw.first_samp + nsamp + 9));
+}
+
+
 //*************************************************************************************************************
 
 void TestFiffRWR::cleanupTestCase()
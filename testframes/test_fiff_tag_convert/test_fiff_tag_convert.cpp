@@ -0,0 +1,315 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_tag_convert.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test and micro benchmark of the byte order conversion of FiffTag
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+
+#include <cstring>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QtEndian>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffTagConvert
+*
+* @brief The TestFiffTagConvert class verifies FiffTag::convert_tag_data against element wise conversion and
+*        benchmarks it against a plain memcpy of the same size, which is the memory bandwidth bound.
+*
+*/
+class TestFiffTagConvert: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffTagConvert();
+
+private slots:
+    void initTestCase();
+    void convertShort();
+    void convertInt();
+    void convertFloat();
+    void convertDouble();
+    void convertComplexFloat();
+    void convertMatrix();
+    void benchmarkConvert_data();
+    void benchmarkConvert();
+    void cleanupTestCase();
+
+private:
+    template<typename T>
+    FiffTag::SPtr makeBigEndianTag(fiff_int_t type, const QVector<T>& values);
+
+    qint32 m_iNumel;
+};
+
+
+//*************************************************************************************************************
+
+TestFiffTagConvert::TestFiffTagConvert()
+: m_iNumel(1027)    // not a multiple of any vector width, so the scalar tails are covered too
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::initTestCase()
+{
+    qsrand(42);
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+FiffTag::SPtr TestFiffTagConvert::makeBigEndianTag(fiff_int_t type, const QVector<T>& values)
+{
+    FiffTag::SPtr tag(new FiffTag());
+    tag->kind = FIFF_DATA_BUFFER;
+    tag->type = type;
+    tag->resize(values.size()*sizeof(T));
+
+    for(qint32 i = 0; i < values.size(); ++i)
+    {
+        T value = values[i];
+        uchar bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        for(quint32 b = 0; b < sizeof(T); ++b)
+            tag->data()[i*sizeof(T) + b] = bytes[sizeof(T) - 1 - b];
+#else
+        memcpy(tag->data() + i*sizeof(T), bytes, sizeof(T));
+#endif
+    }
+
+    return tag;
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::convertShort()
+{
+    QVector<qint16> values(m_iNumel);
+    for(qint32 i = 0; i < m_iNumel; ++i)
+        values[i] = (qint16)(qrand() - RAND_MAX/2);
+
+    FiffTag::SPtr tag = makeBigEndianTag(FIFFT_DAU_PACK16, values);
+    FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_NATIVE_ENDIAN);
+
+    QVERIFY(memcmp(tag->data(), values.constData(), tag->size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::convertInt()
+{
+    QVector<qint32> values(m_iNumel);
+    for(qint32 i = 0; i < m_iNumel; ++i)
+        values[i] = qrand() - RAND_MAX/2;
+
+    FiffTag::SPtr tag = makeBigEndianTag(FIFFT_INT, values);
+    FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_NATIVE_ENDIAN);
+
+    QVERIFY(memcmp(tag->data(), values.constData(), tag->size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::convertFloat()
+{
+    QVector<float> values(m_iNumel);
+    for(qint32 i = 0; i < m_iNumel; ++i)
+        values[i] = (float)qrand()/RAND_MAX - 0.5f;
+
+    FiffTag::SPtr tag = makeBigEndianTag(FIFFT_FLOAT, values);
+    FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_NATIVE_ENDIAN);
+
+    QVERIFY(memcmp(tag->data(), values.constData(), tag->size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::convertDouble()
+{
+    QVector<double> values(m_iNumel);
+    for(qint32 i = 0; i < m_iNumel; ++i)
+        values[i] = (double)qrand()/RAND_MAX - 0.5;
+
+    FiffTag::SPtr tag = makeBigEndianTag(FIFFT_DOUBLE, values);
+    FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_NATIVE_ENDIAN);
+
+    QVERIFY(memcmp(tag->data(), values.constData(), tag->size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::convertComplexFloat()
+{
+    //
+    //   Complex values are pairs of floats, each swapped on its own
+    //
+    QVector<float> values(2*m_iNumel);
+    for(qint32 i = 0; i < values.size(); ++i)
+        values[i] = (float)qrand()/RAND_MAX - 0.5f;
+
+    FiffTag::SPtr tag = makeBigEndianTag(FIFFT_COMPLEX_FLOAT, values);
+    FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_NATIVE_ENDIAN);
+
+    QVERIFY(memcmp(tag->data(), values.constData(), tag->size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::convertMatrix()
+{
+    //
+    //   Dense float matrix: row major data followed by the dimensions (cols, rows, ndim)
+    //
+    qint32 rows = 31, cols = 33;
+    MatrixXf mat = MatrixXf::Random(rows, cols);
+
+    QByteArray baFile;
+    FiffStream t_Stream(&baFile, QIODevice::WriteOnly);
+    t_Stream.write_float_matrix(FIFF_PROJ_ITEM_VECTORS, mat);
+
+    FiffTag::SPtr tag(new FiffTag());
+    tag->kind = FIFF_PROJ_ITEM_VECTORS;
+    tag->type = FIFFT_MATRIX_FLOAT;
+    tag->append(baFile.mid(FIFFC_DATA_OFFSET));
+
+    FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_NATIVE_ENDIAN);
+
+    const qint32* dims = (const qint32*)(tag->constData() + 4*rows*cols);
+    QCOMPARE(dims[0], cols);
+    QCOMPARE(dims[1], rows);
+    QCOMPARE(dims[2], 2);
+
+    Matrix<float,Dynamic,Dynamic,RowMajor> converted = Map< const Matrix<float,Dynamic,Dynamic,RowMajor> >((const float*)tag->constData(), rows, cols);
+    QVERIFY(converted == mat);
+
+    //
+    //   And back to file byte order
+    //
+    FiffTag::convert_tag_data(tag, FIFFV_NATIVE_ENDIAN, FIFFV_BIG_ENDIAN);
+    QVERIFY(*tag == baFile.mid(FIFFC_DATA_OFFSET));
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::benchmarkConvert_data()
+{
+    QTest::addColumn<int>("type");
+
+    //
+    //   32 MB each: memcpy is the reference for memory bandwidth
+    //
+    QTest::newRow("memcpy") << (int)FIFFT_VOID;
+    QTest::newRow("int16") << (int)FIFFT_DAU_PACK16;
+    QTest::newRow("int32") << (int)FIFFT_INT;
+    QTest::newRow("float") << (int)FIFFT_FLOAT;
+    QTest::newRow("double") << (int)FIFFT_DOUBLE;
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::benchmarkConvert()
+{
+    QFETCH(int, type);
+
+    qint32 size = 32*1024*1024;
+
+    FiffTag::SPtr tag(new FiffTag());
+    tag->kind = FIFF_DATA_BUFFER;
+    tag->type = type;
+    tag->fill(0x5a, size);
+
+    if(type == FIFFT_VOID)
+    {
+        QByteArray baDest(size, 0);
+        QBENCHMARK {
+            memcpy(baDest.data(), tag->constData(), size);
+        }
+    }
+    else
+    {
+        QBENCHMARK {
+            FiffTag::convert_tag_data(tag, FIFFV_BIG_ENDIAN, FIFFV_LITTLE_ENDIAN);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagConvert::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffTagConvert)
+#include "test_fiff_tag_convert.moc"
@@ -0,0 +1,230 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_tag_parser.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    The FIFF tag parser unit test
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <fiff/fiff_tag_parser.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QtEndian>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffTagParser
+*
+* @brief The TestFiffTagParser class feeds a fiff tag stream in chunks of different sizes to FiffTagParser and
+*        verifies that exactly the tags read by FiffStream::read_tag are emitted.
+*
+*/
+class TestFiffTagParser: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffTagParser();
+
+public slots:
+    void receiveTag(const QSharedPointer<FIFFLIB::FiffTag>& p_pTag);
+
+private slots:
+    void initTestCase();
+    void parseChunks_data();
+    void parseChunks();
+    void rejectDamagedStream();
+    void cleanupTestCase();
+
+private:
+    QByteArray m_baStream;
+    QList<FiffTag::SPtr> m_refTags;
+    QList<FiffTag::SPtr> m_tags;
+};
+
+
+//*************************************************************************************************************
+
+TestFiffTagParser::TestFiffTagParser()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagParser::receiveTag(const QSharedPointer<FiffTag>& p_pTag)
+{
+    m_tags.append(p_pTag);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagParser::initTestCase()
+{
+    //
+    //   A stream similar to what mne_rt_server sends
+    //
+    QBuffer t_buffer(&m_baStream);
+    QVERIFY(t_buffer.open(QIODevice::WriteOnly));
+    FiffStream t_streamOut(&t_buffer);
+
+    fiff_int_t value = FIFFB_MEAS_INFO;
+    t_streamOut.start_block(FIFFB_MEAS_INFO);
+    float sfreq = 600.614990234375f;
+    t_streamOut.write_float(FIFF_SFREQ, &sfreq);
+    t_streamOut.write_string(FIFF_COMMENT, "tag parser test");
+    value = 3;
+    t_streamOut.write_int(FIFF_NCHAN, &value);
+    t_streamOut.end_block(FIFFB_MEAS_INFO);
+
+    VectorXf data = VectorXf::LinSpaced(3*1000, -1.0f, 1.0f);
+    t_streamOut.write_float(FIFF_DATA_BUFFER, data.data(), data.size());
+    t_streamOut.write_int(FIFF_MNE_RT_CLIENT_ID, &value);
+    t_buffer.close();
+
+    //
+    //   Reference
+    //
+    QVERIFY(t_buffer.open(QIODevice::ReadOnly));
+    FiffStream t_streamIn(&t_buffer);
+    while(!t_buffer.atEnd()) {
+        FiffTag::SPtr t_pTag;
+        QVERIFY(t_streamIn.read_tag(t_pTag));
+        m_refTags.append(t_pTag);
+    }
+    t_buffer.close();
+
+    QCOMPARE(m_refTags.size(), 7);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagParser::parseChunks_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("1 byte") << 1;
+    QTest::newRow("7 bytes") << 7;
+    QTest::newRow("header size") << 16;
+    QTest::newRow("4 kB") << 4096;
+    QTest::newRow("all") << m_baStream.size();
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagParser::parseChunks()
+{
+    QFETCH(int, chunkSize);
+
+    FiffTagParser t_parser;
+    connect(&t_parser, &FiffTagParser::tagReceived, this, &TestFiffTagParser::receiveTag);
+    m_tags.clear();
+
+    for(qint32 pos = 0; pos < m_baStream.size(); pos += chunkSize)
+        QVERIFY(t_parser.append(m_baStream.constData() + pos, qMin(chunkSize, m_baStream.size() - pos)));
+
+    QCOMPARE(t_parser.pendingBytes(), (qint64)0);
+    QCOMPARE(t_parser.tagCount(), (qint64)m_refTags.size());
+    QCOMPARE(m_tags.size(), m_refTags.size());
+    for(qint32 k = 0; k < m_tags.size(); ++k) {
+        QCOMPARE(m_tags[k]->kind, m_refTags[k]->kind);
+        QCOMPARE(m_tags[k]->type, m_refTags[k]->type);
+        QCOMPARE(m_tags[k]->next, m_refTags[k]->next);
+        QVERIFY(*m_tags[k] == *m_refTags[k]);
+    }
+    QCOMPARE(*m_tags[1]->toFloat(), 600.614990234375f);
+
+    QVERIFY(t_parser.maxLatency() >= t_parser.lastLatency());
+    QVERIFY(t_parser.meanLatency() <= t_parser.maxLatency());
+    printf("Chunks of %d bytes: mean latency %.1f us, max latency %.1f us\n", chunkSize, t_parser.meanLatency()/1000.0, t_parser.maxLatency()/1000.0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagParser::rejectDamagedStream()
+{
+    FiffTagParser t_parser;
+    connect(&t_parser, &FiffTagParser::tagReceived, this, &TestFiffTagParser::receiveTag);
+    m_tags.clear();
+
+    QByteArray t_baDamaged = m_baStream;
+    qToBigEndian<qint32>(-5, (uchar*)t_baDamaged.data() + 8);
+
+    QVERIFY(!t_parser.append(t_baDamaged));
+    QCOMPARE(t_parser.pendingBytes(), (qint64)0);
+    QCOMPARE(m_tags.size(), 0);
+
+    //
+    //   The parser continues with the next stream
+    //
+    QVERIFY(t_parser.append(m_baStream));
+    QCOMPARE(m_tags.size(), m_refTags.size());
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffTagParser::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffTagParser)
+#include "test_fiff_tag_parser.moc"
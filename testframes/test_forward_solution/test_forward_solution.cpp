@@ -59,6 +59,7 @@
 
 using namespace FWDLIB;
 using namespace MNELIB;
+using namespace FIFFLIB;
 
 
 //=============================================================================================================
@@ -78,6 +79,10 @@ public:
 private slots:
     void initTestCase();
     void computeForward();
+    void readTransposed();
+    void pickChannels();
+    void toFixedOri();
+    void floatGain();
     void cleanupTestCase();
 
 private:
@@ -209,6 +214,140 @@ void TestForwardSolution::compareForward()
 }
 
 
+//*************************************************************************************************************
+
+void TestForwardSolution::readTransposed()
+{
+    QFile t_fileForwardSolution(QDir::currentPath()+"./mne-cpp-test-data/Result/sample_audvis-meg-oct-6-fwd.fif");
+    FiffStream::SPtr t_pStream(new FiffStream(&t_fileForwardSolution));
+    QVERIFY(t_pStream->open());
+
+    QList<FiffDirNode::SPtr> fwds = t_pStream->dirtree()->dir_tree_find(FIFFB_MNE_FORWARD_SOLUTION);
+    QVERIFY(fwds.size() > 0);
+
+    // The transposed read has to match the transposed stored matrix, served from the mapping and from the device
+    FiffNamedMatrix t_mat, t_matTransposed, t_matMapped;
+    QVERIFY(t_pStream->read_named_matrix(fwds[0], FIFF_MNE_FORWARD_SOLUTION, t_mat));
+    QVERIFY(t_pStream->read_named_matrix(fwds[0], FIFF_MNE_FORWARD_SOLUTION, t_matTransposed, true));
+    QVERIFY(t_pStream->map());
+    QVERIFY(t_pStream->read_named_matrix(fwds[0], FIFF_MNE_FORWARD_SOLUTION, t_matMapped, true));
+    t_pStream->close();
+
+    QCOMPARE(t_matTransposed.nrow, t_mat.ncol);
+    QCOMPARE(t_matTransposed.ncol, t_mat.nrow);
+    QCOMPARE(t_matTransposed.row_names, t_mat.col_names);
+    QCOMPARE(t_matTransposed.col_names, t_mat.row_names);
+    QVERIFY(t_matTransposed.data == t_mat.data.transpose());
+    QVERIFY(t_matMapped.data == t_matTransposed.data);
+}
+
+
+//*************************************************************************************************************
+
+void TestForwardSolution::pickChannels()
+{
+    QFile t_fileForwardSolution(QDir::currentPath()+"./mne-cpp-test-data/Result/sample_audvis-meg-oct-6-fwd.fif");
+    MNEForwardSolution t_Fwd(t_fileForwardSolution);
+    QVERIFY(!t_Fwd.isEmpty());
+
+    const QStringList& t_chNames = t_Fwd.sol.constData()->row_names;
+
+    // Picking all channels keeps sharing the gain matrix
+    MNEForwardSolution t_fwdAll = t_Fwd.pick_channels(t_chNames);
+    QVERIFY(t_fwdAll.sol.constData() == t_Fwd.sol.constData());
+
+    // Picking a subset leaves the original untouched
+    QStringList t_include;
+    for(qint32 i = 0; i < t_chNames.size(); i += 3)
+        t_include << t_chNames[i];
+
+    MatrixXd t_matOrig = t_Fwd.sol.constData()->data;
+    MNEForwardSolution t_fwdPicked = t_Fwd.pick_channels(t_include);
+
+    QCOMPARE(t_fwdPicked.nchan, t_include.size());
+    QCOMPARE(t_fwdPicked.info.chs.size(), t_include.size());
+    QCOMPARE(t_fwdPicked.sol.constData()->row_names, t_include);
+    for(qint32 i = 0; i < t_include.size(); ++i)
+        QVERIFY(t_fwdPicked.sol.constData()->data.row(i) == t_matOrig.row(3*i));
+    QVERIFY(t_Fwd.sol.constData()->data == t_matOrig);
+}
+
+
+//*************************************************************************************************************
+
+void TestForwardSolution::toFixedOri()
+{
+    // Three sources with x, y and z columns, only the surface normals (z) remain
+    MNEForwardSolution t_Fwd;
+    t_Fwd.surf_ori = true;
+    t_Fwd.source_ori = FIFFV_MNE_FREE_ORI;
+    t_Fwd.sol->data = MatrixXd::Random(4, 9);
+    t_Fwd.sol->nrow = 4;
+    t_Fwd.sol->ncol = 9;
+
+    MatrixXd t_matFree = t_Fwd.sol->data;
+    t_Fwd.to_fixed_ori();
+
+    QVERIFY(t_Fwd.isFixedOrient());
+    QCOMPARE(t_Fwd.sol->ncol, 3);
+    QCOMPARE((int)t_Fwd.sol->data.cols(), 3);
+    for(qint32 i = 0; i < 3; ++i)
+        QVERIFY(t_Fwd.sol->data.col(i) == t_matFree.col(3*i + 2));
+}
+
+
+//*************************************************************************************************************
+
+void TestForwardSolution::floatGain()
+{
+    QFile t_fileForwardSolution(QDir::currentPath()+"./mne-cpp-test-data/Result/sample_audvis-meg-oct-6-fwd.fif");
+    MNEForwardSolution t_Fwd(t_fileForwardSolution);
+    QVERIFY(!t_Fwd.isEmpty());
+    QVERIFY(!t_Fwd.isFloatGain());
+
+    MNEForwardSolution t_FwdFloat(t_fileForwardSolution, false, false, defaultQStringList, defaultQStringList, false, true);
+    QVERIFY(!t_FwdFloat.isEmpty());
+    QVERIFY(t_FwdFloat.isFloatGain());
+    QCOMPARE((int)t_FwdFloat.sol->data.size(), 0);
+    QCOMPARE(t_FwdFloat.sol->nrow, t_Fwd.sol->nrow);
+    QCOMPARE(t_FwdFloat.sol->ncol, t_Fwd.sol->ncol);
+
+    // The file holds single precision values, widening them is exact
+    QVERIFY(t_FwdFloat.gain() == t_Fwd.sol->data);
+
+    // Picks share the single precision matrix and select its rows by index
+    const QStringList& t_chNames = t_Fwd.sol.constData()->row_names;
+    QStringList t_include;
+    for(qint32 i = 0; i < t_chNames.size(); i += 3)
+        t_include << t_chNames[i];
+
+    MNEForwardSolution t_fwdPicked = t_Fwd.pick_channels(t_include);
+    MNEForwardSolution t_fwdFloatPicked = t_FwdFloat.pick_channels(t_include);
+    QVERIFY(t_fwdFloatPicked.sol_float.data() == t_FwdFloat.sol_float.data());
+    QCOMPARE((int)t_fwdFloatPicked.sol->data.size(), 0);
+    QCOMPARE(t_fwdFloatPicked.sol->row_names, t_include);
+    QVERIFY(t_fwdFloatPicked.gain() == t_fwdPicked.sol->data);
+
+    VectorXi t_vecSel(2);
+    t_vecSel << 1, 0;
+    QVERIFY(t_fwdFloatPicked.gain(t_vecSel) == t_fwdPicked.gain(t_vecSel));
+
+    // Fixed orientation only drops column indices
+    t_fwdPicked.surf_ori = t_fwdFloatPicked.surf_ori = true;
+    t_fwdPicked.to_fixed_ori();
+    t_fwdFloatPicked.to_fixed_ori();
+    QVERIFY(t_fwdFloatPicked.sol_float.data() == t_FwdFloat.sol_float.data());
+    QCOMPARE(t_fwdFloatPicked.sol->ncol, t_fwdPicked.sol->ncol);
+    QCOMPARE(t_fwdFloatPicked.compute_orient_prior().dim, t_fwdPicked.compute_orient_prior().dim);
+    QVERIFY(t_fwdFloatPicked.gain() == t_fwdPicked.sol->data);
+
+    // Converting to double precision releases the shared matrix
+    t_fwdFloatPicked.to_double_gain();
+    QVERIFY(!t_fwdFloatPicked.isFloatGain());
+    QVERIFY(t_fwdFloatPicked.sol->data == t_fwdPicked.sol->data);
+}
+
+
 //*************************************************************************************************************
 
 void TestForwardSolution::cleanupTestCase()
@@ -0,0 +1,331 @@
+//=============================================================================================================
+/**
+* @file     test_mne_epochs_io.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    The epochs fif file io test implementation
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <mne/mne_epoch_data_list.h>
+#include <mne/mne_epoch_data_file.h>
+
+#include <iostream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace MNELIB;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestMneEpochsIO
+*
+* @brief The TestMneEpochsIO class writes epochs cut from a raw file to an epochs fif file and verifies that they
+*        are read back completely and in random order, also across FIFF_EPOCH tags and continuation files.
+*
+*/
+class TestMneEpochsIO: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestMneEpochsIO();
+
+private slots:
+    void initTestCase();
+    void saveEpochs();
+    void readEpochs();
+    void randomAccess();
+    void unmappedAccess();
+    void tagBoundary();
+    void fileBoundary();
+    void cleanupTestCase();
+
+private:
+    bool compareEpoch(const MNEEpochData::SPtr& epoch, qint32 idx) const;
+
+    double epsilon;
+    QString m_sFileName;
+    FiffInfo m_info;
+    MNEEpochDataList m_epochs;
+};
+
+
+//*************************************************************************************************************
+
+TestMneEpochsIO::TestMneEpochsIO()
+: epsilon(1e-6)
+, m_sFileName("./mne-cpp-test-data/MEG/sample/test_mne_epochs_io-epo.fif")
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::initTestCase()
+{
+    QFile t_fileRaw("./mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif");
+    FiffRawData t_raw(t_fileRaw);
+    m_info = t_raw.info;
+
+    //
+    //   Cut epochs of 0.2 s with varying event codes
+    //
+    qint32 nsamp = (qint32)(0.2 * m_info.sfreq);
+    qint32 tmin = -(qint32)(0.05 * m_info.sfreq);
+    for(qint32 k = 0; k < 12; ++k) {
+        fiff_int_t from = t_raw.first_samp + nsamp * (k + 1);
+        MatrixXd data, times;
+        QVERIFY(t_raw.read_raw_segment(data, times, from + tmin, from + tmin + nsamp - 1));
+
+        MNEEpochData::SPtr t_pEpoch(new MNEEpochData());
+        t_pEpoch->epoch = data;
+        t_pEpoch->event = 1 + k % 4;
+        t_pEpoch->sample = from;
+        t_pEpoch->tmin = (float)tmin / m_info.sfreq;
+        t_pEpoch->tmax = (float)(tmin + nsamp - 1) / m_info.sfreq;
+        m_epochs.append(t_pEpoch);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::saveEpochs()
+{
+    QFile t_fileOut(m_sFileName);
+    QVERIFY(m_epochs.save(t_fileOut, m_info));
+
+    //
+    //   Epochs of different size are rejected
+    //
+    MNEEpochDataList t_invalid = m_epochs;
+    MNEEpochData::SPtr t_pEpoch(new MNEEpochData(*m_epochs[0]));
+    t_pEpoch->epoch.conservativeResize(Eigen::NoChange, t_pEpoch->epoch.cols() - 1);
+    t_invalid.append(t_pEpoch);
+    QBuffer t_buffer;
+    QVERIFY(!t_invalid.save(t_buffer, m_info));
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::readEpochs()
+{
+    QFile t_fileIn(m_sFileName);
+    MNEEpochDataList t_epochs;
+    FiffInfo t_info;
+    QVERIFY(MNEEpochDataList::read(t_fileIn, t_epochs, t_info));
+
+    QCOMPARE(t_info.nchan, m_info.nchan);
+    QCOMPARE(t_info.ch_names, m_info.ch_names);
+    QCOMPARE(t_epochs.size(), m_epochs.size());
+    for(qint32 i = 0; i < t_epochs.size(); ++i)
+        QVERIFY(compareEpoch(t_epochs[i], i));
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::randomAccess()
+{
+    QFile t_fileIn(m_sFileName);
+    MNEEpochDataFile t_file(t_fileIn);
+    QVERIFY(t_file.isValid());
+    QVERIFY(t_file.isMapped());
+    QCOMPARE(t_file.size(), m_epochs.size());
+    QCOMPARE((qint64)t_file.nchan(), (qint64)m_epochs[0]->epoch.rows());
+    QCOMPARE((qint64)t_file.nsamp(), (qint64)m_epochs[0]->epoch.cols());
+
+    qint32 order[] = { 7, 0, 11, 3, 3, 9, 1, 5 };
+    for(qint32 k = 0; k < (qint32)(sizeof(order) / sizeof(order[0])); ++k)
+        QVERIFY(compareEpoch(t_file.epoch(order[k]), order[k]));
+
+    QVERIFY(!t_file.epoch(-1));
+    QVERIFY(!t_file.epoch(t_file.size()));
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::unmappedAccess()
+{
+    //
+    //   A QBuffer cannot be mapped, epochs are read through the device
+    //
+    QFile t_fileIn(m_sFileName);
+    QVERIFY(t_fileIn.open(QIODevice::ReadOnly));
+    QBuffer t_buffer;
+    t_buffer.setData(t_fileIn.readAll());
+    t_fileIn.close();
+
+    MNEEpochDataFile t_file(t_buffer);
+    QVERIFY(t_file.isValid());
+    QVERIFY(!t_file.isMapped());
+    QVERIFY(compareEpoch(t_file.epoch(10), 10));
+    QVERIFY(compareEpoch(t_file.epoch(2), 2));
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::tagBoundary()
+{
+    //
+    //   Five epochs per FIFF_EPOCH tag, the twelve epochs end up in three tags
+    //
+    qint64 epochsize = 4 * m_epochs[0]->epoch.rows() * m_epochs[0]->epoch.cols();
+    QFile t_fileOut(m_sFileName);
+    QVERIFY(m_epochs.save(t_fileOut, m_info, 5 * epochsize + 4 * 4));
+
+    QFile t_fileIn(m_sFileName);
+    MNEEpochDataFile t_file(t_fileIn);
+    QVERIFY(t_file.isValid());
+    QVERIFY(t_file.isMapped());
+    QCOMPARE(t_file.size(), m_epochs.size());
+
+    qint32 order[] = { 4, 5, 9, 10, 11, 0 };
+    for(qint32 k = 0; k < (qint32)(sizeof(order) / sizeof(order[0])); ++k)
+        QVERIFY(compareEpoch(t_file.epoch(order[k]), order[k]));
+
+    //
+    //   Same through the device
+    //
+    QVERIFY(t_fileIn.open(QIODevice::ReadOnly));
+    QBuffer t_buffer;
+    t_buffer.setData(t_fileIn.readAll());
+    t_fileIn.close();
+
+    MNEEpochDataFile t_unmapped(t_buffer);
+    QVERIFY(t_unmapped.isValid());
+    QVERIFY(!t_unmapped.isMapped());
+    for(qint32 k = 0; k < (qint32)(sizeof(order) / sizeof(order[0])); ++k)
+        QVERIFY(compareEpoch(t_unmapped.epoch(order[k]), order[k]));
+
+    MNEEpochDataList t_epochs;
+    FiffInfo t_info;
+    QVERIFY(MNEEpochDataList::read(t_buffer, t_epochs, t_info));
+    QCOMPARE(t_epochs.size(), m_epochs.size());
+    for(qint32 i = 0; i < t_epochs.size(); ++i)
+        QVERIFY(compareEpoch(t_epochs[i], i));
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::fileBoundary()
+{
+    //
+    //   A file size below the size of a tag leaves one tag per file, the epochs continue in -1.fif and -2.fif
+    //
+    qint64 epochsize = 4 * m_epochs[0]->epoch.rows() * m_epochs[0]->epoch.cols();
+    QFile t_fileOut(m_sFileName);
+    QVERIFY(m_epochs.save(t_fileOut, m_info, 5 * epochsize + 4 * 4, epochsize));
+
+    QString t_sBase = m_sFileName.left(m_sFileName.size() - 4);
+    QVERIFY(QFile::exists(t_sBase + "-1.fif"));
+    QVERIFY(QFile::exists(t_sBase + "-2.fif"));
+    QVERIFY(!QFile::exists(t_sBase + "-3.fif"));
+
+    QFile t_fileIn(m_sFileName);
+    MNEEpochDataFile t_file(t_fileIn);
+    QVERIFY(t_file.isValid());
+    QVERIFY(t_file.isMapped());
+    QCOMPARE(t_file.size(), m_epochs.size());
+    QCOMPARE(t_file.events().size(), m_epochs.size());
+    for(qint32 i = t_file.size() - 1; i >= 0; --i)
+        QVERIFY(compareEpoch(t_file.epoch(i), i));
+
+    //
+    //   Devices other than files can not be split
+    //
+    QBuffer t_buffer;
+    QVERIFY(!m_epochs.save(t_buffer, m_info, 5 * epochsize + 4 * 4, epochsize));
+}
+
+
+//*************************************************************************************************************
+
+void TestMneEpochsIO::cleanupTestCase()
+{
+    QString t_sBase = m_sFileName.left(m_sFileName.size() - 4);
+    QFile::remove(m_sFileName);
+    QFile::remove(t_sBase + "-1.fif");
+    QFile::remove(t_sBase + "-2.fif");
+}
+
+
+//*************************************************************************************************************
+
+bool TestMneEpochsIO::compareEpoch(const MNEEpochData::SPtr& epoch, qint32 idx) const
+{
+    if(!epoch)
+        return false;
+
+    const MNEEpochData::SPtr& ref = m_epochs[idx];
+    if(epoch->epoch.rows() != ref->epoch.rows() || epoch->epoch.cols() != ref->epoch.cols())
+        return false;
+
+    //
+    //   Data is stored in single precision
+    //
+    if(!((epoch->epoch - ref->epoch).array().abs() <= epsilon * ref->epoch.array().abs() + 1e-30).all())
+        return false;
+
+    return epoch->event == ref->event && epoch->sample == ref->sample && qAbs(epoch->tmin - ref->tmin) < 1e-4f;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestMneEpochsIO)
+#include "test_mne_epochs_io.moc"
@@ -0,0 +1,325 @@
+//=============================================================================================================
+/**
+* @file     test_rtave.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the real-time averaging of RtAve.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtave.h>
+
+#include <fiff/fiff_evoked_set.h>
+#include <fiff/fiff_info.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS EvokedCollector
+*
+* @brief The EvokedCollector class copies the evoked of one trigger type each time RtAve emits the evoked set.
+*        It has to be connected directly, the set is updated in place by the next epoch.
+*/
+class EvokedCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    EvokedCollector(const QString& sComment)
+    : m_sComment(sComment)
+    {
+    }
+
+    //=========================================================================================================
+    /**
+    * Waits until iCount evoked were collected or iMsecs passed.
+    *
+    * @return true if iCount evoked were collected.
+    */
+    bool waitFor(int iCount, int iMsecs)
+    {
+        QMutexLocker locker(&m_qMutex);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        while(m_lData.size() < iCount && timer.elapsed() < iMsecs) {
+            m_qCollected.wait(&m_qMutex, 100);
+        }
+
+        return m_lData.size() >= iCount;
+    }
+
+    QList<MatrixXd>     m_lData;        /**< The evoked data in the order of emission. */
+    QList<int>          m_lNave;        /**< The number of averages in the order of emission. */
+
+public slots:
+    void onEvokedStim(FIFFLIB::FiffEvokedSet::SPtr pEvokedSet)
+    {
+        QMutexLocker locker(&m_qMutex);
+
+        for(int i = 0; i < pEvokedSet->evoked.size(); ++i) {
+            if(pEvokedSet->evoked.at(i).comment == m_sComment) {
+                m_lData.append(pEvokedSet->evoked.at(i).data);
+                m_lNave.append(pEvokedSet->evoked.at(i).nave);
+                m_qCollected.wakeAll();
+            }
+        }
+    }
+
+private:
+    QString             m_sComment;     /**< The comment, i.e. trigger type, of the collected evoked. */
+    QMutex              m_qMutex;       /**< Guards the collected evoked. */
+    QWaitCondition      m_qCollected;   /**< Signaled for each collected evoked. */
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtAve
+*
+* @brief The TestRtAve class streams synthetic epochs with known triggers through RtAve and compares each
+*        emitted evoked with the plain mean over the epochs it should contain.
+*
+*/
+class TestRtAve: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtAve();
+
+private slots:
+    void initTestCase();
+    void averages_data();
+    void averages();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Computes the expected evoked from the epochs iFirst to iLast, both included.
+    */
+    MatrixXd expected(int iFirst, int iLast, bool bBaseline) const;
+
+    FiffInfo::SPtr      m_pFiffInfo;        /**< Four EEG channels and a stimulus channel. */
+    QList<MatrixXd>     m_lEpochs;          /**< The epochs, the trigger is at column m_iPreStim. */
+    QList<MatrixXd>     m_lSegments;        /**< The streamed blocks which hold the epochs. */
+
+    int                 m_iNumAverages;     /**< The size of the epoch ring in the running mode. */
+    int                 m_iPreStim;         /**< The pre stimulus samples. */
+    int                 m_iPostStim;        /**< The post stimulus samples, including the trigger. */
+    int                 m_iBaselineFrom;    /**< First column of the baseline window. */
+    int                 m_iBaselineTo;      /**< Last column of the baseline window. */
+};
+
+
+//*************************************************************************************************************
+
+TestRtAve::TestRtAve()
+: m_iNumAverages(4)
+, m_iPreStim(20)
+, m_iPostStim(50)
+, m_iBaselineFrom(3)
+, m_iBaselineTo(17)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::initTestCase()
+{
+    m_pFiffInfo = FiffInfo::SPtr(new FiffInfo);
+    m_pFiffInfo->sfreq = 500.0f;
+    m_pFiffInfo->nchan = 5;
+    for(qint32 k = 0; k < m_pFiffInfo->nchan; ++k)
+    {
+        FiffChInfo ch;
+        ch.scanNo = k + 1;
+        ch.logNo = k + 1;
+        ch.kind = (k < 4) ? FIFFV_EEG_CH : FIFFV_STIM_CH;
+        ch.range = 1.0f;
+        ch.cal = 1.0f;
+        ch.ch_name = (k < 4) ? QString("EEG %1").arg(k + 1, 3, 10, QChar('0')) : QString("STI 014");
+        m_pFiffInfo->chs.append(ch);
+        m_pFiffInfo->ch_names.append(ch.ch_name);
+    }
+
+    //
+    //   Eleven epochs, more than the ring of four holds. Each epoch has its own offset, so the baseline matters.
+    //   Every epoch starts a group of four blocks of 100 samples, the trigger is at sample 50 of the first block.
+    //   The following blocks flush the epoch and refill the pre stimulus buffer.
+    //
+    std::srand(42);
+    int iBlockSize = 100;
+    int iTrigger = 50;
+
+    for(int k = 0; k < 11; ++k) {
+        MatrixXd matEpoch = MatrixXd::Random(5, m_iPreStim + m_iPostStim);
+        matEpoch.topRows(4).array() += 0.5 * k;
+        matEpoch.row(4).setZero();
+        matEpoch(4, m_iPreStim) = 1.0;
+        m_lEpochs.append(matEpoch);
+
+        for(int i = 0; i < 4; ++i) {
+            MatrixXd matBlock = MatrixXd::Random(5, iBlockSize);
+            matBlock.row(4).setZero();
+            if(i == 0) {
+                matBlock.middleCols(iTrigger - m_iPreStim, matEpoch.cols()) = matEpoch;
+            }
+            m_lSegments.append(matBlock);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::averages_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<bool>("baseline");
+
+    QTest::newRow("running") << 0 << false;
+    QTest::newRow("running, baseline") << 0 << true;
+    QTest::newRow("cumulative") << 1 << false;
+    QTest::newRow("cumulative, baseline") << 1 << true;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::averages()
+{
+    //
+    //   The k-th evoked is the mean over the last m_iNumAverages epochs (running) or over all epochs (cumulative)
+    //
+    QFETCH(int, mode);
+    QFETCH(bool, baseline);
+
+    RtAve rtAve(m_iNumAverages, m_iPreStim, m_iPostStim, 0, 0, 4, m_pFiffInfo);
+    rtAve.setAverageMode(mode);
+
+    //At 500 Hz the window [-35, -5] ms lies between samples and covers the columns 3 to 17
+    rtAve.setBaselineFrom(m_iBaselineFrom, -35);
+    rtAve.setBaselineTo(m_iBaselineTo, -5);
+    rtAve.setBaselineActive(baseline);
+
+    EvokedCollector collector(QString::number(1.0));
+    connect(&rtAve, &RtAve::evokedStim, &collector, &EvokedCollector::onEvokedStim, Qt::DirectConnection);
+
+    rtAve.start();
+
+    for(int i = 0; i < m_lSegments.size(); ++i) {
+        rtAve.append(m_lSegments.at(i));
+    }
+
+    bool bCollected = collector.waitFor(m_lEpochs.size(), 10000);
+
+    rtAve.stop();
+    rtAve.wait();
+
+    QVERIFY(bCollected);
+
+    for(int k = 0; k < m_lEpochs.size(); ++k) {
+        int iFirst = (mode == 0) ? qMax(0, k - m_iNumAverages + 1) : 0;
+        MatrixXd matExpected = expected(iFirst, k, baseline);
+
+        QCOMPARE(collector.m_lNave.at(k), k - iFirst + 1);
+        QCOMPARE((int)collector.m_lData.at(k).rows(), (int)matExpected.rows());
+        QCOMPARE((int)collector.m_lData.at(k).cols(), (int)matExpected.cols());
+
+        double dMaxError = (collector.m_lData.at(k) - matExpected).cwiseAbs().maxCoeff();
+        QVERIFY2(dMaxError < 1e-10, QString("Evoked %1: maximal error %2").arg(k).arg(dMaxError).toUtf8().constData());
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtAve::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtAve::expected(int iFirst, int iLast, bool bBaseline) const
+{
+    MatrixXd matMean = MatrixXd::Zero(m_lEpochs.at(0).rows(), m_lEpochs.at(0).cols());
+
+    for(int k = iFirst; k <= iLast; ++k) {
+        matMean += m_lEpochs.at(k);
+    }
+    matMean /= (iLast - iFirst + 1);
+
+    if(bBaseline) {
+        VectorXd vecBaseline = matMean.middleCols(m_iBaselineFrom, m_iBaselineTo - m_iBaselineFrom + 1).rowwise().mean();
+        matMean.colwise() -= vecBaseline;
+    }
+
+    return matMean;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtAve)
+#include "test_rtave.moc"
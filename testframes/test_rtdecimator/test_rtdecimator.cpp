@@ -0,0 +1,244 @@
+//=============================================================================================================
+/**
+* @file     test_rtdecimator.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the real-time polyphase decimator.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtdecimator.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtDecimator
+*
+* @brief The TestRtDecimator class streams data block by block through RtDecimator and compares the result with
+*        the filtered and subsampled recording.
+*
+*/
+class TestRtDecimator: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtDecimator();
+
+private slots:
+    void initTestCase();
+    void blockSizes_data();
+    void blockSizes();
+    void antiAlias();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Streams matData through the decimator in blocks of iBlockSize samples.
+    */
+    MatrixXd stream(RtDecimator& decimator, const MatrixXd& matData, int iBlockSize) const;
+
+    MatrixXd        m_matData;          /**< The random recording, the last row is a stimulus channel. */
+};
+
+
+//*************************************************************************************************************
+
+TestRtDecimator::TestRtDecimator()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtDecimator::initTestCase()
+{
+    std::srand(42);
+    m_matData = MatrixXd::Random(8, 3000);
+
+    //Pulses of one sample on the stimulus channel
+    m_matData.row(7).setZero();
+    for(int n = 13; n < m_matData.cols(); n += 311)
+        m_matData(7, n) = 5.0;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtDecimator::blockSizes_data()
+{
+    QTest::addColumn<int>("factor");
+    QTest::addColumn<int>("blockSize");
+
+    QTest::newRow("factor 1") << 1 << 100;
+    QTest::newRow("factor 4, multiple") << 4 << 200;
+    QTest::newRow("factor 4, odd blocks") << 4 << 37;
+    QTest::newRow("factor 5, single samples") << 5 << 1;
+    QTest::newRow("factor 10, short blocks") << 10 << 7;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtDecimator::blockSizes()
+{
+    //
+    //   Output sample k is the causal filter output at input sample k*factor, independent of the block size
+    //
+    QFETCH(int, factor);
+    QFETCH(int, blockSize);
+
+    RtDecimator decimator(factor);
+    QVector<int> lStimChannels;
+    lStimChannels << 7;
+    decimator.setStimChannels(lStimChannels);
+
+    MatrixXd matDecimated = stream(decimator, m_matData, blockSize);
+    QCOMPARE((int)matDecimated.cols(), (int)(m_matData.cols() + factor - 1) / factor);
+
+    const RowVectorXd& vecFilter = decimator.filter();
+    double dMaxError = 0.0;
+
+    for(int k = 0; k < matDecimated.cols(); ++k) {
+        int n = k * factor;
+
+        for(int r = 0; r < 7; ++r) {
+            double dExpected = 0.0;
+            for(int i = 0; i < vecFilter.cols() && i <= n; ++i)
+                dExpected += vecFilter(i) * m_matData(r, n - i);
+
+            dMaxError = qMax(dMaxError, qAbs(matDecimated(r, k) - dExpected));
+        }
+
+        //The stimulus channel holds the maximum of the delayed samples
+        double dExpected = 0.0;
+        for(int i = n - decimator.delay() - factor + 1; i <= n - decimator.delay(); ++i)
+            if(i >= 0)
+                dExpected = qMax(dExpected, m_matData(7, i));
+
+        QCOMPARE(matDecimated(7, k), dExpected);
+    }
+
+    QVERIFY2(dMaxError < 1e-10, QString("Maximal error %1").arg(dMaxError).toUtf8().constData());
+
+    //Every pulse survives, unless it is delayed past the end
+    int iLastInput = (matDecimated.cols() - 1) * factor - decimator.delay();
+    QCOMPARE((int)(matDecimated.row(7).array() == 5.0).count(), (int)(m_matData.row(7).head(iLastInput + 1).array() == 5.0).count());
+}
+
+
+//*************************************************************************************************************
+
+void TestRtDecimator::antiAlias()
+{
+    //
+    //   A tone below the cutoff passes, a tone above the Nyquist frequency of the output is removed
+    //
+    int iFactor = 5;
+    RtDecimator decimator(iFactor);
+
+    double sfreq = 1000.0;
+    MatrixXd matTones(2, 10000);
+    for(int n = 0; n < matTones.cols(); ++n) {
+        matTones(0, n) = sin(2.0 * M_PI * 0.5 * decimator.cutoff(sfreq) * n / sfreq);
+        matTones(1, n) = sin(2.0 * M_PI * 1.5 * sfreq / (2.0 * iFactor) * n / sfreq);
+    }
+
+    MatrixXd matDecimated = stream(decimator, matTones, 250);
+
+    QVERIFY(qAbs(matDecimated.row(0).tail(500).cwiseAbs().maxCoeff() - 1.0) < 1e-2);
+    QVERIFY(matDecimated.row(1).tail(500).cwiseAbs().maxCoeff() < 1e-3);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtDecimator::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtDecimator::stream(RtDecimator& decimator, const MatrixXd& matData, int iBlockSize) const
+{
+    MatrixXd matDecimated(matData.rows(), matData.cols());
+    MatrixXd matBlock;
+    int iOutputs = 0;
+
+    for(int n = 0; n < matData.cols(); n += iBlockSize) {
+        decimator.decimate(matData.middleCols(n, qMin(iBlockSize, (int)matData.cols() - n)), matBlock);
+        matDecimated.middleCols(iOutputs, matBlock.cols()) = matBlock;
+        iOutputs += matBlock.cols();
+    }
+
+    return matDecimated.leftCols(iOutputs);
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtDecimator)
+#include "test_rtdecimator.moc"
@@ -0,0 +1,423 @@
+//=============================================================================================================
+/**
+* @file     test_rtfilter.cpp
+* @author   Christoph Dinh <chdinh@nmr.mgh.harvard.edu>;
+*           Matti Hamalainen <msh@nmr.mgh.harvard.edu>
+* @version  1.0
+* @date     February, 2018
+*
+* @section  LICENSE
+*
+* Copyright (C) 2018, Christoph Dinh and Matti Hamalainen. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the real-time overlap-save filter.
+*
+*/
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtfilter.h>
+#include <utils/filterTools/filterdata.h>
+#include <utils/filterTools/iirfilter.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <complex>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtFilter
+*
+* @brief The TestRtFilter class streams random data block by block through RtFilter and compares the result with
+*        the direct convolution of the whole recording.
+*
+*/
+class TestRtFilter: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtFilter();
+
+private slots:
+    void initTestCase();
+    void cascadedFilters();
+    void longFilter();
+    void filterChange();
+    void iirFilters();
+    void iirDesign();
+    void iirApply();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Creates a filter with random coefficients.
+    */
+    FilterData randomFilter(int iLength) const;
+
+    //=========================================================================================================
+    /**
+    * Evaluates the magnitude response of second-order sections at dFreq, normed to the Nyquist frequency.
+    */
+    double magnitude(const MatrixXd& matSOS, double dFreq) const;
+
+    //=========================================================================================================
+    /**
+    * Streams m_matData through the filter in blocks of iBlockSize samples, the filters are switched to
+    * lFilterDataAfter at block iSwitchBlock.
+    */
+    MatrixXd stream(int iBlockSize, int iMaxFilterLength, const QList<FilterData>& lFilterData, const QList<FilterData>& lFilterDataAfter = QList<FilterData>(), int iSwitchBlock = -1) const;
+
+    //=========================================================================================================
+    /**
+    * Compares the filtered rows with the causal convolution and the other rows with the delayed data, starting
+    * at sample iFirst.
+    */
+    void compare(const MatrixXd& matFiltered, const RowVectorXd& vecImpulse, int iDelay, int iFirst = 0) const;
+
+    MatrixXd        m_matData;          /**< The random recording. */
+    QVector<int>    m_lFilterChannels;  /**< The filtered rows. */
+};
+
+
+//*************************************************************************************************************
+
+TestRtFilter::TestRtFilter()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::initTestCase()
+{
+    std::srand(42);
+    m_matData = MatrixXd::Random(12, 2400);
+
+    for(int i = 0; i < m_matData.rows(); ++i)
+        if(i % 4 != 3)
+            m_lFilterChannels.append(i);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::cascadedFilters()
+{
+    //
+    //   Two filters are applied one after the other, which is the convolution with the cascaded response
+    //
+    QList<FilterData> lFilterData;
+    lFilterData << randomFilter(64) << randomFilter(33);
+
+    RowVectorXd vecImpulse = RowVectorXd::Zero(64 + 33 - 1);
+    for(int i = 0; i < 64; ++i)
+        vecImpulse.segment(i, 33) += lFilterData.at(0).m_dCoeffA(i) * lFilterData.at(1).m_dCoeffA;
+
+    compare(stream(200, 64, lFilterData), vecImpulse, 32);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::longFilter()
+{
+    //
+    //   The impulse response and the delay are longer than a block
+    //
+    QList<FilterData> lFilterData;
+    lFilterData << randomFilter(300);
+
+    compare(stream(100, 300, lFilterData), lFilterData.at(0).m_dCoeffA, 150);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::filterChange()
+{
+    //
+    //   The past samples are kept when the filter changes, so the output is the convolution with the new filter
+    //   right from the block at which it was switched
+    //
+    QList<FilterData> lFilterData, lFilterDataAfter;
+    lFilterData << randomFilter(128);
+    lFilterDataAfter << randomFilter(128);
+
+    compare(stream(200, 128, lFilterData, lFilterDataAfter, 5), lFilterDataAfter.at(0).m_dCoeffA, 64, 5 * 200);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::iirFilters()
+{
+    FilterData lowpass("lowpass", FilterData::LPF, 4, 0.2, 0.0, 0.1, 1000, 512, FilterData::ButterworthIIR);
+    FilterData notch("notch", FilterData::NOTCH, 2, 0.3, 0.05, 0.1, 1000, 512, FilterData::ChebyshevIIR);
+
+    //
+    //   The lowpass passes a constant unchanged, also when filtered forward and backward
+    //
+    QVERIFY(qAbs(std::abs(lowpass.m_dFFTCoeffA(0)) - 1.0) < 1e-10);
+
+    RowVectorXd vecConstant = RowVectorXd::Constant(500, 3.0);
+    QVERIFY((lowpass.applyIIRFilter(vecConstant, true).array() - 3.0).abs().maxCoeff() < 1e-10);
+
+    //
+    //   The sections follow the FIR filter and continue their state from block to block
+    //
+    QList<FilterData> lFilterData;
+    lFilterData << lowpass << randomFilter(32) << notch;
+
+    MatrixXd matFiltered = stream(150, 32, lFilterData);
+
+    MatrixXd matSOS(lowpass.m_matSOS.rows() + notch.m_matSOS.rows(), 6);
+    matSOS << lowpass.m_matSOS, notch.m_matSOS;
+
+    const RowVectorXd& vecImpulse = lFilterData.at(1).m_dCoeffA;
+    MatrixXd matExpected = MatrixXd::Zero(m_matData.rows(), m_matData.cols());
+    for(int k = 0; k < vecImpulse.cols(); ++k)
+        matExpected.rightCols(m_matData.cols() - k) += vecImpulse(k) * m_matData.leftCols(m_matData.cols() - k);
+
+    MatrixXd matState;
+    IIRFilter::filter(matSOS, matExpected, matState);
+
+    double dMaxError = 0.0;
+    for(int r = 0; r < m_matData.rows(); ++r) {
+        if(m_lFilterChannels.contains(r))
+            dMaxError = qMax(dMaxError, (matFiltered.row(r) - matExpected.row(r)).cwiseAbs().maxCoeff());
+        else
+            dMaxError = qMax(dMaxError, (matFiltered.row(r).tail(m_matData.cols() - 16) - m_matData.row(r).head(m_matData.cols() - 16)).cwiseAbs().maxCoeff());
+    }
+
+    QVERIFY2(dMaxError < 1e-10, QString("Maximal error %1").arg(dMaxError).toUtf8().constData());
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::iirDesign()
+{
+    //
+    //   The responses follow the analog prototypes at the prewarped frequencies w = tan(pi*f/2): Butterworth
+    //   |H|^2 = 1/(1 + x^2n) and Chebyshev |H|^2 = 1/(1 + eps^2 T_n(x)^2), with x = w/wc for the lowpass,
+    //   wc/w for the highpass, (w^2 - w0^2)/(B w) for the bandpass and its inverse for the bandstop
+    //
+    int iOrder = 4;
+    FilterData lowpass("lowpass", FilterData::LPF, iOrder, 0.2, 0.0, 0.1, 1000, 512, FilterData::ButterworthIIR);
+    FilterData highpass("highpass", FilterData::HPF, iOrder, 0.2, 0.0, 0.1, 1000, 512, FilterData::ButterworthIIR);
+    FilterData bandpass("bandpass", FilterData::BPF, 3, 0.4, 0.2, 0.1, 1000, 512, FilterData::ButterworthIIR);
+    FilterData bandstop("bandstop", FilterData::NOTCH, 3, 0.4, 0.1, 0.1, 1000, 512, FilterData::ButterworthIIR);
+    FilterData chebyshev("chebyshev", FilterData::LPF, iOrder, 0.2, 0.0, 0.1, 1000, 512, FilterData::ChebyshevIIR);
+
+    double wc = tan(M_PI * 0.2 / 2.0);
+    double wLowPass = tan(M_PI * 0.3 / 2.0), wHighPass = tan(M_PI * 0.5 / 2.0);
+    double wLowStop = tan(M_PI * 0.35 / 2.0), wHighStop = tan(M_PI * 0.45 / 2.0);
+    double eps = sqrt(pow(10.0, chebyshev.m_dRipple / 10.0) - 1.0);
+
+    double dMaxError = 0.0;
+    for(int k = 1; k < 1000; ++k) {
+        double f = k / 1000.0;
+        double w = tan(M_PI * f / 2.0);
+
+        dMaxError = qMax(dMaxError, qAbs(magnitude(lowpass.m_matSOS, f) - 1.0 / sqrt(1.0 + pow(w / wc, 2 * iOrder))));
+        dMaxError = qMax(dMaxError, qAbs(magnitude(highpass.m_matSOS, f) - 1.0 / sqrt(1.0 + pow(wc / w, 2 * iOrder))));
+
+        double x = (w * w - wLowPass * wHighPass) / ((wHighPass - wLowPass) * w);
+        dMaxError = qMax(dMaxError, qAbs(magnitude(bandpass.m_matSOS, f) - 1.0 / sqrt(1.0 + pow(x, 6))));
+
+        x = ((wHighStop - wLowStop) * w) / (w * w - wLowStop * wHighStop);
+        dMaxError = qMax(dMaxError, qAbs(magnitude(bandstop.m_matSOS, f) - 1.0 / sqrt(1.0 + pow(x, 6))));
+
+        x = w / wc;
+        double T = x <= 1.0 ? cos(iOrder * acos(x)) : cosh(iOrder * acosh(x));
+        dMaxError = qMax(dMaxError, qAbs(magnitude(chebyshev.m_matSOS, f) - 1.0 / sqrt(1.0 + eps * eps * T * T)));
+    }
+
+    QVERIFY2(dMaxError < 1e-10, QString("Maximal error %1").arg(dMaxError).toUtf8().constData());
+
+    //
+    //   -3 dB at the Butterworth cutoff and band edges
+    //
+    QVERIFY(qAbs(magnitude(lowpass.m_matSOS, 0.2) - M_SQRT1_2) < 1e-10);
+    QVERIFY(qAbs(magnitude(highpass.m_matSOS, 0.2) - M_SQRT1_2) < 1e-10);
+    QVERIFY(qAbs(magnitude(bandpass.m_matSOS, 0.3) - M_SQRT1_2) < 1e-10);
+    QVERIFY(qAbs(magnitude(bandpass.m_matSOS, 0.5) - M_SQRT1_2) < 1e-10);
+
+    //
+    //   The Chebyshev passband ripples between -m_dRipple dB and 0 dB and ends at -m_dRipple dB
+    //
+    double dRippleMin = pow(10.0, -chebyshev.m_dRipple / 20.0);
+    for(int k = 0; k <= 200; ++k) {
+        double dMagnitude = magnitude(chebyshev.m_matSOS, 0.2 * k / 200.0);
+        QVERIFY(dMagnitude > dRippleMin - 1e-10 && dMagnitude < 1.0 + 1e-10);
+    }
+    QVERIFY(qAbs(magnitude(chebyshev.m_matSOS, 0.2) - dRippleMin) < 1e-10);
+
+    //
+    //   Stopband attenuation
+    //
+    QVERIFY(20.0 * log10(magnitude(lowpass.m_matSOS, 0.5)) < -38.0);
+    QVERIFY(20.0 * log10(magnitude(highpass.m_matSOS, 0.05)) < -48.0);
+    QVERIFY(20.0 * log10(magnitude(bandpass.m_matSOS, 0.1)) < -47.0);
+    QVERIFY(20.0 * log10(magnitude(bandstop.m_matSOS, 0.39)) < -45.0);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::iirApply()
+{
+    //
+    //   The FIR apply functions run the sections of IIR filters: causally for the convolution, forward and backward
+    //   for the FFT filter. With overhead the result has the layout of a linear-phase FIR of the same order.
+    //
+    FilterData lowpass("lowpass", FilterData::LPF, 4, 0.2, 0.0, 0.1, 1000, 512, FilterData::ButterworthIIR);
+    RowVectorXd vecData = m_matData.row(0);
+
+    MatrixXd matCausal = vecData;
+    MatrixXd matState;
+    IIRFilter::filter(lowpass.m_matSOS, matCausal, matState);
+
+    MatrixXd matZeroPhase = vecData;
+    IIRFilter::filtfilt(lowpass.m_matSOS, matZeroPhase);
+
+    QVERIFY(lowpass.applyConvFilter(vecData) == matCausal.row(0));
+    QVERIFY(lowpass.applyFFTFilter(vecData) == matZeroPhase.row(0));
+
+    RowVectorXd vecOverhead = lowpass.applyFFTFilter(vecData, true, FilterData::ZeroPad);
+    QCOMPARE((int)vecOverhead.cols(), (int)vecData.cols() + lowpass.m_iFilterOrder);
+    QVERIFY(vecOverhead.segment(lowpass.m_iFilterOrder/2, vecData.cols()) == matZeroPhase.row(0));
+    QVERIFY((vecOverhead.head(lowpass.m_iFilterOrder/2).array() == 0.0).all());
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+FilterData TestRtFilter::randomFilter(int iLength) const
+{
+    FilterData filter;
+    filter.m_iFilterOrder = iLength;
+    filter.m_dCoeffA = RowVectorXd::Random(iLength) / iLength;
+    return filter;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRtFilter::stream(int iBlockSize, int iMaxFilterLength, const QList<FilterData>& lFilterData, const QList<FilterData>& lFilterDataAfter, int iSwitchBlock) const
+{
+    RtFilter filter;
+    MatrixXd matFiltered(m_matData.rows(), m_matData.cols());
+    MatrixXd matBlock;
+
+    for(int b = 0; b < m_matData.cols() / iBlockSize; ++b) {
+        filter.filterChannelsConcurrently(m_matData.middleCols(b * iBlockSize, iBlockSize), matBlock, iMaxFilterLength, m_lFilterChannels, (iSwitchBlock >= 0 && b >= iSwitchBlock) ? lFilterDataAfter : lFilterData);
+        matFiltered.middleCols(b * iBlockSize, iBlockSize) = matBlock;
+    }
+
+    return matFiltered;
+}
+
+
+//*************************************************************************************************************
+
+void TestRtFilter::compare(const MatrixXd& matFiltered, const RowVectorXd& vecImpulse, int iDelay, int iFirst) const
+{
+    double dMaxError = 0.0;
+
+    for(int r = 0; r < m_matData.rows(); ++r) {
+        for(int n = iFirst; n < m_matData.cols(); ++n) {
+            double dExpected = 0.0;
+
+            if(m_lFilterChannels.contains(r)) {
+                for(int k = 0; k < vecImpulse.cols() && k <= n; ++k)
+                    dExpected += vecImpulse(k) * m_matData(r, n - k);
+            } else if(n >= iDelay) {
+                dExpected = m_matData(r, n - iDelay);
+            }
+
+            dMaxError = qMax(dMaxError, qAbs(matFiltered(r, n) - dExpected));
+        }
+    }
+
+    QVERIFY2(dMaxError < 1e-10, QString("Maximal error %1").arg(dMaxError).toUtf8().constData());
+}
+
+
+//*************************************************************************************************************
+
+double TestRtFilter::magnitude(const MatrixXd& matSOS, double dFreq) const
+{
+    std::complex<double> z = std::polar(1.0, -M_PI * dFreq);
+    std::complex<double> h = 1.0;
+
+    for(int i = 0; i < matSOS.rows(); ++i)
+        h *= (matSOS(i,0) + matSOS(i,1) * z + matSOS(i,2) * z * z) / (matSOS(i,3) + matSOS(i,4) * z + matSOS(i,5) * z * z);
+
+    return std::abs(h);
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtFilter)
+#include "test_rtfilter.moc"
@@ -41,11 +41,24 @@ SUBDIRS += \
     test_codecov \
     test_dipole_fit \
     test_fiff_rwr \
+    test_fiff_raw_seek \
+    test_fiff_tag_convert \
+    test_fiff_dir_index \
+    test_fiff_tag_parser \
+    test_fiff_resample \
+    test_fiff_info_sharing \
+    test_rtfilter \
+    test_rtdecimator \
+    test_circular_matrix_buffer \
+    test_rtave \
     test_fiff_mne_types_io \
+    test_mne_epochs_io \
     test_forward_solution \
     test_fiff_cov \
     test_fiff_digitizer \
     test_mne_msh_display_surface_set \
+    bench_fiff_io \
+    bench_circular_matrix_buffer \
 
 !contains(MNECPP_CONFIG, minimalVersion) {
     qtHaveModule(charts) {
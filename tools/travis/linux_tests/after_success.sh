@@ -10,7 +10,7 @@ export LD_LIBRARY_PATH=$(pwd)/lib:$LD_LIBRARY_PATH
 MNECPP_ROOT=$(pwd)
 
 # Tests to run - TODO: find required tests automatically with grep
-tests=( test_codecov test_fiff_rwr test_dipole_fit test_fiff_mne_types_io test_fiff_cov test_fiff_digitizer test_mne_msh_display_surface_set test_geometryinfo test_interpolation )
+tests=( test_codecov test_fiff_rwr test_fiff_raw_seek test_fiff_tag_convert test_fiff_dir_index test_fiff_tag_parser test_fiff_resample test_fiff_info_sharing test_rtfilter test_rtdecimator test_circular_matrix_buffer test_rtave test_dipole_fit test_fiff_mne_types_io test_mne_epochs_io test_fiff_cov test_fiff_digitizer test_mne_msh_display_surface_set test_geometryinfo test_interpolation )
 
 for test in ${tests[*]};
 do